@@ -8,7 +8,7 @@ _ras_mc_ctl() {
 
     opts="--quiet --mainboard --status --print-labels --guess-labels --register-labels 
           --delay --labeldb --layout --summary --errors --error-count --since 
-          --vendor-errors-summary --vendor-errors --vendor-platforms --help"
+          --vendor-errors-summary --vendor-errors --vendor-platforms --follow --help"
 
     case "${prev}" in
         --delay)
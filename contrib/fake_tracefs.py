@@ -0,0 +1,585 @@
+#!/usr/bin/env python3
+#
+# pylint: disable=C0301, C0114
+# SPDX-License-Identifier: GPL-2.0
+
+import argparse
+import errno
+import os
+import random
+import struct
+import sys
+import time
+
+fake_tracefs_description = """
+Create a synthetic tracefs tree and feed it with RAS events.\n
+
+The tree has the tracepoint format files used by rasdaemon and, for each
+CPU, a FIFO at per_cpu/cpuN/trace_pipe_raw. Once rasdaemon opens them,
+synthetic records are written to the FIFOs as ring buffer sub-buffers,
+in the same binary format used by the Kernel, at the chosen rate.
+
+Run rasdaemon with TRACING_ROOT pointing to the tree, e.g.:
+
+    fake_tracefs.py --rate 10000 --duration 60 /tmp/tracefs &
+    TRACING_ROOT=/tmp/tracefs PAGE_CE_ACTION=off rasdaemon -f -r
+
+The generated memory addresses are random: keep page, row and CPU
+isolation disabled, as they would act on the running system.
+
+When rasdaemon can't keep up with the FIFOs, the sub-buffers that don't
+fit are dropped and reported as missed events, like the Kernel does.
+"""
+
+PAGE_SIZE = 4096
+PAGE_HEADER_SIZE = 16           # u64 timestamp, local_t commit
+RB_MISSED_EVENTS = 1 << 31
+RB_MISSED_STORED = 1 << 30
+TYPE_LEN_MAX = 28               # Larger events store their length
+
+#
+# Tracepoint formats
+#
+# Each field is (declaration, name, element size, count, signed).
+# A count of 0 means a __data_loc field (string or dynamic array).
+#
+
+COMMON_FIELDS = [
+    ("unsigned short", "common_type", 2, 1, 0),
+    ("unsigned char", "common_flags", 1, 1, 0),
+    ("unsigned char", "common_preempt_count", 1, 1, 0),
+    ("int", "common_pid", 4, 1, 1),
+]
+
+EVENTS = {
+    "mc_event": ("ras", [
+        ("unsigned int", "error_type", 4, 1, 0),
+        ("char", "msg", 1, 0, 1),
+        ("char", "label", 1, 0, 1),
+        ("u16", "error_count", 2, 1, 0),
+        ("u8", "mc_index", 1, 1, 0),
+        ("s8", "top_layer", 1, 1, 1),
+        ("s8", "middle_layer", 1, 1, 1),
+        ("s8", "lower_layer", 1, 1, 1),
+        ("long", "address", 8, 1, 1),
+        ("u8", "grain_bits", 1, 1, 0),
+        ("long", "syndrome", 8, 1, 1),
+        ("char", "driver_detail", 1, 0, 1),
+    ]),
+    "mce_record": ("mce", [
+        ("u64", "mcgcap", 8, 1, 0),
+        ("u64", "mcgstatus", 8, 1, 0),
+        ("u64", "status", 8, 1, 0),
+        ("u64", "addr", 8, 1, 0),
+        ("u64", "misc", 8, 1, 0),
+        ("u64", "synd", 8, 1, 0),
+        ("u64", "ipid", 8, 1, 0),
+        ("u64", "ip", 8, 1, 0),
+        ("u64", "tsc", 8, 1, 0),
+        ("u64", "ppin", 8, 1, 0),
+        ("u64", "walltime", 8, 1, 0),
+        ("u32", "microcode", 4, 1, 0),
+        ("u32", "cpu", 4, 1, 0),
+        ("u32", "cpuid", 4, 1, 0),
+        ("u32", "apicid", 4, 1, 0),
+        ("u32", "socketid", 4, 1, 0),
+        ("u8", "cs", 1, 1, 0),
+        ("u8", "bank", 1, 1, 0),
+        ("u8", "cpuvendor", 1, 1, 0),
+        ("u8", "v_data", 1, 0, 0),
+    ]),
+    "aer_event": ("ras", [
+        ("char", "dev_name", 1, 0, 1),
+        ("u32", "status", 4, 1, 0),
+        ("u8", "severity", 1, 1, 0),
+        ("u8", "tlp_header_valid", 1, 1, 0),
+        ("u32", "tlp_header", 4, 4, 0),
+    ]),
+    "arm_event": ("ras", [
+        ("u64", "mpidr", 8, 1, 0),
+        ("u64", "midr", 8, 1, 0),
+        ("u32", "running_state", 4, 1, 0),
+        ("u32", "psci_state", 4, 1, 0),
+        ("u8", "affinity", 1, 1, 0),
+        ("u32", "pei_len", 4, 1, 0),
+        ("u8", "pei_buf", 1, 0, 0),
+        ("u32", "ctx_len", 4, 1, 0),
+        ("u8", "ctx_buf", 1, 0, 0),
+        ("u32", "oem_len", 4, 1, 0),
+        ("u8", "oem_buf", 1, 0, 0),
+        ("u8", "sev", 1, 1, 0),
+        ("int", "cpu", 4, 1, 1),
+    ]),
+    "non_standard_event": ("ras", [
+        ("char", "sec_type", 1, 16, 1),
+        ("char", "fru_id", 1, 16, 1),
+        ("char", "fru_text", 1, 0, 1),
+        ("u8", "sev", 1, 1, 0),
+        ("u32", "len", 4, 1, 0),
+        ("u8", "buf", 1, 0, 0),
+    ]),
+    "cxl_poison": ("cxl", [
+        ("char", "memdev", 1, 0, 1),
+        ("char", "host", 1, 0, 1),
+        ("u64", "serial", 8, 1, 0),
+        ("u8", "trace_type", 1, 1, 0),
+        ("char", "region", 1, 0, 1),
+        ("u64", "overflow_ts", 8, 1, 0),
+        ("u64", "hpa", 8, 1, 0),
+        ("u64", "hpa_alias0", 8, 1, 0),
+        ("u64", "dpa", 8, 1, 0),
+        ("u32", "dpa_length", 4, 1, 0),
+        ("char", "uuid", 1, 16, 1),
+        ("u8", "source", 1, 1, 0),
+        ("u8", "flags", 1, 1, 0),
+    ]),
+    "cxl_aer_uncorrectable_error": ("cxl", [
+        ("char", "memdev", 1, 0, 1),
+        ("char", "host", 1, 0, 1),
+        ("u64", "serial", 8, 1, 0),
+        ("u32", "status", 4, 1, 0),
+        ("u32", "first_error", 4, 1, 0),
+        ("u32", "header_log", 4, 128, 0),
+    ]),
+    "cxl_aer_correctable_error": ("cxl", [
+        ("char", "memdev", 1, 0, 1),
+        ("char", "host", 1, 0, 1),
+        ("u64", "serial", 8, 1, 0),
+        ("u32", "status", 4, 1, 0),
+    ]),
+}
+
+HEADER_PAGE = """\
+\tfield: u64 timestamp;\toffset:0;\tsize:8;\tsigned:0;
+\tfield: local_t commit;\toffset:8;\tsize:8;\tsigned:1;
+\tfield: int overwrite;\toffset:8;\tsize:1;\tsigned:1;
+\tfield: char data;\toffset:16;\tsize:4080;\tsigned:1;
+"""
+
+FIRST_EVENT_ID = 1500
+
+
+class Event:
+    """A synthetic tracepoint, with its format and record layout"""
+
+    def __init__(self, name, group, fields, event_id):
+        self.name = name
+        self.group = group
+        self.id = event_id
+        self.fields = []
+
+        offset = 0
+        for decl, fname, size, count, signed in COMMON_FIELDS + fields:
+            field_size = size * count if count else 4
+            align = min(size if count else 4, 8)
+            offset = (offset + align - 1) & ~(align - 1)
+            self.fields.append((decl, fname, size, count, signed, offset,
+                                field_size))
+            offset += field_size
+
+        self.size = offset
+
+    def format(self):
+        """Return the contents of the format file"""
+
+        out = f"name: {self.name}\nID: {self.id}\nformat:\n"
+        args = []
+        for i, (decl, name, _, count, signed, offset, size) in enumerate(self.fields):
+            if not count:
+                field = f"__data_loc {decl}[] {name}"
+            elif count > 1:
+                field = f"{decl} {name}[{count}]"
+            else:
+                field = f"{decl} {name}"
+                if i >= len(COMMON_FIELDS):
+                    args.append(name)
+
+            out += f"\tfield:{field};\toffset:{offset};\tsize:{size};\tsigned:{signed};\n"
+            if i == len(COMMON_FIELDS) - 1:
+                out += "\n"
+
+        fmt = " ".join(f"{name}=%llu" for name in args)
+        rec = ", ".join(f"REC->{name}" for name in args)
+        out += f"\nprint fmt: \"{fmt}\", {rec}\n"
+
+        return out
+
+    def record(self, values):
+        """Pack a record, with the values of the fields at a dict"""
+
+        data = bytearray(self.size)
+        dynamic = bytearray()
+
+        values["common_type"] = self.id
+        for _, name, size, count, signed, offset, field_size in self.fields:
+            val = values.get(name, 0)
+
+            if not count:
+                if isinstance(val, str):
+                    val = val.encode() + b"\0"
+                elif not val:
+                    val = b""
+                loc = self.size + len(dynamic)
+                struct.pack_into("=I", data, offset, (len(val) << 16) | loc)
+                dynamic += val
+            elif isinstance(val, (bytes, bytearray)):
+                data[offset:offset + field_size] = val[:field_size].ljust(field_size, b"\0")
+            else:
+                data[offset:offset + size] = int(val).to_bytes(size, sys.byteorder,
+                                                               signed=bool(signed))
+
+        return bytes(data + dynamic)
+
+
+#
+# Synthetic values
+#
+
+def mc_event_values(rnd, cpu):
+    """Mostly corrected DIMM errors, with a few uncorrected ones"""
+    channel = rnd.randrange(8)
+    dimm = rnd.randrange(2)
+    return {
+        "error_type": 1 if rnd.random() < 0.01 else 0,
+        "msg": "memory read error",
+        "label": f"CPU_SrcID#0_MC#0_Chan#{channel}_DIMM#{dimm}",
+        "error_count": 1,
+        "top_layer": channel,
+        "middle_layer": dimm,
+        "lower_layer": -1,
+        "address": rnd.getrandbits(40) << 12,
+        "grain_bits": 6,
+        "syndrome": rnd.getrandbits(16),
+        "driver_detail": "",
+    }
+
+
+def mce_record_values(rnd, cpu):
+    """Corrected memory read errors"""
+    return {
+        "status": 0x9c00004000010091 | (rnd.getrandbits(8) << 32),
+        "addr": rnd.getrandbits(40) << 12,
+        "misc": 0x86,
+        "tsc": time.monotonic_ns(),
+        "walltime": int(time.time()),
+        "cpu": cpu,
+        "apicid": cpu,
+        "bank": 7,
+    }
+
+
+def aer_event_values(rnd, cpu):
+    """Correctable errors on a few PCIe devices"""
+    return {
+        "dev_name": f"0000:{rnd.randrange(4):02x}:00.0",
+        "status": 1 << rnd.choice([0, 6, 7, 8, 12, 13]),
+        "severity": 2,
+    }
+
+
+def arm_event_values(rnd, cpu):
+    """Processor errors without error information"""
+    return {
+        "mpidr": cpu,
+        "midr": 0x410fd0c0,
+        "affinity": 0xff,
+        "sev": 1,
+        "cpu": cpu,
+    }
+
+
+def non_standard_event_values(rnd, cpu):
+    """Vendor-specific records, with a small payload"""
+    return {
+        "sec_type": bytes(range(16)),
+        "fru_text": "synthetic",
+        "sev": 1,
+        "len": 16,
+        "buf": bytes(rnd.getrandbits(8) for _ in range(16)),
+    }
+
+
+def cxl_values(rnd, cpu):
+    """Common CXL fields"""
+    return {
+        "memdev": f"mem{rnd.randrange(4)}",
+        "host": "0000:0d:00.0",
+        "serial": 0x1234,
+    }
+
+
+def cxl_poison_values(rnd, cpu):
+    """Poison list entries"""
+    values = cxl_values(rnd, cpu)
+    values.update({
+        "region": "",
+        "hpa": 0xffffffffffffffff,
+        "dpa": rnd.getrandbits(28) << 6,
+        "dpa_length": 64,
+        "source": 1,
+    })
+    return values
+
+
+def cxl_aer_ue_values(rnd, cpu):
+    """Uncorrectable CXL RAS errors"""
+    values = cxl_values(rnd, cpu)
+    values.update({"status": 1 << 8, "first_error": 1 << 8})
+    return values
+
+
+def cxl_aer_ce_values(rnd, cpu):
+    """Correctable CXL RAS errors"""
+    values = cxl_values(rnd, cpu)
+    values["status"] = 1 << rnd.randrange(7)
+    return values
+
+
+GENERATORS = {
+    "mc_event": mc_event_values,
+    "mce_record": mce_record_values,
+    "aer_event": aer_event_values,
+    "arm_event": arm_event_values,
+    "non_standard_event": non_standard_event_values,
+    "cxl_poison": cxl_poison_values,
+    "cxl_aer_uncorrectable_error": cxl_aer_ue_values,
+    "cxl_aer_correctable_error": cxl_aer_ce_values,
+}
+
+
+#
+# Synthetic tracefs tree
+#
+
+def possible_cpus():
+    """Parse the possible CPU list, like "0-3,8-11" """
+    try:
+        with open("/sys/devices/system/cpu/possible", encoding="utf-8") as fp:
+            cpus = fp.read().strip()
+    except OSError:
+        return os.cpu_count()
+
+    last = 0
+    for part in cpus.split(","):
+        last = max(last, int(part.split("-")[-1]))
+
+    return last + 1
+
+
+def write_file(path, contents=""):
+    """Create a file and its parent directories"""
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "w", encoding="utf-8") as fp:
+        fp.write(contents)
+
+
+def create_tree(root, events, n_cpus):
+    """Create the files read by rasdaemon"""
+
+    write_file(os.path.join(root, "events/header_page"), HEADER_PAGE)
+    write_file(os.path.join(root, "set_event"))
+    write_file(os.path.join(root, "buffer_percent"), "50\n")
+    write_file(os.path.join(root, "trace_clock"), "[local] global counter mono\n")
+
+    for ev in events:
+        path = os.path.join(root, "events", ev.group, ev.name)
+        write_file(os.path.join(path, "format"), ev.format())
+        write_file(os.path.join(path, "id"), f"{ev.id}\n")
+        write_file(os.path.join(path, "filter"), "none\n")
+        write_file(os.path.join(path, "enable"), "0\n")
+
+    for cpu in range(n_cpus):
+        path = os.path.join(root, f"per_cpu/cpu{cpu}")
+        write_file(os.path.join(path, "buffer_size_kb"), "1408\n")
+
+        fifo = os.path.join(path, "trace_pipe_raw")
+        if os.path.exists(fifo):
+            os.unlink(fifo)
+        os.mkfifo(fifo, 0o600)
+
+
+#
+# Ring buffer sub-buffers
+#
+
+class Cpu:
+    """Per-CPU sub-buffer being filled, and its FIFO"""
+
+    def __init__(self, root, cpu):
+        self.cpu = cpu
+        self.path = os.path.join(root, f"per_cpu/cpu{cpu}/trace_pipe_raw")
+        self.fd = -1
+        self.data = bytearray()
+        self.events = 0
+        self.missed = 0
+        self.pages = 0
+
+    def open(self):
+        """Non-blocking open, which fails until there's a reader"""
+        try:
+            self.fd = os.open(self.path, os.O_WRONLY | os.O_NONBLOCK)
+        except OSError as e:
+            if e.errno != errno.ENXIO:
+                raise
+        return self.fd >= 0
+
+    def add(self, record):
+        """Add an event to the sub-buffer. Returns False if it is full"""
+
+        # Event data is 4-byte aligned
+        record += b"\0" * (-len(record) % 4)
+        if len(record) <= TYPE_LEN_MAX * 4:
+            hdr = struct.pack("=I", len(record) // 4)
+        else:
+            hdr = struct.pack("=II", 0, len(record) + 4)
+
+        # Keep room for the missed events count
+        if PAGE_HEADER_SIZE + len(self.data) + len(hdr) + len(record) + 8 > PAGE_SIZE:
+            return False
+
+        self.data += hdr + record
+        self.events += 1
+        return True
+
+    def flush(self):
+        """Write the sub-buffer. Returns the number of events lost"""
+
+        if not self.data:
+            return 0
+
+        commit = len(self.data)
+        data = self.data
+        if self.missed:
+            commit |= RB_MISSED_EVENTS | RB_MISSED_STORED
+            data += struct.pack("=q", self.missed)
+
+        page = struct.pack("=Qq", time.monotonic_ns(), commit) + data
+        page += b"\0" * (PAGE_SIZE - len(page))
+        events = self.events
+        self.data = bytearray()
+        self.events = 0
+
+        try:
+            os.write(self.fd, page)
+        except BlockingIOError:
+            # Like the Kernel, report them on the next sub-buffer
+            self.missed += events
+            return events
+
+        self.pages += 1
+        self.missed = 0
+        return 0
+
+
+def run(args, events, cpus):
+    """Feed the FIFOs with events, at the chosen rate"""
+
+    rnd = random.Random(args.seed)
+    sent = lost = 0
+    interval = args.flush_ms / 1000
+    weights = [args.weight.get(ev.name, 1) for ev in events]
+
+    print(f"Waiting for rasdaemon to open {len(cpus)} CPUs at {args.root}")
+    pending = list(cpus)
+    while pending:
+        pending = [c for c in pending if not c.open()]
+        time.sleep(0.1)
+
+    start = last_flush = last_report = time.monotonic()
+    try:
+        while not args.duration or time.monotonic() - start < args.duration:
+            now = time.monotonic()
+
+            # Events due since the start, at the chosen rate
+            due = int((now - start) * args.rate) - sent
+            for _ in range(min(due, 10000)):
+                ev = rnd.choices(events, weights)[0]
+                cpu = cpus[rnd.randrange(len(cpus))]
+                rec = ev.record(GENERATORS[ev.name](rnd, cpu.cpu))
+                if not cpu.add(rec):
+                    lost += cpu.flush()
+                    cpu.add(rec)
+                sent += 1
+
+            if now - last_flush >= interval:
+                for cpu in cpus:
+                    lost += cpu.flush()
+                last_flush = now
+
+            if args.verbose and now - last_report >= 1:
+                print(f"{sent} events sent, {lost} lost")
+                last_report = now
+
+            if due <= 0:
+                time.sleep(min(interval, 1 / args.rate))
+    except KeyboardInterrupt:
+        pass
+
+    for cpu in cpus:
+        lost += cpu.flush()
+
+    elapsed = time.monotonic() - start
+    pages = sum(c.pages for c in cpus)
+    missed = sum(c.missed for c in cpus)
+    print(f"Sent {sent} events in {pages} sub-buffers in {elapsed:.1f}s "
+          f"({sent / elapsed:.0f} events/s). {lost} events lost, "
+          f"{missed} of them not reported yet")
+
+    for cpu in cpus:
+        os.close(cpu.fd)
+
+
+def parse_weights(val):
+    """Parse event=weight pairs"""
+    weights = {}
+    for pair in val.split(","):
+        name, _, weight = pair.partition("=")
+        weights[name] = int(weight or 1)
+    return weights
+
+
+def main():
+    """Main program"""
+
+    parser = argparse.ArgumentParser(description=fake_tracefs_description,
+                                     formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("root", help="Directory where the tree will be created")
+    parser.add_argument("-e", "--events", default=",".join(EVENTS),
+                        help="Comma-separated list of events to generate")
+    parser.add_argument("-w", "--weight", type=parse_weights, default={},
+                        help="Relative frequency of the events, like mc_event=10,aer_event=1")
+    parser.add_argument("-r", "--rate", type=float, default=1000,
+                        help="Events per second. Default: 1000")
+    parser.add_argument("-d", "--duration", type=float, default=0,
+                        help="Time to run, in seconds. Default: forever")
+    parser.add_argument("-c", "--cpus", type=int, default=possible_cpus(),
+                        help="Number of CPUs. Default: the possible CPUs")
+    parser.add_argument("-f", "--flush-ms", type=float, default=10,
+                        help="Maximum time before writing a partial sub-buffer. Default: 10")
+    parser.add_argument("-s", "--seed", type=int, default=0,
+                        help="Random seed, for repeatable runs")
+    parser.add_argument("--create-only", action="store_true",
+                        help="Only create the tree")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="Print the progress every second")
+    args = parser.parse_args()
+
+    events = []
+    for i, name in enumerate(args.events.split(",")):
+        if name not in EVENTS:
+            sys.exit(f"Unknown event {name}. Valid events: {', '.join(EVENTS)}")
+        group, fields = EVENTS[name]
+        events.append(Event(name, group, fields, FIRST_EVENT_ID + i))
+
+    if args.rate <= 0:
+        sys.exit("Rate should be positive")
+
+    create_tree(args.root, events, args.cpus)
+    if args.create_only:
+        return
+
+    run(args, events, [Cpu(args.root, cpu) for cpu in range(args.cpus)])
+
+
+if __name__ == "__main__":
+    main()
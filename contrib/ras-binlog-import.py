@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+#
+# pylint: disable=C0301, C0114
+# SPDX-License-Identifier: GPL-2.0
+
+import argparse
+import bisect
+import mmap
+import os
+import sqlite3
+import struct
+import sys
+import zlib
+
+binlog_import_description = """
+Import the binary event log segments written by rasdaemon, when running
+with EVENT_STORAGE=binlog, at the SQLite database read by ras-mc-ctl.\n
+
+Each segment describes the tables it has events for, so tables missing
+at the database are created. Segments can be given as files or as the
+directory where rasdaemon writes them, e.g.:
+
+    ras-binlog-import.py /var/lib/rasdaemon/binlog
+
+Events aren't checked against the ones already at the database, so each
+segment should be imported only once. The segment being written is read
+up to its last complete event.
+
+Segments are in the byte order of the machine that wrote them.
+"""
+
+MAGIC = b"RASBLG01"
+FOOTER_MAGIC = b"RASBIX01"
+VERSION = 1
+SUFFIX = ".rbl"
+ALIGN = 8
+NULL_LEN = 0xffffffff
+
+REC_TABLE = 1
+REC_EVENT = 2
+
+KIND_NONE = 0
+KIND_INT = 1
+KIND_TEXT = 2
+KIND_BLOB = 3
+
+HDR = struct.Struct("=8sIIQQQQ16x")      # magic, version, big_endian, seg_size, seq, created_ns, footer_offset
+REC = struct.Struct("=IIHHIQQ")          # len, crc, type, table, reserved, time_ns, boot_ns
+INDEX = struct.Struct("=QIHH")           # time_ns, offset, table, reserved
+TABLE_SUM = struct.Struct("=QQIHH")      # first_ns, last_ns, count, table, reserved
+FOOTER = struct.Struct("=8sQQIIII")      # magic, index_offset, tables_offset, n_index, n_tables, crc, reserved
+CRC_SKIP = 8                             # The crc covers the record from .type
+
+
+class Table:
+    """Table described at a segment"""
+
+    def __init__(self, name, columns):
+        self.name = name
+        self.columns = columns           # (kind, name, type)
+
+    def stored(self):
+        """Columns with values at the event records"""
+        return [c for c in self.columns if c[0] != KIND_NONE]
+
+
+class Segment:
+    """Segment file, mapped into memory"""
+
+    def __init__(self, path):
+        self.path = path
+        with open(path, "rb") as f:
+            self.map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(self.map) < HDR.size:
+            raise ValueError("too small")
+
+        magic, version, big_endian, seg_size, self.seq, self.created_ns, \
+            self.footer_offset = HDR.unpack_from(self.map, 0)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError("not an event log segment")
+        if big_endian != (sys.byteorder == "big"):
+            raise ValueError("written by a machine with another byte order")
+        if seg_size != len(self.map):
+            raise ValueError("truncated")
+
+        self.tables = {}
+        self.sums = []
+        self.index = []
+        self.footer = None
+        if self.footer_offset:
+            self.read_footer()
+
+    def read_footer(self):
+        """Reads the index and table summaries of a full segment"""
+        magic, index_offset, tables_offset, n_index, n_tables, crc, _ = \
+            FOOTER.unpack_from(self.map, self.footer_offset)
+        end = tables_offset + n_tables * TABLE_SUM.size
+        if magic != FOOTER_MAGIC or zlib.crc32(self.map[index_offset:end]) != crc:
+            return
+
+        self.index = [INDEX.unpack_from(self.map, index_offset + i * INDEX.size)
+                      for i in range(n_index)]
+        self.sums = [TABLE_SUM.unpack_from(self.map, tables_offset + i * TABLE_SUM.size)
+                     for i in range(n_tables)]
+        self.footer = index_offset
+
+    def records(self):
+        """Yields (offset, header) of the records, up to the last good one"""
+        off = HDR.size
+        end = self.footer or len(self.map)
+        while off + REC.size <= end:
+            rec = REC.unpack_from(self.map, off)
+            length, crc = rec[0], rec[1]
+            if length < REC.size or length > end - off:
+                break
+            if zlib.crc32(self.map[off + CRC_SKIP:off + length]) != crc:
+                break
+            yield off, rec
+            off = (off + length + ALIGN - 1) & ~(ALIGN - 1)
+
+    def read_tables(self):
+        """Reads the table records"""
+        for off, rec in self.records():
+            if rec[2] == REC_TABLE:
+                self.tables[rec[3]] = self.parse_table(off + REC.size, off + rec[0])
+
+    def parse_table(self, off, end):
+        """Table record: name, then kind, name and type of each column"""
+        data = self.map[off:end]
+        name, _, data = data.partition(b"\0")
+        columns = []
+        while data:
+            kind = data[0]
+            col, _, data = data[1:].partition(b"\0")
+            sql_type, _, data = data.partition(b"\0")
+            columns.append((kind, col.decode(), sql_type.decode()))
+        return Table(name.decode(), columns)
+
+    def events(self, since_ns):
+        """Yields (table, header, values), in time order if the segment is full"""
+        if self.index:
+            start = bisect.bisect_left(self.index, (since_ns,))
+            offsets = (entry[1] for entry in self.index[start:])
+        else:
+            offsets = (off for off, rec in self.records() if rec[2] == REC_EVENT)
+
+        for off in offsets:
+            rec = REC.unpack_from(self.map, off)
+            table = self.tables.get(rec[3])
+            if not table or rec[5] < since_ns:
+                continue
+            yield table, rec, self.parse_event(table, off + REC.size)
+
+    def parse_event(self, table, off):
+        """Values of the stored columns"""
+        values = []
+        for kind, _, _ in table.stored():
+            if kind == KIND_INT:
+                values.append(struct.unpack_from("=q", self.map, off)[0])
+                off += 8
+                continue
+
+            length = struct.unpack_from("=I", self.map, off)[0]
+            off += 4
+            if length == NULL_LEN:
+                values.append(None)
+                continue
+
+            data = self.map[off:off + length]
+            off += length
+            values.append(data.decode(errors="replace") if kind == KIND_TEXT else data)
+        return values
+
+
+def segment_paths(paths):
+    """Segment files, from files and directories, in sequence order"""
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            files += [os.path.join(path, f) for f in os.listdir(path) if f.endswith(SUFFIX)]
+        else:
+            files.append(path)
+    return sorted(files, key=os.path.basename)
+
+
+class Database:
+    """Inserts the events, creating the missing tables and columns"""
+
+    def __init__(self, path):
+        self.db = sqlite3.connect(path)
+        self.db.execute("PRAGMA busy_timeout = 5000")
+        self.inserts = {}
+
+    def columns(self, name):
+        """Columns of a table at the database"""
+        return [row[1] for row in self.db.execute(f"PRAGMA table_info({name})")]
+
+    def insert_sql(self, table):
+        """Creates or completes the table, and returns its insert"""
+        key = (table.name, tuple(table.columns))
+        if key in self.inserts:
+            return self.inserts[key]
+
+        existing = self.columns(table.name)
+        wanted = [(c[1], c[2]) for c in table.columns] + [("time_ns", "INTEGER"), ("boot_ns", "INTEGER")]
+        if not existing:
+            cols = ", ".join(f"{n} {t}" for n, t in wanted)
+            self.db.execute(f"CREATE TABLE {table.name} ({cols})")
+        else:
+            for name, sql_type in wanted:
+                if name not in existing:
+                    sql_type = sql_type.replace(" PRIMARY KEY", "")
+                    self.db.execute(f"ALTER TABLE {table.name} ADD COLUMN {name} {sql_type}")
+
+        names = [c[1] for c in table.stored()] + ["time_ns", "boot_ns"]
+        sql = f"INSERT INTO {table.name} ({', '.join(names)}) VALUES ({', '.join('?' * len(names))})"
+        self.inserts[key] = sql
+        return sql
+
+    def store(self, table, rec, values):
+        """Inserts an event"""
+        self.db.execute(self.insert_sql(table), values + [rec[5], rec[6]])
+
+    def commit(self):
+        """Commits the events of a segment"""
+        self.db.commit()
+
+
+def list_segment(seg):
+    """Prints the tables and events of a segment"""
+    state = "full" if seg.footer else "being written"
+    print(f"{seg.path}: segment {seg.seq}, {state}")
+
+    if seg.sums:
+        for first_ns, last_ns, count, table, _ in seg.sums:
+            name = seg.tables[table].name if table in seg.tables else f"table {table}"
+            print(f"    {name}: {count} events, from {first_ns} to {last_ns} ns")
+        return
+
+    counts = {}
+    for table, _, _ in seg.events(0):
+        counts[table.name] = counts.get(table.name, 0) + 1
+    for name, count in sorted(counts.items()):
+        print(f"    {name}: {count} events")
+
+
+def main():
+    """Main program"""
+
+    parser = argparse.ArgumentParser(description=binlog_import_description,
+                                     formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("segments", nargs="+",
+                        help="Segment files, or directories with segments")
+    parser.add_argument("-d", "--database", default="/var/lib/rasdaemon/ras-mc_event.db",
+                        help="Database to import to. Default: /var/lib/rasdaemon/ras-mc_event.db")
+    parser.add_argument("-s", "--since", type=int, default=0,
+                        help="Only import events since this time, in seconds since the epoch")
+    parser.add_argument("-l", "--list", action="store_true",
+                        help="Only list the events at each segment")
+    args = parser.parse_args()
+
+    since_ns = args.since * 1000000000
+    db = None if args.list else Database(args.database)
+
+    for path in segment_paths(args.segments):
+        try:
+            seg = Segment(path)
+        except (OSError, ValueError) as e:
+            print(f"{path}: skipped: {e}", file=sys.stderr)
+            continue
+
+        seg.read_tables()
+
+        if args.list:
+            list_segment(seg)
+            continue
+
+        count = 0
+        for table, rec, values in seg.events(since_ns):
+            db.store(table, rec, values)
+            count += 1
+        db.commit()
+
+        print(f"{path}: imported {count} events")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Microbenchmark of the event field accessors
+ *
+ * Measures the cost of reading the fields of a record, per event, either
+ * looking each field up by name, as tep_get_field_val() does, or with the
+ * field resolved once at registration, as ras_get_field_val() does. All
+ * fields of each event format are read, from a zeroed record.
+ *
+ * The formats are read from tracefs, so it should run as root. It isn't
+ * built nor installed with rasdaemon:
+ *	cc -O2 -o ras-field-bench contrib/ras-field-bench.c \
+ *		$(pkg-config --cflags --libs libtraceevent)
+ *	./ras-field-bench [-n records] [tracefs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <traceevent/event-parse.h>
+#include <unistd.h>
+
+#define DEFAULT_RECORDS		1000000
+#define MAX_FIELDS		64
+
+static const struct {
+	const char *sys;
+	const char *name;
+} events[] = {
+	{ "ras", "mc_event" },
+	{ "mce", "mce_record" },
+	{ "ras", "arm_event" },
+	{ "cxl", "cxl_poison" },
+	{ "cxl", "cxl_aer_uncorrectable_error" },
+	{ "cxl", "cxl_aer_correctable_error" },
+	{ "cxl", "cxl_overflow" },
+	{ "cxl", "cxl_generic_event" },
+	{ "cxl", "cxl_general_media" },
+	{ "cxl", "cxl_dram" },
+	{ "cxl", "cxl_memory_module" },
+};
+
+static unsigned long long sink;
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static char *read_format(const char *tracefs, const char *sys,
+			 const char *name, size_t *size)
+{
+	char path[512];
+	size_t len = 0, alloc = 0;
+	char *buf = NULL, *p;
+	FILE *fp;
+	size_t n;
+
+	snprintf(path, sizeof(path), "%s/events/%s/%s/format", tracefs, sys,
+		 name);
+	fp = fopen(path, "r");
+	if (!fp)
+		return NULL;
+
+	do {
+		if (len == alloc) {
+			alloc += 4096;
+			p = realloc(buf, alloc);
+			if (!p) {
+				free(buf);
+				fclose(fp);
+				return NULL;
+			}
+			buf = p;
+		}
+		n = fread(buf + len, 1, alloc - len, fp);
+		len += n;
+	} while (n);
+	fclose(fp);
+
+	*size = len;
+
+	return buf;
+}
+
+static void read_by_name(struct tep_event *ev, struct tep_format_field **fields,
+			 int nr, struct tep_record *record)
+{
+	unsigned long long val;
+	struct trace_seq s;
+	int i, len;
+
+	trace_seq_init(&s);
+	for (i = 0; i < nr; i++) {
+		if (fields[i]->flags & (TEP_FIELD_IS_ARRAY | TEP_FIELD_IS_DYNAMIC)) {
+			if (tep_get_field_raw(&s, ev, fields[i]->name, record,
+					      &len, 0))
+				sink += len;
+		} else if (!tep_get_field_val(&s, ev, fields[i]->name, record,
+					      &val, 0)) {
+			sink += val;
+		}
+	}
+	trace_seq_destroy(&s);
+}
+
+/* Same as ras_get_field_val() and ras_get_field_raw() */
+static void read_resolved(struct tep_format_field **fields, int nr,
+			  struct tep_record *record)
+{
+	struct tep_format_field *field;
+	unsigned long long val;
+	unsigned int offset;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		field = fields[i];
+		if (field->flags & TEP_FIELD_IS_DYNAMIC) {
+			offset = tep_read_number(field->event->tep,
+						 (char *)record->data + field->offset,
+						 field->size);
+			sink += offset >> 16;
+		} else if (field->flags & TEP_FIELD_IS_ARRAY) {
+			sink += field->size;
+		} else if (!tep_read_number_field(field, record->data, &val)) {
+			sink += val;
+		}
+	}
+}
+
+static void bench(struct tep_handle *tep, const char *tracefs, int i,
+		  long records)
+{
+	struct tep_format_field *fields[MAX_FIELDS], *field;
+	struct tep_record record = { };
+	double start, by_name, resolved;
+	struct tep_event *ev;
+	int nr = 0, size = 0;
+	size_t len;
+	char *buf;
+	long n;
+
+	buf = read_format(tracefs, events[i].sys, events[i].name, &len);
+	if (!buf) {
+		printf("%-28s not available\n", events[i].name);
+		return;
+	}
+	if (tep_parse_event(tep, buf, len, events[i].sys)) {
+		printf("%-28s can't parse its format\n", events[i].name);
+		free(buf);
+		return;
+	}
+	free(buf);
+
+	ev = tep_find_event_by_name(tep, events[i].sys, events[i].name);
+	if (!ev)
+		return;
+
+	for (field = ev->format.fields; field && nr < MAX_FIELDS;
+	     field = field->next) {
+		fields[nr++] = field;
+		if (field->offset + field->size > size)
+			size = field->offset + field->size;
+	}
+
+	/* A zeroed record: dynamic arrays are empty */
+	record.data = calloc(1, size);
+	record.size = size;
+	if (!record.data)
+		return;
+
+	start = now_ns();
+	for (n = 0; n < records; n++)
+		read_by_name(ev, fields, nr, &record);
+	by_name = (now_ns() - start) / records;
+
+	start = now_ns();
+	for (n = 0; n < records; n++)
+		read_resolved(fields, nr, &record);
+	resolved = (now_ns() - start) / records;
+
+	printf("%-28s %3d fields %9.1f ns %9.1f ns %6.1fx\n", events[i].name,
+	       nr, by_name, resolved, resolved ? by_name / resolved : 0);
+
+	free(record.data);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *tracefs = "/sys/kernel/tracing";
+	long records = DEFAULT_RECORDS;
+	struct tep_handle *tep;
+	unsigned int i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			records = strtol(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n records] [tracefs]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (optind < argc)
+		tracefs = argv[optind];
+	if (records <= 0)
+		records = DEFAULT_RECORDS;
+
+	tep = tep_alloc();
+	if (!tep) {
+		fprintf(stderr, "Can't allocate the tep handle\n");
+		return 1;
+	}
+
+	printf("%-28s %10s %12s %12s %7s\n", "event", "", "by name",
+	       "resolved", "speedup");
+	for (i = 0; i < sizeof(events) / sizeof(events[0]); i++)
+		bench(tep, tracefs, i, records);
+
+	tep_free(tep);
+
+	/* Keep the reads from being optimized out */
+	return sink == 1;
+}
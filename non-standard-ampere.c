@@ -470,30 +470,6 @@ static void record_amp_data(struct ras_ns_ev_decoder *ev_decoder,
 	}
 }
 
-static int store_amp_err_data(struct ras_ns_ev_decoder *ev_decoder,
-			      const char *name)
-{
-	int rc;
-
-	rc = sqlite3_step(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do %s step on sqlite: error = %d\n", name, rc);
-
-	rc = sqlite3_reset(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed to reset %s on sqlite: error = %d\n", name, rc);
-
-	rc = sqlite3_clear_bindings(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_OK && rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to clear bindings %s on sqlite: error = %d\n",
-		    name, rc);
-
-	return rc;
-}
-
 /*save all Ampere Specific Error Payload type 0 to sqlite3 database*/
 static void record_amp_payload0_err(struct ras_ns_ev_decoder *ev_decoder,
 				    const char *type_str, const char *subtype_str,
@@ -528,7 +504,8 @@ static void record_amp_payload0_err(struct ras_ns_ev_decoder *ev_decoder,
 		record_amp_data(ev_decoder, AMP_OEM_DATA_TYPE_INT64,
 				AMP_PAYLOAD0_FIELD_MISC3,
 			err->err_misc_3, NULL);
-		store_amp_err_data(ev_decoder, "amp_payload0_event_tab");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "amp_payload0_event_tab");
 	}
 }
 
@@ -578,7 +555,8 @@ static void record_amp_payload1_err(struct ras_ns_ev_decoder *ev_decoder,
 		record_amp_data(ev_decoder, AMP_OEM_DATA_TYPE_INT64,
 				AMP_PAYLOAD1_FIELD_RESERVED2,
 				err->reserved2, NULL);
-		store_amp_err_data(ev_decoder, "amp_payload1_event_tab");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "amp_payload1_event_tab");
 	}
 }
 
@@ -624,7 +602,8 @@ static void record_amp_payload2_err(struct ras_ns_ev_decoder *ev_decoder,
 		record_amp_data(ev_decoder, AMP_OEM_DATA_TYPE_INT64,
 				AMP_PAYLOAD2_FIELD_RESERVED3,
 			err->reserved3, NULL);
-		store_amp_err_data(ev_decoder, "amp_payload2_event_tab");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "amp_payload2_event_tab");
 	}
 }
 
@@ -661,7 +640,8 @@ static void record_amp_payload3_err(struct ras_ns_ev_decoder *ev_decoder,
 		record_amp_data(ev_decoder, AMP_OEM_DATA_TYPE_INT64,
 				AMP_PAYLOAD3_FIELD_FW_SPEC_DATA5,
 			err->fw_speci_data5, NULL);
-		store_amp_err_data(ev_decoder, "amp_payload3_event_tab");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "amp_payload3_event_tab");
 	}
 }
 
@@ -695,11 +675,6 @@ static void record_amp_payload3_err(struct ras_ns_ev_decoder *ev_decoder,
 				    const struct amp_payload3_type_sec *err)
 {
 }
-
-static int store_amp_err_data(struct ras_ns_ev_decoder *ev_decoder, char *name)
-{
-	return 0;
-}
 #endif
 
 /*decode ampere specific error payload type 0, the CPU's data is save*/
@@ -616,32 +616,6 @@ static void record_jm_data(struct ras_ns_ev_decoder *ev_decoder,
 	}
 }
 
-static int store_jm_err_data(struct ras_ns_ev_decoder *ev_decoder,
-			     const char *tab_name)
-{
-	int rc;
-
-	rc = sqlite3_step(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do step on sqlite. Table = %s error = %d\n",
-			tab_name, rc);
-
-	rc = sqlite3_reset(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed to reset on sqlite. Table = %s error = %d\n",
-			tab_name, rc);
-
-	rc = sqlite3_clear_bindings(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_OK && rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to clear bindings on sqlite. Table = %s error = %d\n",
-			tab_name, rc);
-
-	return rc;
-}
-
 /*save all JaguarMicro Specific Error Payload type 0 to sqlite3 database*/
 static void record_jm_payload_err(struct ras_ns_ev_decoder *ev_decoder,
 				  const char *reg_str)
@@ -649,7 +623,8 @@ static void record_jm_payload_err(struct ras_ns_ev_decoder *ev_decoder,
 	if (ev_decoder) {
 		record_jm_data(ev_decoder, JM_OEM_DATA_TYPE_TEXT,
 			       JM_PAYLOAD_FIELD_REGS_DUMP, 0, reg_str);
-		store_jm_err_data(ev_decoder, "jm_payload0_event_tab");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "jm_payload0_event_tab");
 	}
 }
 
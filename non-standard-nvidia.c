@@ -50,24 +50,6 @@ static int nvidia_add_vendor_table(struct ras_events *ras,
 	return rc;
 }
 
-static void nvidia_store_vendor_record(struct ras_ns_ev_decoder *ev_decoder,
-				       const char *label)
-{
-	int rc;
-
-	rc = sqlite3_step(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to store %s event in database: error = %d\n",
-		    label, rc);
-
-	rc = sqlite3_reset(ev_decoder->stmt_dec_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed to reset %s statement: error = %d\n",
-		    label, rc);
-}
-
 #endif  /* HAVE_SQLITE3 */
 
 static const char * const nvidia_reg_names[] = {
@@ -545,6 +527,7 @@ static const struct db_table_descriptor nvidia_ns_table = {
 	.name = "nvidia_ns_event",
 	.fields = nvidia_ns_fields,
 	.num_fields = ARRAY_SIZE(nvidia_ns_fields),
+	.rollup = "signature, socket",
 };
 
 static int nvidia_ns_add_table(struct ras_events *ras,
@@ -599,7 +582,8 @@ static int nvidia_ns_decode(struct ras_events *ras,
 		sqlite3_bind_blob(ev_decoder->stmt_dec_record, 10,
 				  event->error, event->length, SQLITE_TRANSIENT);
 
-		nvidia_store_vendor_record(ev_decoder, "NVIDIA");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "NVIDIA");
 	}
 
 	return 0;
@@ -625,6 +609,7 @@ static const struct db_table_descriptor nvidia_vera_ns_table = {
 	.name = "nvidia_vera_ns_event",
 	.fields = nvidia_vera_ns_fields,
 	.num_fields = ARRAY_SIZE(nvidia_vera_ns_fields),
+	.rollup = "signature, socket",
 };
 
 static int nvidia_vera_ns_add_table(struct ras_events *ras,
@@ -700,7 +685,8 @@ static int nvidia_vera_ns_decode(struct ras_events *ras,
 		sqlite3_bind_blob(ev_decoder->stmt_dec_record, 12,
 				  event->error, event->length, SQLITE_TRANSIENT);
 
-		nvidia_store_vendor_record(ev_decoder, "NVIDIA Vera");
+		ras_mc_store_vendor_record(ev_decoder->stmt_dec_record,
+					   "NVIDIA Vera");
 	}
 
 	return 0;
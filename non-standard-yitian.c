@@ -70,10 +70,10 @@ static const struct yitian_ras_type_info yitian_payload_error_type[] = {
 
 #ifdef HAVE_SQLITE3
 static const struct db_fields yitian_ddr_payload_fields[] = {
-	{ .name = "id",                 .type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",          .type = "TEXT" },
-	{ .name = "address",            .type = "INTEGER" },
-	{ .name = "regs_dump",		    .type = "TEXT" },
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp", struct ras_yitian_ddr_payload_event, timestamp),
+	DB_FIELD_INT("address",	struct ras_yitian_ddr_payload_event, address),
+	DB_FIELD_STR("regs_dump", struct ras_yitian_ddr_payload_event, reg_msg),
 };
 
 static const struct db_table_descriptor yitian_ddr_payload_section_tab = {
@@ -85,26 +85,8 @@ static const struct db_table_descriptor yitian_ddr_payload_section_tab = {
 int record_yitian_ddr_reg_dump_event(struct ras_ns_ev_decoder *ev_decoder,
 				     struct ras_yitian_ddr_payload_event *ev)
 {
-	int rc;
-	struct sqlite3_stmt *stmt = ev_decoder->stmt_dec_record;
-
-	log(TERM, LOG_INFO, "yitian_ddr_reg_dump_event store: %p\n", stmt);
-
-	sqlite3_bind_text(stmt,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_int64(stmt,  2, ev->address);
-	sqlite3_bind_text(stmt,  3, ev->reg_msg, -1, NULL);
-
-	rc = sqlite3_step(stmt);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do yitian_ddr_reg_dump_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(stmt);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset yitian_ddr_reg_dump_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
-
-	return rc;
+	return ras_mc_store_vendor_event(ev_decoder->stmt_dec_record,
+					 &yitian_ddr_payload_section_tab, ev);
 }
 #endif
 
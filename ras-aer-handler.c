@@ -5,6 +5,7 @@
  */
 
 #define _GNU_SOURCE
+#include <errno.h>
 #include <pci/pci.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,7 +17,9 @@
 #include "bitfield.h"
 #include "ras-aer-handler.h"
 #include "ras-logger.h"
-#include "ras-report.h"
+#include "ras-pipeline.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "unified-sel.h"
 #include "trigger.h"
 #include "types.h"
@@ -61,6 +64,8 @@ static bool use_ipmitool = false;
 #define MAX_ENV 30
 static const char *aer_ce_trigger = NULL;
 static const char *aer_ue_trigger = NULL;
+static struct ras_sink aer_trigger_sink;
+static struct ras_sink_queue *aer_trigger_queue;
 
 void aer_event_trigger_setup(void)
 {
@@ -97,6 +102,11 @@ void aer_event_trigger_setup(void)
 			    trigger);
 		}
 	}
+
+	if (aer_ce_trigger || aer_ue_trigger) {
+		aer_trigger_queue = ras_sink_queue_create(aer_trigger_sink.name);
+		ras_sink_register(&aer_trigger_sink);
+	}
 }
 
 void ras_aer_handler_init(int enable_ipmitool)
@@ -147,9 +157,10 @@ free:
 	pci_cleanup(pacc);
 }
 
-static void run_aer_trigger(struct ras_aer_event *ev, const char *aer_trigger)
+static int run_aer_trigger(struct ras_aer_event *ev, const char *aer_trigger)
 {
 	char *env[MAX_ENV];
+	int rc = -ENOMEM;
 	int ei = 0;
 	int i;
 
@@ -166,13 +177,37 @@ static void run_aer_trigger(struct ras_aer_event *ev, const char *aer_trigger)
 	env[ei] = NULL;
 	assert(ei < MAX_ENV);
 
-	run_trigger(aer_trigger, NULL, env, "aer_event");
+	rc = run_trigger(aer_trigger_queue, aer_trigger, NULL, env,
+			 "aer_event");
 
 free:
 	for (i = 0; i < ei; i++)
 		free(env[i]);
+
+	return rc;
 }
 
+static int aer_trigger_emit(struct ras_events *ras,
+			    const struct ras_sink_event *sev)
+{
+	struct ras_aer_event *ev = sev->ev;
+
+	if (aer_ce_trigger && !strcmp(ev->error_type, "Corrected"))
+		return run_aer_trigger(ev, aer_ce_trigger);
+
+	if (aer_ue_trigger && !strncmp(ev->error_type, "Uncorrected", 11))
+		return run_aer_trigger(ev, aer_ue_trigger);
+
+	return 0;
+}
+
+static struct ras_sink aer_trigger_sink = {
+	.name = "aer_trigger",
+	.emit = aer_trigger_emit,
+	.types = BIT_ULL(AER_EVENT),
+	.min_severity = RAS_SEV_CORRECTED,
+};
+
 int ras_aer_event_handler(struct trace_seq *s,
 			  struct tep_record *record,
 			  struct tep_event *event, void *context)
@@ -297,15 +332,7 @@ int ras_aer_event_handler(struct trace_seq *s,
 	}
 	trace_seq_puts(s, ev.error_type);
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_aer_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_aer_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, AER_EVENT, ras_severity_from_str(ev.error_type), &ev);
 
 #ifdef HAVE_AMP_NS_DECODE
 	/*
@@ -340,11 +367,5 @@ int ras_aer_event_handler(struct trace_seq *s,
 			return -1;
 #endif
 
-	if (aer_ce_trigger && !strcmp(ev.error_type, "Corrected"))
-		run_aer_trigger(&ev, aer_ce_trigger);
-
-	if (aer_ue_trigger && !strncmp(ev.error_type, "Uncorrected", 11))
-		run_aer_trigger(&ev, aer_ue_trigger);
-
 	return 0;
 }
@@ -14,8 +14,10 @@
 #include "ras-arm-handler.h"
 #include "ras-cpu-isolation.h"
 #include "ras-logger.h"
+#include "ras-mce-handler.h"
 #include "ras-non-standard-handler.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 #define ARM_ERR_VALID_ERROR_COUNT BIT(0)
@@ -374,6 +376,45 @@ static int parse_arm_processor_err_info(struct trace_seq *s, struct ras_arm_even
 	return 0;
 }
 
+enum {
+	ARM_FIELD_AFFINITY,
+	ARM_FIELD_MPIDR,
+	ARM_FIELD_MIDR,
+	ARM_FIELD_RUNNING_STATE,
+	ARM_FIELD_PSCI_STATE,
+	ARM_FIELD_PEI_LEN,
+	ARM_FIELD_PEI_BUF,
+	ARM_FIELD_BUF,
+	ARM_FIELD_CTX_LEN,
+	ARM_FIELD_CTX_BUF,
+	ARM_FIELD_BUF1,
+	ARM_FIELD_OEM_LEN,
+	ARM_FIELD_OEM_BUF,
+	ARM_FIELD_BUF2,
+	ARM_FIELD_CPU,
+	ARM_FIELD_SEV,
+};
+
+struct ras_field arm_event_tep_fields[] = {
+	[ARM_FIELD_AFFINITY] = RAS_FIELD("affinity"),
+	[ARM_FIELD_MPIDR] = RAS_FIELD("mpidr"),
+	[ARM_FIELD_MIDR] = RAS_FIELD("midr"),
+	[ARM_FIELD_RUNNING_STATE] = RAS_FIELD("running_state"),
+	[ARM_FIELD_PSCI_STATE] = RAS_FIELD("psci_state"),
+	[ARM_FIELD_PEI_LEN] = RAS_FIELD("pei_len"),
+	[ARM_FIELD_PEI_BUF] = RAS_FIELD("pei_buf"),
+	[ARM_FIELD_BUF] = RAS_FIELD("buf"),
+	[ARM_FIELD_CTX_LEN] = RAS_FIELD("ctx_len"),
+	[ARM_FIELD_CTX_BUF] = RAS_FIELD("ctx_buf"),
+	[ARM_FIELD_BUF1] = RAS_FIELD("buf1"),
+	[ARM_FIELD_OEM_LEN] = RAS_FIELD("oem_len"),
+	[ARM_FIELD_OEM_BUF] = RAS_FIELD("oem_buf"),
+	[ARM_FIELD_BUF2] = RAS_FIELD("buf2"),
+	[ARM_FIELD_CPU] = RAS_FIELD("cpu"),
+	[ARM_FIELD_SEV] = RAS_FIELD("sev"),
+	{ }
+};
+
 #ifdef HAVE_CPU_FAULT_ISOLATION
 static int is_core_failure(struct ras_arm_err_info *err_info)
 {
@@ -431,18 +472,19 @@ static int ras_handle_cpu_error(struct trace_seq *s,
 				struct tep_event *event,
 				struct ras_arm_event *ev, time_t now)
 {
+	struct ras_field *f = arm_event_tep_fields;
 	unsigned long long val;
 	int cpu;
 	char *severity;
 	struct error_info err_info;
 
-	if (tep_get_field_val(s, event, "cpu", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_CPU], record, &val, 1) < 0)
 		return -1;
 	cpu = val;
 	trace_seq_printf(s, "\n cpu: %d", cpu);
 
 	/* record cpu error */
-	if (tep_get_field_val(s, event, "sev", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_SEV], record, &val, 1) < 0)
 		return -1;
 	/* refer to UEFI_2_9 specification chapter N2.2 Table N-5 */
 	switch (val) {
@@ -476,10 +518,32 @@ static int ras_handle_cpu_error(struct trace_seq *s,
 }
 #endif
 
+static enum ras_severity arm_severity(struct trace_seq *s,
+				      struct tep_record *record)
+{
+	unsigned long long val;
+
+	if (ras_get_field_val(s, &arm_event_tep_fields[ARM_FIELD_SEV],
+			      record, &val, 0) < 0)
+		return RAS_SEV_INFO;
+
+	switch (val) {
+	case GHES_SEV_NO:
+		return RAS_SEV_INFO;
+	case GHES_SEV_CORRECTED:
+		return RAS_SEV_CORRECTED;
+	case GHES_SEV_RECOVERABLE:
+		return RAS_SEV_UNCORRECTED;
+	default:
+		return RAS_SEV_FATAL;
+	}
+}
+
 int ras_arm_event_handler(struct trace_seq *s,
 			  struct tep_record *record,
 			  struct tep_event *event, void *context)
 {
+	struct ras_field *f = arm_event_tep_fields;
 	unsigned long long val;
 	struct ras_events *ras = context;
 	time_t now;
@@ -511,43 +575,43 @@ int ras_arm_event_handler(struct trace_seq *s,
 			 "%Y-%m-%d %H:%M:%S %z", tm);
 	trace_seq_printf(s, "%s", ev.timestamp);
 
-	if (tep_get_field_val(s, event, "affinity", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_AFFINITY], record, &val, 1) < 0)
 		return -1;
 	ev.affinity = val;
 	trace_seq_printf(s, " affinity: %d", ev.affinity);
 
-	if (tep_get_field_val(s, event, "mpidr", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_MPIDR], record, &val, 1) < 0)
 		return -1;
 	ev.mpidr = val;
 	trace_seq_printf(s, " MPIDR: 0x%llx", (unsigned long long)ev.mpidr);
 
-	if (tep_get_field_val(s, event, "midr", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_MIDR], record, &val, 1) < 0)
 		return -1;
 	ev.midr = val;
 	trace_seq_printf(s, " MIDR: 0x%llx", (unsigned long long)ev.midr);
 
-	if (tep_get_field_val(s, event, "running_state", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_RUNNING_STATE], record, &val, 1) < 0)
 		return -1;
 	ev.running_state = val;
 	trace_seq_printf(s, " running_state: %d", ev.running_state);
 
-	if (tep_get_field_val(s, event, "psci_state", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[ARM_FIELD_PSCI_STATE], record, &val, 1) < 0)
 		return -1;
 	ev.psci_state = val;
 	trace_seq_printf(s, " psci_state: %d", ev.psci_state);
 
 	/* Upstream Kernels up to version 6.10 don't decode UEFI 2.6+ N.17 table */
-	if (tep_get_field_val(s, event, "pei_len", record, &val, 0) >= 0) {
+	if (ras_get_field_val(s, &f[ARM_FIELD_PEI_LEN], record, &val, 0) >= 0) {
 		bool legacy_patch = false;
 
 		ev.pei_len = val;
 		trace_seq_printf(s, " ARM Processor Err Info data len: %d\n",
 				 ev.pei_len);
 
-		ev.pei_error = tep_get_field_raw(s, event, "pei_buf", record, &len, 1);
+		ev.pei_error = ras_get_field_raw(s, &f[ARM_FIELD_PEI_BUF], record, &len, 1);
 		if (!ev.pei_error) {
 			/* Keep support for OOT CPER N.16/N.17 full table patch */
-			ev.pei_error = tep_get_field_raw(s, event, "buf", record, &len, 1);
+			ev.pei_error = ras_get_field_raw(s, &f[ARM_FIELD_BUF], record, &len, 1);
 			if (!ev.pei_error)
 				return -1;
 			legacy_patch = true;
@@ -556,30 +620,30 @@ int ras_arm_event_handler(struct trace_seq *s,
 
 		parse_arm_processor_err_info(s, &ev);
 
-		if (tep_get_field_val(s, event, "ctx_len", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[ARM_FIELD_CTX_LEN], record, &val, 1) < 0)
 			return -1;
 		ev.ctx_len = val;
 		trace_seq_printf(s, " ARM Processor Err Context Info data len: %d\n",
 				 ev.ctx_len);
 
 		if (!legacy_patch)
-			ev.ctx_error = tep_get_field_raw(s, event, "ctx_buf", record, &len, 1);
+			ev.ctx_error = ras_get_field_raw(s, &f[ARM_FIELD_CTX_BUF], record, &len, 1);
 		else
-			ev.ctx_error = tep_get_field_raw(s, event, "buf1", record, &len, 1);
+			ev.ctx_error = ras_get_field_raw(s, &f[ARM_FIELD_BUF1], record, &len, 1);
 		if (!ev.ctx_error)
 			return -1;
 		display_raw_data(s, ev.ctx_error, ev.ctx_len);
 
-		if (tep_get_field_val(s, event, "oem_len", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[ARM_FIELD_OEM_LEN], record, &val, 1) < 0)
 			return -1;
 		ev.oem_len = val;
 		trace_seq_printf(s, " Vendor Specific Err Info data len: %d\n",
 				 ev.oem_len);
 
 		if (!legacy_patch)
-			ev.vsei_error = tep_get_field_raw(s, event, "oem_buf", record, &len, 1);
+			ev.vsei_error = ras_get_field_raw(s, &f[ARM_FIELD_OEM_BUF], record, &len, 1);
 		else
-			ev.vsei_error = tep_get_field_raw(s, event, "buf2", record, &len, 1);
+			ev.vsei_error = ras_get_field_raw(s, &f[ARM_FIELD_BUF2], record, &len, 1);
 		if (!ev.vsei_error)
 			return -1;
 
@@ -596,15 +660,7 @@ int ras_arm_event_handler(struct trace_seq *s,
 #endif
 	}
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_arm_record(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_arm_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, ARM_EVENT, arm_severity(s, record), &ev);
 
 	return 0;
 }
@@ -30,6 +30,8 @@ struct ras_arm_err_info {
 
 #pragma pack()
 
+extern struct ras_field arm_event_tep_fields[];
+
 int ras_arm_event_handler(struct trace_seq *s,
 			  struct tep_record *record,
 			  struct tep_event *event, void *context);
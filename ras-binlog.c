@@ -0,0 +1,785 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Append-only binary event log
+ *
+ * With EVENT_STORAGE=binlog, the events are appended to fixed-size
+ * segment files at BINLOG_DIR, instead of being inserted at the SQLite
+ * database. Segments are mapped into memory, so storing an event only
+ * copies its values into the mapping, and they reach the disk with the
+ * page cache writeback. Uncorrected and fatal errors are synced at once.
+ *
+ * A segment has a header, followed by the records. Each record has its
+ * length and a checksum, so a record torn by a power loss ends the
+ * segment, instead of being read as garbage. The length is written last.
+ * The first record of a table at each segment describes its columns, so
+ * segments can be read without rasdaemon, and imported at the database
+ * by contrib/ras-binlog-import.py.
+ *
+ * Once full, a segment gets a footer, with an index of its events sorted
+ * by time, and the number of events and time range of each table, so
+ * readers can find the events they want without scanning the records.
+ * The segment being written has no footer yet. After a restart, its
+ * records are checked, and new events are appended after the last good
+ * one.
+ *
+ * Values are stored in host byte order.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ras-binlog.h"
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-record.h"
+#include "ras-sink.h"
+#include "ras-stats.h"
+#include "ras-tables.h"
+
+#define EVENT_STORAGE			"EVENT_STORAGE"
+#define BINLOG_DIR			"BINLOG_DIR"
+#define BINLOG_SEGMENT_KB		"BINLOG_SEGMENT_KB"
+#define BINLOG_MAX_SEGMENTS		"BINLOG_MAX_SEGMENTS"
+#define DEFAULT_BINLOG_DIR		RASSTATEDIR "/binlog"
+#define DEFAULT_SEGMENT_KB		4096
+#define MIN_SEGMENT_KB			64
+#define RETRY_SEC			5
+
+#define BINLOG_MAGIC			"RASBLG01"
+#define BINLOG_FOOTER_MAGIC		"RASBIX01"
+#define BINLOG_VERSION			1
+#define BINLOG_SUFFIX			".rbl"
+#define BINLOG_ALIGN			8
+#define BINLOG_MAX_TABLES		64
+
+enum binlog_rec_type {
+	BINLOG_REC_TABLE = 1,		/* Table name and columns */
+	BINLOG_REC_EVENT,		/* Column values */
+};
+
+struct binlog_hdr {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	big_endian;
+	uint64_t	seg_size;
+	uint64_t	seq;
+	uint64_t	created_ns;	/* CLOCK_REALTIME */
+	uint64_t	footer_offset;	/* 0 while being written */
+	uint64_t	reserved[2];
+};
+
+struct binlog_rec {
+	uint32_t	len;		/* Of the header and payload */
+	uint32_t	crc;		/* From .type to the end of the payload */
+	uint16_t	type;
+	uint16_t	table;		/* Index of the table at the segment */
+	uint32_t	reserved;
+	uint64_t	time_ns;	/* Event time, at the wall clock */
+	uint64_t	boot_ns;	/* Event time, since boot */
+};
+
+struct binlog_index {
+	uint64_t	time_ns;
+	uint32_t	offset;		/* Of the record at the segment */
+	uint16_t	table;
+	uint16_t	reserved;
+};
+
+struct binlog_table_sum {
+	uint64_t	first_ns;
+	uint64_t	last_ns;
+	uint32_t	count;
+	uint16_t	table;
+	uint16_t	reserved;
+};
+
+struct binlog_footer {
+	char		magic[8];
+	uint64_t	index_offset;
+	uint64_t	tables_offset;
+	uint32_t	n_index;	/* Sorted by time */
+	uint32_t	n_tables;
+	uint32_t	crc;		/* Of the index and table summaries */
+	uint32_t	reserved;
+};
+
+/* Room needed by the footer, besides one index entry per event */
+#define FOOTER_SPACE	(BINLOG_MAX_TABLES * sizeof(struct binlog_table_sum) + \
+			 sizeof(struct binlog_footer))
+
+/* Only used by the event decoder thread */
+static struct {
+	char				*dir;
+	uint64_t			seg_size;
+	unsigned int			max_segments;
+	long				page_size;
+
+	/* Segment being written */
+	int				fd;
+	char				*seg;
+	uint64_t			seq;
+	uint64_t			first_seq;
+	uint64_t			end;
+	const struct db_table_descriptor *tables[BINLOG_MAX_TABLES];
+	struct binlog_table_sum		sums[BINLOG_MAX_TABLES];
+	unsigned int			n_tables;
+	struct binlog_index		*index;
+	unsigned int			n_index;
+	unsigned int			index_size;
+
+	/* Without a segment, e.g. on a full disk */
+	uint64_t			dropped;
+	time_t				retry_sec;
+} blog = {
+	.fd = -1,
+};
+
+static uint32_t rec_crc(const struct binlog_rec *rec, size_t len)
+{
+	size_t skip = offsetof(struct binlog_rec, type);
+
+	return ras_crc32(0, (const char *)rec + skip, len - skip);
+}
+
+static uint64_t align_up(uint64_t val)
+{
+	return (val + BINLOG_ALIGN - 1) & ~(uint64_t)(BINLOG_ALIGN - 1);
+}
+
+static bool host_is_big_endian(void)
+{
+	uint16_t val = 1;
+
+	return *(uint8_t *)&val == 0;
+}
+
+bool ras_binlog_configured(void)
+{
+	char *env = getenv(EVENT_STORAGE);
+
+	return env && !strcasecmp(env, "binlog");
+}
+
+/* Opened, even if its segment couldn't be created */
+bool ras_binlog_active(void)
+{
+	return blog.dir;
+}
+
+static void segment_path(char *path, size_t size, uint64_t seq)
+{
+	snprintf(path, size, "%s/%016" PRIu64 BINLOG_SUFFIX, blog.dir, seq);
+}
+
+/*
+ * Segment footer
+ */
+
+static int cmp_index(const void *a, const void *b)
+{
+	const struct binlog_index *ia = a, *ib = b;
+
+	if (ia->time_ns != ib->time_ns)
+		return ia->time_ns < ib->time_ns ? -1 : 1;
+
+	return ia->offset < ib->offset ? -1 : ia->offset > ib->offset;
+}
+
+static void segment_seal(void)
+{
+	struct binlog_hdr *hdr = (struct binlog_hdr *)blog.seg;
+	struct binlog_footer *footer;
+	size_t index_len, sums_len;
+	uint64_t off;
+
+	qsort(blog.index, blog.n_index, sizeof(*blog.index), cmp_index);
+
+	index_len = blog.n_index * sizeof(*blog.index);
+	sums_len = blog.n_tables * sizeof(*blog.sums);
+
+	off = align_up(blog.end);
+	memcpy(blog.seg + off, blog.index, index_len);
+	memcpy(blog.seg + off + index_len, blog.sums, sums_len);
+
+	footer = (struct binlog_footer *)(blog.seg + off + index_len + sums_len);
+	memcpy(footer->magic, BINLOG_FOOTER_MAGIC, sizeof(footer->magic));
+	footer->index_offset = off;
+	footer->tables_offset = off + index_len;
+	footer->n_index = blog.n_index;
+	footer->n_tables = blog.n_tables;
+	footer->crc = ras_crc32(0, blog.seg + off, index_len + sums_len);
+
+	hdr->footer_offset = (char *)footer - blog.seg;
+}
+
+static void segment_close(bool seal)
+{
+	if (!blog.seg)
+		return;
+
+	if (seal)
+		segment_seal();
+
+	if (msync(blog.seg, blog.seg_size, seal ? MS_ASYNC : MS_SYNC))
+		log(ALL, LOG_ERR, "Can't sync the event log: %s\n",
+		    strerror(errno));
+
+	munmap(blog.seg, blog.seg_size);
+	close(blog.fd);
+	blog.seg = NULL;
+	blog.fd = -1;
+}
+
+/*
+ * Segment files
+ */
+
+static int segment_map(const char *path, int flags)
+{
+	struct stat st;
+
+	blog.fd = open(path, O_RDWR | O_CLOEXEC | flags, 0600);
+	if (blog.fd < 0)
+		return -errno;
+
+	if (flags & O_CREAT) {
+		/* Allocated now, so a full disk can't fault the mapping later */
+		errno = posix_fallocate(blog.fd, 0, blog.seg_size);
+		if (errno)
+			goto error;
+	} else if (fstat(blog.fd, &st) || st.st_size != blog.seg_size) {
+		errno = EINVAL;
+		goto error;
+	}
+
+	blog.seg = mmap(NULL, blog.seg_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, blog.fd, 0);
+	if (blog.seg == MAP_FAILED) {
+		blog.seg = NULL;
+		goto error;
+	}
+
+	blog.n_tables = 0;
+	blog.n_index = 0;
+	blog.end = sizeof(struct binlog_hdr);
+
+	return 0;
+
+error:
+	close(blog.fd);
+	blog.fd = -1;
+	if (flags & O_CREAT)
+		unlink(path);
+
+	return -errno;
+}
+
+static void segment_expire(void)
+{
+	char path[PATH_MAX];
+
+	if (!blog.max_segments)
+		return;
+
+	while (blog.seq - blog.first_seq >= blog.max_segments) {
+		segment_path(path, sizeof(path), blog.first_seq++);
+		if (unlink(path) && errno != ENOENT)
+			log(ALL, LOG_WARNING, "Can't remove %s: %s\n",
+			    path, strerror(errno));
+	}
+}
+
+static int segment_create(uint64_t seq)
+{
+	struct binlog_hdr *hdr;
+	struct timespec ts;
+	char path[PATH_MAX];
+	int rc;
+
+	segment_path(path, sizeof(path), seq);
+	rc = segment_map(path, O_CREAT | O_EXCL);
+	if (rc) {
+		log(ALL, LOG_ERR, "Can't create event log %s: %s\n",
+		    path, strerror(-rc));
+		return rc;
+	}
+	blog.seq = seq;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	hdr = (struct binlog_hdr *)blog.seg;
+	memcpy(hdr->magic, BINLOG_MAGIC, sizeof(hdr->magic));
+	hdr->version = BINLOG_VERSION;
+	hdr->big_endian = host_is_big_endian();
+	hdr->seg_size = blog.seg_size;
+	hdr->seq = seq;
+	hdr->created_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+	segment_expire();
+
+	return 0;
+}
+
+static int index_add(uint64_t time_ns, uint64_t offset, uint16_t table)
+{
+	struct binlog_index *index;
+	unsigned int size;
+
+	if (blog.n_index == blog.index_size) {
+		size = blog.index_size ? blog.index_size * 2 : 1024;
+		index = realloc(blog.index, size * sizeof(*index));
+		if (!index)
+			return -ENOMEM;
+		blog.index = index;
+		blog.index_size = size;
+	}
+
+	index = &blog.index[blog.n_index++];
+	index->time_ns = time_ns;
+	index->offset = offset;
+	index->table = table;
+	index->reserved = 0;
+
+	return 0;
+}
+
+static void sum_add(uint16_t table, uint64_t time_ns)
+{
+	struct binlog_table_sum *sum = &blog.sums[table];
+
+	if (!sum->count || time_ns < sum->first_ns)
+		sum->first_ns = time_ns;
+	if (time_ns > sum->last_ns)
+		sum->last_ns = time_ns;
+	sum->count++;
+}
+
+/*
+ * Checks the records of a segment left without footer, rebuilding its
+ * index, and returns the offset after the last good record. The table
+ * descriptors aren't known yet, so a table record is written again the
+ * next time each table is stored.
+ */
+static int segment_recover(uint64_t seq)
+{
+	struct binlog_hdr *hdr = (struct binlog_hdr *)blog.seg;
+	struct binlog_rec *rec;
+	unsigned int n_tables = 0;
+	int rc;
+
+	if (memcmp(hdr->magic, BINLOG_MAGIC, sizeof(hdr->magic)) ||
+	    hdr->version != BINLOG_VERSION || hdr->seq != seq)
+		return -EINVAL;
+
+	while (blog.end + sizeof(*rec) <= blog.seg_size) {
+		rec = (struct binlog_rec *)(blog.seg + blog.end);
+		if (rec->len < sizeof(*rec) ||
+		    rec->len > blog.seg_size - blog.end ||
+		    rec->crc != rec_crc(rec, rec->len))
+			break;
+
+		if (rec->type == BINLOG_REC_TABLE) {
+			if (rec->table != n_tables || n_tables == BINLOG_MAX_TABLES)
+				break;
+			memset(&blog.sums[n_tables], 0, sizeof(*blog.sums));
+			blog.sums[n_tables].table = n_tables;
+			n_tables++;
+		} else if (rec->table < n_tables) {
+			rc = index_add(rec->time_ns, blog.end, rec->table);
+			if (rc)
+				return rc;
+			sum_add(rec->table, rec->time_ns);
+		}
+
+		blog.end = align_up(blog.end + rec->len);
+	}
+
+	/* Clear whatever a torn write left after the last good record */
+	if (blog.end < blog.seg_size)
+		memset(blog.seg + blog.end, 0, blog.seg_size - blog.end);
+
+	/*
+	 * New table records can't reuse the indexes of the old ones, so keep
+	 * them at the summaries, but with no descriptor.
+	 */
+	blog.n_tables = n_tables;
+	memset(blog.tables, 0, sizeof(blog.tables));
+
+	return 0;
+}
+
+/* Finds the first and last segments, and reopens the last one */
+static int segment_resume(void)
+{
+	struct binlog_hdr *hdr;
+	struct dirent *de;
+	char path[PATH_MAX];
+	uint64_t seq, last = 0;
+	bool found = false;
+	char *end;
+	DIR *dir;
+	int rc;
+
+	dir = opendir(blog.dir);
+	if (!dir)
+		return -errno;
+
+	blog.first_seq = UINT64_MAX;
+	while ((de = readdir(dir))) {
+		seq = strtoull(de->d_name, &end, 10);
+		if (end == de->d_name || strcmp(end, BINLOG_SUFFIX))
+			continue;
+		if (seq < blog.first_seq)
+			blog.first_seq = seq;
+		if (!found || seq > last)
+			last = seq;
+		found = true;
+	}
+	closedir(dir);
+
+	if (!found) {
+		blog.first_seq = 0;
+		return segment_create(0);
+	}
+
+	segment_path(path, sizeof(path), last);
+	rc = segment_map(path, 0);
+	if (!rc) {
+		hdr = (struct binlog_hdr *)blog.seg;
+		blog.seq = last;
+		if (!hdr->footer_offset && !segment_recover(last)) {
+			segment_expire();
+			log(ALL, LOG_INFO, "Appending to event log %s, with %u events\n",
+			    path, blog.n_index);
+			return 0;
+		}
+		segment_close(false);
+	}
+
+	return segment_create(last + 1);
+}
+
+int ras_binlog_open(void)
+{
+	char *env = getenv(BINLOG_DIR);
+	int rc;
+
+	blog.dir = strdup(env && *env ? env : DEFAULT_BINLOG_DIR);
+	if (!blog.dir)
+		return -ENOMEM;
+
+	blog.seg_size = get_env_uint(BINLOG_SEGMENT_KB, DEFAULT_SEGMENT_KB);
+	if (blog.seg_size < MIN_SEGMENT_KB)
+		blog.seg_size = MIN_SEGMENT_KB;
+	blog.seg_size <<= 10;
+	blog.max_segments = get_env_uint(BINLOG_MAX_SEGMENTS, 0);
+	blog.page_size = sysconf(_SC_PAGESIZE);
+
+	/* The default directory is inside the state directory */
+	mkdir(RASSTATEDIR, 0700);
+	if (mkdir(blog.dir, 0700) && errno != EEXIST) {
+		rc = -errno;
+		log(ALL, LOG_ERR, "Can't create event log directory %s: %s\n",
+		    blog.dir, strerror(errno));
+		goto error;
+	}
+
+	rc = segment_resume();
+	if (rc)
+		goto error;
+
+	log(ALL, LOG_INFO, "Storing events at %s, in segments of %" PRIu64 " kB\n",
+	    blog.dir, blog.seg_size >> 10);
+
+	return 0;
+
+error:
+	free(blog.dir);
+	blog.dir = NULL;
+
+	return rc;
+}
+
+void ras_binlog_close(void)
+{
+	segment_close(false);
+
+	if (blog.dropped)
+		log(ALL, LOG_WARNING,
+		    "Dropped %" PRIu64 " events, with no event log segment\n",
+		    blog.dropped);
+	blog.dropped = 0;
+	blog.retry_sec = 0;
+
+	free(blog.index);
+	free(blog.dir);
+	blog.index = NULL;
+	blog.index_size = 0;
+	blog.dir = NULL;
+}
+
+/*
+ * Records
+ */
+
+static int segment_next(void)
+{
+	segment_close(true);
+
+	return segment_create(blog.seq + 1);
+}
+
+/*
+ * Once a new segment couldn't be created, events are dropped until one
+ * can. Retried by the next event, but at most every RETRY_SEC.
+ */
+static int segment_retry(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec < blog.retry_sec)
+		return -EIO;
+	blog.retry_sec = now.tv_sec + RETRY_SEC;
+
+	if (segment_create(blog.seq + 1))
+		return -EIO;
+
+	log(ALL, LOG_INFO, "Event log resumed, after dropping %" PRIu64 " events\n",
+	    blog.dropped);
+	blog.dropped = 0;
+
+	return 0;
+}
+
+/*
+ * Returns room for a record of @len bytes at the segment, or NULL if it
+ * is full. @event records also need room for their index entry.
+ */
+static struct binlog_rec *rec_alloc(size_t len, bool event)
+{
+	uint64_t need;
+
+	need = align_up(blog.end + len) +
+	       (blog.n_index + event) * sizeof(struct binlog_index) +
+	       FOOTER_SPACE;
+	if (need > blog.seg_size)
+		return NULL;
+
+	return (struct binlog_rec *)(blog.seg + blog.end);
+}
+
+/* Makes the record visible to readers, and moves past it */
+static void rec_commit(struct binlog_rec *rec, size_t len)
+{
+	rec->crc = rec_crc(rec, len);
+	__atomic_store_n(&rec->len, len, __ATOMIC_RELEASE);
+
+	blog.end = align_up(blog.end + len);
+}
+
+/* Returns the index of the table at the segment, adding it if new */
+static int table_get(const struct db_table_descriptor *tab)
+{
+	struct binlog_rec *rec;
+	unsigned int i, idx;
+	size_t len;
+
+	for (i = 0; i < blog.n_tables; i++)
+		if (blog.tables[i] == tab)
+			return i;
+
+	if (blog.n_tables == BINLOG_MAX_TABLES)
+		return -ENOSPC;
+
+	len = sizeof(*rec) + ras_table_desc_len(tab);
+
+	rec = rec_alloc(len, false);
+	if (!rec) {
+		if (segment_next())
+			return -EIO;
+		rec = rec_alloc(len, false);
+		if (!rec)
+			return -ENOSPC;
+	}
+
+	idx = blog.n_tables;
+
+	memset(rec, 0, sizeof(*rec));
+	rec->type = BINLOG_REC_TABLE;
+	rec->table = idx;
+
+	ras_table_desc(tab, (char *)(rec + 1));
+	rec_commit(rec, len);
+
+	blog.tables[idx] = tab;
+	memset(&blog.sums[idx], 0, sizeof(*blog.sums));
+	blog.sums[idx].table = idx;
+	blog.n_tables++;
+
+	return idx;
+}
+
+static void sync_rec(const struct binlog_rec *rec)
+{
+	uintptr_t start = (uintptr_t)rec & ~(uintptr_t)(blog.page_size - 1);
+
+	if (msync((void *)start, (uintptr_t)rec + rec->len - start, MS_SYNC))
+		log(ALL, LOG_ERR, "Can't sync the event log: %s\n",
+		    strerror(errno));
+}
+
+/*
+ * Appends the columns of @tab, taken from the event struct @ev, as
+ * ras_store_event() would insert them at the database.
+ */
+int ras_binlog_store(const struct db_table_descriptor *tab, const void *ev,
+		     uint64_t time_ns, uint64_t boot_ns, bool urgent)
+{
+	struct binlog_rec *rec;
+	size_t len;
+	int table;
+
+	if (!blog.seg && segment_retry()) {
+		table = -EIO;
+		goto error;
+	}
+
+	len = sizeof(*rec) + ras_event_packed_len(tab, ev);
+	if (len > blog.seg_size / 4) {
+		table = -E2BIG;
+		goto error;
+	}
+
+	table = table_get(tab);
+	if (table < 0)
+		goto error;
+
+	rec = rec_alloc(len, true);
+	if (!rec) {
+		/* The new segment needs the table record again */
+		if (segment_next()) {
+			table = -EIO;
+			goto error;
+		}
+		table = table_get(tab);
+		if (table < 0)
+			goto error;
+		rec = rec_alloc(len, true);
+		if (!rec) {
+			table = -ENOSPC;
+			goto error;
+		}
+	}
+
+	if (index_add(time_ns, (char *)rec - blog.seg, table)) {
+		table = -ENOMEM;
+		goto error;
+	}
+	sum_add(table, time_ns);
+
+	memset(rec, 0, sizeof(*rec));
+	rec->type = BINLOG_REC_EVENT;
+	rec->table = table;
+	rec->time_ns = time_ns;
+	rec->boot_ns = boot_ns;
+
+	ras_event_pack(tab, ev, (char *)(rec + 1));
+	rec_commit(rec, len);
+
+	if (urgent)
+		sync_rec(rec);
+
+	return 0;
+
+error:
+	if (!blog.seg) {
+		if (!blog.dropped++)
+			log(ALL, LOG_ERR,
+			    "No event log segment: dropping events until one can be created\n");
+		return table;
+	}
+
+	log(TERM, LOG_ERR, "Can't store %s at the event log: %s\n",
+	    tab->name, strerror(-table));
+
+	return table;
+}
+
+#ifndef HAVE_SQLITE3
+
+/*
+ * Without SQLite, the events are always stored at the event log
+ */
+
+static int binlog_sink_emit(struct ras_events *ras,
+			    const struct ras_sink_event *ev)
+{
+	const struct db_table_descriptor *tab = ras_event_table(ev->type);
+	uint64_t boot_ns, wall_ns;
+	int rc;
+
+	if (!tab || !ras_binlog_active())
+		return 0;
+
+	ras_db_event_time(&boot_ns, &wall_ns);
+	rc = ras_binlog_store(tab, ev->ev, wall_ns, boot_ns,
+			      ev->severity >= RAS_SEV_UNCORRECTED);
+	if (rc)
+		ras_stats_drop(RAS_DROP_DB, -1, ev->type, 1);
+
+	return rc;
+}
+
+static struct ras_sink binlog_sink = {
+	.name = "storage",
+	.emit = binlog_sink_emit,
+	.types = RAS_SINK_ALL_EVENTS,
+};
+
+int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras)
+{
+	if (ras->db_ref_count++)
+		return 0;
+
+	ras_sink_register(&binlog_sink);
+
+	return ras_binlog_open() ? -1 : 0;
+}
+
+int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras)
+{
+	if (!ras->db_ref_count || --ras->db_ref_count)
+		return 0;
+
+	ras_binlog_close();
+
+	return 0;
+}
+
+/* Failing to store the losses isn't counted as a loss */
+int ras_store_lost_event(struct ras_events *ras, struct ras_lost_event *ev)
+{
+	uint64_t boot_ns, wall_ns;
+
+	if (!ras_binlog_active())
+		return 0;
+
+	ras_db_event_time(&boot_ns, &wall_ns);
+
+	return ras_binlog_store(&lost_event_tab, ev, wall_ns, boot_ns, false);
+}
+
+#endif
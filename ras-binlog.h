@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Append-only binary event log, an alternative to the SQLite database
+ */
+
+#ifndef __RAS_BINLOG_H
+#define __RAS_BINLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct db_table_descriptor;
+
+bool ras_binlog_configured(void);
+bool ras_binlog_active(void);
+int ras_binlog_open(void);
+int ras_binlog_store(const struct db_table_descriptor *tab, const void *ev,
+		     uint64_t time_ns, uint64_t boot_ns, bool urgent);
+void ras_binlog_close(void);
+
+#endif
@@ -0,0 +1,440 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Capture of the raw trace buffers, and replay of the captured data
+ *
+ * A capture file has the tracepoint formats used by rasdaemon, followed
+ * by the sub-buffers read from the per-CPU trace_pipe_raw, exactly as
+ * the Kernel wrote them. Replaying it feeds the sub-buffers to the same
+ * kbuffer, libtraceevent and handler code used with a live Kernel,
+ * either as fast as possible or with the captured timing.
+ *
+ * The sub-buffers are stored in host byte order, so captures can only
+ * be replayed on machines with the same endianness and long size.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ras-capture.h"
+#include "ras-events.h"
+#include "ras-logger.h"
+
+#define CAPTURE_MAGIC		"RASCAP01"
+#define CAPTURE_MAX_REC		(1024 * 1024)
+
+enum capture_rec_type {
+	CAPTURE_HEADER_PAGE,
+	CAPTURE_FORMAT,
+	CAPTURE_PAGE,
+};
+
+struct capture_hdr {
+	char		magic[8];
+	uint32_t	page_size;
+	uint32_t	long_size;
+	uint32_t	big_endian;
+	uint32_t	use_uptime;
+	int64_t		uptime_diff;
+};
+
+struct capture_rec {
+	uint32_t	type;
+	uint32_t	len;		/* Of the payload after this header */
+	uint64_t	time;		/* CLOCK_MONOTONIC, in ns */
+	int32_t		cpu;
+	uint32_t	reserved;
+};
+
+struct capture_format {
+	char		*group;
+	char		*event;
+	char		*buf;
+	int		size;
+};
+
+static struct {
+	FILE			*fp;
+	pthread_mutex_t		lock;
+
+	/* Replay */
+	bool			replay;
+	bool			realtime;
+	struct capture_rec	next;
+	bool			has_next;
+	char			*page;
+	char			*header_page;
+	int			header_page_size;
+	struct capture_format	*formats;
+	unsigned int		n_formats;
+	uint64_t		first_time;
+	struct timespec		start;
+} cap = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool host_is_big_endian(void)
+{
+	uint16_t val = 1;
+
+	return *(uint8_t *)&val == 0;
+}
+
+/*
+ * Capture
+ */
+
+int ras_capture_open(const char *path)
+{
+	cap.fp = fopen(path, "w");
+	if (!cap.fp) {
+		log(ALL, LOG_ERR, "Can't create capture file %s: %s\n",
+		    path, strerror(errno));
+		return -errno;
+	}
+
+	log(ALL, LOG_INFO, "Capturing the trace buffers at %s\n", path);
+
+	return 0;
+}
+
+bool ras_capturing(void)
+{
+	return cap.fp && !cap.replay;
+}
+
+static void capture_write(uint32_t type, int cpu, const void *a, int a_len,
+			  const void *b, int b_len)
+{
+	struct capture_rec rec = {
+		.type = type,
+		.len = a_len + b_len,
+		.time = now_ns(),
+		.cpu = cpu,
+	};
+
+	pthread_mutex_lock(&cap.lock);
+	/* Closed meanwhile */
+	if (!cap.fp) {
+		pthread_mutex_unlock(&cap.lock);
+		return;
+	}
+
+	if (fwrite(&rec, sizeof(rec), 1, cap.fp) != 1 ||
+	    fwrite(a, 1, a_len, cap.fp) != a_len ||
+	    (b_len && fwrite(b, 1, b_len, cap.fp) != b_len)) {
+		log(ALL, LOG_ERR, "Can't write to the capture file. Stop capturing\n");
+		fclose(cap.fp);
+		cap.fp = NULL;
+	}
+	pthread_mutex_unlock(&cap.lock);
+}
+
+int ras_capture_start(struct ras_events *ras)
+{
+	struct capture_hdr hdr = {
+		.magic = CAPTURE_MAGIC,
+		.page_size = ras->page_size ? ras->page_size : 4096,
+		.long_size = sizeof(long),
+		.big_endian = host_is_big_endian(),
+		.use_uptime = ras->use_uptime,
+		.uptime_diff = ras->uptime_diff,
+	};
+
+	if (!ras_capturing())
+		return 0;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, cap.fp) != 1) {
+		log(ALL, LOG_ERR, "Can't write to the capture file\n");
+		ras_capture_close();
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void ras_capture_header_page(const char *buf, int size)
+{
+	if (ras_capturing())
+		capture_write(CAPTURE_HEADER_PAGE, -1, buf, size, NULL, 0);
+}
+
+/* Payload: "<group>\0<event>\0<format>" */
+void ras_capture_format(const char *group, const char *event,
+			const char *buf, int size)
+{
+	char name[256];
+	int len;
+
+	if (!ras_capturing())
+		return;
+
+	len = snprintf(name, sizeof(name), "%s%c%s", group, '\0', event) + 1;
+	if (len > sizeof(name))
+		return;
+
+	capture_write(CAPTURE_FORMAT, -1, name, len, buf, size);
+}
+
+/* Called by the reader threads, for each sub-buffer read */
+void ras_capture_page(int cpu, const void *page, int size)
+{
+	if (ras_capturing())
+		capture_write(CAPTURE_PAGE, cpu, page, size, NULL, 0);
+}
+
+void ras_capture_close(void)
+{
+	if (!ras_capturing())
+		return;
+
+	pthread_mutex_lock(&cap.lock);
+	if (cap.fp && fclose(cap.fp))
+		log(ALL, LOG_ERR, "Can't write to the capture file\n");
+	cap.fp = NULL;
+	pthread_mutex_unlock(&cap.lock);
+}
+
+/*
+ * Replay
+ */
+
+int ras_replay_open(const char *path, bool realtime)
+{
+	cap.fp = fopen(path, "r");
+	if (!cap.fp) {
+		log(ALL, LOG_ERR, "Can't open capture file %s: %s\n",
+		    path, strerror(errno));
+		return -errno;
+	}
+	cap.replay = true;
+	cap.realtime = realtime;
+
+	return 0;
+}
+
+/*
+ * A replayed capture is about another machine, so nothing is done to the
+ * local one: no page, row or CPU isolation, triggers nor ABRT reports.
+ */
+bool ras_replaying(void)
+{
+	return cap.replay;
+}
+
+static int read_rec(struct capture_rec *rec)
+{
+	if (fread(rec, sizeof(*rec), 1, cap.fp) != 1)
+		return feof(cap.fp) ? 0 : -EIO;
+
+	if (rec->len > CAPTURE_MAX_REC) {
+		log(ALL, LOG_ERR, "Invalid capture record\n");
+		return -EINVAL;
+	}
+
+	return 1;
+}
+
+static int add_format(char *payload, int len)
+{
+	struct capture_format *f;
+	char *event, *buf;
+
+	event = memchr(payload, '\0', len);
+	if (!event++ || event >= payload + len)
+		return -EINVAL;
+	buf = memchr(event, '\0', payload + len - event);
+	if (!buf++)
+		return -EINVAL;
+
+	f = realloc(cap.formats, (cap.n_formats + 1) * sizeof(*f));
+	if (!f)
+		return -ENOMEM;
+	cap.formats = f;
+
+	f = &cap.formats[cap.n_formats++];
+	f->group = payload;
+	f->event = event;
+	f->buf = buf;
+	f->size = payload + len - buf;
+
+	return 0;
+}
+
+/* Read the capture header, and everything up to the first sub-buffer */
+int ras_replay_start(struct ras_events *ras)
+{
+	struct capture_hdr hdr;
+	struct capture_rec rec;
+	char *payload;
+	int rc;
+
+	if (fread(&hdr, sizeof(hdr), 1, cap.fp) != 1 ||
+	    memcmp(hdr.magic, CAPTURE_MAGIC, sizeof(hdr.magic))) {
+		log(ALL, LOG_ERR, "Not a rasdaemon capture file\n");
+		return -EINVAL;
+	}
+
+	if (hdr.long_size != sizeof(long) ||
+	    hdr.big_endian != host_is_big_endian()) {
+		log(ALL, LOG_ERR,
+		    "Capture file is from a machine with a different word size or endianness\n");
+		return -EINVAL;
+	}
+
+	ras->use_uptime = hdr.use_uptime;
+	ras->uptime_diff = hdr.uptime_diff;
+
+	while ((rc = read_rec(&rec)) > 0) {
+		if (rec.type == CAPTURE_PAGE) {
+			cap.next = rec;
+			cap.has_next = true;
+			break;
+		}
+
+		payload = malloc(rec.len + 1);
+		if (!payload)
+			return -ENOMEM;
+		if (fread(payload, 1, rec.len, cap.fp) != rec.len) {
+			free(payload);
+			return -EIO;
+		}
+		payload[rec.len] = '\0';
+
+		if (rec.type == CAPTURE_HEADER_PAGE) {
+			free(cap.header_page);
+			cap.header_page = payload;
+			cap.header_page_size = rec.len;
+		} else if (rec.type != CAPTURE_FORMAT ||
+			   add_format(payload, rec.len)) {
+			free(payload);
+		}
+	}
+	if (rc < 0)
+		return rc;
+
+	cap.page = malloc(CAPTURE_MAX_REC);
+	if (!cap.page)
+		return -ENOMEM;
+
+	log(ALL, LOG_INFO, "Replaying %u tracepoint formats%s\n",
+	    cap.n_formats, cap.realtime ? " with the captured timing" : "");
+
+	return 0;
+}
+
+const char *ras_replay_header_page(int *size)
+{
+	*size = cap.header_page_size;
+
+	return cap.header_page;
+}
+
+const char *ras_replay_format(const char *group, const char *event,
+			      int *size)
+{
+	unsigned int i;
+
+	for (i = 0; i < cap.n_formats; i++) {
+		if (!strcmp(cap.formats[i].group, group) &&
+		    !strcmp(cap.formats[i].event, event)) {
+			*size = cap.formats[i].size;
+			return cap.formats[i].buf;
+		}
+	}
+
+	return NULL;
+}
+
+/* Wait until the time the sub-buffer was read, relative to the first one */
+static void replay_wait(uint64_t time)
+{
+	struct timespec ts;
+	uint64_t delta;
+
+	if (!cap.first_time) {
+		cap.first_time = time;
+		clock_gettime(CLOCK_MONOTONIC, &cap.start);
+		return;
+	}
+
+	delta = time - cap.first_time;
+	ts.tv_sec = cap.start.tv_sec + delta / 1000000000ULL;
+	ts.tv_nsec = cap.start.tv_nsec + delta % 1000000000ULL;
+	if (ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+}
+
+/*
+ * Returns the next captured sub-buffer. Returns 1 on success, 0 at the end
+ * of the capture, or a negative error code.
+ */
+int ras_replay_next_page(int *cpu, void **page, int *size)
+{
+	struct capture_rec rec;
+	int rc;
+
+	do {
+		if (cap.has_next) {
+			rec = cap.next;
+			cap.has_next = false;
+		} else {
+			rc = read_rec(&rec);
+			if (rc <= 0)
+				return rc;
+		}
+
+		if (fread(cap.page, 1, rec.len, cap.fp) != rec.len)
+			return -EIO;
+	} while (rec.type != CAPTURE_PAGE);
+
+	if (cap.realtime)
+		replay_wait(rec.time);
+
+	*cpu = rec.cpu;
+	*page = cap.page;
+	*size = rec.len;
+
+	return 1;
+}
+
+void ras_replay_close(void)
+{
+	unsigned int i;
+
+	if (!cap.replay)
+		return;
+
+	for (i = 0; i < cap.n_formats; i++)
+		free(cap.formats[i].group);
+	free(cap.formats);
+	free(cap.header_page);
+	free(cap.page);
+	fclose(cap.fp);
+
+	cap.fp = NULL;
+	cap.replay = false;
+	cap.formats = NULL;
+	cap.n_formats = 0;
+	cap.header_page = NULL;
+	cap.page = NULL;
+}
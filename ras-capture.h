@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Capture of the raw trace buffers, and replay of the captured data
+ */
+
+#ifndef __RAS_CAPTURE_H
+#define __RAS_CAPTURE_H
+
+#include <stdbool.h>
+
+struct ras_events;
+
+int ras_capture_open(const char *path);
+bool ras_capturing(void);
+int ras_capture_start(struct ras_events *ras);
+void ras_capture_header_page(const char *buf, int size);
+void ras_capture_format(const char *group, const char *event,
+			const char *buf, int size);
+void ras_capture_page(int cpu, const void *page, int size);
+void ras_capture_close(void);
+
+int ras_replay_open(const char *path, bool realtime);
+bool ras_replaying(void);
+int ras_replay_start(struct ras_events *ras);
+const char *ras_replay_header_page(int *size);
+const char *ras_replay_format(const char *group, const char *event,
+			      int *size);
+int ras_replay_next_page(int *cpu, void **page, int *size);
+void ras_replay_close(void);
+
+#endif
@@ -13,8 +13,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include "ras-capture.h"
 #include "ras-cpu-isolation.h"
 #include "ras-logger.h"
+#include "ras-stats.h"
 
 #define SECOND_OF_MON (30 * 24 * 60 * 60)
 #define SECOND_OF_DAY (24 * 60 * 60)
@@ -222,7 +224,8 @@ static int check_config_status(void)
 
 void ras_cpu_isolation_init(unsigned int cpus)
 {
-	if (init_cpu_info(cpus) < 0 || check_config_status() < 0) {
+	if (ras_replaying() || init_cpu_info(cpus) < 0 ||
+	    check_config_status() < 0) {
 		enabled = 0;
 		log(TERM, LOG_WARNING, "Cpu fault isolation is disabled\n");
 		return;
@@ -273,6 +276,7 @@ static int do_cpu_offline(unsigned int cpu)
 
 static int do_ce_handler(unsigned int cpu)
 {
+	static unsigned long lost_seen;
 	struct link_queue *queue = cpu_infos[cpu].ce_queue;
 	unsigned int tmp;
 	/*
@@ -291,6 +295,8 @@ static int do_ce_handler(unsigned int cpu)
 	    "Current number of Corrected Errors in cpu%d in the cycle is %lu\n",
 		cpu, cpu_infos[cpu].ce_nums);
 
+	ras_stats_ce_lost(&lost_seen, "cpu");
+
 	if (cpu_infos[cpu].ce_nums >= threshold.value) {
 		log(TERM, LOG_INFO,
 		    "Corrected Errors exceeded threshold %lu, try to offline cpu%u\n",
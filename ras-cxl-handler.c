@@ -15,7 +15,7 @@
 #include "ras-page-isolation.h"
 #include "ras-logger.h"
 #include "ras-record.h"
-#include "ras-report.h"
+#include "ras-sink.h"
 #include "types.h"
 
 /* Common Functions */
@@ -64,8 +64,7 @@ static int decode_cxl_event_flags(struct trace_seq *s, uint32_t flags,
 
 	for (i = 0; i < num_elems; i++) {
 		if (flags & cxl_ev_flags[i].bit)
-			if (trace_seq_printf(s, "\'%s\' ", cxl_ev_flags[i].flag) <= 0)
-				return -1;
+			trace_seq_printf(s, "\'%s\' ", cxl_ev_flags[i].flag);
 	}
 	return 0;
 }
@@ -124,10 +123,44 @@ enum cxl_poison_trace_type {
 	CXL_POISON_TRACE_CLEAR,
 };
 
+enum {
+	CXL_POISON_FIELD_MEMDEV,
+	CXL_POISON_FIELD_HOST,
+	CXL_POISON_FIELD_SERIAL,
+	CXL_POISON_FIELD_TRACE_TYPE,
+	CXL_POISON_FIELD_REGION,
+	CXL_POISON_FIELD_UUID,
+	CXL_POISON_FIELD_HPA,
+	CXL_POISON_FIELD_HPA_ALIAS0,
+	CXL_POISON_FIELD_DPA,
+	CXL_POISON_FIELD_DPA_LENGTH,
+	CXL_POISON_FIELD_SOURCE,
+	CXL_POISON_FIELD_FLAGS,
+	CXL_POISON_FIELD_OVERFLOW_TS,
+};
+
+struct ras_field cxl_poison_event_tep_fields[] = {
+	[CXL_POISON_FIELD_MEMDEV] = RAS_FIELD("memdev"),
+	[CXL_POISON_FIELD_HOST] = RAS_FIELD("host"),
+	[CXL_POISON_FIELD_SERIAL] = RAS_FIELD("serial"),
+	[CXL_POISON_FIELD_TRACE_TYPE] = RAS_FIELD("trace_type"),
+	[CXL_POISON_FIELD_REGION] = RAS_FIELD("region"),
+	[CXL_POISON_FIELD_UUID] = RAS_FIELD("uuid"),
+	[CXL_POISON_FIELD_HPA] = RAS_FIELD("hpa"),
+	[CXL_POISON_FIELD_HPA_ALIAS0] = RAS_FIELD("hpa_alias0"),
+	[CXL_POISON_FIELD_DPA] = RAS_FIELD("dpa"),
+	[CXL_POISON_FIELD_DPA_LENGTH] = RAS_FIELD("dpa_length"),
+	[CXL_POISON_FIELD_SOURCE] = RAS_FIELD("source"),
+	[CXL_POISON_FIELD_FLAGS] = RAS_FIELD("flags"),
+	[CXL_POISON_FIELD_OVERFLOW_TS] = RAS_FIELD("overflow_ts"),
+	{ }
+};
+
 int ras_cxl_poison_event_handler(struct trace_seq *s,
 				 struct tep_record *record,
 				 struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_poison_event_tep_fields;
 	int len;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -135,30 +168,24 @@ int ras_cxl_poison_event_handler(struct trace_seq *s,
 
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_ERR]);
 	get_timestamp(s, record, ras, (char *)&ev.timestamp, sizeof(ev.timestamp));
-	if (trace_seq_printf(s, "%s ", ev.timestamp) <= 0)
-		return -1;
+	trace_seq_printf(s, "%s ", ev.timestamp);
 
-	ev.memdev = tep_get_field_raw(s, event, "memdev",
-				      record, &len, 1);
+	ev.memdev = ras_get_field_raw(s, &f[CXL_POISON_FIELD_MEMDEV], record, &len, 1);
 	if (!ev.memdev)
 		return -1;
-	if (trace_seq_printf(s, "memdev:%s ", ev.memdev) <= 0)
-		return -1;
+	trace_seq_printf(s, "memdev:%s ", ev.memdev);
 
-	ev.host = tep_get_field_raw(s, event, "host",
-				    record, &len, 1);
+	ev.host = ras_get_field_raw(s, &f[CXL_POISON_FIELD_HOST], record, &len, 1);
 	if (!ev.host)
 		return -1;
-	if (trace_seq_printf(s, "host:%s ", ev.host) <= 0)
-		return -1;
+	trace_seq_printf(s, "host:%s ", ev.host);
 
-	if (tep_get_field_val(s, event, "serial", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_SERIAL], record, &val, 1) < 0)
 		return -1;
 	ev.serial = val;
-	if (trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial) <= 0)
-		return -1;
+	trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial);
 
-	if (tep_get_field_val(s,  event, "trace_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_TRACE_TYPE], record, &val, 1) < 0)
 		return -1;
 	switch (val) {
 	case CXL_POISON_TRACE_LIST:
@@ -173,48 +200,39 @@ int ras_cxl_poison_event_handler(struct trace_seq *s,
 	default:
 		ev.trace_type = "Invalid";
 	}
-	if (trace_seq_printf(s, "trace_type:%s ", ev.trace_type) <= 0)
-		return -1;
+	trace_seq_printf(s, "trace_type:%s ", ev.trace_type);
 
-	ev.region = tep_get_field_raw(s, event, "region",
-				      record, &len, 1);
+	ev.region = ras_get_field_raw(s, &f[CXL_POISON_FIELD_REGION], record, &len, 1);
 	if (!ev.region)
 		return -1;
-	if (trace_seq_printf(s, "region:%s ", ev.region) <= 0)
-		return -1;
+	trace_seq_printf(s, "region:%s ", ev.region);
 
-	ev.uuid = tep_get_field_raw(s, event, "uuid",
-				    record, &len, 1);
+	ev.uuid = ras_get_field_raw(s, &f[CXL_POISON_FIELD_UUID], record, &len, 1);
 	if (!ev.uuid)
 		return -1;
-	if (trace_seq_printf(s, "region_uuid:%s ", ev.uuid) <= 0)
-		return -1;
+	trace_seq_printf(s, "region_uuid:%s ", ev.uuid);
 
-	if (tep_get_field_val(s, event, "hpa", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_HPA], record, &val, 1) < 0)
 		return -1;
 	ev.hpa = val;
-	if (trace_seq_printf(s, "hpa:0x%llx ", (unsigned long long)ev.hpa) <= 0)
-		return -1;
+	trace_seq_printf(s, "hpa:0x%llx ", (unsigned long long)ev.hpa);
 
-	if (tep_get_field_val(s, event, "hpa_alias0", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_HPA_ALIAS0], record, &val, 1) < 0)
 		return -1;
 	ev.hpa_alias0 = val;
-	if (trace_seq_printf(s, "hpa_alias0:0x%llx ", (unsigned long long)ev.hpa_alias0) <= 0)
-		return -1;
+	trace_seq_printf(s, "hpa_alias0:0x%llx ", (unsigned long long)ev.hpa_alias0);
 
-	if (tep_get_field_val(s, event, "dpa", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_DPA], record, &val, 1) < 0)
 		return -1;
 	ev.dpa = val;
-	if (trace_seq_printf(s, "dpa:0x%llx ", (unsigned long long)ev.dpa) <= 0)
-		return -1;
+	trace_seq_printf(s, "dpa:0x%llx ", (unsigned long long)ev.dpa);
 
-	if (tep_get_field_val(s, event, "dpa_length", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_DPA_LENGTH], record, &val, 1) < 0)
 		return -1;
 	ev.dpa_length = val;
-	if (trace_seq_printf(s, "dpa_length:0x%x ", ev.dpa_length) <= 0)
-		return -1;
+	trace_seq_printf(s, "dpa_length:0x%x ", ev.dpa_length);
 
-	if (tep_get_field_val(s,  event, "source", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_SOURCE], record, &val, 1) < 0)
 		return -1;
 	switch (val) {
 	case CXL_POISON_SOURCE_UNKNOWN:
@@ -235,17 +253,15 @@ int ras_cxl_poison_event_handler(struct trace_seq *s,
 	default:
 		ev.source = "Invalid";
 	}
-	if (trace_seq_printf(s, "source:%s ", ev.source) <= 0)
-		return -1;
+	trace_seq_printf(s, "source:%s ", ev.source);
 
-	if (tep_get_field_val(s,  event, "flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_POISON_FIELD_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.flags = val;
-	if (trace_seq_printf(s, "flags:%d ", ev.flags) <= 0)
-		return -1;
+	trace_seq_printf(s, "flags:%d ", ev.flags);
 
 	if (ev.flags & CXL_POISON_FLAG_OVERFLOW) {
-		if (tep_get_field_val(s,  event, "overflow_ts", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_POISON_FIELD_OVERFLOW_TS], record, &val, 1) < 0)
 			return -1;
 		convert_timestamp(val, ev.overflow_ts, sizeof(ev.overflow_ts));
 	} else {
@@ -253,18 +269,9 @@ int ras_cxl_poison_event_handler(struct trace_seq *s,
 			sizeof(ev.overflow_ts));
 	}
 
-	if (trace_seq_printf(s, "overflow timestamp:%s\n", ev.overflow_ts) <= 0)
-		return -1;
-
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_poison_event(ras, &ev);
-#endif
+	trace_seq_printf(s, "overflow timestamp:%s\n", ev.overflow_ts);
 
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_poison_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_POISON_EVENT, RAS_SEV_UNCORRECTED, &ev);
 
 	return 0;
 }
@@ -336,16 +343,35 @@ static int decode_cxl_error_status(struct trace_seq *s, uint32_t status,
 
 	for (i = 0; i < num_elems; i++) {
 		if (status & cxl_error_list[i].bit)
-			if (trace_seq_printf(s, "\'%s\' ", cxl_error_list[i].error) <= 0)
-				return -1;
+			trace_seq_printf(s, "\'%s\' ", cxl_error_list[i].error);
 	}
 	return 0;
 }
 
+enum {
+	CXL_AER_UE_FIELD_MEMDEV,
+	CXL_AER_UE_FIELD_HOST,
+	CXL_AER_UE_FIELD_SERIAL,
+	CXL_AER_UE_FIELD_STATUS,
+	CXL_AER_UE_FIELD_FIRST_ERROR,
+	CXL_AER_UE_FIELD_HEADER_LOG,
+};
+
+struct ras_field cxl_aer_ue_event_tep_fields[] = {
+	[CXL_AER_UE_FIELD_MEMDEV] = RAS_FIELD("memdev"),
+	[CXL_AER_UE_FIELD_HOST] = RAS_FIELD("host"),
+	[CXL_AER_UE_FIELD_SERIAL] = RAS_FIELD("serial"),
+	[CXL_AER_UE_FIELD_STATUS] = RAS_FIELD("status"),
+	[CXL_AER_UE_FIELD_FIRST_ERROR] = RAS_FIELD("first_error"),
+	[CXL_AER_UE_FIELD_HEADER_LOG] = RAS_FIELD("header_log"),
+	{ }
+};
+
 int ras_cxl_aer_ue_event_handler(struct trace_seq *s,
 				 struct tep_record *record,
 				 struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_aer_ue_event_tep_fields;
 	int len, i;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -354,61 +380,49 @@ int ras_cxl_aer_ue_event_handler(struct trace_seq *s,
 	memset(&ev, 0, sizeof(ev));
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_CRIT]);
 	get_timestamp(s, record, ras, (char *)&ev.timestamp, sizeof(ev.timestamp));
-	if (trace_seq_printf(s, "%s ", ev.timestamp) <= 0)
-		return -1;
+	trace_seq_printf(s, "%s ", ev.timestamp);
 
-	ev.memdev = tep_get_field_raw(s, event, "memdev",
-				      record, &len, 1);
+	ev.memdev = ras_get_field_raw(s, &f[CXL_AER_UE_FIELD_MEMDEV], record, &len, 1);
 	if (!ev.memdev)
 		return -1;
-	if (trace_seq_printf(s, "memdev:%s ", ev.memdev) <= 0)
-		return -1;
+	trace_seq_printf(s, "memdev:%s ", ev.memdev);
 
-	ev.host = tep_get_field_raw(s, event, "host",
-				    record, &len, 1);
+	ev.host = ras_get_field_raw(s, &f[CXL_AER_UE_FIELD_HOST], record, &len, 1);
 	if (!ev.host)
 		return -1;
-	if (trace_seq_printf(s, "host:%s ", ev.host) <= 0)
-		return -1;
+	trace_seq_printf(s, "host:%s ", ev.host);
 
-	if (tep_get_field_val(s, event, "serial", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_AER_UE_FIELD_SERIAL], record, &val, 1) < 0)
 		return -1;
 	ev.serial = val;
-	if (trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial) <= 0)
-		return -1;
+	trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial);
 
-	if (tep_get_field_val(s, event, "status", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_AER_UE_FIELD_STATUS], record, &val, 1) < 0)
 		return -1;
 	ev.error_status = val;
 
-	if (trace_seq_printf(s, "error status:") <= 0)
-		return -1;
+	trace_seq_printf(s, "error status:");
 	if (decode_cxl_error_status(s, ev.error_status,
 				    cxl_aer_ue, ARRAY_SIZE(cxl_aer_ue)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s,  event, "first_error", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_AER_UE_FIELD_FIRST_ERROR], record, &val, 1) < 0)
 		return -1;
 	ev.first_error = val;
 
-	if (trace_seq_printf(s, "first error:") <= 0)
-		return -1;
+	trace_seq_printf(s, "first error:");
 	if (decode_cxl_error_status(s, ev.first_error,
 				    cxl_aer_ue, ARRAY_SIZE(cxl_aer_ue)) < 0)
 		return -1;
 
-	ev.header_log = tep_get_field_raw(s, event, "header_log",
-					  record, &len, 1);
+	ev.header_log = ras_get_field_raw(s, &f[CXL_AER_UE_FIELD_HEADER_LOG], record, &len, 1);
 	if (!ev.header_log)
 		return -1;
-	if (trace_seq_printf(s, "header log:\n") <= 0)
-		return -1;
+	trace_seq_printf(s, "header log:\n");
 	for (i = 0; i < CXL_HEADERLOG_SIZE_U32; i++) {
-		if (trace_seq_printf(s, "%08x ", ev.header_log[i]) <= 0)
-			break;
+		trace_seq_printf(s, "%08x ", ev.header_log[i]);
 		if (i > 0 && ((i % 20) == 0))
-			if (trace_seq_printf(s, "\n") <= 0)
-				break;
+			trace_seq_printf(s, "\n");
 		/* Convert header log data to the big-endian format because
 		 * the SQLite database seems uses the big-endian storage.
 		 */
@@ -417,23 +431,31 @@ int ras_cxl_aer_ue_event_handler(struct trace_seq *s,
 	if (i < CXL_HEADERLOG_SIZE_U32)
 		return -1;
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_aer_ue_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_aer_ue_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_AER_UE_EVENT, RAS_SEV_UNCORRECTED, &ev);
 
 	return 0;
 }
 
+enum {
+	CXL_AER_CE_FIELD_MEMDEV,
+	CXL_AER_CE_FIELD_HOST,
+	CXL_AER_CE_FIELD_SERIAL,
+	CXL_AER_CE_FIELD_STATUS,
+};
+
+struct ras_field cxl_aer_ce_event_tep_fields[] = {
+	[CXL_AER_CE_FIELD_MEMDEV] = RAS_FIELD("memdev"),
+	[CXL_AER_CE_FIELD_HOST] = RAS_FIELD("host"),
+	[CXL_AER_CE_FIELD_SERIAL] = RAS_FIELD("serial"),
+	[CXL_AER_CE_FIELD_STATUS] = RAS_FIELD("status"),
+	{ }
+};
+
 int ras_cxl_aer_ce_event_handler(struct trace_seq *s,
 				 struct tep_record *record,
 				 struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_aer_ce_event_tep_fields;
 	int len;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -441,47 +463,32 @@ int ras_cxl_aer_ce_event_handler(struct trace_seq *s,
 
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_ERR]);
 	get_timestamp(s, record, ras, (char *)&ev.timestamp, sizeof(ev.timestamp));
-	if (trace_seq_printf(s, "%s ", ev.timestamp) <= 0)
-		return -1;
+	trace_seq_printf(s, "%s ", ev.timestamp);
 
-	ev.memdev = tep_get_field_raw(s, event, "memdev",
-				      record, &len, 1);
+	ev.memdev = ras_get_field_raw(s, &f[CXL_AER_CE_FIELD_MEMDEV], record, &len, 1);
 	if (!ev.memdev)
 		return -1;
-	if (trace_seq_printf(s, "memdev:%s ", ev.memdev) <= 0)
-		return -1;
+	trace_seq_printf(s, "memdev:%s ", ev.memdev);
 
-	ev.host = tep_get_field_raw(s, event, "host",
-				    record, &len, 1);
+	ev.host = ras_get_field_raw(s, &f[CXL_AER_CE_FIELD_HOST], record, &len, 1);
 	if (!ev.host)
 		return -1;
-	if (trace_seq_printf(s, "host:%s ", ev.host) <= 0)
-		return -1;
+	trace_seq_printf(s, "host:%s ", ev.host);
 
-	if (tep_get_field_val(s, event, "serial", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_AER_CE_FIELD_SERIAL], record, &val, 1) < 0)
 		return -1;
 	ev.serial = val;
-	if (trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial) <= 0)
-		return -1;
+	trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial);
 
-	if (tep_get_field_val(s, event, "status", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_AER_CE_FIELD_STATUS], record, &val, 1) < 0)
 		return -1;
 	ev.error_status = val;
-	if (trace_seq_printf(s, "error status:") <= 0)
-		return -1;
+	trace_seq_printf(s, "error status:");
 	if (decode_cxl_error_status(s, ev.error_status,
 				    cxl_aer_ce, ARRAY_SIZE(cxl_aer_ce)) < 0)
 		return -1;
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_aer_ce_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_aer_ce_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_AER_CE_EVENT, RAS_SEV_CORRECTED, &ev);
 
 	return 0;
 }
@@ -515,10 +522,32 @@ static char *cxl_event_log_type_str(uint32_t log_type)
 	return "Unknown";
 }
 
+enum {
+	CXL_OVERFLOW_FIELD_MEMDEV,
+	CXL_OVERFLOW_FIELD_HOST,
+	CXL_OVERFLOW_FIELD_SERIAL,
+	CXL_OVERFLOW_FIELD_LOG,
+	CXL_OVERFLOW_FIELD_COUNT,
+	CXL_OVERFLOW_FIELD_FIRST_TS,
+	CXL_OVERFLOW_FIELD_LAST_TS,
+};
+
+struct ras_field cxl_overflow_event_tep_fields[] = {
+	[CXL_OVERFLOW_FIELD_MEMDEV] = RAS_FIELD("memdev"),
+	[CXL_OVERFLOW_FIELD_HOST] = RAS_FIELD("host"),
+	[CXL_OVERFLOW_FIELD_SERIAL] = RAS_FIELD("serial"),
+	[CXL_OVERFLOW_FIELD_LOG] = RAS_FIELD("log"),
+	[CXL_OVERFLOW_FIELD_COUNT] = RAS_FIELD("count"),
+	[CXL_OVERFLOW_FIELD_FIRST_TS] = RAS_FIELD("first_ts"),
+	[CXL_OVERFLOW_FIELD_LAST_TS] = RAS_FIELD("last_ts"),
+	{ }
+};
+
 int ras_cxl_overflow_event_handler(struct trace_seq *s,
 				   struct tep_record *record,
 				   struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_overflow_event_tep_fields;
 	int len;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -527,59 +556,45 @@ int ras_cxl_overflow_event_handler(struct trace_seq *s,
 	memset(&ev, 0, sizeof(ev));
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_ERR]);
 	get_timestamp(s, record, ras, (char *)&ev.timestamp, sizeof(ev.timestamp));
-	if (trace_seq_printf(s, "%s ", ev.timestamp) <= 0)
-		return -1;
+	trace_seq_printf(s, "%s ", ev.timestamp);
 
-	ev.memdev = tep_get_field_raw(s, event, "memdev", record, &len, 1);
+	ev.memdev = ras_get_field_raw(s, &f[CXL_OVERFLOW_FIELD_MEMDEV], record, &len, 1);
 	if (!ev.memdev)
 		return -1;
-	if (trace_seq_printf(s, "memdev:%s ", ev.memdev) <= 0)
-		return -1;
+	trace_seq_printf(s, "memdev:%s ", ev.memdev);
 
-	ev.host = tep_get_field_raw(s, event, "host", record, &len, 1);
+	ev.host = ras_get_field_raw(s, &f[CXL_OVERFLOW_FIELD_HOST], record, &len, 1);
 	if (!ev.host)
 		return -1;
-	if (trace_seq_printf(s, "host:%s ", ev.host) <= 0)
-		return -1;
+	trace_seq_printf(s, "host:%s ", ev.host);
 
-	if (tep_get_field_val(s, event, "serial", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_OVERFLOW_FIELD_SERIAL], record, &val, 1) < 0)
 		return -1;
 	ev.serial = val;
-	if (trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial) <= 0)
-		return -1;
+	trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)ev.serial);
 
-	if (tep_get_field_val(s, event, "log", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_OVERFLOW_FIELD_LOG], record, &val, 1) < 0)
 		return -1;
 	ev.log_type = cxl_event_log_type_str(val);
-	if (trace_seq_printf(s, "log type:%s ", ev.log_type) <= 0)
-		return -1;
+	trace_seq_printf(s, "log type:%s ", ev.log_type);
 
-	if (tep_get_field_val(s, event, "count", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_OVERFLOW_FIELD_COUNT], record, &val, 1) < 0)
 		return -1;
 	ev.count = val;
 
-	if (tep_get_field_val(s,  event, "first_ts", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_OVERFLOW_FIELD_FIRST_TS], record, &val, 1) < 0)
 		return -1;
 	convert_timestamp(val, ev.first_ts, sizeof(ev.first_ts));
 
-	if (tep_get_field_val(s,  event, "last_ts", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_OVERFLOW_FIELD_LAST_TS], record, &val, 1) < 0)
 		return -1;
 	convert_timestamp(val, ev.last_ts, sizeof(ev.last_ts));
 
 	if (ev.count) {
-		if (trace_seq_printf(s, "%u errors from %s to %s\n",
-				     ev.count, ev.first_ts, ev.last_ts) <= 0)
-			return -1;
+		trace_seq_printf(s, "%u errors from %s to %s\n",
+				 ev.count, ev.first_ts, ev.last_ts);
 	}
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_overflow_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_overflow_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_OVERFLOW_EVENT, RAS_SEV_INFO, &ev);
 
 	return 0;
 }
@@ -601,22 +616,18 @@ static int ras_cxl_print_component_id(struct trace_seq *s, uint8_t *comp_id,
 	int i;
 
 	if (comp_id[0] & CXL_PLDM_COMPONENT_ID_ENTITY_VALID) {
-		if (trace_seq_printf(s, "PLDM Entity ID:") <= 0)
-			return -1;
+		trace_seq_printf(s, "PLDM Entity ID:");
 		for (i = 1; i < 7; i++) {
-			if (trace_seq_printf(s, "%02x ", comp_id[i]) <= 0)
-				return -1;
+			trace_seq_printf(s, "%02x ", comp_id[i]);
 		}
 		if (entity_id)
 			memcpy(entity_id, &comp_id[1], CXL_PLDM_ENTITY_ID_LEN);
 	}
 
 	if (comp_id[0] & CXL_PLDM_COMPONENT_ID_RES_VALID) {
-		if (trace_seq_printf(s, "Resource ID:") <= 0)
-			return -1;
+		trace_seq_printf(s, "Resource ID:");
 		for (i = 7; i < 11; i++) {
-			if (trace_seq_printf(s, "%02x ", comp_id[i]) <= 0)
-				return -1;
+			trace_seq_printf(s, "%02x ", comp_id[i]);
 		}
 		if (res_id)
 			memcpy(res_id, &comp_id[7], CXL_PLDM_RES_ID_LEN);
@@ -647,9 +658,44 @@ static const struct  cxl_event_flags cxl_hdr_flags[] = {
 	{ .bit = CXL_EVENT_RECORD_FLAG_HEAD_ID_VALID, .flag = "DEV_HEAD_ID_VALID" },
 };
 
+enum {
+	CXL_HDR_FIELD_MEMDEV,
+	CXL_HDR_FIELD_HOST,
+	CXL_HDR_FIELD_SERIAL,
+	CXL_HDR_FIELD_LOG,
+	CXL_HDR_FIELD_HDR_UUID,
+	CXL_HDR_FIELD_HDR_FLAGS,
+	CXL_HDR_FIELD_HDR_HANDLE,
+	CXL_HDR_FIELD_HDR_RELATED_HANDLE,
+	CXL_HDR_FIELD_HDR_TIMESTAMP,
+	CXL_HDR_FIELD_HDR_LENGTH,
+	CXL_HDR_FIELD_HDR_MAINT_OP_CLASS,
+	CXL_HDR_FIELD_HDR_MAINT_OP_SUB_CLASS,
+	CXL_HDR_FIELD_HDR_LD_ID,
+	CXL_HDR_FIELD_HDR_HEAD_ID,
+	NR_CXL_HDR_FIELDS
+};
+
+/* Fields of all events with a common header */
+#define CXL_HDR_FIELDS \
+	[CXL_HDR_FIELD_MEMDEV] = RAS_FIELD("memdev"), \
+	[CXL_HDR_FIELD_HOST] = RAS_FIELD("host"), \
+	[CXL_HDR_FIELD_SERIAL] = RAS_FIELD("serial"), \
+	[CXL_HDR_FIELD_LOG] = RAS_FIELD("log"), \
+	[CXL_HDR_FIELD_HDR_UUID] = RAS_FIELD("hdr_uuid"), \
+	[CXL_HDR_FIELD_HDR_FLAGS] = RAS_FIELD("hdr_flags"), \
+	[CXL_HDR_FIELD_HDR_HANDLE] = RAS_FIELD("hdr_handle"), \
+	[CXL_HDR_FIELD_HDR_RELATED_HANDLE] = RAS_FIELD("hdr_related_handle"), \
+	[CXL_HDR_FIELD_HDR_TIMESTAMP] = RAS_FIELD("hdr_timestamp"), \
+	[CXL_HDR_FIELD_HDR_LENGTH] = RAS_FIELD("hdr_length"), \
+	[CXL_HDR_FIELD_HDR_MAINT_OP_CLASS] = RAS_FIELD("hdr_maint_op_class"), \
+	[CXL_HDR_FIELD_HDR_MAINT_OP_SUB_CLASS] = RAS_FIELD("hdr_maint_op_sub_class"), \
+	[CXL_HDR_FIELD_HDR_LD_ID] = RAS_FIELD("hdr_ld_id"), \
+	[CXL_HDR_FIELD_HDR_HEAD_ID] = RAS_FIELD("hdr_head_id")
+
 static int handle_ras_cxl_common_hdr(struct trace_seq *s,
 				     struct tep_record *record,
-				     struct tep_event *event, void *context,
+				     struct ras_field *f, void *context,
 				     struct ras_cxl_event_common_hdr *hdr)
 {
 	int len;
@@ -657,108 +703,105 @@ static int handle_ras_cxl_common_hdr(struct trace_seq *s,
 	struct ras_events *ras = context;
 
 	get_timestamp(s, record, ras, (char *)&hdr->timestamp, sizeof(hdr->timestamp));
-	if (trace_seq_printf(s, "%s ", hdr->timestamp) <= 0)
-		return -1;
+	trace_seq_printf(s, "%s ", hdr->timestamp);
 
-	hdr->memdev = tep_get_field_raw(s, event, "memdev", record, &len, 1);
+	hdr->memdev = ras_get_field_raw(s, &f[CXL_HDR_FIELD_MEMDEV], record, &len, 1);
 	if (!hdr->memdev)
 		return -1;
-	if (trace_seq_printf(s, "memdev:%s ", hdr->memdev) <= 0)
-		return -1;
+	trace_seq_printf(s, "memdev:%s ", hdr->memdev);
 
-	hdr->host = tep_get_field_raw(s, event, "host", record, &len, 1);
+	hdr->host = ras_get_field_raw(s, &f[CXL_HDR_FIELD_HOST], record, &len, 1);
 	if (!hdr->host)
 		return -1;
-	if (trace_seq_printf(s, "host:%s ", hdr->host) <= 0)
-		return -1;
+	trace_seq_printf(s, "host:%s ", hdr->host);
 
-	if (tep_get_field_val(s, event, "serial", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_SERIAL], record, &val, 1) < 0)
 		return -1;
 	hdr->serial = val;
-	if (trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)hdr->serial) <= 0)
-		return -1;
+	trace_seq_printf(s, "serial:0x%llx ", (unsigned long long)hdr->serial);
 
-	if (tep_get_field_val(s, event, "log", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_LOG], record, &val, 1) < 0)
 		return -1;
 	hdr->log_type = cxl_event_log_type_str(val);
-	if (trace_seq_printf(s, "log type:%s ", hdr->log_type) <= 0)
-		return -1;
+	trace_seq_printf(s, "log type:%s ", hdr->log_type);
 
-	hdr->hdr_uuid = tep_get_field_raw(s, event, "hdr_uuid", record, &len, 1);
+	hdr->hdr_uuid = ras_get_field_raw(s, &f[CXL_HDR_FIELD_HDR_UUID], record, &len, 1);
 	if (!hdr->hdr_uuid)
 		return -1;
 	hdr->hdr_uuid = uuid_be(hdr->hdr_uuid);
-	if (trace_seq_printf(s, "hdr_uuid:%s ", hdr->hdr_uuid) <= 0)
-		return -1;
+	trace_seq_printf(s, "hdr_uuid:%s ", hdr->hdr_uuid);
 
-	if (tep_get_field_val(s, event, "hdr_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_FLAGS], record, &val, 1) < 0)
 		return -1;
 	hdr->hdr_flags = val;
 	if (decode_cxl_event_flags(s, hdr->hdr_flags, cxl_hdr_flags,
 				   ARRAY_SIZE(cxl_hdr_flags)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s, event, "hdr_handle", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_HANDLE], record, &val, 1) < 0)
 		return -1;
 	hdr->hdr_handle = val;
-	if (trace_seq_printf(s, "hdr_handle:0x%x ", hdr->hdr_handle) <= 0)
-		return -1;
+	trace_seq_printf(s, "hdr_handle:0x%x ", hdr->hdr_handle);
 
-	if (tep_get_field_val(s, event, "hdr_related_handle", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_RELATED_HANDLE], record, &val, 1) < 0)
 		return -1;
 	hdr->hdr_related_handle = val;
-	if (trace_seq_printf(s, "hdr_related_handle:0x%x ", hdr->hdr_related_handle) <= 0)
-		return -1;
+	trace_seq_printf(s, "hdr_related_handle:0x%x ", hdr->hdr_related_handle);
 
-	if (tep_get_field_val(s,  event, "hdr_timestamp", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_TIMESTAMP], record, &val, 1) < 0)
 		return -1;
 	convert_timestamp(val, hdr->hdr_timestamp, sizeof(hdr->hdr_timestamp));
-	if (trace_seq_printf(s, "hdr_timestamp:%s ", hdr->hdr_timestamp) <= 0)
-		return -1;
+	trace_seq_printf(s, "hdr_timestamp:%s ", hdr->hdr_timestamp);
 
-	if (tep_get_field_val(s,  event, "hdr_length", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_LENGTH], record, &val, 1) < 0)
 		return -1;
 	hdr->hdr_length = val;
-	if (trace_seq_printf(s, "hdr_length:%u ", hdr->hdr_length) <= 0)
-		return -1;
+	trace_seq_printf(s, "hdr_length:%u ", hdr->hdr_length);
 
-	if (tep_get_field_val(s,  event, "hdr_maint_op_class", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_MAINT_OP_CLASS], record, &val, 1) < 0)
 		return -1;
 	hdr->hdr_maint_op_class = val;
-	if (trace_seq_printf(s, "hdr_maint_op_class:%u ", hdr->hdr_maint_op_class) <= 0)
-		return -1;
+	trace_seq_printf(s, "hdr_maint_op_class:%u ", hdr->hdr_maint_op_class);
 
 	if (hdr->hdr_flags & CXL_EVENT_RECORD_FLAG_MAINT_OP_SUB_CLASS_VALID) {
-		if (tep_get_field_val(s,  event, "hdr_maint_op_sub_class", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_MAINT_OP_SUB_CLASS], record, &val, 1) < 0)
 			return -1;
 		hdr->hdr_maint_op_sub_class = val;
-		if (trace_seq_printf(s, "hdr_maint_op_sub_class:%u ", hdr->hdr_maint_op_sub_class) <= 0)
-			return -1;
+		trace_seq_printf(s, "hdr_maint_op_sub_class:%u ", hdr->hdr_maint_op_sub_class);
 	}
 
 	if (hdr->hdr_flags & CXL_EVENT_RECORD_FLAG_LD_ID_VALID) {
-		if (tep_get_field_val(s,  event, "hdr_ld_id", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_LD_ID], record, &val, 1) < 0)
 			return -1;
 		hdr->hdr_ld_id = val;
-		if (trace_seq_printf(s, "hdr_ld_id:0x%x ", hdr->hdr_ld_id) <= 0)
-			return -1;
+		trace_seq_printf(s, "hdr_ld_id:0x%x ", hdr->hdr_ld_id);
 	}
 
 	if (hdr->hdr_flags & CXL_EVENT_RECORD_FLAG_HEAD_ID_VALID) {
-		if (tep_get_field_val(s,  event, "hdr_head_id", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_HDR_FIELD_HDR_HEAD_ID], record, &val, 1) < 0)
 			return -1;
 		hdr->hdr_head_id = val;
-		if (trace_seq_printf(s, "hdr_head_id:0x%x ", hdr->hdr_head_id) <= 0)
-			return -1;
+		trace_seq_printf(s, "hdr_head_id:0x%x ", hdr->hdr_head_id);
 	}
 
 	return 0;
 }
 
+enum {
+	CXL_GENERIC_FIELD_DATA = NR_CXL_HDR_FIELDS,
+};
+
+struct ras_field cxl_generic_event_tep_fields[] = {
+	CXL_HDR_FIELDS,
+	[CXL_GENERIC_FIELD_DATA] = RAS_FIELD("data"),
+	{ }
+};
+
 int ras_cxl_generic_event_handler(struct trace_seq *s,
 				  struct tep_record *record,
 				  struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_generic_event_tep_fields;
 	int len, i;
 	struct ras_events *ras = context;
 	struct ras_cxl_generic_event ev;
@@ -766,34 +809,24 @@ int ras_cxl_generic_event_handler(struct trace_seq *s,
 
 	memset(&ev, 0, sizeof(ev));
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_ERR]);
-	if (handle_ras_cxl_common_hdr(s, record, event, context, &ev.hdr) < 0)
+	if (handle_ras_cxl_common_hdr(s, record, f, context, &ev.hdr) < 0)
 		return -1;
 
-	ev.data = tep_get_field_raw(s, event, "data", record, &len, 1);
+	ev.data = ras_get_field_raw(s, &f[CXL_GENERIC_FIELD_DATA], record, &len, 1);
 	if (!ev.data)
 		return -1;
 	i = 0;
 	buf = ev.data;
-	if (trace_seq_printf(s, "\ndata:\n  %08x: ", i) <= 0)
-		return -1;
+	trace_seq_printf(s, "\ndata:\n  %08x: ", i);
 	for (i = 0; i < CXL_EVENT_RECORD_DATA_LENGTH; i += 4) {
 		if (i > 0 && ((i % 16) == 0))
-			if (trace_seq_printf(s, "\n  %08x: ", i) <= 0)
-				break;
-		if (trace_seq_printf(s, "%02x%02x%02x%02x ",
-				     buf[i], buf[i + 1], buf[i + 2], buf[i + 3]) <= 0)
-			break;
+			trace_seq_printf(s, "\n  %08x: ", i);
+		trace_seq_printf(s, "%02x%02x%02x%02x ",
+				 buf[i], buf[i + 1], buf[i + 2], buf[i + 3]);
 	}
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_generic_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_generic_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_GENERIC_EVENT,
+		      ras_severity_from_str(ev.hdr.log_type), &ev);
 
 	return 0;
 }
@@ -871,10 +904,53 @@ static const char * const cxl_gmer_trans_type[] = {
 	"Media Initialization",
 };
 
+enum {
+	CXL_GMER_FIELD_DPA = NR_CXL_HDR_FIELDS,
+	CXL_GMER_FIELD_DPA_FLAGS,
+	CXL_GMER_FIELD_DESCRIPTOR,
+	CXL_GMER_FIELD_TYPE,
+	CXL_GMER_FIELD_SUB_TYPE,
+	CXL_GMER_FIELD_TRANSACTION_TYPE,
+	CXL_GMER_FIELD_HPA,
+	CXL_GMER_FIELD_HPA_ALIAS0,
+	CXL_GMER_FIELD_REGION_NAME,
+	CXL_GMER_FIELD_REGION_UUID,
+	CXL_GMER_FIELD_VALIDITY_FLAGS,
+	CXL_GMER_FIELD_CHANNEL,
+	CXL_GMER_FIELD_RANK,
+	CXL_GMER_FIELD_DEVICE,
+	CXL_GMER_FIELD_COMP_ID,
+	CXL_GMER_FIELD_CME_THRESHOLD_EV_FLAGS,
+	CXL_GMER_FIELD_CME_COUNT,
+};
+
+struct ras_field cxl_general_media_event_tep_fields[] = {
+	CXL_HDR_FIELDS,
+	[CXL_GMER_FIELD_DPA] = RAS_FIELD("dpa"),
+	[CXL_GMER_FIELD_DPA_FLAGS] = RAS_FIELD("dpa_flags"),
+	[CXL_GMER_FIELD_DESCRIPTOR] = RAS_FIELD("descriptor"),
+	[CXL_GMER_FIELD_TYPE] = RAS_FIELD("type"),
+	[CXL_GMER_FIELD_SUB_TYPE] = RAS_FIELD("sub_type"),
+	[CXL_GMER_FIELD_TRANSACTION_TYPE] = RAS_FIELD("transaction_type"),
+	[CXL_GMER_FIELD_HPA] = RAS_FIELD("hpa"),
+	[CXL_GMER_FIELD_HPA_ALIAS0] = RAS_FIELD("hpa_alias0"),
+	[CXL_GMER_FIELD_REGION_NAME] = RAS_FIELD("region_name"),
+	[CXL_GMER_FIELD_REGION_UUID] = RAS_FIELD("region_uuid"),
+	[CXL_GMER_FIELD_VALIDITY_FLAGS] = RAS_FIELD("validity_flags"),
+	[CXL_GMER_FIELD_CHANNEL] = RAS_FIELD("channel"),
+	[CXL_GMER_FIELD_RANK] = RAS_FIELD("rank"),
+	[CXL_GMER_FIELD_DEVICE] = RAS_FIELD("device"),
+	[CXL_GMER_FIELD_COMP_ID] = RAS_FIELD("comp_id"),
+	[CXL_GMER_FIELD_CME_THRESHOLD_EV_FLAGS] = RAS_FIELD("cme_threshold_ev_flags"),
+	[CXL_GMER_FIELD_CME_COUNT] = RAS_FIELD("cme_count"),
+	{ }
+};
+
 int ras_cxl_general_media_event_handler(struct trace_seq *s,
 					struct tep_record *record,
 					struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_general_media_event_tep_fields;
 	int len, i, rc;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -882,126 +958,109 @@ int ras_cxl_general_media_event_handler(struct trace_seq *s,
 
 	memset(&ev, 0, sizeof(ev));
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_ERR]);
-	if (handle_ras_cxl_common_hdr(s, record, event, context, &ev.hdr) < 0)
+	if (handle_ras_cxl_common_hdr(s, record, f, context, &ev.hdr) < 0)
 		return -1;
 
-	if (tep_get_field_val(s, event, "dpa", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_DPA], record, &val, 1) < 0)
 		return -1;
 	ev.dpa = val;
-	if (trace_seq_printf(s, "dpa:0x%llx ", (unsigned long long)ev.dpa) <= 0)
-		return -1;
+	trace_seq_printf(s, "dpa:0x%llx ", (unsigned long long)ev.dpa);
 
-	if (tep_get_field_val(s,  event, "dpa_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_DPA_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.dpa_flags = val;
-	if (trace_seq_printf(s, "dpa_flags:") <= 0)
-		return -1;
+	trace_seq_printf(s, "dpa_flags:");
 	if (decode_cxl_event_flags(s, ev.dpa_flags, cxl_dpa_flags, ARRAY_SIZE(cxl_dpa_flags)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s,  event, "descriptor", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_DESCRIPTOR], record, &val, 1) < 0)
 		return -1;
 	ev.descriptor = val;
-	if (trace_seq_printf(s, "descriptor:") <= 0)
-		return -1;
+	trace_seq_printf(s, "descriptor:");
 	if (decode_cxl_event_flags(s, ev.descriptor, cxl_gmer_event_desc_flags,
 				   ARRAY_SIZE(cxl_gmer_event_desc_flags)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s,  event, "type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.type = val;
-	if (trace_seq_printf(s, "memory_event_type:%s ",
-			     get_cxl_type_str(cxl_gmer_mem_event_type,
-					      ARRAY_SIZE(cxl_gmer_mem_event_type), ev.type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "memory_event_type:%s ",
+			 get_cxl_type_str(cxl_gmer_mem_event_type,
+					  ARRAY_SIZE(cxl_gmer_mem_event_type), ev.type));
 
-	if (tep_get_field_val(s,  event, "sub_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_SUB_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.sub_type = val;
-	if (trace_seq_printf(s, "memory_event_sub_type:%s ",
-			     get_cxl_type_str(cxl_mem_event_sub_type,
-					      ARRAY_SIZE(cxl_mem_event_sub_type),
-					      ev.sub_type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "memory_event_sub_type:%s ",
+			 get_cxl_type_str(cxl_mem_event_sub_type,
+					  ARRAY_SIZE(cxl_mem_event_sub_type),
+					  ev.sub_type));
 
-	if (tep_get_field_val(s,  event, "transaction_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_TRANSACTION_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.transaction_type = val;
-	if (trace_seq_printf(s, "transaction_type:%s ",
-			     get_cxl_type_str(cxl_gmer_trans_type,
-					      ARRAY_SIZE(cxl_gmer_trans_type),
-					      ev.transaction_type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "transaction_type:%s ",
+			 get_cxl_type_str(cxl_gmer_trans_type,
+					  ARRAY_SIZE(cxl_gmer_trans_type),
+					  ev.transaction_type));
 
-	if (tep_get_field_val(s, event, "hpa", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_HPA], record, &val, 1) < 0)
 		return -1;
 	ev.hpa = val;
-	if (trace_seq_printf(s, "hpa:0x%llx ", (unsigned long long)ev.hpa) <= 0)
-		return -1;
+	trace_seq_printf(s, "hpa:0x%llx ", (unsigned long long)ev.hpa);
 
-	if (tep_get_field_val(s, event, "hpa_alias0", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_HPA_ALIAS0], record, &val, 1) < 0)
 		return -1;
 	ev.hpa_alias0 = val;
-	if (trace_seq_printf(s, "hpa_alias0:0x%llx ", (unsigned long long)ev.hpa_alias0) <= 0)
-		return -1;
+	trace_seq_printf(s, "hpa_alias0:0x%llx ", (unsigned long long)ev.hpa_alias0);
 
-	ev.region = tep_get_field_raw(s, event, "region_name", record, &len, 1);
+	ev.region = ras_get_field_raw(s, &f[CXL_GMER_FIELD_REGION_NAME], record, &len, 1);
 	if (!ev.region)
 		return -1;
-	if (trace_seq_printf(s, "region:%s ", ev.region) <= 0)
-		return -1;
+	trace_seq_printf(s, "region:%s ", ev.region);
 
-	ev.region_uuid = tep_get_field_raw(s, event, "region_uuid",
-					   record, &len, 1);
+	ev.region_uuid = ras_get_field_raw(s, &f[CXL_GMER_FIELD_REGION_UUID], record, &len, 1);
 	if (!ev.region_uuid)
 		return -1;
 	ev.region_uuid = uuid_be(ev.region_uuid);
-	if (trace_seq_printf(s, "region_uuid:%s ", ev.region_uuid) <= 0)
-		return -1;
+	trace_seq_printf(s, "region_uuid:%s ", ev.region_uuid);
 
-	if (tep_get_field_val(s,  event, "validity_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_GMER_FIELD_VALIDITY_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.validity_flags = val;
 
 	if (ev.validity_flags & CXL_GMER_VALID_CHANNEL) {
-		if (tep_get_field_val(s,  event, "channel", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_GMER_FIELD_CHANNEL], record, &val, 1) < 0)
 			return -1;
 		ev.channel = val;
-		if (trace_seq_printf(s, "channel:%u ", ev.channel) <= 0)
-			return -1;
+		trace_seq_printf(s, "channel:%u ", ev.channel);
 	}
 
 	if (ev.validity_flags & CXL_GMER_VALID_RANK) {
-		if (tep_get_field_val(s,  event, "rank", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_GMER_FIELD_RANK], record, &val, 1) < 0)
 			return -1;
 		ev.rank = val;
-		if (trace_seq_printf(s, "rank:%u ", ev.rank) <= 0)
-			return -1;
+		trace_seq_printf(s, "rank:%u ", ev.rank);
 	}
 
 	if (ev.validity_flags & CXL_GMER_VALID_DEVICE) {
-		if (tep_get_field_val(s,  event, "device", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_GMER_FIELD_DEVICE], record, &val, 1) < 0)
 			return -1;
 		ev.device = val;
-		if (trace_seq_printf(s, "device:%x ", ev.device) <= 0)
-			return -1;
+		trace_seq_printf(s, "device:%x ", ev.device);
 	}
 
 	if (ev.validity_flags & CXL_GMER_VALID_COMPONENT) {
-		ev.comp_id = tep_get_field_raw(s, event, "comp_id", record, &len, 1);
+		ev.comp_id = ras_get_field_raw(s, &f[CXL_GMER_FIELD_COMP_ID], record, &len, 1);
 		if (!ev.comp_id)
 			return -1;
-		if (trace_seq_printf(s, "comp_id:") <= 0)
-			return -1;
+		trace_seq_printf(s, "comp_id:");
 		for (i = 0; i < CXL_EVENT_GEN_MED_COMP_ID_SIZE; i++) {
-			if (trace_seq_printf(s, "%02x ", ev.comp_id[i]) <= 0)
-				break;
+			trace_seq_printf(s, "%02x ", ev.comp_id[i]);
 		}
 
 		if (ev.validity_flags & CXL_GMER_VALID_COMPONENT_ID_FORMAT) {
-			if (trace_seq_printf(s, "comp_id_pldm_valid_flags:") <= 0)
-				return -1;
+			trace_seq_printf(s, "comp_id_pldm_valid_flags:");
 			if (decode_cxl_event_flags(s, ev.comp_id[0], cxl_pldm_comp_id_flags,
 						   ARRAY_SIZE(cxl_pldm_comp_id_flags)) < 0)
 				return -1;
@@ -1013,32 +1072,23 @@ int ras_cxl_general_media_event_handler(struct trace_seq *s,
 	}
 
 	if (ev.descriptor & CXL_GMER_EVT_DESC_THRESHOLD_EVENT) {
-		if (tep_get_field_val(s,  event, "cme_threshold_ev_flags", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_GMER_FIELD_CME_THRESHOLD_EV_FLAGS], record, &val, 1) < 0)
 			return -1;
 		ev.cme_threshold_ev_flags = val;
-		if (trace_seq_printf(s, "Advanced Programmable CME threshold Event Flags:") <= 0)
-			return -1;
+		trace_seq_printf(s, "Advanced Programmable CME threshold Event Flags:");
 		if (decode_cxl_event_flags(s, ev.cme_threshold_ev_flags,
 					   cxl_cme_threshold_ev_flags,
 					   ARRAY_SIZE(cxl_cme_threshold_ev_flags)) < 0)
 			return -1;
 
-		if (tep_get_field_val(s,  event, "cme_count", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_GMER_FIELD_CME_COUNT], record, &val, 1) < 0)
 			return -1;
 		ev.cme_count = val;
-		if (trace_seq_printf(s, "Corrected Memory Error Count:%u ", ev.cme_count) <= 0)
-			return -1;
+		trace_seq_printf(s, "Corrected Memory Error Count:%u ", ev.cme_count);
 	}
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_general_media_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_general_media_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_GENERAL_MEDIA_EVENT,
+		      ras_severity_from_str(ev.hdr.log_type), &ev);
 
 	return 0;
 }
@@ -1070,10 +1120,65 @@ static const char * const cxl_der_mem_event_type[] = {
 	"CKID Violation",
 };
 
+enum {
+	CXL_DER_FIELD_DPA = NR_CXL_HDR_FIELDS,
+	CXL_DER_FIELD_DPA_FLAGS,
+	CXL_DER_FIELD_DESCRIPTOR,
+	CXL_DER_FIELD_TYPE,
+	CXL_DER_FIELD_SUB_TYPE,
+	CXL_DER_FIELD_TRANSACTION_TYPE,
+	CXL_DER_FIELD_HPA,
+	CXL_DER_FIELD_HPA_ALIAS0,
+	CXL_DER_FIELD_REGION_NAME,
+	CXL_DER_FIELD_REGION_UUID,
+	CXL_DER_FIELD_VALIDITY_FLAGS,
+	CXL_DER_FIELD_CHANNEL,
+	CXL_DER_FIELD_SUB_CHANNEL,
+	CXL_DER_FIELD_RANK,
+	CXL_DER_FIELD_NIBBLE_MASK,
+	CXL_DER_FIELD_BANK_GROUP,
+	CXL_DER_FIELD_BANK,
+	CXL_DER_FIELD_ROW,
+	CXL_DER_FIELD_COLUMN,
+	CXL_DER_FIELD_COR_MASK,
+	CXL_DER_FIELD_COMP_ID,
+	CXL_DER_FIELD_CME_THRESHOLD_EV_FLAGS,
+	CXL_DER_FIELD_CVME_COUNT,
+};
+
+struct ras_field cxl_dram_event_tep_fields[] = {
+	CXL_HDR_FIELDS,
+	[CXL_DER_FIELD_DPA] = RAS_FIELD("dpa"),
+	[CXL_DER_FIELD_DPA_FLAGS] = RAS_FIELD("dpa_flags"),
+	[CXL_DER_FIELD_DESCRIPTOR] = RAS_FIELD("descriptor"),
+	[CXL_DER_FIELD_TYPE] = RAS_FIELD("type"),
+	[CXL_DER_FIELD_SUB_TYPE] = RAS_FIELD("sub_type"),
+	[CXL_DER_FIELD_TRANSACTION_TYPE] = RAS_FIELD("transaction_type"),
+	[CXL_DER_FIELD_HPA] = RAS_FIELD("hpa"),
+	[CXL_DER_FIELD_HPA_ALIAS0] = RAS_FIELD("hpa_alias0"),
+	[CXL_DER_FIELD_REGION_NAME] = RAS_FIELD("region_name"),
+	[CXL_DER_FIELD_REGION_UUID] = RAS_FIELD("region_uuid"),
+	[CXL_DER_FIELD_VALIDITY_FLAGS] = RAS_FIELD("validity_flags"),
+	[CXL_DER_FIELD_CHANNEL] = RAS_FIELD("channel"),
+	[CXL_DER_FIELD_SUB_CHANNEL] = RAS_FIELD("sub_channel"),
+	[CXL_DER_FIELD_RANK] = RAS_FIELD("rank"),
+	[CXL_DER_FIELD_NIBBLE_MASK] = RAS_FIELD("nibble_mask"),
+	[CXL_DER_FIELD_BANK_GROUP] = RAS_FIELD("bank_group"),
+	[CXL_DER_FIELD_BANK] = RAS_FIELD("bank"),
+	[CXL_DER_FIELD_ROW] = RAS_FIELD("row"),
+	[CXL_DER_FIELD_COLUMN] = RAS_FIELD("column"),
+	[CXL_DER_FIELD_COR_MASK] = RAS_FIELD("cor_mask"),
+	[CXL_DER_FIELD_COMP_ID] = RAS_FIELD("comp_id"),
+	[CXL_DER_FIELD_CME_THRESHOLD_EV_FLAGS] = RAS_FIELD("cme_threshold_ev_flags"),
+	[CXL_DER_FIELD_CVME_COUNT] = RAS_FIELD("cvme_count"),
+	{ }
+};
+
 int ras_cxl_dram_event_handler(struct trace_seq *s,
 			       struct tep_record *record,
 			       struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_dram_event_tep_fields;
 	int len, i, rc;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -1081,163 +1186,142 @@ int ras_cxl_dram_event_handler(struct trace_seq *s,
 
 	memset(&ev, 0, sizeof(ev));
 	trace_seq_printf(s, "%s ", loglevel_str[LOGLEVEL_ERR]);
-	if (handle_ras_cxl_common_hdr(s, record, event, context, &ev.hdr) < 0)
+	if (handle_ras_cxl_common_hdr(s, record, f, context, &ev.hdr) < 0)
 		return -1;
 
-	if (tep_get_field_val(s, event, "dpa", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_DPA], record, &val, 1) < 0)
 		return -1;
 	ev.dpa = val;
-	if (trace_seq_printf(s, "dpa:0x%llx ", (unsigned long long)ev.dpa) <= 0)
-		return -1;
+	trace_seq_printf(s, "dpa:0x%llx ", (unsigned long long)ev.dpa);
 
-	if (tep_get_field_val(s,  event, "dpa_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_DPA_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.dpa_flags = val;
-	if (trace_seq_printf(s, "dpa_flags:") <= 0)
-		return -1;
+	trace_seq_printf(s, "dpa_flags:");
 	if (decode_cxl_event_flags(s, ev.dpa_flags, cxl_dpa_flags,
 				   ARRAY_SIZE(cxl_dpa_flags)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s,  event, "descriptor", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_DESCRIPTOR], record, &val, 1) < 0)
 		return -1;
 	ev.descriptor = val;
-	if (trace_seq_printf(s, "descriptor:") <= 0)
-		return -1;
+	trace_seq_printf(s, "descriptor:");
 	if (decode_cxl_event_flags(s, ev.descriptor, cxl_gmer_event_desc_flags,
 				   ARRAY_SIZE(cxl_gmer_event_desc_flags)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s,  event, "type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.type = val;
-	if (trace_seq_printf(s, "memory_event_type:%s ",
-			     get_cxl_type_str(cxl_der_mem_event_type,
-					      ARRAY_SIZE(cxl_der_mem_event_type),
-					      ev.type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "memory_event_type:%s ",
+			 get_cxl_type_str(cxl_der_mem_event_type,
+					  ARRAY_SIZE(cxl_der_mem_event_type),
+					  ev.type));
 
-	if (tep_get_field_val(s,  event, "sub_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_SUB_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.sub_type = val;
-	if (trace_seq_printf(s, "memory_event_sub_type:%s ",
-			     get_cxl_type_str(cxl_mem_event_sub_type,
-					      ARRAY_SIZE(cxl_mem_event_sub_type),
-					      ev.sub_type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "memory_event_sub_type:%s ",
+			 get_cxl_type_str(cxl_mem_event_sub_type,
+					  ARRAY_SIZE(cxl_mem_event_sub_type),
+					  ev.sub_type));
 
-	if (tep_get_field_val(s,  event, "transaction_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_TRANSACTION_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.transaction_type = val;
-	if (trace_seq_printf(s, "transaction_type:%s ",
-			     get_cxl_type_str(cxl_gmer_trans_type,
-					      ARRAY_SIZE(cxl_gmer_trans_type),
-					      ev.transaction_type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "transaction_type:%s ",
+			 get_cxl_type_str(cxl_gmer_trans_type,
+					  ARRAY_SIZE(cxl_gmer_trans_type),
+					  ev.transaction_type));
 
-	if (tep_get_field_val(s, event, "hpa", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_HPA], record, &val, 1) < 0)
 		return -1;
 	ev.hpa = val;
-	if (trace_seq_printf(s, "hpa:0x%llx ", (unsigned long long)ev.hpa) <= 0)
-		return -1;
+	trace_seq_printf(s, "hpa:0x%llx ", (unsigned long long)ev.hpa);
 
-	if (tep_get_field_val(s, event, "hpa_alias0", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_HPA_ALIAS0], record, &val, 1) < 0)
 		return -1;
 	ev.hpa_alias0 = val;
-	if (trace_seq_printf(s, "hpa_alias0:0x%llx ", (unsigned long long)ev.hpa_alias0) <= 0)
-		return -1;
+	trace_seq_printf(s, "hpa_alias0:0x%llx ", (unsigned long long)ev.hpa_alias0);
 
-	ev.region = tep_get_field_raw(s, event, "region_name", record, &len, 1);
+	ev.region = ras_get_field_raw(s, &f[CXL_DER_FIELD_REGION_NAME], record, &len, 1);
 	if (!ev.region)
 		return -1;
-	if (trace_seq_printf(s, "region:%s ", ev.region) <= 0)
-		return -1;
+	trace_seq_printf(s, "region:%s ", ev.region);
 
-	ev.region_uuid = tep_get_field_raw(s, event, "region_uuid",
-					   record, &len, 1);
+	ev.region_uuid = ras_get_field_raw(s, &f[CXL_DER_FIELD_REGION_UUID], record, &len, 1);
 	if (!ev.region_uuid)
 		return -1;
 	ev.region_uuid = uuid_be(ev.region_uuid);
-	if (trace_seq_printf(s, "region_uuid:%s ", ev.region_uuid) <= 0)
-		return -1;
+	trace_seq_printf(s, "region_uuid:%s ", ev.region_uuid);
 
-	if (tep_get_field_val(s,  event, "validity_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_DER_FIELD_VALIDITY_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.validity_flags = val;
 
 	if (ev.validity_flags & CXL_DER_VALID_CHANNEL) {
-		if (tep_get_field_val(s,  event, "channel", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_CHANNEL], record, &val, 1) < 0)
 			return -1;
 		ev.channel = val;
-		if (trace_seq_printf(s, "channel:%u ", ev.channel) <= 0)
-			return -1;
+		trace_seq_printf(s, "channel:%u ", ev.channel);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_SUB_CHANNEL) {
-		if (tep_get_field_val(s,  event, "sub_channel", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_SUB_CHANNEL], record, &val, 1) < 0)
 			return -1;
 		ev.sub_channel = val;
-		if (trace_seq_printf(s, "sub_channel:%u ", ev.sub_channel) <= 0)
-			return -1;
+		trace_seq_printf(s, "sub_channel:%u ", ev.sub_channel);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_RANK) {
-		if (tep_get_field_val(s,  event, "rank", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_RANK], record, &val, 1) < 0)
 			return -1;
 		ev.rank = val;
-		if (trace_seq_printf(s, "rank:%u ", ev.rank) <= 0)
-			return -1;
+		trace_seq_printf(s, "rank:%u ", ev.rank);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_NIBBLE) {
-		if (tep_get_field_val(s,  event, "nibble_mask", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_NIBBLE_MASK], record, &val, 1) < 0)
 			return -1;
 		ev.nibble_mask = val;
-		if (trace_seq_printf(s, "nibble_mask:%u ", ev.nibble_mask) <= 0)
-			return -1;
+		trace_seq_printf(s, "nibble_mask:%u ", ev.nibble_mask);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_BANK_GROUP) {
-		if (tep_get_field_val(s,  event, "bank_group", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_BANK_GROUP], record, &val, 1) < 0)
 			return -1;
 		ev.bank_group = val;
-		if (trace_seq_printf(s, "bank_group:%u ", ev.bank_group) <= 0)
-			return -1;
+		trace_seq_printf(s, "bank_group:%u ", ev.bank_group);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_BANK) {
-		if (tep_get_field_val(s,  event, "bank", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_BANK], record, &val, 1) < 0)
 			return -1;
 		ev.bank = val;
-		if (trace_seq_printf(s, "bank:%u ", ev.bank) <= 0)
-			return -1;
+		trace_seq_printf(s, "bank:%u ", ev.bank);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_ROW) {
-		if (tep_get_field_val(s,  event, "row", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_ROW], record, &val, 1) < 0)
 			return -1;
 		ev.row = val;
-		if (trace_seq_printf(s, "row:%u ", ev.row) <= 0)
-			return -1;
+		trace_seq_printf(s, "row:%u ", ev.row);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_COLUMN) {
-		if (tep_get_field_val(s,  event, "column", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_COLUMN], record, &val, 1) < 0)
 			return -1;
 		ev.column = val;
-		if (trace_seq_printf(s, "column:%u ", ev.column) <= 0)
-			return -1;
+		trace_seq_printf(s, "column:%u ", ev.column);
 	}
 
 	if (ev.validity_flags & CXL_DER_VALID_CORRECTION_MASK) {
-		ev.cor_mask = tep_get_field_raw(s, event, "cor_mask", record, &len, 1);
+		ev.cor_mask = ras_get_field_raw(s, &f[CXL_DER_FIELD_COR_MASK], record, &len, 1);
 		if (!ev.cor_mask)
 			return -1;
-		if (trace_seq_printf(s, "correction_mask:") <= 0)
-			return -1;
+		trace_seq_printf(s, "correction_mask:");
 		for (i = 0; i < CXL_EVENT_DER_CORRECTION_MASK_SIZE; i++) {
-			if (trace_seq_printf(s, "%02x ", ev.cor_mask[i]) <= 0)
-				break;
+			trace_seq_printf(s, "%02x ", ev.cor_mask[i]);
 		}
 	}
 
@@ -1249,19 +1333,16 @@ int ras_cxl_dram_event_handler(struct trace_seq *s,
 #endif
 
 	if (ev.validity_flags & CXL_DER_VALID_COMPONENT_ID) {
-		ev.comp_id = tep_get_field_raw(s, event, "comp_id", record, &len, 1);
+		ev.comp_id = ras_get_field_raw(s, &f[CXL_DER_FIELD_COMP_ID], record, &len, 1);
 		if (!ev.comp_id)
 			return -1;
-		if (trace_seq_printf(s, "comp_id:") <= 0)
-			return -1;
+		trace_seq_printf(s, "comp_id:");
 		for (i = 0; i < CXL_EVENT_GEN_MED_COMP_ID_SIZE; i++) {
-			if (trace_seq_printf(s, "%02x ", ev.comp_id[i]) <= 0)
-				break;
+			trace_seq_printf(s, "%02x ", ev.comp_id[i]);
 		}
 
 		if (ev.validity_flags & CXL_DER_VALID_COMPONENT_ID_FORMAT) {
-			if (trace_seq_printf(s, "comp_id_pldm_valid_flags:") <= 0)
-				return -1;
+			trace_seq_printf(s, "comp_id_pldm_valid_flags:");
 			if (decode_cxl_event_flags(s, ev.comp_id[0], cxl_pldm_comp_id_flags,
 						   ARRAY_SIZE(cxl_pldm_comp_id_flags)) < 0)
 				return -1;
@@ -1273,32 +1354,23 @@ int ras_cxl_dram_event_handler(struct trace_seq *s,
 	}
 
 	if (ev.descriptor & CXL_GMER_EVT_DESC_THRESHOLD_EVENT) {
-		if (tep_get_field_val(s,  event, "cme_threshold_ev_flags", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_CME_THRESHOLD_EV_FLAGS], record, &val, 1) < 0)
 			return -1;
 		ev.cme_threshold_ev_flags = val;
-		if (trace_seq_printf(s, "Advanced Programmable CME threshold Event Flags:") <= 0)
-			return -1;
+		trace_seq_printf(s, "Advanced Programmable CME threshold Event Flags:");
 		if (decode_cxl_event_flags(s, ev.cme_threshold_ev_flags,
 					   cxl_cme_threshold_ev_flags,
 					   ARRAY_SIZE(cxl_cme_threshold_ev_flags)) < 0)
 			return -1;
 
-		if (tep_get_field_val(s,  event, "cvme_count", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_DER_FIELD_CVME_COUNT], record, &val, 1) < 0)
 			return -1;
 		ev.cvme_count = val;
-		if (trace_seq_printf(s, "CVME Count:%u ", ev.cvme_count) <= 0)
-			return -1;
+		trace_seq_printf(s, "CVME Count:%u ", ev.cvme_count);
 	}
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_dram_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_dram_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_DRAM_EVENT,
+		      ras_severity_from_str(ev.hdr.log_type), &ev);
 
 	return 0;
 }
@@ -1376,127 +1448,144 @@ static const char * const cxl_one_bit_status[] = {
 #define CXL_MMER_VALID_COMPONENT_ID		BIT(0)
 #define CXL_MMER_VALID_COMPONENT_ID_FORMAT	BIT(1)
 
+enum {
+	CXL_MMER_FIELD_EVENT_TYPE = NR_CXL_HDR_FIELDS,
+	CXL_MMER_FIELD_EVENT_SUB_TYPE,
+	CXL_MMER_FIELD_HEALTH_STATUS,
+	CXL_MMER_FIELD_MEDIA_STATUS,
+	CXL_MMER_FIELD_ADD_STATUS,
+	CXL_MMER_FIELD_LIFE_USED,
+	CXL_MMER_FIELD_DEVICE_TEMP,
+	CXL_MMER_FIELD_DIRTY_SHUTDOWN_CNT,
+	CXL_MMER_FIELD_COR_VOL_ERR_CNT,
+	CXL_MMER_FIELD_COR_PER_ERR_CNT,
+	CXL_MMER_FIELD_VALIDITY_FLAGS,
+	CXL_MMER_FIELD_COMP_ID,
+};
+
+struct ras_field cxl_memory_module_event_tep_fields[] = {
+	CXL_HDR_FIELDS,
+	[CXL_MMER_FIELD_EVENT_TYPE] = RAS_FIELD("event_type"),
+	[CXL_MMER_FIELD_EVENT_SUB_TYPE] = RAS_FIELD("event_sub_type"),
+	[CXL_MMER_FIELD_HEALTH_STATUS] = RAS_FIELD("health_status"),
+	[CXL_MMER_FIELD_MEDIA_STATUS] = RAS_FIELD("media_status"),
+	[CXL_MMER_FIELD_ADD_STATUS] = RAS_FIELD("add_status"),
+	[CXL_MMER_FIELD_LIFE_USED] = RAS_FIELD("life_used"),
+	[CXL_MMER_FIELD_DEVICE_TEMP] = RAS_FIELD("device_temp"),
+	[CXL_MMER_FIELD_DIRTY_SHUTDOWN_CNT] = RAS_FIELD("dirty_shutdown_cnt"),
+	[CXL_MMER_FIELD_COR_VOL_ERR_CNT] = RAS_FIELD("cor_vol_err_cnt"),
+	[CXL_MMER_FIELD_COR_PER_ERR_CNT] = RAS_FIELD("cor_per_err_cnt"),
+	[CXL_MMER_FIELD_VALIDITY_FLAGS] = RAS_FIELD("validity_flags"),
+	[CXL_MMER_FIELD_COMP_ID] = RAS_FIELD("comp_id"),
+	{ }
+};
+
 int ras_cxl_memory_module_event_handler(struct trace_seq *s,
 					struct tep_record *record,
 					struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_memory_module_event_tep_fields;
 	int len, i, rc;
 	unsigned long long val;
 	struct ras_events *ras = context;
 	struct ras_cxl_memory_module_event ev;
 
 	memset(&ev, 0, sizeof(ev));
-	if (handle_ras_cxl_common_hdr(s, record, event, context, &ev.hdr) < 0)
+	if (handle_ras_cxl_common_hdr(s, record, f, context, &ev.hdr) < 0)
 		return -1;
 
-	if (tep_get_field_val(s, event, "event_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_EVENT_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.event_type = val;
-	if (trace_seq_printf(s, "event_type:%s ",
-			     get_cxl_type_str(cxl_dev_evt_type,
-					      ARRAY_SIZE(cxl_dev_evt_type),
-					      ev.event_type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "event_type:%s ",
+			 get_cxl_type_str(cxl_dev_evt_type,
+					  ARRAY_SIZE(cxl_dev_evt_type),
+					  ev.event_type));
 
-	if (tep_get_field_val(s, event, "event_sub_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_EVENT_SUB_TYPE], record, &val, 1) < 0)
 		return -1;
 	ev.event_sub_type = val;
-	if (trace_seq_printf(s, "event_sub_type:%s ",
-			     get_cxl_type_str(cxl_dev_evt_sub_type,
-					      ARRAY_SIZE(cxl_dev_evt_sub_type),
-					      ev.event_sub_type)) <= 0)
-		return -1;
+	trace_seq_printf(s, "event_sub_type:%s ",
+			 get_cxl_type_str(cxl_dev_evt_sub_type,
+					  ARRAY_SIZE(cxl_dev_evt_sub_type),
+					  ev.event_sub_type));
 
-	if (tep_get_field_val(s, event, "health_status", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_HEALTH_STATUS], record, &val, 1) < 0)
 		return -1;
 	ev.health_status = val;
-	if (trace_seq_printf(s, "health_status:") <= 0)
-		return -1;
+	trace_seq_printf(s, "health_status:");
 	if (decode_cxl_event_flags(s, ev.health_status, cxl_health_status,
 				   ARRAY_SIZE(cxl_health_status)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s, event, "media_status", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_MEDIA_STATUS], record, &val, 1) < 0)
 		return -1;
 	ev.media_status = val;
-	if (trace_seq_printf(s, "media_status:%s ",
-			     get_cxl_type_str(cxl_media_status,
-					      ARRAY_SIZE(cxl_media_status),
-					      ev.media_status)) <= 0)
-		return -1;
+	trace_seq_printf(s, "media_status:%s ",
+			 get_cxl_type_str(cxl_media_status,
+					  ARRAY_SIZE(cxl_media_status),
+					  ev.media_status));
 
-	if (tep_get_field_val(s, event, "add_status", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_ADD_STATUS], record, &val, 1) < 0)
 		return -1;
 	ev.add_status = val;
-	if (trace_seq_printf(s, "as_life_used:%s ",
-			     get_cxl_type_str(cxl_two_bit_status,
-					      ARRAY_SIZE(cxl_two_bit_status),
-			     CXL_DHI_AS_LIFE_USED(ev.add_status))) <= 0)
-		return -1;
-	if (trace_seq_printf(s, "as_dev_temp:%s ",
-			     get_cxl_type_str(cxl_two_bit_status,
-					      ARRAY_SIZE(cxl_two_bit_status),
-			     CXL_DHI_AS_DEV_TEMP(ev.add_status))) <= 0)
-		return -1;
-	if (trace_seq_printf(s, "as_cor_vol_err_cnt:%s ",
-			     get_cxl_type_str(cxl_one_bit_status,
-					      ARRAY_SIZE(cxl_one_bit_status),
-			     CXL_DHI_AS_COR_VOL_ERR_CNT(ev.add_status))) <= 0)
-		return -1;
-	if (trace_seq_printf(s, "as_cor_per_err_cnt:%s ",
-			     get_cxl_type_str(cxl_one_bit_status,
-					      ARRAY_SIZE(cxl_one_bit_status),
-			     CXL_DHI_AS_COR_PER_ERR_CNT(ev.add_status))) <= 0)
-		return -1;
-
-	if (tep_get_field_val(s, event, "life_used", record, &val, 1) < 0)
+	trace_seq_printf(s, "as_life_used:%s ",
+			 get_cxl_type_str(cxl_two_bit_status,
+					  ARRAY_SIZE(cxl_two_bit_status),
+			 CXL_DHI_AS_LIFE_USED(ev.add_status)));
+	trace_seq_printf(s, "as_dev_temp:%s ",
+			 get_cxl_type_str(cxl_two_bit_status,
+					  ARRAY_SIZE(cxl_two_bit_status),
+			 CXL_DHI_AS_DEV_TEMP(ev.add_status)));
+	trace_seq_printf(s, "as_cor_vol_err_cnt:%s ",
+			 get_cxl_type_str(cxl_one_bit_status,
+					  ARRAY_SIZE(cxl_one_bit_status),
+			 CXL_DHI_AS_COR_VOL_ERR_CNT(ev.add_status)));
+	trace_seq_printf(s, "as_cor_per_err_cnt:%s ",
+			 get_cxl_type_str(cxl_one_bit_status,
+					  ARRAY_SIZE(cxl_one_bit_status),
+			 CXL_DHI_AS_COR_PER_ERR_CNT(ev.add_status)));
+
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_LIFE_USED], record, &val, 1) < 0)
 		return -1;
 	ev.life_used = val;
-	if (trace_seq_printf(s, "life_used:%u ", ev.life_used) <= 0)
-		return -1;
+	trace_seq_printf(s, "life_used:%u ", ev.life_used);
 
-	if (tep_get_field_val(s, event, "device_temp", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_DEVICE_TEMP], record, &val, 1) < 0)
 		return -1;
 	ev.device_temp = val;
-	if (trace_seq_printf(s, "device_temp:%u ", ev.device_temp) <= 0)
-		return -1;
+	trace_seq_printf(s, "device_temp:%u ", ev.device_temp);
 
-	if (tep_get_field_val(s, event, "dirty_shutdown_cnt", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_DIRTY_SHUTDOWN_CNT], record, &val, 1) < 0)
 		return -1;
 	ev.dirty_shutdown_cnt = val;
-	if (trace_seq_printf(s, "dirty_shutdown_cnt:%u ", ev.dirty_shutdown_cnt) <= 0)
-		return -1;
+	trace_seq_printf(s, "dirty_shutdown_cnt:%u ", ev.dirty_shutdown_cnt);
 
-	if (tep_get_field_val(s, event, "cor_vol_err_cnt", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_COR_VOL_ERR_CNT], record, &val, 1) < 0)
 		return -1;
 	ev.cor_vol_err_cnt = val;
-	if (trace_seq_printf(s, "cor_vol_err_cnt:%u ", ev.cor_vol_err_cnt) <= 0)
-		return -1;
+	trace_seq_printf(s, "cor_vol_err_cnt:%u ", ev.cor_vol_err_cnt);
 
-	if (tep_get_field_val(s, event, "cor_per_err_cnt", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_COR_PER_ERR_CNT], record, &val, 1) < 0)
 		return -1;
 	ev.cor_per_err_cnt = val;
-	if (trace_seq_printf(s, "cor_per_err_cnt:%u ", ev.cor_per_err_cnt) <= 0)
-		return -1;
+	trace_seq_printf(s, "cor_per_err_cnt:%u ", ev.cor_per_err_cnt);
 
-	if (tep_get_field_val(s,  event, "validity_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MMER_FIELD_VALIDITY_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.validity_flags = val;
 
 	if (ev.validity_flags & CXL_MMER_VALID_COMPONENT_ID) {
-		ev.comp_id = tep_get_field_raw(s, event, "comp_id", record, &len, 1);
+		ev.comp_id = ras_get_field_raw(s, &f[CXL_MMER_FIELD_COMP_ID], record, &len, 1);
 		if (!ev.comp_id)
 			return -1;
-		if (trace_seq_printf(s, "comp_id:") <= 0)
-			return -1;
+		trace_seq_printf(s, "comp_id:");
 		for (i = 0; i < CXL_EVENT_GEN_MED_COMP_ID_SIZE; i++) {
-			if (trace_seq_printf(s, "%02x ", ev.comp_id[i]) <= 0)
-				break;
+			trace_seq_printf(s, "%02x ", ev.comp_id[i]);
 		}
 
 		if (ev.validity_flags & CXL_MMER_VALID_COMPONENT_ID_FORMAT) {
-			if (trace_seq_printf(s, "comp_id_pldm_valid_flags:") <= 0)
-				return -1;
+			trace_seq_printf(s, "comp_id_pldm_valid_flags:");
 			if (decode_cxl_event_flags(s, ev.comp_id[0], cxl_pldm_comp_id_flags,
 						   ARRAY_SIZE(cxl_pldm_comp_id_flags)) < 0)
 				return -1;
@@ -1506,15 +1595,8 @@ int ras_cxl_memory_module_event_handler(struct trace_seq *s,
 				return rc;
 		}
 	}
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_cxl_memory_module_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_cxl_memory_module_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, CXL_MEMORY_MODULE_EVENT,
+		      ras_severity_from_str(ev.hdr.log_type), &ev);
 
 	return 0;
 }
@@ -1545,121 +1627,142 @@ static const struct cxl_event_flags cxl_mser_flags[] = {
 	{ .bit = CXL_MSER_DEV_INITIATED_FLAG, .flag = "DEVICE_INITIATED" },
 };
 
+enum {
+	CXL_MSER_FIELD_FLAGS = NR_CXL_HDR_FIELDS,
+	CXL_MSER_FIELD_RESULT,
+	CXL_MSER_FIELD_VALIDITY_FLAGS,
+	CXL_MSER_FIELD_RES_AVAIL,
+	CXL_MSER_FIELD_CHANNEL,
+	CXL_MSER_FIELD_SUB_CHANNEL,
+	CXL_MSER_FIELD_RANK,
+	CXL_MSER_FIELD_NIBBLE_MASK,
+	CXL_MSER_FIELD_BANK_GROUP,
+	CXL_MSER_FIELD_BANK,
+	CXL_MSER_FIELD_ROW,
+	CXL_MSER_FIELD_COLUMN,
+	CXL_MSER_FIELD_COMP_ID,
+};
+
+struct ras_field cxl_memory_sparing_event_tep_fields[] = {
+	CXL_HDR_FIELDS,
+	[CXL_MSER_FIELD_FLAGS] = RAS_FIELD("flags"),
+	[CXL_MSER_FIELD_RESULT] = RAS_FIELD("result"),
+	[CXL_MSER_FIELD_VALIDITY_FLAGS] = RAS_FIELD("validity_flags"),
+	[CXL_MSER_FIELD_RES_AVAIL] = RAS_FIELD("res_avail"),
+	[CXL_MSER_FIELD_CHANNEL] = RAS_FIELD("channel"),
+	[CXL_MSER_FIELD_SUB_CHANNEL] = RAS_FIELD("sub_channel"),
+	[CXL_MSER_FIELD_RANK] = RAS_FIELD("rank"),
+	[CXL_MSER_FIELD_NIBBLE_MASK] = RAS_FIELD("nibble_mask"),
+	[CXL_MSER_FIELD_BANK_GROUP] = RAS_FIELD("bank_group"),
+	[CXL_MSER_FIELD_BANK] = RAS_FIELD("bank"),
+	[CXL_MSER_FIELD_ROW] = RAS_FIELD("row"),
+	[CXL_MSER_FIELD_COLUMN] = RAS_FIELD("column"),
+	[CXL_MSER_FIELD_COMP_ID] = RAS_FIELD("comp_id"),
+	{ }
+};
+
 int ras_cxl_memory_sparing_event_handler(struct trace_seq *s,
 					 struct tep_record *record,
 					 struct tep_event *event, void *context)
 {
+	struct ras_field *f = cxl_memory_sparing_event_tep_fields;
 	int len, i, rc;
 	unsigned long long val;
 	struct ras_cxl_memory_sparing_event ev;
 
 	memset(&ev, 0, sizeof(ev));
-	if (handle_ras_cxl_common_hdr(s, record, event, context, &ev.hdr) < 0)
+	if (handle_ras_cxl_common_hdr(s, record, f, context, &ev.hdr) < 0)
 		return -1;
 
-	if (tep_get_field_val(s, event, "flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MSER_FIELD_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.flags = val;
-	if (trace_seq_printf(s, "flags:0x%x ", ev.flags) <= 0)
-		return -1;
+	trace_seq_printf(s, "flags:0x%x ", ev.flags);
 	if (decode_cxl_event_flags(s, ev.flags, cxl_mser_flags,
 				   ARRAY_SIZE(cxl_mser_flags)) < 0)
 		return -1;
 
-	if (tep_get_field_val(s,  event, "result", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MSER_FIELD_RESULT], record, &val, 1) < 0)
 		return -1;
 	ev.result = val;
-	if (trace_seq_printf(s, "result:0x%x ", ev.result) <= 0)
-		return -1;
+	trace_seq_printf(s, "result:0x%x ", ev.result);
 
-	if (tep_get_field_val(s,  event, "validity_flags", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MSER_FIELD_VALIDITY_FLAGS], record, &val, 1) < 0)
 		return -1;
 	ev.validity_flags = val;
 
-	if (tep_get_field_val(s,  event, "res_avail", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[CXL_MSER_FIELD_RES_AVAIL], record, &val, 1) < 0)
 		return -1;
 	ev.res_avail = val;
-	if (trace_seq_printf(s, "spare resources available:%u ", ev.res_avail) <= 0)
-		return -1;
+	trace_seq_printf(s, "spare resources available:%u ", ev.res_avail);
 
 	if (ev.validity_flags & CXL_MSER_VALID_CHANNEL) {
-		if (tep_get_field_val(s,  event, "channel", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_CHANNEL], record, &val, 1) < 0)
 			return -1;
 		ev.channel = val;
-		if (trace_seq_printf(s, "channel:%u ", ev.channel) <= 0)
-			return -1;
+		trace_seq_printf(s, "channel:%u ", ev.channel);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_SUB_CHANNEL) {
-		if (tep_get_field_val(s,  event, "sub_channel", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_SUB_CHANNEL], record, &val, 1) < 0)
 			return -1;
 		ev.sub_channel = val;
-		if (trace_seq_printf(s, "sub_channel:%u ", ev.sub_channel) <= 0)
-			return -1;
+		trace_seq_printf(s, "sub_channel:%u ", ev.sub_channel);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_RANK) {
-		if (tep_get_field_val(s,  event, "rank", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_RANK], record, &val, 1) < 0)
 			return -1;
 		ev.rank = val;
-		if (trace_seq_printf(s, "rank:%u ", ev.rank) <= 0)
-			return -1;
+		trace_seq_printf(s, "rank:%u ", ev.rank);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_NIBBLE) {
-		if (tep_get_field_val(s,  event, "nibble_mask", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_NIBBLE_MASK], record, &val, 1) < 0)
 			return -1;
 		ev.nibble_mask = val;
-		if (trace_seq_printf(s, "nibble_mask:%u ", ev.nibble_mask) <= 0)
-			return -1;
+		trace_seq_printf(s, "nibble_mask:%u ", ev.nibble_mask);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_BANK_GROUP) {
-		if (tep_get_field_val(s,  event, "bank_group", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_BANK_GROUP], record, &val, 1) < 0)
 			return -1;
 		ev.bank_group = val;
-		if (trace_seq_printf(s, "bank_group:%u ", ev.bank_group) <= 0)
-			return -1;
+		trace_seq_printf(s, "bank_group:%u ", ev.bank_group);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_BANK) {
-		if (tep_get_field_val(s,  event, "bank", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_BANK], record, &val, 1) < 0)
 			return -1;
 		ev.bank = val;
-		if (trace_seq_printf(s, "bank:%u ", ev.bank) <= 0)
-			return -1;
+		trace_seq_printf(s, "bank:%u ", ev.bank);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_ROW) {
-		if (tep_get_field_val(s,  event, "row", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_ROW], record, &val, 1) < 0)
 			return -1;
 		ev.row = val;
-		if (trace_seq_printf(s, "row:%u ", ev.row) <= 0)
-			return -1;
+		trace_seq_printf(s, "row:%u ", ev.row);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_COLUMN) {
-		if (tep_get_field_val(s,  event, "column", record, &val, 1) < 0)
+		if (ras_get_field_val(s, &f[CXL_MSER_FIELD_COLUMN], record, &val, 1) < 0)
 			return -1;
 		ev.column = val;
-		if (trace_seq_printf(s, "column:%u ", ev.column) <= 0)
-			return -1;
+		trace_seq_printf(s, "column:%u ", ev.column);
 	}
 
 	if (ev.validity_flags & CXL_MSER_VALID_COMPONENT_ID) {
-		ev.comp_id = tep_get_field_raw(s, event, "comp_id", record, &len, 1);
+		ev.comp_id = ras_get_field_raw(s, &f[CXL_MSER_FIELD_COMP_ID], record, &len, 1);
 		if (!ev.comp_id)
 			return -1;
-		if (trace_seq_printf(s, "comp_id:") <= 0)
-			return -1;
+		trace_seq_printf(s, "comp_id:");
 		for (i = 0; i < CXL_EVENT_GEN_MED_COMP_ID_SIZE; i++) {
-			if (trace_seq_printf(s, "%02x ", ev.comp_id[i]) <= 0)
-				break;
+			trace_seq_printf(s, "%02x ", ev.comp_id[i]);
 		}
 
 		if (ev.validity_flags & CXL_MSER_VALID_COMPONENT_ID_FORMAT) {
-			if (trace_seq_printf(s, "comp_id_pldm_valid_flags:") <= 0)
-				return -1;
+			trace_seq_printf(s, "comp_id_pldm_valid_flags:");
 			if (decode_cxl_event_flags(s, ev.comp_id[0], cxl_pldm_comp_id_flags,
 						   ARRAY_SIZE(cxl_pldm_comp_id_flags)) < 0)
 				return -1;
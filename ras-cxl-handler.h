@@ -11,6 +11,16 @@
 
 #include "ras-events.h"
 
+extern struct ras_field cxl_poison_event_tep_fields[];
+extern struct ras_field cxl_aer_ue_event_tep_fields[];
+extern struct ras_field cxl_aer_ce_event_tep_fields[];
+extern struct ras_field cxl_overflow_event_tep_fields[];
+extern struct ras_field cxl_generic_event_tep_fields[];
+extern struct ras_field cxl_general_media_event_tep_fields[];
+extern struct ras_field cxl_dram_event_tep_fields[];
+extern struct ras_field cxl_memory_module_event_tep_fields[];
+extern struct ras_field cxl_memory_sparing_event_tep_fields[];
+
 int ras_cxl_poison_event_handler(struct trace_seq *s,
 				 struct tep_record *record,
 				 struct tep_event *event, void *context);
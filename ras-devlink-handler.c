@@ -13,7 +13,8 @@
 
 #include "ras-devlink-handler.h"
 #include "ras-logger.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 int ras_net_xmit_timeout_handler(struct trace_seq *s,
@@ -56,15 +57,7 @@ int ras_net_xmit_timeout_handler(struct trace_seq *s,
 	if (asprintf(&ev.msg, "TX timeout on queue: %d\n", (int)val) < 0)
 		return -1;
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_devlink_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_devlink_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, DEVLINK_EVENT, RAS_SEV_INFO, &ev);
 
 	free(ev.msg);
 	return 0;
@@ -129,15 +122,7 @@ int ras_devlink_event_handler(struct trace_seq *s,
 	if (!ev.msg)
 		return -1;
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_devlink_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_devlink_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, DEVLINK_EVENT, RAS_SEV_INFO, &ev);
 
 	return 0;
 }
@@ -13,7 +13,8 @@
 
 #include "ras-diskerror-handler.h"
 #include "ras-logger.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 static const struct {
@@ -104,15 +105,8 @@ int ras_diskerror_event_handler(struct trace_seq *s,
 	if (!ev.cmd)
 		return -1;
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_diskerror_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, DISKERROR_EVENT, RAS_SEV_UNCORRECTED, &ev);
 
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_diskerror_event(ras, &ev);
-#endif
 	free(ev.dev);
 	return 0;
 }
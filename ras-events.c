@@ -4,24 +4,37 @@
  * Copyright (C) 2013 Mauro Carvalho Chehab <mchehab+huawei@kernel.org>
  */
 
+#define _GNU_SOURCE
+#include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <sched.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/poll.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/signalfd.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
+#include <time.h>
 #include <traceevent/event-parse.h>
 #include <traceevent/kbuffer.h>
 #include <unistd.h>
 
 #include "ras-aer-handler.h"
 #include "ras-arm-handler.h"
+#include "ras-capture.h"
 #include "ras-cpu-isolation.h"
 #include "ras-cxl-handler.h"
 #include "ras-devlink-handler.h"
@@ -32,10 +45,16 @@
 #include "ras-aer-handler.h"
 #include "ras-mce-handler.h"
 #include "ras-mc-handler.h"
+#include "ras-metrics.h"
 #include "ras-memory-failure-handler.h"
 #include "ras-non-standard-handler.h"
+#include "ras-output.h"
 #include "ras-page-isolation.h"
+#include "ras-pipeline.h"
+#include "ras-report.h"
 #include "ras-signal-handler.h"
+#include "ras-stats.h"
+#include "ras-subscribe.h"
 #include "ras-record.h"
 #include "ras-reri-handler.h"
 #include "trigger.h"
@@ -54,6 +73,36 @@
 	#define ENDIAN TEP_BIG_ENDIAN
 #endif
 
+#ifdef HAVE_LINUX_TRACE_MMAP_H
+#include <linux/trace_mmap.h>
+#else
+/* From Kernel's include/uapi/linux/trace_mmap.h (Kernel 6.10 and upper) */
+struct trace_buffer_meta {
+	uint32_t	meta_page_size;
+	uint32_t	meta_struct_len;
+
+	uint32_t	subbuf_size;
+	uint32_t	nr_subbufs;
+
+	struct {
+		uint64_t	lost_events;
+		uint32_t	id;
+		uint32_t	read;
+	} reader;
+
+	uint64_t	flags;
+
+	uint64_t	entries;
+	uint64_t	overrun;
+	uint64_t	read;
+
+	uint64_t	Reserved1;
+	uint64_t	Reserved2;
+};
+
+#define TRACE_MMAP_IOCTL_GET_READER	_IO('R', 0x20)
+#endif
+
 char *choices_disable;
 
 static const struct event_trigger event_triggers[] = {
@@ -117,16 +166,74 @@ static int get_tracefs_dir(char *tracing_dir, size_t len)
 	return get_mountdir_by_type("tracefs", tracing_dir, len);
 }
 
+static long elapsed_ms(struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000 +
+	       (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/*
+ * Wait for a tracefs file to be created. At early boot, the tracing
+ * files may not be there yet, so watch the parent directory for new
+ * entries, instead of polling it.
+ */
 static int wait_access(char *path, int ms)
 {
-	int i;
+	char dir[MAX_PATH + 1], *p;
+	struct timespec start;
+	struct pollfd pfd;
+	char buf[4096];
+	long left;
+	int fd, i;
 
-	for (i = 0; i < ms; i++) {
-		if (access(path, F_OK) == 0)
-			return 0;
-		usleep(1000);
+	if (access(path, F_OK) == 0)
+		return 0;
+
+	strscpy(dir, path, sizeof(dir));
+	p = strrchr(dir, '/');
+	if (p)
+		*p = '\0';
+
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd >= 0 && inotify_add_watch(fd, dir, IN_CREATE | IN_MOVED_TO) < 0) {
+		close(fd);
+		fd = -1;
 	}
 
+	if (fd < 0) {
+		/* Parent directory doesn't exist yet: poll */
+		for (i = 0; i < ms; i++) {
+			if (access(path, F_OK) == 0)
+				return 0;
+			usleep(1000);
+		}
+		goto timeout;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	do {
+		/* Re-check, as the file may be created before adding the watch */
+		if (access(path, F_OK) == 0) {
+			close(fd);
+			return 0;
+		}
+
+		left = ms - elapsed_ms(&start);
+		if (left <= 0)
+			break;
+		if (poll(&pfd, 1, left < 100 ? left : 100) > 0)
+			while (read(fd, buf, sizeof(buf)) > 0)
+				;
+	} while (1);
+	close(fd);
+
+timeout:
 	log(ALL, LOG_WARNING, "%s failed, %s not created in %d ms\n",
 	    __func__, path, ms);
 	return -1;
@@ -163,6 +270,19 @@ static int open_trace(struct ras_events *ras, char *name, int flags)
 	return rc;
 }
 
+#define TRACING_ROOT	"TRACING_ROOT"
+
+/*
+ * An alternative tracing directory, like the synthetic one created by
+ * contrib/fake_tracefs.py, in order to run without RAS hardware
+ */
+static char *get_tracing_root(void)
+{
+	char *env = getenv(TRACING_ROOT);
+
+	return env && *env ? env : NULL;
+}
+
 static int get_tracing_dir(struct ras_events *ras)
 {
 	char		fname[MAX_PATH + 1];
@@ -170,6 +290,17 @@ static int get_tracing_dir(struct ras_events *ras)
 	int		rc, has_instances = 0;
 	DIR		*dir;
 	struct dirent	*entry;
+	char		*root;
+
+	root = get_tracing_root();
+	if (root) {
+		rc = strscpy(ras->tracing, root, sizeof(ras->tracing));
+		if (rc < 0)
+			return rc;
+
+		log(ALL, LOG_INFO, "Using tracing root %s\n", ras->tracing);
+		return 0;
+	}
 
 	rc = get_tracefs_dir(fname, sizeof(fname));
 	if (rc < 0)
@@ -379,6 +510,10 @@ static int filter_ras_mc_event(struct ras_events *ras, char *group, char *event,
 	int fd, rc;
 	char fname[MAX_PATH + 1];
 
+	/* Captures only have the events that passed the filters */
+	if (ras_replaying())
+		return 0;
+
 	snprintf(fname, sizeof(fname), "events/%s/%s/filter", group, event);
 	fd = open_trace(ras, fname, O_RDWR | O_APPEND);
 	if (fd < 0) {
@@ -411,6 +546,15 @@ static int get_pagesize(struct ras_events *ras, struct tep_handle *pevent)
 {
 	int fd, len, page_size = 4096;
 	char buf[page_size];
+	const char *hdr;
+
+	if (ras_replaying()) {
+		hdr = ras_replay_header_page(&len);
+		if (hdr)
+			tep_parse_header_page(pevent, (char *)hdr, len,
+					      sizeof(long));
+		return page_size;
+	}
 
 	fd = open_trace(ras, "events/header_page", O_RDONLY);
 	if (fd < 0)
@@ -421,32 +565,144 @@ static int get_pagesize(struct ras_events *ras, struct tep_handle *pevent)
 		goto error;
 	if (tep_parse_header_page(pevent, buf, len, sizeof(long)))
 		goto error;
+	ras_capture_header_page(buf, len);
 
 error:
 	close(fd);
 	return page_size;
 }
 
-static void parse_ras_data(struct pthread_data *pdata, struct kbuffer *kbuf,
-			   void *data, unsigned long long time_stamp)
+#define EVENT_TEXT_OUTPUT "EVENT_TEXT_OUTPUT"
+
+/*
+ * Text output is only useful if someone reads the daemon's stdout.
+ * When it goes to /dev/null (e.g. after daemon()), the handlers can
+ * skip formatting it.
+ */
+static bool stdout_is_devnull(void)
+{
+	struct stat st, null_st;
+
+	if (fstat(STDOUT_FILENO, &st) < 0)
+		return true;
+
+	if (!S_ISCHR(st.st_mode) || stat("/dev/null", &null_st) < 0)
+		return false;
+
+	return st.st_rdev == null_st.st_rdev;
+}
+
+static void select_text_output(struct ras_events *ras)
+{
+	char *env = getenv(EVENT_TEXT_OUTPUT);
+
+	if (env && !strcasecmp(env, "yes"))
+		ras->text_output = 1;
+	else if (env && !strcasecmp(env, "no"))
+		ras->text_output = 0;
+	else
+		ras->text_output = !stdout_is_devnull();
+
+	if (!ras->text_output)
+		log(TERM, LOG_INFO, "Events won't be printed at stdout\n");
+}
+
+/*
+ * Maps the tracepoint types to the rasdaemon event IDs, used by the
+ * event counters. Some IDs are used by more than one tracepoint.
+ */
+#define MAX_EVENT_TYPES		32
+
+static struct {
+	int	type;
+	int	id;
+} event_types[MAX_EVENT_TYPES];
+static unsigned int n_event_types;
+
+static void add_event_type(struct tep_handle *pevent, char *group,
+			   char *event, int id)
+{
+	struct tep_event *ev = tep_find_event_by_name(pevent, group, event);
+
+	if (!ev || n_event_types >= MAX_EVENT_TYPES)
+		return;
+
+	event_types[n_event_types].type = ev->id;
+	event_types[n_event_types].id = id;
+	n_event_types++;
+}
+
+static int get_event_id(struct tep_event *event)
 {
-	struct tep_record record;
+	unsigned int i;
+
+	for (i = 0; i < n_event_types; i++) {
+		if (event_types[i].type == event->id)
+			return event_types[i].id;
+	}
+
+	return -1;
+}
+
+/*
+ * Time of the record, in ns, for the event database. Without the uptime
+ * trace clock, the time the record is decoded is used.
+ */
+static void set_event_time(struct ras_events *ras, struct tep_record *record)
+{
+	uint64_t boot_ns;
+
+	if (!ras->use_uptime) {
+		ras_db_set_event_time(0, 0);
+		return;
+	}
+
+	boot_ns = record->ts * (1000000000ULL / user_hz);
+	ras_db_set_event_time(boot_ns,
+			      boot_ns + ras->uptime_diff * 1000000000ULL);
+}
+
+/* Runs at the decoder thread */
+static void decode_ras_data(struct ras_events *ras, struct tep_record *record)
+{
+	/*
+	 * A trace_seq in error state: trace_seq_printf() returns before
+	 * formatting anything, so handlers only fill their event structs.
+	 */
+	static struct trace_seq muted = { .state = TRACE_SEQ__MEM_ALLOC_FAILED };
+	struct tep_event *event;
 	struct trace_seq s;
+	uint64_t start;
+	int id = -1;
+
+	tep_set_file_bigendian(ras->pevent, ENDIAN);
+
+	if (ras->record_events)
+		set_event_time(ras, record);
+
+	/* Store the losses noticed since the last event */
+	if (ras->record_events)
+		ras_stats_store(ras);
 
-	record.ts = time_stamp;
-	record.size = kbuffer_event_size(kbuf);
-	record.data = data;
-	record.offset = kbuffer_curr_offset(kbuf);
-	record.cpu = pdata->cpu;
+	event = tep_find_event_by_record(ras->pevent, record);
+	if (event) {
+		id = get_event_id(event);
+		ras_stats_event(id);
+	}
+
+	start = ras_metrics_now();
 
-	/* note offset is just offset in subbuffer */
-	record.missed_events = kbuffer_missed_events(kbuf);
-	record.record_size = kbuffer_curr_size(kbuf);
+	if (!ras->text_output) {
+		if (event && event->handler) {
+			event->handler(&muted, record, event, event->context);
+			ras_metrics_decoded(id, start);
+		}
+		return;
+	}
 
 	/* TODO - logging */
 	trace_seq_init(&s);
-	tep_set_file_bigendian(pdata->ras->pevent, ENDIAN);
-	tep_print_event(pdata->ras->pevent, &s, &record,
+	tep_print_event(ras->pevent, &s, record,
 			"%16s-%-5d [%03d] %s %6.1000d %s %s",
 			TEP_PRINT_COMM, TEP_PRINT_PID, TEP_PRINT_CPU,
 			TEP_PRINT_LATENCY, TEP_PRINT_TIME, TEP_PRINT_NAME,
@@ -455,17 +711,90 @@ static void parse_ras_data(struct pthread_data *pdata, struct kbuffer *kbuf,
 	printf("\n");
 	fflush(stdout);
 	trace_seq_destroy(&s);
+
+	ras_metrics_decoded(id, start);
+}
+
+/* Runs at the reader threads: queue the record for decoding */
+static void parse_ras_data(struct pthread_data *pdata, unsigned int ring,
+			   struct kbuffer *kbuf, void *data,
+			   unsigned long long time_stamp)
+{
+	ras_pipeline_push(pdata->ras->pipeline, ring, kbuf, data, time_stamp,
+			  pdata->cpu);
+}
+
+/*
+ * Parse a sysfs CPU list, like "0-3,8-11". Returns the highest CPU
+ * number plus one.
+ */
+static int parse_cpu_list(const char *path)
+{
+	char buf[4096], *p;
+	int fd, max = 0, cpu;
+	ssize_t size;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+	size = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (size <= 0)
+		return -EINVAL;
+	buf[size] = '\0';
+
+	for (p = buf; *p && *p != '\n';) {
+		cpu = strtol(p, &p, 10);
+		if (*p == '-')
+			cpu = strtol(p + 1, &p, 10);
+		if (cpu + 1 > max)
+			max = cpu + 1;
+		if (*p == ',')
+			p++;
+		else if (*p && *p != '\n')
+			return -EINVAL;
+	}
+
+	return max;
 }
 
+/*
+ * tracefs has per_cpu directories for all possible CPUs, so allocate
+ * them all, in order to handle CPU hotplug.
+ */
 static int get_num_cpus(struct ras_events *ras)
 {
 	int cpus;
 
-	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	cpus = parse_cpu_list("/sys/devices/system/cpu/possible");
+	if (cpus <= 0)
+		cpus = sysconf(_SC_NPROCESSORS_CONF);
 	assert(cpus > 0);
 	return cpus;
 }
 
+static bool cpu_is_online(int cpu)
+{
+	char path[MAX_PATH + 1];
+	char online = '1';
+	int fd;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+	if (access(path, F_OK))
+		return false;
+
+	/* CPUs that can't be hot-unplugged don't have an online file */
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/online", cpu);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return true;
+	if (read(fd, &online, 1) != 1)
+		online = '1';
+	close(fd);
+
+	return online == '1';
+}
+
 static int set_buffer_percent(struct ras_events *ras, int percent)
 {
 	char buf[16];
@@ -502,187 +831,1262 @@ static int set_buffer_percent(struct ras_events *ras, int percent)
  */
 #define LEGACY_KERNEL		255
 
-static int read_ras_event_all_cpus(struct pthread_data *pdata,
-				   unsigned int n_cpus)
+/*
+ * Reader pool
+ *
+ * The per-CPU trace_pipe_raw files are drained by a small pool of reader
+ * threads. Each reader is pinned to a NUMA node and owns the CPUs of that
+ * node, so that a storm on one socket doesn't delay the others. Readers
+ * use edge-triggered epoll, so a wakeup costs O(ready CPUs) instead of
+ * scanning all of them.
+ */
+
+#define READER_THREADS		"READER_THREADS"
+#define MAX_EPOLL_EVENTS	64
+
+/*
+ * Maximum number of sub-buffers read from a single CPU before moving to
+ * the next ready one, in order to keep the readers fair among CPUs.
+ */
+#define MAX_DRAIN_PAGES		16
+
+struct ras_reader {
+	pthread_t		thread;
+	struct ras_events	*ras;
+	int			id;
+	int			epfd;
+
+	/* Stop and CPU hotplug requests from the main thread */
+	int			ctlfd;
+
+	/* Periodic buffer_size_kb tuning */
+	int			timerfd;
+	pthread_mutex_t		ctl_lock;
+	unsigned		stop: 1;
+
+	cpu_set_t		*cpuset;
+	size_t			cpuset_size;
+
+	unsigned int		n_cpus;
+	struct pthread_data	**pdata;
+
+	unsigned		running: 1;
+};
+
+static int get_cpu_node(int cpu)
 {
-	ssize_t size;
-	unsigned long long time_stamp;
-	void *data;
-	int ready, i, count_nready;
-	struct kbuffer *kbuf;
-	void *page;
-	struct pollfd fds[n_cpus + 1];
-	struct signalfd_siginfo fdsiginfo;
-	sigset_t mask;
-	int warnonce[n_cpus];
-	char pipe_raw[PATH_MAX];
-	int legacy_kernel = 0;
+	char path[MAX_PATH + 1];
+	struct dirent *entry;
+	DIR *dir;
+	int node = 0;
 
-	memset(&warnonce, 0, sizeof(warnonce));
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+	dir = opendir(path);
+	if (!dir)
+		return 0;
 
-	page = malloc(pdata[0].ras->page_size);
-	if (!page) {
-		log(TERM, LOG_ERR, "Can't allocate page\n");
-		return -ENOMEM;
+	for (entry = readdir(dir); entry; entry = readdir(dir)) {
+		if (!strncmp(entry->d_name, "node", 4) &&
+		    isdigit(entry->d_name[4])) {
+			node = atoi(entry->d_name + 4);
+			break;
+		}
 	}
+	closedir(dir);
 
-	kbuf = kbuffer_alloc(KBUFFER_LSIZE_SAME_AS_HOST, KBUFFER_ENDIAN_SAME_AS_HOST);
-	if (!kbuf) {
-		log(TERM, LOG_ERR, "Can't allocate kbuf\n");
-		free(page);
-		return -ENOMEM;
-	}
+	return node;
+}
 
-	/* Fix for poll() on the per_cpu trace_pipe and trace_pipe_raw blocks
-	 * indefinitely with the default buffer_percent in the kernel trace system,
-	 * which is introduced by the following change in the kernel.
-	 * https://lore.kernel.org/all/20221020231427.41be3f26@gandalf.local.home/T/#u.
-	 * Set buffer_percent to 0 so that poll() will return immediately
-	 * when the trace data is available in the ras per_cpu trace pipe_raw
-	 */
-	if (set_buffer_percent(pdata[0].ras, 0))
-		log(TERM, LOG_WARNING, "Set buffer_percent failed\n");
+static int get_num_readers(int n_nodes, unsigned int n_cpus)
+{
+	char *env = getenv(READER_THREADS);
+	int n = 0;
 
-	for (i = 0; i < (n_cpus + 1); i++)
-		fds[i].fd = -1;
+	if (env && strlen(env))
+		n = atoi(env);
 
-	for (i = 0; i < n_cpus; i++) {
-		fds[i].events = POLLIN;
+	if (n <= 0)
+		n = n_nodes;
+	if (n > n_cpus)
+		n = n_cpus;
 
-		/* FIXME: use select to open for all CPUs */
-		snprintf(pipe_raw, sizeof(pipe_raw),
-			 "per_cpu/cpu%d/trace_pipe_raw", i);
+	return n;
+}
 
-		fds[i].fd = open_trace(pdata[0].ras, pipe_raw, O_RDONLY);
-		if (fds[i].fd < 0) {
-			log(TERM, LOG_ERR, "Can't open trace_pipe_raw\n");
-			goto error;
-		}
+/*
+ * Distribute the CPUs among the readers. When there are less readers than
+ * nodes, a reader owns several nodes. When there are more readers than
+ * nodes, the CPUs of a node are split among the readers assigned to it.
+ */
+static struct ras_reader *alloc_readers(struct pthread_data *pdata,
+					unsigned int n_cpus, int *n_readers)
+{
+	struct ras_reader *readers;
+	int *node_idx, *node_seen;
+	int i, r, n_nodes = 0, max_node = 0;
+
+	for (i = 0; i < n_cpus; i++) {
+		pdata[i].node = get_cpu_node(pdata[i].cpu);
+		if (pdata[i].node > max_node)
+			max_node = pdata[i].node;
 	}
 
-	sigemptyset(&mask);
-	sigaddset(&mask, SIGINT);
-	sigaddset(&mask, SIGTERM);
-	sigaddset(&mask, SIGHUP);
-	sigaddset(&mask, SIGQUIT);
-	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
-		log(TERM, LOG_WARNING, "sigprocmask\n");
-	fds[n_cpus].events = POLLIN;
-	fds[n_cpus].fd = signalfd(-1, &mask, 0);
-	if (fds[n_cpus].fd < 0) {
-		log(TERM, LOG_WARNING, "signalfd\n");
-		goto error;
+	node_idx = calloc(max_node + 1, sizeof(*node_idx));
+	node_seen = calloc(max_node + 1, sizeof(*node_seen));
+	if (!node_idx || !node_seen) {
+		free(node_idx);
+		free(node_seen);
+		return NULL;
 	}
 
-	log(TERM, LOG_INFO, "Listening to events for cpus 0 to %d\n", n_cpus - 1);
-	if (pdata[0].ras->record_events) {
-		if (ras_mc_event_opendb(pdata[0].cpu, pdata[0].ras))
-			goto error;
-#ifdef HAVE_NON_STANDARD
-		if (ras_ns_add_vendor_tables(pdata[0].ras))
-			log(TERM, LOG_ERR, "Can't add vendor table\n");
-#endif
+	for (i = 0; i <= max_node; i++)
+		node_idx[i] = -1;
+	for (i = 0; i < n_cpus; i++) {
+		if (node_idx[pdata[i].node] < 0)
+			node_idx[pdata[i].node] = n_nodes++;
 	}
 
-	do {
-		ready = poll(fds, (n_cpus + 1), -1);
-		if (ready < 0)
-			log(TERM, LOG_WARNING, "poll\n");
-
-		/* check for the signal */
-		if (fds[n_cpus].revents & POLLIN) {
-			size = read(fds[n_cpus].fd, &fdsiginfo,
-				    sizeof(struct signalfd_siginfo));
-			if (size != sizeof(struct signalfd_siginfo))
-				log(TERM, LOG_WARNING, "signalfd read\n");
-
-			if (fdsiginfo.ssi_signo == SIGINT ||
-			    fdsiginfo.ssi_signo == SIGTERM ||
-			    fdsiginfo.ssi_signo == SIGHUP ||
-			    fdsiginfo.ssi_signo == SIGQUIT) {
-				log(TERM, LOG_INFO, "Received signal=%d\n",
-				    fdsiginfo.ssi_signo);
-				goto  cleanup;
-			} else {
-				log(TERM, LOG_INFO,
-				    "Received unexpected signal=%d\n",
-				    fdsiginfo.ssi_signo);
-			}
+	*n_readers = get_num_readers(n_nodes, n_cpus);
+
+	readers = calloc(*n_readers, sizeof(*readers));
+	if (!readers)
+		goto free;
+
+	for (r = 0; r < *n_readers; r++) {
+		readers[r].id = r;
+		readers[r].ras = pdata[0].ras;
+		readers[r].epfd = -1;
+		readers[r].ctlfd = -1;
+		readers[r].timerfd = -1;
+		pthread_mutex_init(&readers[r].ctl_lock, NULL);
+		readers[r].pdata = calloc(n_cpus, sizeof(*readers[r].pdata));
+		readers[r].cpuset = CPU_ALLOC(n_cpus);
+		readers[r].cpuset_size = CPU_ALLOC_SIZE(n_cpus);
+		if (!readers[r].pdata || !readers[r].cpuset)
+			goto free_all;
+		CPU_ZERO_S(readers[r].cpuset_size, readers[r].cpuset);
+	}
+
+	for (i = 0; i < n_cpus; i++) {
+		int node = node_idx[pdata[i].node];
+		int per_node;
+
+		if (*n_readers <= n_nodes) {
+			r = node % *n_readers;
+		} else {
+			per_node = (*n_readers - node + n_nodes - 1) / n_nodes;
+			r = node + (node_seen[pdata[i].node]++ % per_node) * n_nodes;
 		}
+		readers[r].pdata[readers[r].n_cpus++] = &pdata[i];
+		pdata[i].reader = r;
+	}
 
-		count_nready = 0;
-		for (i = 0; i < n_cpus; i++) {
-			if (fds[i].revents & POLLERR) {
-				if (!warnonce[i]) {
-					log(TERM, LOG_INFO,
-					    "Error on CPU %i\n", i);
-					warnonce[i]++;
-				}
-			}
-			if (!(fds[i].revents & POLLIN)) {
-				count_nready++;
-				continue;
-			}
-			size = read(fds[i].fd, page, pdata[i].ras->page_size);
-			if (size < 0) {
-				log(TERM, LOG_WARNING, "read\n");
-				goto cleanup;
-			} else if (size > 0) {
-				kbuffer_load_subbuffer(kbuf, page);
-
-				while ((data = kbuffer_read_event(kbuf, &time_stamp))) {
-					if (kbuffer_curr_size(kbuf) < 0) {
-						log(TERM, LOG_ERR, "invalid kbuf data, discard\n");
-						break;
-					}
-
-					parse_ras_data(&pdata[i],
-						       kbuf, data, time_stamp);
-
-					/* increment to read next event */
-					kbuffer_next_event(kbuf, NULL);
-				}
-			} else {
-				count_nready++;
+	/* Pin each reader to all CPUs of the nodes it serves */
+	for (r = 0; r < *n_readers; r++) {
+		unsigned int j;
+
+		for (j = 0; j < readers[r].n_cpus; j++) {
+			for (i = 0; i < n_cpus; i++) {
+				if (pdata[i].node == readers[r].pdata[j]->node)
+					CPU_SET_S(pdata[i].cpu,
+						  readers[r].cpuset_size,
+						  readers[r].cpuset);
 			}
 		}
-		/*
-		 * If we enable fallback mode, it will always be used, as
-		 * poll is still not working fine, IMHO
-		 */
-		if (count_nready == n_cpus) {
-			/* Should only happen with legacy kernels */
-			legacy_kernel = 1;
-			break;
-		}
-	} while (1);
+	}
+
+	free(node_idx);
+	free(node_seen);
+
+	return readers;
+
+free_all:
+	for (r = 0; r < *n_readers; r++) {
+		pthread_mutex_destroy(&readers[r].ctl_lock);
+		free(readers[r].pdata);
+		if (readers[r].cpuset)
+			CPU_FREE(readers[r].cpuset);
+	}
+	free(readers);
+	readers = NULL;
+free:
+	free(node_idx);
+	free(node_seen);
+	return NULL;
+}
+
+static void free_readers(struct ras_reader *readers, int n_readers)
+{
+	int r;
+
+	for (r = 0; r < n_readers; r++) {
+		if (readers[r].epfd >= 0)
+			close(readers[r].epfd);
+		if (readers[r].ctlfd >= 0)
+			close(readers[r].ctlfd);
+		if (readers[r].timerfd >= 0)
+			close(readers[r].timerfd);
+		pthread_mutex_destroy(&readers[r].ctl_lock);
+		free(readers[r].pdata);
+		CPU_FREE(readers[r].cpuset);
+	}
+	free(readers);
+}
+
+/*
+ * Zero-copy reader: on Kernel 6.10 and upper, the per_cpu ring buffers
+ * can be mmap'd. The reader sub-buffer is then swapped in with an ioctl
+ * and its events are parsed in place, instead of being copied by read().
+ * While the tracer writes to the reader sub-buffer, the same sub-buffer
+ * is returned again, so parsing resumes from the last offset.
+ */
+
+#define TRACE_MMAP		"TRACE_MMAP"
+
+static bool use_trace_mmap(void)
+{
+	char *env = getenv(TRACE_MMAP);
+
+	/* Captures store whole sub-buffers, as read from trace_pipe_raw */
+	if (ras_capturing())
+		return false;
+
+	return env && !strcasecmp(env, "yes");
+}
+
+static int map_cpu_buffer(struct pthread_data *pdata)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+	struct trace_buffer_meta *meta;
+	size_t meta_len = page_size;
+	void *data;
+	int rc;
+
+	meta = mmap(NULL, meta_len, PROT_READ, MAP_SHARED, pdata->fd, 0);
+	if (meta == MAP_FAILED)
+		return -errno;
+
+	if (meta->meta_page_size > meta_len) {
+		meta_len = meta->meta_page_size;
+		munmap(meta, page_size);
+		meta = mmap(NULL, meta_len, PROT_READ, MAP_SHARED, pdata->fd, 0);
+		if (meta == MAP_FAILED)
+			return -errno;
+	}
+
+	pdata->map_len = (size_t)meta->subbuf_size * meta->nr_subbufs;
+	data = mmap(NULL, pdata->map_len, PROT_READ, MAP_SHARED, pdata->fd,
+		    meta->meta_page_size);
+	if (data == MAP_FAILED) {
+		rc = -errno;
+		munmap(meta, meta_len);
+		return rc;
+	}
+
+	pdata->meta = meta;
+	pdata->map_data = data;
+	pdata->last_id = -1;
+	pdata->last_offset = 0;
+
+	return 0;
+}
+
+static void unmap_cpu_buffer(struct pthread_data *pdata)
+{
+	if (!pdata->meta)
+		return;
+
+	munmap(pdata->map_data, pdata->map_len);
+	munmap(pdata->meta, pdata->meta->meta_page_size);
+	pdata->meta = NULL;
+	pdata->map_data = NULL;
+}
+
+/* Account the events overwritten by the Kernel before a sub-buffer */
+static bool account_missed_events(int cpu, struct kbuffer *kbuf)
+{
+	int missed = kbuffer_missed_events(kbuf);
+
+	if (!missed)
+		return false;
+
+	/* The Kernel may not know how many events were lost */
+	ras_stats_drop(RAS_DROP_KERNEL, cpu, -1, missed > 0 ? missed : 1);
+
+	return true;
+}
+
+/* Same as drain_cpu(), for a mmap'd ring buffer */
+static int drain_mapped_cpu(struct pthread_data *pdata, unsigned int ring,
+			    struct kbuffer *kbuf)
+{
+	struct trace_buffer_meta *meta = pdata->meta;
+	unsigned long long time_stamp;
+	void *data;
+	int i, id;
+
+	for (i = 0; i < MAX_DRAIN_PAGES; i++) {
+		if (ioctl(pdata->fd, TRACE_MMAP_IOCTL_GET_READER) < 0) {
+			if (errno == EINTR)
+				return 1;
+			log(TERM, LOG_WARNING, "Can't get cpu %d reader sub-buffer\n",
+			    pdata->cpu);
+			return -errno;
+		}
+
+		id = __atomic_load_n(&meta->reader.id, __ATOMIC_ACQUIRE);
+		kbuffer_load_subbuffer(kbuf, pdata->map_data +
+				       (size_t)meta->subbuf_size * id);
+
+		if (id == pdata->last_id) {
+			/* Same sub-buffer: skip the events already parsed */
+			data = kbuffer_read_at_offset(kbuf, pdata->last_offset,
+						      &time_stamp);
+			if (!data)
+				return 0;
+		} else {
+			if (account_missed_events(pdata->cpu, kbuf))
+				pdata->missed = 1;
+			data = kbuffer_read_event(kbuf, &time_stamp);
+		}
+
+		while (data) {
+			if (kbuffer_curr_size(kbuf) < 0) {
+				log(TERM, LOG_ERR, "invalid kbuf data, discard\n");
+				break;
+			}
+
+			parse_ras_data(pdata, ring, kbuf, data, time_stamp);
+
+			data = kbuffer_next_event(kbuf, &time_stamp);
+		}
+
+		pdata->last_id = id;
+		pdata->last_offset = kbuffer_curr_offset(kbuf);
+		ras_pipeline_kick(pdata->ras->pipeline);
+	}
+
+	return 1;
+}
+
+/*
+ * Read up to MAX_DRAIN_PAGES sub-buffers from a CPU.
+ *
+ * Returns 1 if there's still data to be read, 0 if the CPU buffer was
+ * drained, or a negative error code.
+ */
+static int drain_cpu(struct pthread_data *pdata, unsigned int ring,
+		     struct kbuffer *kbuf, void *page)
+{
+	struct ras_events *ras = pdata->ras;
+	unsigned long long time_stamp;
+	ssize_t size;
+	void *data;
+	int i;
+
+	if (pdata->meta)
+		return drain_mapped_cpu(pdata, ring, kbuf);
+
+	for (i = 0; i < MAX_DRAIN_PAGES; i++) {
+		size = read(pdata->fd, page, ras->page_size);
+		if (size < 0) {
+			if (errno == EAGAIN || errno == EINTR)
+				return 0;
+			log(TERM, LOG_WARNING, "read\n");
+			return -errno;
+		}
+		if (!size)
+			return 0;
+
+		kbuffer_load_subbuffer(kbuf, page);
+		/* The read size is a whole page, whatever it holds */
+		pdata->drained += kbuffer_subbuffer_size(kbuf);
+		if (account_missed_events(pdata->cpu, kbuf))
+			pdata->missed = 1;
+		ras_capture_page(pdata->cpu, page, size);
+
+		while ((data = kbuffer_read_event(kbuf, &time_stamp))) {
+			if (kbuffer_curr_size(kbuf) < 0) {
+				log(TERM, LOG_ERR, "invalid kbuf data, discard\n");
+				break;
+			}
+
+			parse_ras_data(pdata, ring, kbuf, data, time_stamp);
+
+			/* increment to read next event */
+			kbuffer_next_event(kbuf, NULL);
+		}
+		ras_pipeline_kick(ras->pipeline);
+	}
+
+	return 1;
+}
+
+/*
+ * Adaptive per-CPU buffer size
+ *
+ * The buffers start small, as RAS events are rare. Each reader checks
+ * its CPUs once per BUFFER_TUNE_MS: a CPU that missed events, or that
+ * got more than half of its buffer in a period, has its buffer grown.
+ * A buffer that stays mostly idle for BUFFER_SHRINK_TICKS is halved.
+ * Mapped buffers can't be resized, so they keep their size.
+ */
+
+#define TRACE_BUFFER_MIN_KB	"TRACE_BUFFER_MIN_KB"
+#define TRACE_BUFFER_MAX_KB	"TRACE_BUFFER_MAX_KB"
+#define DEFAULT_BUFFER_MIN_KB	64
+#define DEFAULT_BUFFER_MAX_KB	4096
+#define BUFFER_TUNE_MS		1000
+#define BUFFER_SHRINK_TICKS	300
+
+static unsigned int get_env_kb(char *name, unsigned int def)
+{
+	char *env = getenv(name);
+
+	if (!env || !*env)
+		return def;
+
+	return strtoul(env, NULL, 0);
+}
+
+static void select_buffer_size(struct ras_events *ras)
+{
+	ras->buffer_kb_min = get_env_kb(TRACE_BUFFER_MIN_KB,
+					DEFAULT_BUFFER_MIN_KB);
+	ras->buffer_kb_max = get_env_kb(TRACE_BUFFER_MAX_KB,
+					DEFAULT_BUFFER_MAX_KB);
+
+	if (!ras->buffer_kb_min || ras->buffer_kb_max < ras->buffer_kb_min) {
+		log(TERM, LOG_INFO, "Not managing the trace buffer size\n");
+		ras->buffer_kb_min = 0;
+		ras->buffer_kb_max = 0;
+		return;
+	}
+
+	log(TERM, LOG_INFO, "Trace buffers sized from %u kB to %u kB per cpu\n",
+	    ras->buffer_kb_min, ras->buffer_kb_max);
+}
+
+static int set_cpu_buffer_kb(struct pthread_data *pdata, unsigned int kb)
+{
+	char fname[MAX_PATH + 1], buf[16];
+	int fd, len, rc;
+
+	snprintf(fname, sizeof(fname), "per_cpu/cpu%d/buffer_size_kb",
+		 pdata->cpu);
+	fd = open_trace(pdata->ras, fname, O_WRONLY);
+	if (fd < 0) {
+		log(TERM, LOG_WARNING, "Can't open cpu %d buffer_size_kb\n",
+		    pdata->cpu);
+		return fd;
+	}
+
+	len = snprintf(buf, sizeof(buf), "%u", kb);
+	rc = write(fd, buf, len);
+	close(fd);
+	if (rc != len) {
+		log(TERM, LOG_WARNING, "Can't set cpu %d buffer to %u kB\n",
+		    pdata->cpu, kb);
+		return -EIO;
+	}
+
+	pdata->buffer_kb = kb;
+	pdata->idle_ticks = 0;
+
+	return 0;
+}
+
+static int read_cpu_file(struct pthread_data *pdata, char *name, char *buf,
+			 size_t len)
+{
+	char fname[MAX_PATH + 1];
+	ssize_t size;
+	int fd;
+
+	snprintf(fname, sizeof(fname), "per_cpu/cpu%d/%s", pdata->cpu, name);
+	fd = open_trace(pdata->ras, fname, O_RDONLY);
+	if (fd < 0)
+		return fd;
+
+	size = read(fd, buf, len - 1);
+	if (size < 0)
+		size = -errno;
+	close(fd);
+	if (size < 0)
+		return size;
+
+	buf[size] = '\0';
+
+	return 0;
+}
+
+/*
+ * Sets the buffer of a CPU being opened to the minimum size. A larger
+ * buffer that already has events keeps its size, as shrinking it would
+ * drop them. It is shrunk later, if it stays idle.
+ */
+static void init_cpu_buffer(struct pthread_data *pdata)
+{
+	unsigned int min = pdata->ras->buffer_kb_min;
+	unsigned long kb;
+	char buf[1024], *p;
+
+	pdata->buffer_kb = 0;
+	if (!min)
+		return;
+
+	/* Either "<kb>" or, while not allocated yet, "<kb> (expanded: <kb>)" */
+	if (!read_cpu_file(pdata, "buffer_size_kb", buf, sizeof(buf))) {
+		kb = strtoul(buf, NULL, 10);
+		if (kb > min &&
+		    !read_cpu_file(pdata, "stats", buf, sizeof(buf)) &&
+		    (p = strstr(buf, "entries:")) && strtoul(p + 8, NULL, 10)) {
+			log(TERM, LOG_INFO,
+			    "Keeping cpu %d buffer at %lu kB, as it has events\n",
+			    pdata->cpu, kb);
+			pdata->buffer_kb = kb;
+			return;
+		}
+	}
+
+	set_cpu_buffer_kb(pdata, min);
+}
+
+static void tune_cpu_buffer(struct pthread_data *pdata)
+{
+	struct ras_events *ras = pdata->ras;
+	size_t size = (size_t)pdata->buffer_kb * 1024;
+	unsigned int kb = pdata->buffer_kb;
+
+	if (!kb || pdata->meta)
+		goto reset;
+
+	if (pdata->missed)
+		kb *= 4;
+	else if (pdata->drained > size / 2)
+		kb *= 2;
+
+	if (kb > ras->buffer_kb_max)
+		kb = ras->buffer_kb_max;
+
+	if (kb > pdata->buffer_kb) {
+		log(TERM, LOG_INFO, "Growing cpu %d buffer to %u kB%s\n",
+		    pdata->cpu, kb, pdata->missed ? " after missed events" : "");
+		set_cpu_buffer_kb(pdata, kb);
+		goto reset;
+	}
+
+	if (pdata->drained > size / 16) {
+		pdata->idle_ticks = 0;
+		goto reset;
+	}
+
+	if (++pdata->idle_ticks >= BUFFER_SHRINK_TICKS &&
+	    pdata->buffer_kb > ras->buffer_kb_min) {
+		kb = pdata->buffer_kb / 2;
+		if (kb < ras->buffer_kb_min)
+			kb = ras->buffer_kb_min;
+		log(TERM, LOG_DEBUG, "Shrinking cpu %d buffer to %u kB\n",
+		    pdata->cpu, kb);
+		set_cpu_buffer_kb(pdata, kb);
+	}
+
+reset:
+	pdata->drained = 0;
+	pdata->missed = 0;
+}
+
+static void reader_tune_buffers(struct ras_reader *rd)
+{
+	uint64_t val;
+	unsigned int i;
+
+	if (read(rd->timerfd, &val, sizeof(val)) < 0)
+		return;
+
+	for (i = 0; i < rd->n_cpus; i++) {
+		if (rd->pdata[i]->fd >= 0)
+			tune_cpu_buffer(rd->pdata[i]);
+	}
+}
+
+static int open_cpu(struct pthread_data *pdata)
+{
+	char pipe_raw[PATH_MAX];
+
+	snprintf(pipe_raw, sizeof(pipe_raw),
+		 "per_cpu/cpu%d/trace_pipe_raw", pdata->cpu);
+
+	/* Edge-triggered epoll requires draining with non-blocking reads */
+	pdata->fd = open_trace(pdata->ras, pipe_raw, O_RDONLY | O_NONBLOCK);
+	if (pdata->fd < 0) {
+		log(TERM, LOG_ERR, "Can't open cpu %d trace_pipe_raw\n",
+		    pdata->cpu);
+		return pdata->fd;
+	}
+	pdata->online = 1;
+
+	/* Resize before mapping, as mapped buffers can't be resized */
+	init_cpu_buffer(pdata);
+
+	if (use_trace_mmap() && map_cpu_buffer(pdata))
+		log(TERM, LOG_INFO, "Can't mmap cpu %d ring buffer. Using trace_pipe_raw\n",
+		    pdata->cpu);
+
+	return 0;
+}
+
+static void close_cpu(struct pthread_data *pdata)
+{
+	unmap_cpu_buffer(pdata);
+	if (pdata->fd >= 0)
+		close(pdata->fd);
+	pdata->fd = -1;
+	pdata->online = 0;
+}
+
+/*
+ * Handle the CPU hotplug requests. A CPU going online is added to the
+ * epoll set and drained, as it may already have events. A CPU going
+ * offline is drained before closing it, as its buffer keeps the events
+ * recorded before it went offline.
+ */
+static int reader_hotplug(struct ras_reader *rd, struct kbuffer *kbuf,
+			  void *page, struct pthread_data **ready,
+			  unsigned int *n_ready)
+{
+	struct epoll_event ev = { .events = EPOLLIN | EPOLLET };
+	struct pthread_data *pdata;
+	unsigned int i, j;
+	int rc = 0;
+
+	for (i = 0; i < rd->n_cpus; i++) {
+		pdata = rd->pdata[i];
+
+		switch (pdata->hotplug) {
+		case CPU_HOTPLUG_ONLINE:
+			if (pdata->fd >= 0 || open_cpu(pdata))
+				break;
+
+			ev.data.ptr = pdata;
+			if (epoll_ctl(rd->epfd, EPOLL_CTL_ADD, pdata->fd, &ev) < 0) {
+				log(TERM, LOG_ERR, "Can't add cpu %d to epoll\n",
+				    pdata->cpu);
+				close_cpu(pdata);
+				break;
+			}
+			log(TERM, LOG_INFO, "Reader %d: cpu %d is online\n",
+			    rd->id, pdata->cpu);
+
+			if (!pdata->ready) {
+				pdata->ready = 1;
+				ready[(*n_ready)++] = pdata;
+			}
+			break;
+		case CPU_HOTPLUG_OFFLINE:
+			if (pdata->fd < 0)
+				break;
+
+			do {
+				rc = drain_cpu(pdata, rd->id, kbuf, page);
+			} while (rc > 0);
+
+			epoll_ctl(rd->epfd, EPOLL_CTL_DEL, pdata->fd, NULL);
+			close_cpu(pdata);
+			log(TERM, LOG_INFO, "Reader %d: cpu %d is offline\n",
+			    rd->id, pdata->cpu);
+			break;
+		}
+		pdata->hotplug = CPU_HOTPLUG_NONE;
+		if (rc < 0)
+			break;
+	}
+
+	/* Offline CPUs can't be at the ready list anymore */
+	for (i = 0, j = 0; i < *n_ready; i++) {
+		if (ready[i]->fd >= 0)
+			ready[j++] = ready[i];
+		else
+			ready[i]->ready = 0;
+	}
+	*n_ready = j;
+
+	return rc;
+}
+
+static void *ras_reader_thread(void *priv)
+{
+	struct ras_reader *rd = priv;
+	struct epoll_event events[MAX_EPOLL_EVENTS];
+	struct pthread_data *pdata, **ready;
+	unsigned int n_ready = 0, i, j;
+	struct kbuffer *kbuf;
+	uint64_t val;
+	void *page;
+	int n, rc, stop = 0, ctl;
+
+	ready = calloc(rd->n_cpus, sizeof(*ready));
+	page = malloc(rd->ras->page_size);
+	kbuf = kbuffer_alloc(KBUFFER_LSIZE_SAME_AS_HOST, KBUFFER_ENDIAN_SAME_AS_HOST);
+	if (!ready || !page || !kbuf) {
+		log(TERM, LOG_ERR, "Reader %d: can't allocate memory\n", rd->id);
+		goto free;
+	}
+
+	log(TERM, LOG_INFO, "Reader %d listening to events on %d cpus\n",
+	    rd->id, rd->n_cpus);
+
+	do {
+		/* Don't sleep if there are CPUs not fully drained yet */
+		n = epoll_wait(rd->epfd, events, ARRAY_SIZE(events),
+			       n_ready ? 0 : -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			log(TERM, LOG_WARNING, "epoll_wait\n");
+			break;
+		}
+
+		ctl = 0;
+		for (i = 0; i < n; i++) {
+			pdata = events[i].data.ptr;
+			if (!pdata) {
+				ctl = 1;
+				continue;
+			}
+			if (events[i].data.ptr == rd) {
+				reader_tune_buffers(rd);
+				continue;
+			}
+
+			if ((events[i].events & EPOLLERR) && !pdata->warnonce) {
+				log(TERM, LOG_INFO, "Error on CPU %i\n", pdata->cpu);
+				pdata->warnonce = 1;
+			}
+
+			if (!pdata->ready) {
+				pdata->ready = 1;
+				ready[n_ready++] = pdata;
+			}
+		}
+
+		if (ctl) {
+			if (read(rd->ctlfd, &val, sizeof(val)) < 0)
+				log(TERM, LOG_WARNING, "Can't read reader eventfd\n");
+
+			pthread_mutex_lock(&rd->ctl_lock);
+			stop = rd->stop;
+			rc = reader_hotplug(rd, kbuf, page, ready, &n_ready);
+			pthread_mutex_unlock(&rd->ctl_lock);
+			if (rc < 0) {
+				kill(getpid(), SIGTERM);
+				stop = 1;
+			}
+			if (stop)
+				break;
+		}
+
+		/* Round-robin among the CPUs with pending data */
+		for (i = 0, j = 0; i < n_ready; i++) {
+			pdata = ready[i];
+			rc = drain_cpu(pdata, rd->id, kbuf, page);
+			if (rc < 0) {
+				/* Let the main thread tear everything down */
+				kill(getpid(), SIGTERM);
+				stop = 1;
+				break;
+			}
+			if (rc > 0)
+				ready[j++] = pdata;
+			else
+				pdata->ready = 0;
+		}
+		if (!stop)
+			n_ready = j;
+	} while (!stop);
+
+free:
+	if (kbuf)
+		kbuffer_free(kbuf);
+	free(page);
+	free(ready);
+
+	return NULL;
+}
+
+static int setup_reader(struct ras_reader *rd)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+	unsigned int i;
+
+	rd->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (rd->epfd < 0) {
+		log(TERM, LOG_ERR, "Can't create epoll instance\n");
+		return -errno;
+	}
+
+	rd->ctlfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (rd->ctlfd < 0) {
+		log(TERM, LOG_ERR, "Can't create eventfd\n");
+		return -errno;
+	}
+
+	ev.data.ptr = NULL;
+	if (epoll_ctl(rd->epfd, EPOLL_CTL_ADD, rd->ctlfd, &ev) < 0)
+		return -errno;
+
+	if (rd->ras->buffer_kb_min) {
+		struct itimerspec its = {
+			.it_interval.tv_sec = BUFFER_TUNE_MS / 1000,
+			.it_interval.tv_nsec = (BUFFER_TUNE_MS % 1000) * 1000000,
+		};
+
+		its.it_value = its.it_interval;
+		rd->timerfd = timerfd_create(CLOCK_MONOTONIC,
+					     TFD_CLOEXEC | TFD_NONBLOCK);
+		if (rd->timerfd < 0 || timerfd_settime(rd->timerfd, 0, &its, NULL)) {
+			log(TERM, LOG_ERR, "Can't create reader timer\n");
+			return -errno;
+		}
+
+		ev.data.ptr = rd;
+		if (epoll_ctl(rd->epfd, EPOLL_CTL_ADD, rd->timerfd, &ev) < 0)
+			return -errno;
+	}
+
+	for (i = 0; i < rd->n_cpus; i++) {
+		/* Offline CPUs are added when they go online */
+		if (rd->pdata[i]->fd < 0)
+			continue;
+
+		ev.events = EPOLLIN | EPOLLET;
+		ev.data.ptr = rd->pdata[i];
+		if (epoll_ctl(rd->epfd, EPOLL_CTL_ADD, rd->pdata[i]->fd, &ev) < 0) {
+			/* Legacy kernels don't support poll() on trace_pipe_raw */
+			if (errno == EPERM)
+				return LEGACY_KERNEL;
+			log(TERM, LOG_ERR, "Can't add cpu %d to epoll\n",
+			    rd->pdata[i]->cpu);
+			return -errno;
+		}
+	}
+
+	return 0;
+}
+
+static void stop_readers(struct ras_reader *readers, int n_readers)
+{
+	uint64_t val = 1;
+	int r;
+
+	for (r = 0; r < n_readers; r++) {
+		if (!readers[r].running)
+			continue;
+		pthread_mutex_lock(&readers[r].ctl_lock);
+		readers[r].stop = 1;
+		pthread_mutex_unlock(&readers[r].ctl_lock);
+		if (write(readers[r].ctlfd, &val, sizeof(val)) < 0)
+			log(TERM, LOG_WARNING, "Can't stop reader %d\n", r);
+	}
+
+	for (r = 0; r < n_readers; r++) {
+		if (readers[r].running)
+			pthread_join(readers[r].thread, NULL);
+		readers[r].running = 0;
+	}
+}
+
+static void request_hotplug(struct ras_reader *readers,
+			    struct pthread_data *pdata, int action)
+{
+	struct ras_reader *rd = &readers[pdata->reader];
+	uint64_t val = 1;
+
+	pthread_mutex_lock(&rd->ctl_lock);
+	pdata->hotplug = action;
+	pthread_mutex_unlock(&rd->ctl_lock);
+
+	if (write(rd->ctlfd, &val, sizeof(val)) < 0)
+		log(TERM, LOG_WARNING, "Can't notify reader %d\n", rd->id);
+}
+
+/*
+ * CPU hotplug is notified by the Kernel via uevents, like
+ * "online@/devices/system/cpu/cpu3".
+ */
+static int open_uevent_socket(void)
+{
+	struct sockaddr_nl addr = {
+		.nl_family = AF_NETLINK,
+		.nl_groups = 1,		/* Kernel events */
+	};
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+		    NETLINK_KOBJECT_UEVENT);
+	if (fd < 0)
+		return -errno;
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -errno;
+	}
+
+	return fd;
+}
+
+/*
+ * Reads the pending uevents until a CPU hotplug one. Returns its CPU, or
+ * -1 when there's no more.
+ */
+static int read_cpu_uevent(int fd, unsigned int n_cpus, int *action)
+{
+	static const char cpu_path[] = "/devices/system/cpu/cpu";
+	struct sockaddr_nl addr;
+	struct iovec iov;
+	struct msghdr msg = {
+		.msg_name = &addr,
+		.msg_namelen = sizeof(addr),
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+	char buf[4096], *devpath, *end;
+	ssize_t size;
+	long cpu;
+
+	do {
+		iov.iov_base = buf;
+		iov.iov_len = sizeof(buf) - 1;
+		size = recvmsg(fd, &msg, 0);
+		if (size <= 0)
+			return -1;
+
+		/* Only trust messages from the Kernel */
+		if (addr.nl_pid)
+			continue;
+		buf[size] = '\0';
+
+		if (!strncmp(buf, "online@", 7))
+			*action = CPU_HOTPLUG_ONLINE;
+		else if (!strncmp(buf, "offline@", 8))
+			*action = CPU_HOTPLUG_OFFLINE;
+		else
+			continue;
+
+		devpath = strchr(buf, '@') + 1;
+		if (strncmp(devpath, cpu_path, sizeof(cpu_path) - 1))
+			continue;
+
+		devpath += sizeof(cpu_path) - 1;
+		cpu = strtol(devpath, &end, 10);
+		if (end == devpath || *end || cpu < 0 || cpu >= n_cpus)
+			continue;
+
+		return cpu;
+	} while (1);
+}
+
+static void handle_uevents(int fd, struct ras_reader *readers,
+			   struct pthread_data *pdata, unsigned int n_cpus)
+{
+	int cpu, action;
+
+	while ((cpu = read_cpu_uevent(fd, n_cpus, &action)) >= 0)
+		request_hotplug(readers, &pdata[cpu], action);
+}
+
+static int read_ras_event_all_cpus(struct pthread_data *pdata,
+				   unsigned int n_cpus)
+{
+	ssize_t size;
+	int i, rc = -EINVAL, n_readers = 0, n_online = 0;
+	struct ras_reader *readers = NULL;
+	struct signalfd_siginfo fdsiginfo;
+	struct ras_events *ras = pdata[0].ras;
+	struct pollfd fds[2];
+	pthread_attr_t attr;
+	sigset_t mask;
+	int sigfd = -1, uevfd;
+
+	/* Fix for poll() on the per_cpu trace_pipe and trace_pipe_raw blocks
+	 * indefinitely with the default buffer_percent in the kernel trace system,
+	 * which is introduced by the following change in the kernel.
+	 * https://lore.kernel.org/all/20221020231427.41be3f26@gandalf.local.home/T/#u.
+	 * Set buffer_percent to 0 so that poll() will return immediately
+	 * when the trace data is available in the ras per_cpu trace pipe_raw
+	 */
+	if (set_buffer_percent(ras, 0))
+		log(TERM, LOG_WARNING, "Set buffer_percent failed\n");
+
+	for (i = 0; i < n_cpus; i++)
+		pdata[i].fd = -1;
+
+	select_buffer_size(ras);
+
+	/* Listen to CPU hotplug before checking which CPUs are online */
+	uevfd = open_uevent_socket();
+	if (uevfd < 0)
+		log(TERM, LOG_WARNING,
+		    "Can't listen to uevents: %s. CPU hotplug won't be handled\n",
+		    strerror(-uevfd));
+
+	for (i = 0; i < n_cpus; i++) {
+		if (!cpu_is_online(pdata[i].cpu))
+			continue;
+
+		rc = open_cpu(&pdata[i]);
+		if (rc)
+			goto error;
+		n_online++;
+	}
+
+	readers = alloc_readers(pdata, n_cpus, &n_readers);
+	if (!readers) {
+		log(TERM, LOG_ERR, "Can't allocate reader threads\n");
+		goto error;
+	}
+
+	for (i = 0; i < n_readers; i++) {
+		rc = setup_reader(&readers[i]);
+		if (rc)
+			goto error;
+	}
+
+	/* One ring per reader, as rings have a single producer */
+	ras->pipeline = ras_pipeline_alloc(ras, n_readers, false,
+					  decode_ras_data);
+	if (!ras->pipeline) {
+		rc = -ENOMEM;
+		goto error;
+	}
+
+	/*
+	 * Block the signals before creating the readers, as they inherit
+	 * the signal mask. Only the main thread handles them, via signalfd.
+	 */
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGUSR1);
+	if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1)
+		log(TERM, LOG_WARNING, "sigprocmask\n");
+	sigfd = signalfd(-1, &mask, 0);
+	if (sigfd < 0) {
+		log(TERM, LOG_WARNING, "signalfd\n");
+		rc = -EINVAL;
+		goto error;
+	}
+
+	log(TERM, LOG_INFO, "Listening to events for %d online cpus (%d possible)\n",
+	    n_online, n_cpus);
+	if (ras->record_events) {
+		if (ras_mc_event_opendb(pdata[0].cpu, ras)) {
+			rc = -EINVAL;
+			goto error;
+		}
+#ifdef HAVE_NON_STANDARD
+		if (ras_ns_add_vendor_tables(ras))
+			log(TERM, LOG_ERR, "Can't add vendor table\n");
+#endif
+	}
+
+	rc = ras_pipeline_start(ras->pipeline);
+	if (rc)
+		goto cleanup;
+
+	log(TERM, LOG_INFO, "Starting %d reader threads\n", n_readers);
+	for (i = 0; i < n_readers; i++) {
+		/* More readers than CPUs on a node */
+		if (!readers[i].n_cpus)
+			continue;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setaffinity_np(&attr, readers[i].cpuset_size,
+					    readers[i].cpuset);
+		rc = pthread_create(&readers[i].thread, &attr,
+				    ras_reader_thread, &readers[i]);
+		pthread_attr_destroy(&attr);
+
+		/* All CPUs of the reader's nodes may be offline */
+		if (rc == EINVAL)
+			rc = pthread_create(&readers[i].thread, NULL,
+					    ras_reader_thread, &readers[i]);
+		if (rc) {
+			log(TERM, LOG_ERR, "Can't create reader thread %d\n", i);
+			rc = -EINVAL;
+			goto cleanup;
+		}
+		readers[i].running = 1;
+	}
+
+	fds[0].fd = sigfd;
+	fds[0].events = POLLIN;
+	fds[1].fd = uevfd;
+	fds[1].events = POLLIN;
+
+	do {
+		if (poll(fds, uevfd >= 0 ? 2 : 1, -1) < 0) {
+			if (errno != EINTR)
+				log(TERM, LOG_WARNING, "poll\n");
+			continue;
+		}
+
+		if (uevfd >= 0 && (fds[1].revents & POLLIN))
+			handle_uevents(uevfd, readers, pdata, n_cpus);
+
+		if (!(fds[0].revents & POLLIN))
+			continue;
+
+		size = read(sigfd, &fdsiginfo, sizeof(struct signalfd_siginfo));
+		if (size != sizeof(struct signalfd_siginfo)) {
+			log(TERM, LOG_WARNING, "signalfd read\n");
+			continue;
+		}
+
+		if (fdsiginfo.ssi_signo == SIGINT ||
+		    fdsiginfo.ssi_signo == SIGTERM ||
+		    fdsiginfo.ssi_signo == SIGHUP ||
+		    fdsiginfo.ssi_signo == SIGQUIT) {
+			log(TERM, LOG_INFO, "Received signal=%d\n",
+			    fdsiginfo.ssi_signo);
+			break;
+		}
+
+		if (fdsiginfo.ssi_signo == SIGUSR1) {
+			ras_stats_log();
+			continue;
+		}
+
+		log(TERM, LOG_INFO, "Received unexpected signal=%d\n",
+		    fdsiginfo.ssi_signo);
+	} while (1);
+
+	rc = -EINVAL;
+
+cleanup:
+	stop_readers(readers, n_readers);
+
+	/* Decode what was already read before closing the database */
+	ras_pipeline_stop(ras->pipeline);
+	ras_stats_log();
+
+	if (ras->record_events) {
+		ras_stats_store(ras);
+#ifdef HAVE_NON_STANDARD
+		ras_ns_finalize_vendor_tables();
+#endif
+		ras_mc_event_closedb(pdata[0].cpu, ras);
+	}
+
+error:
+	if (sigfd >= 0) {
+		close(sigfd);
+		sigprocmask(SIG_UNBLOCK, &mask, NULL);
+	}
+
+	if (readers)
+		free_readers(readers, n_readers);
+
+	ras_pipeline_free(ras->pipeline);
+	ras->pipeline = NULL;
+
+	for (i = 0; i < n_cpus; i++)
+		close_cpu(&pdata[i]);
+
+	if (uevfd >= 0)
+		close(uevfd);
+
+	if (rc == LEGACY_KERNEL)
+		log(TERM, LOG_INFO,
+		    "Old kernel detected. Stop listening and fall back to pthread way.\n");
+
+	return rc;
+}
+
+/*
+ * Feed a capture to the event pipeline, as the reader threads do with the
+ * live trace buffers. A single ring keeps the captured order.
+ */
+static int replay_ras_events(struct ras_events *ras)
+{
+	unsigned long long time_stamp, pages = 0, bytes = 0;
+	struct timespec start;
+	struct kbuffer *kbuf;
+	void *page, *data;
+	int rc, cpu, size;
+
+	kbuf = kbuffer_alloc(KBUFFER_LSIZE_SAME_AS_HOST, KBUFFER_ENDIAN_SAME_AS_HOST);
+	if (!kbuf)
+		return -ENOMEM;
+
+	ras->pipeline = ras_pipeline_alloc(ras, 1, false, decode_ras_data);
+	if (!ras->pipeline) {
+		rc = -ENOMEM;
+		goto free;
+	}
+	ras_pipeline_set_lossless(ras->pipeline);
+
+	if (ras->record_events) {
+		rc = ras_mc_event_opendb(0, ras);
+		if (rc) {
+			log(TERM, LOG_ERR, "Can't open database\n");
+			goto free;
+		}
+#ifdef HAVE_NON_STANDARD
+		if (ras_ns_add_vendor_tables(ras))
+			log(TERM, LOG_ERR, "Can't add vendor table\n");
+#endif
+	}
+
+	rc = ras_pipeline_start(ras->pipeline);
+	if (rc)
+		goto close;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while ((rc = ras_replay_next_page(&cpu, &page, &size)) > 0) {
+		kbuffer_load_subbuffer(kbuf, page);
+		account_missed_events(cpu, kbuf);
+
+		while ((data = kbuffer_read_event(kbuf, &time_stamp))) {
+			if (kbuffer_curr_size(kbuf) < 0) {
+				log(TERM, LOG_ERR, "invalid kbuf data, discard\n");
+				break;
+			}
+
+			ras_pipeline_push(ras->pipeline, 0, kbuf, data,
+					  time_stamp, cpu);
+
+			/* increment to read next event */
+			kbuffer_next_event(kbuf, NULL);
+		}
+		ras_pipeline_kick(ras->pipeline);
+
+		pages++;
+		bytes += size;
+	}
+	if (rc < 0)
+		log(ALL, LOG_ERR, "Can't read the capture file\n");
 
-	/* poll() is not supported. We need to fallback to the old way */
-	log(TERM, LOG_INFO,
-	    "Old kernel detected. Stop listening and fall back to pthread way.\n");
+	/* Wait for the decoder, so that the time covers the whole pipeline */
+	ras_pipeline_stop(ras->pipeline);
+	log(ALL, LOG_INFO, "Replayed %llu sub-buffers (%llu kB) in %ld ms\n",
+	    pages, bytes / 1024, elapsed_ms(&start));
+	ras_stats_log();
 
-cleanup:
-	if (pdata[0].ras->record_events) {
+close:
+	if (ras->record_events) {
+		ras_stats_store(ras);
 #ifdef HAVE_NON_STANDARD
 		ras_ns_finalize_vendor_tables();
 #endif
-		ras_mc_event_closedb(pdata[0].cpu, pdata[0].ras);
+		ras_mc_event_closedb(0, ras);
 	}
-
-error:
+free:
 	kbuffer_free(kbuf);
-	free(page);
-	sigprocmask(SIG_UNBLOCK, &mask, NULL);
-
-	for (i = 0; i < (n_cpus + 1); i++) {
-		if (fds[i].fd > 0)
-			close(fds[i].fd);
-	}
 
-	if (legacy_kernel)
-		return LEGACY_KERNEL;
-
-	return -EINVAL;
+	return rc;
 }
 
 static int read_ras_event(int fd,
@@ -692,8 +2096,11 @@ static int read_ras_event(int fd,
 {
 	int size;
 	unsigned long long time_stamp;
+	struct timespec last;
 	void *data;
 
+	clock_gettime(CLOCK_MONOTONIC, &last);
+
 	/*
 	 * read() never blocks. We can't call poll() here, as it is
 	 * not supported on kernels below 3.10. So, the better is to just
@@ -706,16 +2113,29 @@ static int read_ras_event(int fd,
 			return -EINVAL;
 		} else if (size > 0) {
 			kbuffer_load_subbuffer(kbuf, page);
+			pdata->drained += kbuffer_subbuffer_size(kbuf);
+			if (account_missed_events(pdata->cpu, kbuf))
+				pdata->missed = 1;
+			ras_capture_page(pdata->cpu, page, size);
 
 			while ((data = kbuffer_read_event(kbuf, &time_stamp))) {
-				parse_ras_data(pdata, kbuf, data, time_stamp);
+				/* One ring per CPU thread */
+				parse_ras_data(pdata, pdata->cpu, kbuf, data,
+					       time_stamp);
 
 				/* increment to read next event */
 				kbuffer_next_event(kbuf, NULL);
 			}
+			ras_pipeline_kick(pdata->ras->pipeline);
 		} else {
 			sleep(POLLING_TIME);
 		}
+
+		if (pdata->ras->buffer_kb_min &&
+		    elapsed_ms(&last) >= BUFFER_TUNE_MS) {
+			tune_cpu_buffer(pdata);
+			clock_gettime(CLOCK_MONOTONIC, &last);
+		}
 	} while (1);
 }
 
@@ -754,34 +2174,9 @@ static void *handle_ras_events_cpu(void *priv)
 	}
 
 	log(TERM, LOG_INFO, "Listening to events on cpu %d\n", pdata->cpu);
-	if (pdata->ras->record_events) {
-		pthread_mutex_lock(&pdata->ras->db_lock);
-		if (ras_mc_event_opendb(pdata->cpu, pdata->ras)) {
-			pthread_mutex_unlock(&pdata->ras->db_lock);
-			log(TERM, LOG_ERR, "Can't open database\n");
-			close(fd);
-			kbuffer_free(kbuf);
-			free(page);
-			return 0;
-		}
-#ifdef HAVE_NON_STANDARD
-		if (ras_ns_add_vendor_tables(pdata->ras))
-			log(TERM, LOG_ERR, "Can't add vendor table\n");
-#endif
-		pthread_mutex_unlock(&pdata->ras->db_lock);
-	}
 
 	read_ras_event(fd, pdata, kbuf, page);
 
-	if (pdata->ras->record_events) {
-		pthread_mutex_lock(&pdata->ras->db_lock);
-#ifdef HAVE_NON_STANDARD
-		ras_ns_finalize_vendor_tables();
-#endif
-		ras_mc_event_closedb(pdata->cpu, pdata->ras);
-		pthread_mutex_unlock(&pdata->ras->db_lock);
-	}
-
 	close(fd);
 	kbuffer_free(kbuf);
 	free(page);
@@ -789,6 +2184,48 @@ static void *handle_ras_events_cpu(void *priv)
 	return NULL;
 }
 
+/*
+ * On legacy kernels, each CPU has its own thread and ring. Both are only
+ * allocated for the CPUs that are online, as they're started.
+ */
+static int legacy_start_cpu(struct pthread_data *pdata)
+{
+	int rc;
+
+	rc = ras_pipeline_ring_alloc(pdata->ras->pipeline, pdata->cpu);
+	if (rc)
+		return rc;
+
+	rc = pthread_create(&pdata->thread, NULL, handle_ras_events_cpu,
+			    (void *)pdata);
+	if (rc)
+		return -rc;
+
+	pdata->online = 1;
+
+	return 0;
+}
+
+static void legacy_hotplug(int fd, struct pthread_data *data,
+			   unsigned int n_cpus)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	int cpu, action, rc;
+
+	while (poll(&pfd, 1, -1) >= 0 || errno == EINTR) {
+		while ((cpu = read_cpu_uevent(fd, n_cpus, &action)) >= 0) {
+			if (action != CPU_HOTPLUG_ONLINE || data[cpu].online)
+				continue;
+
+			rc = legacy_start_cpu(&data[cpu]);
+			if (rc)
+				log(ALL, LOG_ERR,
+				    "Can't start the thread of cpu %d: %s\n",
+				    cpu, strerror(-rc));
+		}
+	}
+}
+
 #define UPTIME "uptime"
 
 static int select_tracing_timestamp(struct ras_events *ras)
@@ -858,6 +2295,10 @@ static int select_tracing_timestamp(struct ras_events *ras)
 static bool check_event_exist(struct ras_events *ras, char *group, char *event)
 {
 	char fname[MAX_PATH + 256];
+	int size;
+
+	if (ras_replaying())
+		return ras_replay_format(group, event, &size) != NULL;
 
 	snprintf(fname, sizeof(fname), "%s/events/%s/%s",
 		 ras->tracing, group, event);
@@ -869,62 +2310,206 @@ static bool check_event_exist(struct ras_events *ras, char *group, char *event)
 
 #define EVENT_DISABLED	1
 
-static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
-			     unsigned int page_size, char *group, char *event,
-			     tep_event_handler_func func, char *filter_str, int id)
+/*
+ * Field accessors
+ */
+
+static struct ras_field *event_fields[NR_EVENTS] = {
+	[MC_EVENT] = mc_event_tep_fields,
+#ifdef HAVE_MCE
+	[MCE_EVENT] = mce_record_tep_fields,
+#endif
+#ifdef HAVE_ARM
+	[ARM_EVENT] = arm_event_tep_fields,
+#endif
+#ifdef HAVE_CXL
+	[CXL_POISON_EVENT] = cxl_poison_event_tep_fields,
+	[CXL_AER_UE_EVENT] = cxl_aer_ue_event_tep_fields,
+	[CXL_AER_CE_EVENT] = cxl_aer_ce_event_tep_fields,
+	[CXL_OVERFLOW_EVENT] = cxl_overflow_event_tep_fields,
+	[CXL_GENERIC_EVENT] = cxl_generic_event_tep_fields,
+	[CXL_GENERAL_MEDIA_EVENT] = cxl_general_media_event_tep_fields,
+	[CXL_DRAM_EVENT] = cxl_dram_event_tep_fields,
+	[CXL_MEMORY_MODULE_EVENT] = cxl_memory_module_event_tep_fields,
+	[CXL_MEMORY_SPARING_EVENT] = cxl_memory_sparing_event_tep_fields,
+#endif
+};
+
+static void resolve_event_fields(struct tep_handle *pevent, char *group,
+				 char *event, int id)
 {
-	int fd, rc;
-	int size = 0;
-	char *page, fname[MAX_PATH + 1];
-	struct tep_event_filter *filter = NULL;
+	struct ras_field *f = event_fields[id];
+	struct tep_event *ev;
+
+	if (!f)
+		return;
+
+	ev = tep_find_event_by_name(pevent, group, event);
+	for (; f->name; f++) {
+		f->field = ev ? tep_find_field(ev, f->name) : NULL;
+		if (!f->field)
+			log(TERM, LOG_DEBUG, "%s:%s has no field %s\n",
+			    group, event, f->name);
+	}
+}
 
-	if (!check_event_exist(ras, group, event)) {
-		log(ALL, LOG_WARNING, "%s:%s event not exist\n",
-		    group, event);
-		return -EINVAL;
+/* Same as tep_get_field_val(), for a field resolved at registration */
+int ras_get_field_val(struct trace_seq *s, struct ras_field *f,
+		      struct tep_record *record, unsigned long long *val,
+		      int err)
+{
+	if (!f->field) {
+		if (err)
+			trace_seq_printf(s, "<CANT FIND FIELD %s>", f->name);
+		return -1;
 	}
 
-	snprintf(fname, sizeof(fname), "events/%s/%s/format", group, event);
+	if (tep_read_number_field(f->field, record->data, val)) {
+		if (err)
+			trace_seq_printf(s, " %s=INVALID", f->name);
+		return -1;
+	}
 
-	fd = open_trace(ras, fname, O_RDONLY);
-	if (fd < 0) {
-		if (fd == -ENOENT) {
-			log(TERM, LOG_ERR,
-			    "Feature %s:%s not supported on your system.\n",
-			    group, event);
-			return EVENT_DISABLED;
-		}
+	return 0;
+}
 
-		log(TERM, LOG_ERR, "Can't get %s:%s traces: %s\n",
-		    group, event, strerror(-fd));
+/* Same as tep_get_field_raw(), for a field resolved at registration */
+void *ras_get_field_raw(struct trace_seq *s, struct ras_field *f,
+			struct tep_record *record, int *len, int err)
+{
+	struct tep_format_field *field = f->field;
+	unsigned int offset;
+	int dummy;
 
-		return fd;
+	if (!field) {
+		if (err)
+			trace_seq_printf(s, "<CANT FIND FIELD %s>", f->name);
+		return NULL;
+	}
+
+	/* Allow @len to be NULL */
+	if (!len)
+		len = &dummy;
+
+	offset = field->offset;
+	if (field->flags & TEP_FIELD_IS_DYNAMIC) {
+		offset = tep_read_number(field->event->tep,
+					 record->data + offset, field->size);
+		*len = offset >> 16;
+		offset &= 0xffff;
+		if (field->flags & TEP_FIELD_IS_RELATIVE)
+			offset += field->offset + field->size;
+	} else {
+		*len = field->size;
 	}
 
-	page = malloc(page_size);
+	return record->data + offset;
+}
+
+/*
+ * Tracepoint formats
+ *
+ * Reading the format files is the slowest part of the startup, so the ones
+ * of the events to be registered are read in parallel, before registering
+ * the handlers. Parsing them can't be done in parallel, as struct
+ * tep_handle is not thread-safe.
+ */
+
+/* Same events, and conditions, as registered by handle_ras_events() */
+static const struct {
+	char *group;
+	char *event;
+} tracepoints[] = {
+	{ "ras", "mc_event" },
+#ifdef HAVE_AER
+	{ "ras", "aer_event" },
+#endif
+#ifdef HAVE_NON_STANDARD
+	{ "ras", "non_standard_event" },
+#endif
+#ifdef HAVE_ARM
+	{ "ras", "arm_event" },
+#endif
+#ifdef HAVE_MCE
+	{ "mce", "mce_record" },
+#endif
+#ifdef HAVE_EXTLOG
+	{ "ras", "extlog_mem_event" },
+#endif
+#ifdef HAVE_DEVLINK
+	{ "net", "net_dev_xmit_timeout" },
+	{ "devlink", "devlink_health_report" },
+#endif
+#ifdef HAVE_DISKERROR
+#ifdef HAVE_BLK_RQ_ERROR
+	{ "block", "block_rq_error" },
+#else
+	{ "block", "block_rq_complete" },
+#endif
+#endif
+#ifdef HAVE_MEMORY_FAILURE
+	{ "ras", "memory_failure_event" },
+#endif
+#ifdef HAVE_CXL
+	{ "cxl", "cxl_poison" },
+	{ "cxl", "cxl_aer_uncorrectable_error" },
+	{ "cxl", "cxl_aer_correctable_error" },
+	{ "cxl", "cxl_overflow" },
+	{ "cxl", "cxl_generic_event" },
+	{ "cxl", "cxl_general_media" },
+	{ "cxl", "cxl_dram" },
+	{ "cxl", "cxl_memory_module" },
+	{ "cxl", "cxl_memory_sparing" },
+#endif
+#ifdef HAVE_SIGNAL
+	{ "signal", "signal_generate" },
+#endif
+#ifdef HAVE_RERI
+	{ "ras", "reri_event" },
+#endif
+};
+
+#define NR_TRACEPOINTS		ARRAY_SIZE(tracepoints)
+#define MAX_PREFETCH_THREADS	8
+
+struct event_format {
+	char	*buf;
+	int	size;
+	int	rc;
+	bool	fetched;
+};
+
+static struct event_format prefetched[NR_TRACEPOINTS];
+
+static int read_trace_file(struct ras_events *ras, char *name,
+			   unsigned int page_size, char **buf)
+{
+	char *page, *p;
+	int fd, rc, size = 0;
+
+	fd = open_trace(ras, name, O_RDONLY);
+	if (fd < 0)
+		return fd;
+
+	page = malloc(page_size + 1);
 	if (!page) {
-		rc = -errno;
-		log(TERM, LOG_ERR, "Can't allocate page to read %s:%s format\n",
-		    group, event);
 		close(fd);
-		return rc;
+		return -ENOMEM;
 	}
 
 	do {
 		if (size > 0) {
-			page = realloc(page, page_size + size);
-			if (!page) {
-				rc = -errno;
-				log(TERM, LOG_ERR,
-				    "Can't reallocate page to read %s:%s format\n",
-				    group, event);
+			p = realloc(page, size + page_size + 1);
+			if (!p) {
+				free(page);
 				close(fd);
-				return rc;
+				return -ENOMEM;
 			}
+			page = p;
 		}
 		rc = read(fd, page + size, page_size);
 		if (rc < 0) {
-			log(TERM, LOG_ERR, "Can't get arch page size\n");
+			rc = -errno;
 			free(page);
 			close(fd);
 			return rc;
@@ -933,6 +2518,147 @@ static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
 	} while (rc > 0);
 	close(fd);
 
+	page[size] = '\0';
+	*buf = page;
+
+	return size;
+}
+
+static void read_event_format(struct ras_events *ras, unsigned int page_size,
+			      char *group, char *event, struct event_format *fmt)
+{
+	char fname[MAX_PATH + 1];
+	int rc;
+
+	memset(fmt, 0, sizeof(*fmt));
+
+	snprintf(fname, sizeof(fname), "events/%s/%s/format", group, event);
+	rc = read_trace_file(ras, fname, page_size, &fmt->buf);
+	if (rc < 0)
+		fmt->rc = rc;
+	else
+		fmt->size = rc;
+	fmt->fetched = true;
+}
+
+struct prefetch_data {
+	struct ras_events	*ras;
+	unsigned int		page_size;
+	unsigned int		next;
+};
+
+static void *prefetch_thread(void *priv)
+{
+	struct prefetch_data *pf = priv;
+	unsigned int i;
+
+	while ((i = __atomic_fetch_add(&pf->next, 1, __ATOMIC_RELAXED)) <
+	       NR_TRACEPOINTS) {
+		/* Non-existing events would wait for their files to show up */
+		if (!check_event_exist(pf->ras, tracepoints[i].group,
+				       tracepoints[i].event))
+			continue;
+
+		read_event_format(pf->ras, pf->page_size, tracepoints[i].group,
+				  tracepoints[i].event, &prefetched[i]);
+	}
+
+	return NULL;
+}
+
+static void prefetch_event_formats(struct ras_events *ras,
+				   unsigned int page_size)
+{
+	pthread_t threads[MAX_PREFETCH_THREADS];
+	struct prefetch_data pf = {
+		.ras = ras,
+		.page_size = page_size,
+	};
+	unsigned int i, n_threads = 0;
+
+	for (i = 0; i < MAX_PREFETCH_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, prefetch_thread, &pf))
+			break;
+		n_threads++;
+	}
+
+	/* Whatever was not fetched is read when registering the event */
+	for (i = 0; i < n_threads; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static void free_event_formats(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NR_TRACEPOINTS; i++) {
+		free(prefetched[i].buf);
+		memset(&prefetched[i], 0, sizeof(prefetched[i]));
+	}
+}
+
+static void get_event_format(struct ras_events *ras, unsigned int page_size,
+			     char *group, char *event, struct event_format *fmt)
+{
+	const char *buf;
+	unsigned int i;
+
+	if (ras_replaying()) {
+		memset(fmt, 0, sizeof(*fmt));
+		buf = ras_replay_format(group, event, &fmt->size);
+		fmt->buf = buf ? strndup(buf, fmt->size) : NULL;
+		fmt->rc = buf ? 0 : -ENOENT;
+		return;
+	}
+
+	for (i = 0; i < NR_TRACEPOINTS; i++) {
+		if (strcmp(tracepoints[i].group, group) ||
+		    strcmp(tracepoints[i].event, event))
+			continue;
+
+		if (!prefetched[i].fetched)
+			break;
+
+		/* Hand over the prefetched buffer */
+		*fmt = prefetched[i];
+		memset(&prefetched[i], 0, sizeof(prefetched[i]));
+		return;
+	}
+
+	read_event_format(ras, page_size, group, event, fmt);
+}
+
+static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
+			     unsigned int page_size, char *group, char *event,
+			     tep_event_handler_func func, char *filter_str, int id)
+{
+	struct tep_event_filter *filter = NULL;
+	struct event_format fmt;
+	char *page;
+	int rc;
+
+	if (!check_event_exist(ras, group, event)) {
+		log(ALL, LOG_WARNING, "%s:%s event not exist\n",
+		    group, event);
+		return -EINVAL;
+	}
+
+	get_event_format(ras, page_size, group, event, &fmt);
+	if (!fmt.buf) {
+		if (fmt.rc == -ENOENT) {
+			log(TERM, LOG_ERR,
+			    "Feature %s:%s not supported on your system.\n",
+			    group, event);
+			return EVENT_DISABLED;
+		}
+
+		log(TERM, LOG_ERR, "Can't get %s:%s traces: %s\n",
+		    group, event, strerror(-fmt.rc));
+
+		return fmt.rc ? fmt.rc : -EINVAL;
+	}
+	page = fmt.buf;
+
 	/* Registers the special event handlers */
 	rc = tep_register_event_handler(pevent, -1, group, event, func, ras);
 	if (rc == TEP_ERRNO__MEM_ALLOC_FAILED) {
@@ -942,13 +2668,18 @@ static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
 		return -EINVAL;
 	}
 
-	rc = tep_parse_event(pevent, page, size, group);
+	rc = tep_parse_event(pevent, page, fmt.size, group);
 	if (rc) {
 		log(TERM, LOG_ERR, "Can't parse event %s:%s\n", group, event);
 		free(page);
 		return -EINVAL;
 	}
 
+	ras_capture_format(group, event, page, fmt.size);
+
+	resolve_event_fields(pevent, group, event, id);
+	add_event_type(pevent, group, event, id);
+
 	if (filter_str) {
 		char error[255];
 
@@ -981,7 +2712,7 @@ static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
 	}
 
 	/* Enable RAS events */
-	rc = __toggle_ras_mc_event(ras, group, event, 1);
+	rc = ras_replaying() ? 0 : __toggle_ras_mc_event(ras, group, event, 1);
 	free(page);
 	if (rc < 0) {
 		log(TERM, LOG_ERR, "Can't enable %s:%s tracing\n",
@@ -990,7 +2721,8 @@ static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
 		return -EINVAL;
 	}
 
-	setup_event_trigger(event);
+	if (!ras_replaying())
+		setup_event_trigger(event);
 
 	log(ALL, LOG_INFO, "Enabled event %s:%s\n", group, event);
 
@@ -999,8 +2731,8 @@ static int add_event_handler(struct ras_events *ras, struct tep_handle *pevent,
 
 int handle_ras_events(int record_events, int enable_ipmitool)
 {
-	int rc, page_size, i;
-	int num_events = 0;
+	int rc, page_size, i, uevfd;
+	int num_events = 0, n_threads = 0;
 	unsigned int cpus;
 	struct tep_handle *pevent = NULL;
 	struct pthread_data *data = NULL;
@@ -1018,15 +2750,32 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 		return -errno;
 	}
 
-	rc = get_tracing_dir(ras);
-	if (rc < 0) {
-		log(TERM, LOG_ERR, "Can't locate a mounted debugfs\n");
-		goto err;
+	if (ras_replaying()) {
+		rc = ras_replay_start(ras);
+		if (rc < 0)
+			goto err;
+
+		/* The captured events are not about this machine */
+		log(ALL, LOG_INFO,
+		    "Replaying: isolation, triggers and ABRT reports are disabled\n");
+	} else {
+		rc = get_tracing_dir(ras);
+		if (rc < 0) {
+			log(TERM, LOG_ERR, "Can't locate a mounted debugfs\n");
+			goto err;
+		}
+
+		rc = select_tracing_timestamp(ras);
+		if (rc < 0)
+			log(TERM, LOG_ERR, "Can't select a timestamp for tracing. Using default\n");
+
+		rc = ras_capture_start(ras);
+		if (rc < 0)
+			goto err;
 	}
 
-	rc = select_tracing_timestamp(ras);
-	if (rc < 0)
-		log(TERM, LOG_ERR, "Can't select a timestamp for tracing. Using default\n");
+	select_text_output(ras);
+	ras_output_setup(ras);
 
 	pevent = tep_alloc();
 	if (!pevent) {
@@ -1041,6 +2790,9 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 	ras->page_size = page_size;
 	ras->record_events = record_events;
 
+	if (!ras_replaying())
+		prefetch_event_formats(ras, page_size);
+
 #ifdef HAVE_MEMORY_ROW_CE_PFA
 	ras_row_account_init();
 #endif
@@ -1050,6 +2802,11 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 	ras_page_account_init();
 #endif
 
+	if (!ras_replaying())
+		ras_report_setup();
+	ras_metrics_setup();
+	ras_subscribe_setup();
+
 	rc = add_event_handler(ras, pevent, page_size, "ras", "mc_event",
 			       ras_mc_event_handler, NULL, MC_EVENT);
 	if (!rc)
@@ -1090,13 +2847,15 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 #endif
 
 	cpus = get_num_cpus(ras);
+	if (ras_stats_init(cpus))
+		log(TERM, LOG_WARNING, "Can't allocate the per-cpu event counters\n");
 
 #ifdef HAVE_CPU_FAULT_ISOLATION
 	ras_cpu_isolation_init(sysconf(_SC_NPROCESSORS_CONF));
 #endif
 
 #ifdef HAVE_MCE
-	rc = register_mce_handler(ras, cpus);
+	rc = register_mce_handler(ras, sysconf(_SC_NPROCESSORS_ONLN));
 	if (rc && rc != -ENOENT)
 		log(ALL, LOG_INFO, "Can't register mce handler\n");
 	if (ras->mce_priv) {
@@ -1116,7 +2875,8 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 			       ras_extlog_mem_event_handler, NULL, EXTLOG_EVENT);
 	if (!rc) {
 		/* tell kernel we are listening, so don't printk to console */
-		(void)open("/sys/kernel/debug/ras/daemon_active", 0);
+		if (!ras_replaying())
+			(void)open("/sys/kernel/debug/ras/daemon_active", 0);
 		num_events++;
 	} else if (rc != EVENT_DISABLED)
 		log(ALL, LOG_ERR, "Can't get traces from %s:%s\n",
@@ -1275,6 +3035,8 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 		    "ras", "reri_event");
 #endif
 
+	free_event_formats();
+
 	if (!num_events) {
 		log(ALL, LOG_INFO,
 		    "Failed to trace any supported RAS events. Aborting.\n");
@@ -1282,6 +3044,11 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 		goto err;
 	}
 
+	if (ras_replaying()) {
+		rc = replay_ras_events(ras);
+		goto err;
+	}
+
 	data = calloc(cpus, sizeof(*data));
 	if (!data)
 		goto err;
@@ -1294,33 +3061,86 @@ int handle_ras_events(int record_events, int enable_ipmitool)
 
 	/* Poll doesn't work on this kernel. Fallback to pthread way */
 	if (rc == LEGACY_KERNEL) {
-		if (pthread_mutex_init(&ras->db_lock, NULL) != 0) {
-			log(SYSLOG, LOG_INFO, "sqlite db lock init has failed\n");
+		/* One ring per CPU thread, allocated as it starts */
+		ras->pipeline = ras_pipeline_alloc(ras, cpus, true,
+						  decode_ras_data);
+		if (!ras->pipeline) {
+			rc = -ENOMEM;
 			goto err;
 		}
 
-		log(SYSLOG, LOG_INFO,
-		    "Opening one thread per cpu (%d threads)\n", cpus);
+		if (ras->record_events) {
+			rc = ras_mc_event_opendb(0, ras);
+			if (rc) {
+				log(TERM, LOG_ERR, "Can't open database\n");
+				goto err;
+			}
+#ifdef HAVE_NON_STANDARD
+			if (ras_ns_add_vendor_tables(ras))
+				log(TERM, LOG_ERR, "Can't add vendor table\n");
+#endif
+		}
+
+		rc = ras_pipeline_start(ras->pipeline);
+		if (rc)
+			goto err_legacy;
+
+		/* Listen before looking at which CPUs are online */
+		uevfd = open_uevent_socket();
+		if (uevfd < 0)
+			log(TERM, LOG_WARNING,
+			    "Can't listen for CPU hotplug events: %s\n",
+			    strerror(-uevfd));
+
 		for (i = 0; i < cpus; i++) {
-			rc = pthread_create(&data[i].thread, NULL,
-					    handle_ras_events_cpu,
-					(void *)&data[i]);
+			if (!cpu_is_online(i))
+				continue;
+
+			rc = legacy_start_cpu(&data[i]);
 			if (rc) {
 				log(SYSLOG, LOG_INFO,
 				    "Failed to create thread for cpu %d. Aborting.\n",
 				i);
-				while (--i)
-					pthread_cancel(data[i].thread);
+				while (--i >= 0) {
+					if (data[i].online)
+						pthread_cancel(data[i].thread);
+				}
+				if (uevfd >= 0)
+					close(uevfd);
 
-				pthread_mutex_destroy(&ras->db_lock);
-				goto err;
+				goto err_legacy;
 			}
+			n_threads++;
+		}
+		log(SYSLOG, LOG_INFO,
+		    "Opened one thread per online cpu (%d threads)\n",
+		    n_threads);
+
+		/*
+		 * Start the threads of the CPUs going online. The ones of the
+		 * CPUs going offline just wait for them to be back.
+		 */
+		if (uevfd >= 0) {
+			legacy_hotplug(uevfd, data, cpus);
+			close(uevfd);
 		}
 
 		/* Wait for all threads to complete */
-		for (i = 0; i < cpus; i++)
-			pthread_join(data[i].thread, NULL);
-		pthread_mutex_destroy(&ras->db_lock);
+		for (i = 0; i < cpus; i++) {
+			if (data[i].online)
+				pthread_join(data[i].thread, NULL);
+		}
+
+err_legacy:
+		ras_pipeline_stop(ras->pipeline);
+		ras_stats_log();
+		if (ras->record_events) {
+			ras_stats_store(ras);
+#ifdef HAVE_NON_STANDARD
+			ras_ns_finalize_vendor_tables();
+#endif
+			ras_mc_event_closedb(0, ras);
+		}
 	}
 
 	log(SYSLOG, LOG_INFO, "Huh! something got wrong. Aborting.\n");
@@ -1333,6 +3153,7 @@ err:
 		tep_free(pevent);
 
 	if (ras) {
+		ras_pipeline_free(ras->pipeline);
 		for (i = 0; i < NR_EVENTS; i++) {
 			if (ras->filters[i])
 				tep_filter_free(ras->filters[i]);
@@ -1346,5 +3167,12 @@ err:
 #ifdef HAVE_MEMORY_ROW_CE_PFA
 	row_record_infos_free();
 #endif
+	ras_output_close();
+	ras_subscribe_close();
+	ras_metrics_close();
+	ras_stats_free();
+	ras_capture_close();
+	ras_replay_close();
+
 	return rc;
 }
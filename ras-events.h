@@ -15,6 +15,11 @@
 extern char *choices_disable;
 
 struct mce_priv;
+struct ras_pipeline;
+struct tep_format_field;
+struct trace_buffer_meta;
+struct tep_record;
+struct trace_seq;
 struct ras_mc_offline_event;
 
 enum {
@@ -49,14 +54,21 @@ struct ras_events {
 	/* Booleans */
 	unsigned	use_uptime: 1;
 	unsigned        record_events: 1;
+	unsigned	text_output: 1;
 
 	/* For timestamp */
 	time_t		uptime_diff;
 
+	/* Bounds of the per_cpu buffer_size_kb. Zero if not managed */
+	unsigned int	buffer_kb_min;
+	unsigned int	buffer_kb_max;
+
 	/* For ras-record */
 	void	*db_priv;
 	int	db_ref_count;
-	pthread_mutex_t db_lock;
+
+	/* Readers -> decoder rings. Event handlers run at the decoder */
+	struct ras_pipeline *pipeline;
 
 	/* For the mce handler */
 	struct mce_priv	*mce_priv;
@@ -67,13 +79,53 @@ struct ras_events {
 	struct tep_event_filter *filters[NR_EVENTS];
 };
 
+enum {
+	CPU_HOTPLUG_NONE,
+	CPU_HOTPLUG_ONLINE,
+	CPU_HOTPLUG_OFFLINE,
+};
+
 struct pthread_data {
 	pthread_t		thread;
 	struct tep_handle	*pevent;
 	struct ras_events	*ras;
 	int			cpu;
+
+	/* per_cpu trace_pipe_raw, when read by a reader thread */
+	int			fd;
+	int			node;
+	int			reader;
+	int			hotplug;	/* Pending CPU_HOTPLUG_* request */
+	unsigned		online: 1;
+	unsigned		ready: 1;
+	unsigned		warnonce: 1;
+
+	/* mmap'd per_cpu ring buffer, when TRACE_MMAP is enabled */
+	struct trace_buffer_meta *meta;
+	void			*map_data;
+	size_t			map_len;
+	int			last_id;
+	int			last_offset;
+
+	/* Adaptive buffer_size_kb, updated by the reader thread */
+	unsigned int		buffer_kb;
+	unsigned int		idle_ticks;
+	size_t			drained;
+	unsigned		missed: 1;
 };
 
+/*
+ * Event field accessors. Handlers declare a table with the fields they
+ * use, terminated by an empty entry. The fields are looked up once, when
+ * the event is registered, instead of by name for every record.
+ */
+struct ras_field {
+	const char		*name;
+	struct tep_format_field	*field;
+};
+
+#define RAS_FIELD(_name)	{ .name = _name }
+
 /* Should match the code at Kernel's include/linux/edac.c */
 enum hw_event_mc_err_type {
 	HW_EVENT_ERR_CORRECTED,
@@ -101,6 +153,11 @@ enum ghes_severity {
 /* Function prototypes */
 int toggle_ras_mc_event(int enable);
 int handle_ras_events(int record_events, int enable_ipmitool);
+int ras_get_field_val(struct trace_seq *s, struct ras_field *f,
+		      struct tep_record *record, unsigned long long *val,
+		      int err);
+void *ras_get_field_raw(struct trace_seq *s, struct ras_field *f,
+			struct tep_record *record, int *len, int err);
 int ras_offline_mce_event(struct ras_mc_offline_event *event);
 int handle_ras_events(int record_events, int enable_ipmitool);
 
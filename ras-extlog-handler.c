@@ -15,7 +15,8 @@
 
 #include "ras-extlog-handler.h"
 #include "ras-logger.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 static char *err_type(int etype)
@@ -294,7 +295,8 @@ int ras_extlog_mem_event_handler(struct trace_seq *s,
 
 	report_extlog_mem_event(ras, record, s, &ev);
 
-	ras_store_extlog_mem_record(ras, &ev);
+	ras_sink_emit(ras, EXTLOG_EVENT,
+		      ras_severity_from_str(err_severity(ev.severity)), &ev);
 
 	return 0;
 }
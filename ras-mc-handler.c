@@ -16,13 +16,17 @@
 #include "ras-logger.h"
 #include "ras-mc-handler.h"
 #include "ras-page-isolation.h"
-#include "ras-report.h"
+#include "ras-pipeline.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "trigger.h"
 #include "types.h"
 
 #define MAX_ENV 30
 static const char *mc_ce_trigger = NULL;
 static const char *mc_ue_trigger = NULL;
+static struct ras_sink mc_trigger_sink;
+static struct ras_sink_queue *mc_trigger_queue;
 
 void mc_event_trigger_setup(void)
 {
@@ -57,11 +61,17 @@ void mc_event_trigger_setup(void)
 			    trigger);
 		}
 	}
+
+	if (mc_ce_trigger || mc_ue_trigger) {
+		mc_trigger_queue = ras_sink_queue_create(mc_trigger_sink.name);
+		ras_sink_register(&mc_trigger_sink);
+	}
 }
 
-static void run_mc_trigger(struct ras_mc_event *ev, const char *mc_trigger)
+static int run_mc_trigger(struct ras_mc_event *ev, const char *mc_trigger)
 {
 	char *env[MAX_ENV];
+	int rc = -ENOMEM;
 	int ei = 0;
 	int i;
 
@@ -96,13 +106,36 @@ static void run_mc_trigger(struct ras_mc_event *ev, const char *mc_trigger)
 	env[ei] = NULL;
 	assert(ei < MAX_ENV);
 
-	run_trigger(mc_trigger, NULL, env, "mc_event");
+	rc = run_trigger(mc_trigger_queue, mc_trigger, NULL, env, "mc_event");
 
 free:
 	for (i = 0; i < ei; i++)
 		free(env[i]);
+
+	return rc;
 }
 
+static int mc_trigger_emit(struct ras_events *ras,
+			   const struct ras_sink_event *sev)
+{
+	struct ras_mc_event *ev = sev->ev;
+
+	if (mc_ce_trigger && !strcmp(ev->error_type, "Corrected"))
+		return run_mc_trigger(ev, mc_ce_trigger);
+
+	if (mc_ue_trigger && !strcmp(ev->error_type, "Uncorrected"))
+		return run_mc_trigger(ev, mc_ue_trigger);
+
+	return 0;
+}
+
+static struct ras_sink mc_trigger_sink = {
+	.name = "mc_trigger",
+	.emit = mc_trigger_emit,
+	.types = BIT_ULL(MC_EVENT),
+	.min_severity = RAS_SEV_CORRECTED,
+};
+
 static unsigned long long per_sec_ce_count;
 unsigned long long mc_ce_stat_threshold;
 static time_t cur;
@@ -124,10 +157,42 @@ static int ras_mc_event_stat(time_t now, struct ras_mc_event *e)
 	return 0;
 }
 
+enum {
+	MC_FIELD_ERROR_TYPE,
+	MC_FIELD_ERROR_COUNT,
+	MC_FIELD_MSG,
+	MC_FIELD_LABEL,
+	MC_FIELD_MC_INDEX,
+	MC_FIELD_TOP_LAYER,
+	MC_FIELD_MIDDLE_LAYER,
+	MC_FIELD_LOWER_LAYER,
+	MC_FIELD_ADDRESS,
+	MC_FIELD_GRAIN_BITS,
+	MC_FIELD_SYNDROME,
+	MC_FIELD_DRIVER_DETAIL,
+};
+
+struct ras_field mc_event_tep_fields[] = {
+	[MC_FIELD_ERROR_TYPE] = RAS_FIELD("error_type"),
+	[MC_FIELD_ERROR_COUNT] = RAS_FIELD("error_count"),
+	[MC_FIELD_MSG] = RAS_FIELD("msg"),
+	[MC_FIELD_LABEL] = RAS_FIELD("label"),
+	[MC_FIELD_MC_INDEX] = RAS_FIELD("mc_index"),
+	[MC_FIELD_TOP_LAYER] = RAS_FIELD("top_layer"),
+	[MC_FIELD_MIDDLE_LAYER] = RAS_FIELD("middle_layer"),
+	[MC_FIELD_LOWER_LAYER] = RAS_FIELD("lower_layer"),
+	[MC_FIELD_ADDRESS] = RAS_FIELD("address"),
+	[MC_FIELD_GRAIN_BITS] = RAS_FIELD("grain_bits"),
+	[MC_FIELD_SYNDROME] = RAS_FIELD("syndrome"),
+	[MC_FIELD_DRIVER_DETAIL] = RAS_FIELD("driver_detail"),
+	{ }
+};
+
 int ras_mc_event_handler(struct trace_seq *s,
 			 struct tep_record *record,
 			 struct tep_event *event, void *context)
 {
+	struct ras_field *f = mc_event_tep_fields;
 	int len;
 	unsigned long long val;
 	struct ras_events *ras = context;
@@ -137,7 +202,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 	int parsed_fields = 0;
 	const char *level;
 
-	if (tep_get_field_val(s, event, "error_type", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_ERROR_TYPE], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 
@@ -196,7 +261,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 			 "%Y-%m-%d %H:%M:%S %z", tm);
 	trace_seq_printf(s, "%s ", ev.timestamp);
 
-	if (tep_get_field_val(s,  event, "error_count", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_ERROR_COUNT], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 
@@ -209,7 +274,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 	else
 		trace_seq_puts(s, " error:");
 
-	ev.msg = tep_get_field_raw(s, event, "msg", record, &len, 1);
+	ev.msg = ras_get_field_raw(s, &f[MC_FIELD_MSG], record, &len, 1);
 	if (!ev.msg)
 		goto parse_error;
 	parsed_fields++;
@@ -219,7 +284,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 		trace_seq_puts(s, ev.msg);
 	}
 
-	ev.label = tep_get_field_raw(s, event, "label", record, &len, 1);
+	ev.label = ras_get_field_raw(s, &f[MC_FIELD_LABEL], record, &len, 1);
 	if (!ev.label)
 		goto parse_error;
 	parsed_fields++;
@@ -230,24 +295,24 @@ int ras_mc_event_handler(struct trace_seq *s,
 	}
 
 	trace_seq_puts(s, " (");
-	if (tep_get_field_val(s,  event, "mc_index", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_MC_INDEX], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 
 	ev.mc_index = val;
 	trace_seq_printf(s, "mc: %d", ev.mc_index);
 
-	if (tep_get_field_val(s,  event, "top_layer", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_TOP_LAYER], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 	ev.top_layer = (signed char)val;
 
-	if (tep_get_field_val(s,  event, "middle_layer", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_MIDDLE_LAYER], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 	ev.middle_layer = (signed char)val;
 
-	if (tep_get_field_val(s,  event, "lower_layer", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_LOWER_LAYER], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 	ev.lower_layer = (signed char)val;
@@ -263,7 +328,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 			trace_seq_printf(s, " location: %d", ev.top_layer);
 	}
 
-	if (tep_get_field_val(s,  event, "address", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_ADDRESS], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 
@@ -271,14 +336,14 @@ int ras_mc_event_handler(struct trace_seq *s,
 	if (ev.address)
 		trace_seq_printf(s, " address: 0x%08llx", ev.address);
 
-	if (tep_get_field_val(s,  event, "grain_bits", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_GRAIN_BITS], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 
 	ev.grain = val;
 	trace_seq_printf(s, " grain: %lld", ev.grain);
 
-	if (tep_get_field_val(s,  event, "syndrome", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MC_FIELD_SYNDROME], record, &val, 1) < 0)
 		goto parse_error;
 	parsed_fields++;
 
@@ -286,7 +351,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 	if (val)
 		trace_seq_printf(s, " syndrome: 0x%08llx", ev.syndrome);
 
-	ev.driver_detail = tep_get_field_raw(s, event, "driver_detail", record,
+	ev.driver_detail = ras_get_field_raw(s, &f[MC_FIELD_DRIVER_DETAIL], record,
 					     &len, 1);
 	if (!ev.driver_detail)
 		goto parse_error;
@@ -298,9 +363,7 @@ int ras_mc_event_handler(struct trace_seq *s,
 	}
 	trace_seq_puts(s, ")");
 
-	/* Insert data into the SGBD */
-
-	ras_store_mc_event(ras, &ev);
+	ras_sink_emit(ras, MC_EVENT, ras_severity_from_str(ev.error_type), &ev);
 
 	ras_mc_event_stat(now, &ev);
 
@@ -325,17 +388,6 @@ int ras_mc_event_handler(struct trace_seq *s,
 				     ts.tv_sec, ev.address);
 #endif
 
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_mc_event(ras, &ev);
-#endif
-
-	if (mc_ce_trigger && !strcmp(ev.error_type, "Corrected"))
-		run_mc_trigger(&ev, mc_ce_trigger);
-
-	if (mc_ue_trigger && !strcmp(ev.error_type, "Uncorrected"))
-		run_mc_trigger(&ev, mc_ue_trigger);
-
 	return 0;
 
 parse_error:
@@ -14,6 +14,8 @@ extern unsigned long long mc_ce_stat_threshold;
 
 void mc_event_trigger_setup(void);
 
+extern struct ras_field mc_event_tep_fields[];
+
 int ras_mc_event_handler(struct trace_seq *s,
 			 struct tep_record *record,
 			 struct tep_event *event, void *context);
@@ -15,7 +15,8 @@
 
 #include "ras-logger.h"
 #include "ras-mce-handler.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 /*
@@ -526,10 +527,68 @@ free_mce:
 	return rc;
 }
 
+enum {
+	MCE_FIELD_MCGCAP,
+	MCE_FIELD_MCGSTATUS,
+	MCE_FIELD_STATUS,
+	MCE_FIELD_ADDR,
+	MCE_FIELD_MISC,
+	MCE_FIELD_IP,
+	MCE_FIELD_TSC,
+	MCE_FIELD_WALLTIME,
+	MCE_FIELD_CPU,
+	MCE_FIELD_CPUID,
+	MCE_FIELD_APICID,
+	MCE_FIELD_SOCKETID,
+	MCE_FIELD_CS,
+	MCE_FIELD_BANK,
+	MCE_FIELD_CPUVENDOR,
+	MCE_FIELD_SYND,
+	MCE_FIELD_IPID,
+	MCE_FIELD_PPIN,
+	MCE_FIELD_MICROCODE,
+	MCE_FIELD_V_DATA,
+};
+
+struct ras_field mce_record_tep_fields[] = {
+	[MCE_FIELD_MCGCAP] = RAS_FIELD("mcgcap"),
+	[MCE_FIELD_MCGSTATUS] = RAS_FIELD("mcgstatus"),
+	[MCE_FIELD_STATUS] = RAS_FIELD("status"),
+	[MCE_FIELD_ADDR] = RAS_FIELD("addr"),
+	[MCE_FIELD_MISC] = RAS_FIELD("misc"),
+	[MCE_FIELD_IP] = RAS_FIELD("ip"),
+	[MCE_FIELD_TSC] = RAS_FIELD("tsc"),
+	[MCE_FIELD_WALLTIME] = RAS_FIELD("walltime"),
+	[MCE_FIELD_CPU] = RAS_FIELD("cpu"),
+	[MCE_FIELD_CPUID] = RAS_FIELD("cpuid"),
+	[MCE_FIELD_APICID] = RAS_FIELD("apicid"),
+	[MCE_FIELD_SOCKETID] = RAS_FIELD("socketid"),
+	[MCE_FIELD_CS] = RAS_FIELD("cs"),
+	[MCE_FIELD_BANK] = RAS_FIELD("bank"),
+	[MCE_FIELD_CPUVENDOR] = RAS_FIELD("cpuvendor"),
+	[MCE_FIELD_SYND] = RAS_FIELD("synd"),
+	[MCE_FIELD_IPID] = RAS_FIELD("ipid"),
+	[MCE_FIELD_PPIN] = RAS_FIELD("ppin"),
+	[MCE_FIELD_MICROCODE] = RAS_FIELD("microcode"),
+	[MCE_FIELD_V_DATA] = RAS_FIELD("v_data"),
+	{ }
+};
+
+static enum ras_severity mce_severity(struct mce_event *e)
+{
+	if (e->status & MCI_STATUS_PCC)
+		return RAS_SEV_FATAL;
+	if (e->status & MCI_STATUS_UC)
+		return RAS_SEV_UNCORRECTED;
+
+	return RAS_SEV_CORRECTED;
+}
+
 int ras_mce_event_handler(struct trace_seq *s,
 			  struct tep_record *record,
 			  struct tep_event *event, void *context)
 {
+	struct ras_field *f = mce_record_tep_fields;
 	unsigned long long val;
 	struct ras_events *ras = context;
 	struct mce_priv *mce = ras->mce_priv;
@@ -539,69 +598,69 @@ int ras_mce_event_handler(struct trace_seq *s,
 	memset(&e, 0, sizeof(e));
 
 	/* Parse the MCE error data */
-	if (tep_get_field_val(s, event, "mcgcap", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_MCGCAP], record, &val, 1) < 0)
 		return -1;
 	e.mcgcap = val;
-	if (tep_get_field_val(s, event, "mcgstatus", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_MCGSTATUS], record, &val, 1) < 0)
 		return -1;
 	e.mcgstatus = val;
-	if (tep_get_field_val(s, event, "status", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_STATUS], record, &val, 1) < 0)
 		return -1;
 	e.status = val;
-	if (tep_get_field_val(s, event, "addr", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_ADDR], record, &val, 1) < 0)
 		return -1;
 	e.addr = val;
-	if (tep_get_field_val(s, event, "misc", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_MISC], record, &val, 1) < 0)
 		return -1;
 	e.misc = val;
-	if (tep_get_field_val(s, event, "ip", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_IP], record, &val, 1) < 0)
 		return -1;
 	e.ip = val;
-	if (tep_get_field_val(s, event, "tsc", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_TSC], record, &val, 1) < 0)
 		return -1;
 	e.tsc = val;
-	if (tep_get_field_val(s, event, "walltime", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_WALLTIME], record, &val, 1) < 0)
 		return -1;
 	e.walltime = val;
-	if (tep_get_field_val(s, event, "cpu", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_CPU], record, &val, 1) < 0)
 		return -1;
 	e.cpu = val;
-	if (tep_get_field_val(s, event, "cpuid", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_CPUID], record, &val, 1) < 0)
 		return -1;
 	e.cpuid = val;
-	if (tep_get_field_val(s, event, "apicid", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_APICID], record, &val, 1) < 0)
 		return -1;
 	e.apicid = val;
-	if (tep_get_field_val(s, event, "socketid", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_SOCKETID], record, &val, 1) < 0)
 		return -1;
 	e.socketid = val;
-	if (tep_get_field_val(s, event, "cs", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_CS], record, &val, 1) < 0)
 		return -1;
 	e.cs = val;
-	if (tep_get_field_val(s, event, "bank", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_BANK], record, &val, 1) < 0)
 		return -1;
 	e.bank = val;
-	if (tep_get_field_val(s, event, "cpuvendor", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_CPUVENDOR], record, &val, 1) < 0)
 		return -1;
 	e.cpuvendor = val;
 	/* Get New entries */
-	if (tep_get_field_val(s, event, "synd", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_SYND], record, &val, 1) < 0)
 		return -1;
 	e.synd = val;
-	if (tep_get_field_val(s, event, "ipid", record, &val, 1) < 0)
+	if (ras_get_field_val(s, &f[MCE_FIELD_IPID], record, &val, 1) < 0)
 		return -1;
 	e.ipid = val;
 
 	/* Get PPIN */
-	if (!tep_get_field_val(s, event, "ppin", record, &val, 1))
+	if (!ras_get_field_val(s, &f[MCE_FIELD_PPIN], record, &val, 1))
 		e.ppin = val;
 
 	/* Get Microcode Revision */
-	if (!tep_get_field_val(s, event, "microcode", record, &val, 1))
+	if (!ras_get_field_val(s, &f[MCE_FIELD_MICROCODE], record, &val, 1))
 		e.microcode = val;
 
 	/* Get Vendor-specfic Data, if any */
-	e.vdata = tep_get_field_raw(s, event, "v_data", record, &e.vdata_len, 1);
+	e.vdata = ras_get_field_raw(s, &f[MCE_FIELD_V_DATA], record, &e.vdata_len, 1);
 
 	switch (mce->cputype) {
 	case CPU_GENERIC:
@@ -629,14 +688,7 @@ int ras_mce_event_handler(struct trace_seq *s,
 
 	report_mce_event(ras, record, s, &e);
 
-#ifdef HAVE_SQLITE3
-	ras_store_mce_record(ras, &e);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_mce_event(ras, &e);
-#endif
+	ras_sink_emit(ras, MCE_EVENT, mce_severity(&e), &e);
 
 	return 0;
 }
@@ -113,6 +113,8 @@ struct mce_priv {
 
 /* register and handling routines */
 int register_mce_handler(struct ras_events *ras, unsigned int ncpus);
+extern struct ras_field mce_record_tep_fields[];
+
 int ras_mce_event_handler(struct trace_seq *s,
 			  struct tep_record *record,
 			  struct tep_event *event, void *context);
@@ -6,14 +6,17 @@
 
 #define _GNU_SOURCE
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "ras-logger.h"
 #include "ras-memory-failure-handler.h"
+#include "ras-pipeline.h"
 #include "ras-poison-page-stat.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "trigger.h"
 #include "types.h"
 
@@ -89,6 +92,8 @@ static const struct {
 
 #define MAX_ENV 6
 static const char *mf_trigger = NULL;
+static struct ras_sink mf_trigger_sink;
+static struct ras_sink_queue *mf_trigger_queue;
 
 void mem_fail_event_trigger_setup(void)
 {
@@ -106,18 +111,21 @@ void mem_fail_event_trigger_setup(void)
 			log(ALL, LOG_INFO,
 			    "Setup memory_fail_event trigger `%s`\n",
 			    trigger);
+			mf_trigger_queue = ras_sink_queue_create(mf_trigger_sink.name);
+			ras_sink_register(&mf_trigger_sink);
 		}
 	}
 }
 
-static void run_mf_trigger(struct ras_mf_event *ev)
+static int run_mf_trigger(struct ras_mf_event *ev)
 {
 	char *env[MAX_ENV];
+	int rc = -ENOMEM;
 	int ei = 0;
 	int i;
 
 	if (!mf_trigger)
-		return;
+		return 0;
 
 	if (asprintf(&env[ei++], "PATH=%s", getenv("PATH") ?: "/sbin:/usr/sbin:/bin:/usr/bin") < 0)
 		goto free;
@@ -133,13 +141,28 @@ static void run_mf_trigger(struct ras_mf_event *ev)
 	env[ei] = NULL;
 	assert(ei < MAX_ENV);
 
-	run_trigger(mf_trigger, NULL, env, "memory_fail_event");
+	rc = run_trigger(mf_trigger_queue, mf_trigger, NULL, env,
+			 "memory_fail_event");
 
 free:
 	for (i = 0; i < ei; i++)
 		free(env[i]);
+
+	return rc;
 }
 
+static int mf_trigger_emit(struct ras_events *ras,
+			   const struct ras_sink_event *sev)
+{
+	return run_mf_trigger(sev->ev);
+}
+
+static struct ras_sink mf_trigger_sink = {
+	.name = "mf_trigger",
+	.emit = mf_trigger_emit,
+	.types = BIT_ULL(MF_EVENT),
+};
+
 static const char *get_page_type(int page_type)
 {
 	unsigned int i;
@@ -214,16 +237,7 @@ int ras_memory_failure_event_handler(struct trace_seq *s,
 	ras_poison_page_stat();
 #endif
 
-	/* Store data into the SQLite DB */
-#ifdef HAVE_SQLITE3
-	ras_store_mf_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_mf_event(ras, &ev);
-#endif
-	run_mf_trigger(&ev);
+	ras_sink_emit(ras, MF_EVENT, RAS_SEV_UNCORRECTED, &ev);
 
 	return 0;
 }
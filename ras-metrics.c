@@ -0,0 +1,849 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Event metrics
+ *
+ * The events are counted in memory, per event type and severity, and per
+ * location: DIMM (memory controller and layers), PCI device, CPU and MCA
+ * bank, CXL memory device and block device. The daemon internals are also
+ * exported: events decoded per second, handler latency, pipeline queue
+ * depths, lost events and the event sink counters.
+ *
+ * The counters are served in OpenMetrics text format at a Unix socket,
+ * set by METRICS_SOCKET, that only root and METRICS_SOCKET_GROUP can
+ * connect. HTTP clients get an HTTP response; clients not sending a
+ * request get the bare metrics:
+ *	curl --unix-socket /run/rasdaemon-metrics.sock http://localhost/metrics
+ *	socat -u UNIX-CONNECT:/run/rasdaemon-metrics.sock -
+ *
+ * Counters are only updated by the event decoder thread, so locations are
+ * added without locks: a location is filled and then published. Scrapes
+ * only read the counters, never the database, so their cost only depends
+ * on the number of counters.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <grp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-mce-handler.h"
+#include "ras-metrics.h"
+#include "ras-pipeline.h"
+#include "ras-record.h"
+#include "ras-sink.h"
+#include "ras-stats.h"
+#include "types.h"
+
+#define METRICS_SOCKET		"METRICS_SOCKET"
+#define METRICS_SOCKET_GROUP	"METRICS_SOCKET_GROUP"
+
+/* Per location counters. Locations past LOCATION_MAX are only counted */
+#define LOCATION_SLOTS		1024
+#define LOCATION_MAX		(LOCATION_SLOTS * 3 / 4)
+#define LABELS_SIZE		160
+
+/* Events decoded per second, averaged over RATE_WINDOW seconds */
+#define RATE_SLOTS		64
+#define RATE_WINDOW		60
+
+#define REQUEST_WAIT_MS		100	/* For the request to start */
+#define REQUEST_TIMEOUT_MS	1000	/* For all of it */
+#define SEND_TIMEOUT		5	/* seconds */
+
+#define CONTENT_TYPE	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+enum metrics_location {
+	LOC_DIMM,
+	LOC_PCI,
+	LOC_CPU_BANK,
+	LOC_CXL_MEMDEV,
+	LOC_BLOCK_DEVICE,
+	NR_LOCATIONS
+};
+
+static const struct {
+	const char *name;
+	const char *help;
+} location_families[NR_LOCATIONS] = {
+	[LOC_DIMM] = {
+		"rasdaemon_dimm_errors",
+		"Memory errors per memory controller and DIMM layers"
+	},
+	[LOC_PCI] = {
+		"rasdaemon_pci_errors",
+		"PCIe AER errors per PCI device"
+	},
+	[LOC_CPU_BANK] = {
+		"rasdaemon_mce_errors",
+		"Machine check errors per CPU and MCA bank"
+	},
+	[LOC_CXL_MEMDEV] = {
+		"rasdaemon_cxl_errors",
+		"CXL events per memory device"
+	},
+	[LOC_BLOCK_DEVICE] = {
+		"rasdaemon_disk_errors",
+		"Disk errors per block device"
+	},
+};
+
+/* Upper bounds of the handler latency buckets, in ns */
+static const struct {
+	uint64_t	ns;
+	const char	*le;
+} latency_buckets[] = {
+	{ 1000, "1e-06" },
+	{ 5000, "5e-06" },
+	{ 10000, "1e-05" },
+	{ 50000, "5e-05" },
+	{ 100000, "0.0001" },
+	{ 500000, "0.0005" },
+	{ 1000000, "0.001" },
+	{ 5000000, "0.005" },
+	{ 10000000, "0.01" },
+	{ 50000000, "0.05" },
+	{ 100000000, "0.1" },
+	{ UINT64_MAX, "+Inf" },
+};
+
+#define NR_LATENCY_BUCKETS	ARRAY_SIZE(latency_buckets)
+
+struct location {
+	atomic_int		used;		/* Set once the slot is filled */
+	uint8_t			kind;
+	uint8_t			event;
+	uint8_t			severity;
+	char			labels[LABELS_SIZE];
+	_Atomic uint64_t	count;
+};
+
+struct metrics_buf {
+	char	*data;
+	size_t	len;
+	size_t	size;
+	bool	error;
+};
+
+static struct {
+	bool			enabled;
+
+	_Atomic uint64_t	events[NR_EVENTS][NR_RAS_SEVERITIES];
+
+	struct location		locations[LOCATION_SLOTS];
+	unsigned int		n_locations;
+	_Atomic uint64_t	location_overflow;
+
+	_Atomic uint64_t	latency[NR_EVENTS][NR_LATENCY_BUCKETS];
+	_Atomic uint64_t	latency_ns[NR_EVENTS];
+
+	_Atomic uint64_t	rate_sec[RATE_SLOTS];
+	_Atomic uint64_t	rate_count[RATE_SLOTS];
+
+	/* Exporter */
+	int			fd;
+	char			path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	pthread_t		thread;
+	bool			running;
+	struct metrics_buf	buf;
+} mt = {
+	.fd = -1,
+};
+
+uint64_t ras_metrics_now(void)
+{
+	struct timespec ts;
+
+	if (!mt.enabled)
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Called by the decoder after the handler of @event, started at @start */
+void ras_metrics_decoded(int event, uint64_t start)
+{
+	uint64_t now, elapsed, sec;
+	unsigned int i, slot;
+
+	if (!mt.enabled || event < 0 || event >= NR_EVENTS)
+		return;
+
+	now = ras_metrics_now();
+	elapsed = now - start;
+
+	for (i = 0; elapsed > latency_buckets[i].ns; i++)
+		;
+	atomic_fetch_add_explicit(&mt.latency[event][i], 1,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&mt.latency_ns[event], elapsed,
+				  memory_order_relaxed);
+
+	sec = now / 1000000000ULL;
+	slot = sec % RATE_SLOTS;
+	if (atomic_load_explicit(&mt.rate_sec[slot], memory_order_relaxed) != sec) {
+		atomic_store_explicit(&mt.rate_count[slot], 0,
+				      memory_order_relaxed);
+		atomic_store_explicit(&mt.rate_sec[slot], sec,
+				      memory_order_release);
+	}
+	atomic_fetch_add_explicit(&mt.rate_count[slot], 1,
+				  memory_order_relaxed);
+}
+
+/*
+ * Locations
+ */
+
+/* Appends name="value" to @labels, escaped as OpenMetrics label values */
+static void add_label(char *labels, const char *name, const char *val)
+{
+	size_t len = strlen(labels);
+	int n;
+
+	n = snprintf(labels + len, LABELS_SIZE - len, "%s%s=\"",
+		     len ? "," : "", name);
+	if (n < 0 || len + n >= LABELS_SIZE - 2)
+		return;
+	len += n;
+
+	for (; val && *val && len < LABELS_SIZE - 3; val++) {
+		switch (*val) {
+		case '\\':
+		case '"':
+			labels[len++] = '\\';
+			labels[len++] = *val;
+			break;
+		case '\n':
+			labels[len++] = '\\';
+			labels[len++] = 'n';
+			break;
+		default:
+			labels[len++] = *val;
+		}
+	}
+	labels[len++] = '"';
+	labels[len] = '\0';
+}
+
+static void add_label_int(char *labels, const char *name, int val)
+{
+	char buf[16];
+
+	snprintf(buf, sizeof(buf), "%d", val);
+	add_label(labels, name, buf);
+}
+
+/*
+ * Fills the location labels of the event. Returns the location kind, or
+ * -1 if the event has no location.
+ */
+static int event_location(const struct ras_sink_event *event, char *labels,
+			  uint64_t *count)
+{
+	const struct ras_cxl_event_common_hdr *hdr;
+	const struct ras_mc_event *mc;
+	const struct mce_event *mce;
+
+	labels[0] = '\0';
+
+	switch (event->type) {
+	case MC_EVENT:
+		mc = event->ev;
+		add_label_int(labels, "mc", mc->mc_index);
+		add_label_int(labels, "top", mc->top_layer);
+		add_label_int(labels, "middle", mc->middle_layer);
+		add_label_int(labels, "lower", mc->lower_layer);
+		if (mc->error_count > 0)
+			*count = mc->error_count;
+		return LOC_DIMM;
+	case AER_EVENT:
+		add_label(labels, "bdf",
+			  ((const struct ras_aer_event *)event->ev)->dev_name);
+		return LOC_PCI;
+	case MCE_EVENT:
+		mce = event->ev;
+		add_label_int(labels, "cpu", mce->cpu);
+		add_label_int(labels, "bank", mce->bank);
+		return LOC_CPU_BANK;
+	case CXL_POISON_EVENT:
+		add_label(labels, "memdev",
+			  ((const struct ras_cxl_poison_event *)event->ev)->memdev);
+		return LOC_CXL_MEMDEV;
+	case CXL_AER_UE_EVENT:
+		add_label(labels, "memdev",
+			  ((const struct ras_cxl_aer_ue_event *)event->ev)->memdev);
+		return LOC_CXL_MEMDEV;
+	case CXL_AER_CE_EVENT:
+		add_label(labels, "memdev",
+			  ((const struct ras_cxl_aer_ce_event *)event->ev)->memdev);
+		return LOC_CXL_MEMDEV;
+	case CXL_OVERFLOW_EVENT:
+		add_label(labels, "memdev",
+			  ((const struct ras_cxl_overflow_event *)event->ev)->memdev);
+		return LOC_CXL_MEMDEV;
+	case CXL_GENERIC_EVENT:
+	case CXL_GENERAL_MEDIA_EVENT:
+	case CXL_DRAM_EVENT:
+	case CXL_MEMORY_MODULE_EVENT:
+		/* The common header is the first member of these events */
+		hdr = event->ev;
+		add_label(labels, "memdev", hdr->memdev);
+		return LOC_CXL_MEMDEV;
+	case DISKERROR_EVENT:
+		add_label(labels, "device",
+			  ((const struct diskerror_event *)event->ev)->dev);
+		return LOC_BLOCK_DEVICE;
+	}
+
+	return -1;
+}
+
+static uint32_t location_hash(int kind, int event, int severity,
+			      const char *labels)
+{
+	uint32_t hash = 2166136261U;
+
+	hash = (hash ^ kind) * 16777619U;
+	hash = (hash ^ event) * 16777619U;
+	hash = (hash ^ severity) * 16777619U;
+	for (; *labels; labels++)
+		hash = (hash ^ (uint8_t)*labels) * 16777619U;
+
+	return hash;
+}
+
+static void count_location(int kind, int event, int severity,
+			   const char *labels, uint64_t count)
+{
+	uint32_t i = location_hash(kind, event, severity, labels);
+	struct location *loc;
+	unsigned int n;
+
+	for (n = 0; n < LOCATION_SLOTS; n++, i++) {
+		loc = &mt.locations[i % LOCATION_SLOTS];
+
+		if (!atomic_load_explicit(&loc->used, memory_order_relaxed))
+			break;
+
+		if (loc->kind == kind && loc->event == event &&
+		    loc->severity == severity && !strcmp(loc->labels, labels)) {
+			atomic_fetch_add_explicit(&loc->count, count,
+						  memory_order_relaxed);
+			return;
+		}
+	}
+
+	if (n == LOCATION_SLOTS || mt.n_locations >= LOCATION_MAX) {
+		atomic_fetch_add_explicit(&mt.location_overflow, count,
+					  memory_order_relaxed);
+		return;
+	}
+
+	loc->kind = kind;
+	loc->event = event;
+	loc->severity = severity;
+	strcpy(loc->labels, labels);
+	atomic_store_explicit(&loc->count, count, memory_order_relaxed);
+	atomic_store_explicit(&loc->used, 1, memory_order_release);
+	mt.n_locations++;
+}
+
+static int metrics_sink_emit(struct ras_events *ras,
+			     const struct ras_sink_event *event)
+{
+	char labels[LABELS_SIZE];
+	uint64_t count = 1;
+	int kind;
+
+	if (event->type < 0 || event->type >= NR_EVENTS ||
+	    event->severity >= NR_RAS_SEVERITIES)
+		return -EINVAL;
+
+	atomic_fetch_add_explicit(&mt.events[event->type][event->severity], 1,
+				  memory_order_relaxed);
+
+	kind = event_location(event, labels, &count);
+	if (kind >= 0)
+		count_location(kind, event->type, event->severity, labels,
+			       count);
+
+	return 0;
+}
+
+static struct ras_sink metrics_sink = {
+	.name = "metrics",
+	.emit = metrics_sink_emit,
+	.types = RAS_SINK_ALL_EVENTS,
+};
+
+/*
+ * OpenMetrics output
+ */
+
+static void buf_printf(struct metrics_buf *b, const char *fmt, ...)
+{
+	size_t size;
+	va_list ap;
+	char *data;
+	int n;
+
+	if (b->error)
+		return;
+
+	do {
+		va_start(ap, fmt);
+		n = vsnprintf(b->data + b->len, b->size - b->len, fmt, ap);
+		va_end(ap);
+		if (n < 0) {
+			b->error = true;
+			return;
+		}
+		if (b->len + n < b->size)
+			break;
+
+		size = b->size ? b->size * 2 : 16384;
+		while (size <= b->len + n)
+			size *= 2;
+		data = realloc(b->data, size);
+		if (!data) {
+			b->error = true;
+			return;
+		}
+		b->data = data;
+		b->size = size;
+	} while (1);
+
+	b->len += n;
+}
+
+static void family(struct metrics_buf *b, const char *name, const char *type,
+		   const char *help)
+{
+	buf_printf(b, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+static void write_events(struct metrics_buf *b)
+{
+	unsigned int i, j;
+	uint64_t val;
+
+	family(b, "rasdaemon_events", "counter",
+	       "Events decoded, per event and severity");
+	for (i = 0; i < NR_EVENTS; i++) {
+		for (j = 0; j < NR_RAS_SEVERITIES; j++) {
+			val = atomic_load_explicit(&mt.events[i][j],
+						   memory_order_relaxed);
+			if (!val)
+				continue;
+
+			buf_printf(b, "rasdaemon_events_total{event=\"%s\",severity=\"%s\"} %llu\n",
+				   ras_stats_event_name(i),
+				   ras_severity_name(j),
+				   (unsigned long long)val);
+		}
+	}
+}
+
+static void write_locations(struct metrics_buf *b)
+{
+	struct location *loc;
+	unsigned int kind, i;
+
+	for (kind = 0; kind < NR_LOCATIONS; kind++) {
+		family(b, location_families[kind].name, "counter",
+		       location_families[kind].help);
+
+		for (i = 0; i < LOCATION_SLOTS; i++) {
+			loc = &mt.locations[i];
+			if (!atomic_load_explicit(&loc->used,
+						  memory_order_acquire) ||
+			    loc->kind != kind)
+				continue;
+
+			buf_printf(b, "%s_total{event=\"%s\",severity=\"%s\",%s} %llu\n",
+				   location_families[kind].name,
+				   ras_stats_event_name(loc->event),
+				   ras_severity_name(loc->severity),
+				   loc->labels,
+				   (unsigned long long)atomic_load_explicit(&loc->count,
+									    memory_order_relaxed));
+		}
+	}
+
+	family(b, "rasdaemon_location_overflow", "counter",
+	       "Errors not counted per location, as there were too many locations");
+	buf_printf(b, "rasdaemon_location_overflow_total %llu\n",
+		   (unsigned long long)atomic_load(&mt.location_overflow));
+}
+
+static void write_internals(struct metrics_buf *b)
+{
+	uint64_t now = ras_metrics_now() / 1000000000ULL, sec, total = 0;
+	struct ras_pipeline_stats st;
+	unsigned int i;
+
+	for (i = 0; i < RATE_SLOTS; i++) {
+		sec = atomic_load_explicit(&mt.rate_sec[i], memory_order_acquire);
+		if (sec < now && now - sec <= RATE_WINDOW)
+			total += atomic_load_explicit(&mt.rate_count[i],
+						      memory_order_relaxed);
+	}
+	family(b, "rasdaemon_event_rate", "gauge",
+	       "Events decoded per second, over the last minute");
+	buf_printf(b, "rasdaemon_event_rate %.3f\n", (double)total / RATE_WINDOW);
+
+	family(b, "rasdaemon_lost_events", "counter",
+	       "Events lost at the Kernel, at the event pipeline or not stored");
+	for (i = 0; i < NR_RAS_DROPS; i++)
+		buf_printf(b, "rasdaemon_lost_events_total{source=\"%s\"} %llu\n",
+			   ras_stats_drop_name(i),
+			   (unsigned long long)ras_stats_drops(i));
+
+	if (ras_pipeline_get_stats(&st))
+		return;
+
+	family(b, "rasdaemon_pipeline_records", "counter",
+	       "Trace records read by the reader threads");
+	buf_printf(b, "rasdaemon_pipeline_records_total %llu\n",
+		   (unsigned long long)st.records);
+	family(b, "rasdaemon_pipeline_stalls", "counter",
+	       "Times a reader waited for room at a full ring");
+	buf_printf(b, "rasdaemon_pipeline_stalls_total %llu\n",
+		   (unsigned long long)st.stalls);
+	family(b, "rasdaemon_pipeline_ring_bytes", "gauge",
+	       "Bytes waiting for the event decoder at the rings");
+	buf_printf(b, "rasdaemon_pipeline_ring_bytes %llu\n",
+		   (unsigned long long)st.ring_used);
+	family(b, "rasdaemon_pipeline_ring_size_bytes", "gauge",
+	       "Size of the rings");
+	buf_printf(b, "rasdaemon_pipeline_ring_size_bytes %llu\n",
+		   (unsigned long long)st.ring_size);
+	family(b, "rasdaemon_sink_queue_jobs", "gauge",
+	       "Jobs waiting at the sink worker queues");
+	buf_printf(b, "rasdaemon_sink_queue_jobs %u\n", st.sink_queued);
+	family(b, "rasdaemon_sink_queue_drops", "counter",
+	       "Jobs dropped at full sink worker queues");
+	buf_printf(b, "rasdaemon_sink_queue_drops_total %llu\n",
+		   (unsigned long long)st.sink_drops);
+}
+
+static void write_latency(struct metrics_buf *b)
+{
+	uint64_t buckets[NR_LATENCY_BUCKETS], count;
+	unsigned int i, j;
+
+	family(b, "rasdaemon_handler_latency_seconds", "histogram",
+	       "Time taken to decode and dispatch each event");
+	for (i = 0; i < NR_EVENTS; i++) {
+		for (j = 0; j < NR_LATENCY_BUCKETS; j++)
+			buckets[j] = atomic_load_explicit(&mt.latency[i][j],
+							  memory_order_relaxed);
+
+		count = 0;
+		for (j = 0; j < NR_LATENCY_BUCKETS; j++)
+			count += buckets[j];
+		if (!count)
+			continue;
+
+		count = 0;
+		for (j = 0; j < NR_LATENCY_BUCKETS; j++) {
+			count += buckets[j];
+			buf_printf(b, "rasdaemon_handler_latency_seconds_bucket{event=\"%s\",le=\"%s\"} %llu\n",
+				   ras_stats_event_name(i),
+				   latency_buckets[j].le,
+				   (unsigned long long)count);
+		}
+
+		buf_printf(b, "rasdaemon_handler_latency_seconds_count{event=\"%s\"} %llu\n",
+			   ras_stats_event_name(i), (unsigned long long)count);
+		buf_printf(b, "rasdaemon_handler_latency_seconds_sum{event=\"%s\"} %.9f\n",
+			   ras_stats_event_name(i),
+			   atomic_load_explicit(&mt.latency_ns[i],
+						memory_order_relaxed) / 1e9);
+	}
+}
+
+static void write_sinks(struct metrics_buf *b)
+{
+	struct ras_sink *sink;
+
+	family(b, "rasdaemon_sink_events", "counter",
+	       "Events per sink: handed to it, filtered out, dropped or failed");
+	for (sink = ras_sink_next(NULL); sink; sink = ras_sink_next(sink)) {
+		buf_printf(b, "rasdaemon_sink_events_total{sink=\"%s\",outcome=\"emitted\"} %llu\n",
+			   sink->name,
+			   (unsigned long long)atomic_load(&sink->emitted));
+		buf_printf(b, "rasdaemon_sink_events_total{sink=\"%s\",outcome=\"filtered\"} %llu\n",
+			   sink->name,
+			   (unsigned long long)atomic_load(&sink->filtered));
+		buf_printf(b, "rasdaemon_sink_events_total{sink=\"%s\",outcome=\"dropped\"} %llu\n",
+			   sink->name,
+			   (unsigned long long)atomic_load(&sink->dropped));
+		buf_printf(b, "rasdaemon_sink_events_total{sink=\"%s\",outcome=\"failed\"} %llu\n",
+			   sink->name,
+			   (unsigned long long)atomic_load(&sink->failed));
+	}
+
+	family(b, "rasdaemon_sink_seconds", "counter",
+	       "Time taken by each sink");
+	for (sink = ras_sink_next(NULL); sink; sink = ras_sink_next(sink))
+		buf_printf(b, "rasdaemon_sink_seconds_total{sink=\"%s\"} %.9f\n",
+			   sink->name, atomic_load(&sink->time_ns) / 1e9);
+}
+
+static void write_metrics(struct metrics_buf *b)
+{
+	b->len = 0;
+	b->error = false;
+
+	write_events(b);
+	write_locations(b);
+	write_internals(b);
+	write_latency(b);
+	write_sinks(b);
+	buf_printf(b, "# EOF\n");
+}
+
+/*
+ * Exporter
+ */
+
+static int send_all(int fd, const char *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		n = send(fd, buf, len, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static long ms_since(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000 +
+	       (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/*
+ * HTTP clients send a request first, that is read until its end, so that
+ * closing the connection doesn't reset it. Other clients get the metrics
+ * right away. As scrapes are served one at a time, a request not complete
+ * within REQUEST_TIMEOUT_MS is dropped.
+ */
+static void serve_scrape(int fd)
+{
+	struct timeval tv = { .tv_sec = SEND_TIMEOUT };
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	char req[4096], hdr[256];
+	int wait = REQUEST_WAIT_MS;
+	struct timespec start;
+	bool done = false;
+	size_t len = 0;
+	ssize_t n;
+	int hlen;
+
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (len < sizeof(req) - 1 && poll(&pfd, 1, wait) > 0) {
+		n = recv(fd, req + len, sizeof(req) - 1 - len, MSG_DONTWAIT);
+		if (n <= 0) {
+			done = true;
+			break;
+		}
+		len += n;
+		req[len] = '\0';
+		if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n")) {
+			done = true;
+			break;
+		}
+
+		wait = REQUEST_TIMEOUT_MS - ms_since(&start);
+		if (wait <= 0)
+			break;
+	}
+	req[len] = '\0';
+
+	if (len && !done && len < sizeof(req) - 1) {
+		log(TERM, LOG_DEBUG, "Dropping a metrics client: request timeout\n");
+		return;
+	}
+
+	if (len && strncmp(req, "GET ", 4)) {
+		hlen = snprintf(hdr, sizeof(hdr),
+				"HTTP/1.0 405 Method Not Allowed\r\n"
+				"Allow: GET\r\nContent-Length: 0\r\n"
+				"Connection: close\r\n\r\n");
+		send_all(fd, hdr, hlen);
+		return;
+	}
+
+	write_metrics(&mt.buf);
+	if (mt.buf.error) {
+		log(ALL, LOG_ERR, "Can't allocate the metrics\n");
+		return;
+	}
+
+	if (len) {
+		hlen = snprintf(hdr, sizeof(hdr),
+				"HTTP/1.0 200 OK\r\nContent-Type: %s\r\n"
+				"Content-Length: %zu\r\nConnection: close\r\n\r\n",
+				CONTENT_TYPE, mt.buf.len);
+		if (send_all(fd, hdr, hlen))
+			return;
+	}
+	send_all(fd, mt.buf.data, mt.buf.len);
+}
+
+static void *metrics_thread(void *arg)
+{
+	int fd;
+
+	while (1) {
+		fd = accept4(mt.fd, NULL, NULL, SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno != EINTR && errno != ECONNABORTED) {
+				log(ALL, LOG_ERR,
+				    "Can't accept metrics connections: %s\n",
+				    strerror(errno));
+				sleep(1);
+			}
+			continue;
+		}
+
+		/* Only cancelled while waiting for connections */
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+		serve_scrape(fd);
+		close(fd);
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+	}
+
+	return NULL;
+}
+
+/* Lets the group set by METRICS_SOCKET_GROUP connect, besides root */
+static int socket_group(const char *path)
+{
+	char *env = getenv(METRICS_SOCKET_GROUP);
+	struct group *gr;
+
+	if (!env || !*env)
+		return 0;
+
+	gr = getgrnam(env);
+	if (!gr) {
+		log(ALL, LOG_ERR, "Unknown %s=%s\n", METRICS_SOCKET_GROUP, env);
+		errno = EINVAL;
+		return -1;
+	}
+
+	return chown(path, -1, gr->gr_gid);
+}
+
+static int metrics_listen(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct stat st;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		log(ALL, LOG_ERR, "Metrics socket path %s is too long\n", path);
+		return -ENAMETOOLONG;
+	}
+	strcpy(addr.sun_path, path);
+
+	/* Left behind by a previous run */
+	if (!lstat(path, &st) && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto error;
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    socket_group(path) || chmod(path, 0660) || listen(fd, 8))
+		goto error;
+
+	return fd;
+
+error:
+	log(ALL, LOG_ERR, "Can't listen at the metrics socket %s: %s\n",
+	    path, strerror(errno));
+	if (fd >= 0)
+		close(fd);
+
+	return -errno;
+}
+
+/* Should be called before the events are enabled */
+void ras_metrics_setup(void)
+{
+	char *env = getenv(METRICS_SOCKET);
+
+	if (mt.enabled || !env || !*env)
+		return;
+
+	mt.fd = metrics_listen(env);
+	if (mt.fd < 0)
+		return;
+	strscpy(mt.path, env, sizeof(mt.path));
+
+	if (pthread_create(&mt.thread, NULL, metrics_thread, NULL)) {
+		log(ALL, LOG_ERR, "Can't create the metrics thread\n");
+		ras_metrics_close();
+		return;
+	}
+	mt.running = true;
+	mt.enabled = true;
+
+	ras_sink_register(&metrics_sink);
+
+	log(ALL, LOG_INFO, "Serving metrics at %s\n", mt.path);
+}
+
+void ras_metrics_close(void)
+{
+	if (mt.running) {
+		pthread_cancel(mt.thread);
+		pthread_join(mt.thread, NULL);
+		mt.running = false;
+	}
+
+	if (mt.fd >= 0) {
+		close(mt.fd);
+		unlink(mt.path);
+		mt.fd = -1;
+	}
+
+	free(mt.buf.data);
+	memset(&mt.buf, 0, sizeof(mt.buf));
+}
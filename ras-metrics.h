@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * In-memory event counters, served in OpenMetrics text format
+ */
+
+#ifndef __RAS_METRICS_H
+#define __RAS_METRICS_H
+
+#include <stdint.h>
+
+void ras_metrics_setup(void);
+void ras_metrics_close(void);
+
+uint64_t ras_metrics_now(void);
+void ras_metrics_decoded(int event, uint64_t start);
+
+#endif
@@ -13,7 +13,8 @@
 
 #include "ras-logger.h"
 #include "ras-non-standard-handler.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 static struct  ras_ns_ev_decoder *ras_ns_ev_dec_list;
@@ -260,15 +261,8 @@ int ras_non_standard_event_handler(struct trace_seq *s,
 		}
 	}
 
-	/* Insert data into the SGBD */
-#ifdef HAVE_SQLITE3
-	ras_store_non_standard_record(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_non_standard_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, NON_STANDARD_EVENT,
+		      ras_severity_from_str(ev.severity), &ev);
 
 	return 0;
 }
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Structured event output
+ *
+ * With EVENT_OUTPUT_FORMAT=ndjson, the events printed at stdout aren't the
+ * text formatted by each handler, but a JSON object per line, built from
+ * the event struct and the columns of its table, as at the database:
+ *	{"event":"mc_event","severity":"corrected","timestamp":"...",...}
+ * so log pipelines don't need to parse the text of each event type.
+ *
+ * The lines are buffered, and written when the buffer is full, when the
+ * oldest one waited for EVENT_OUTPUT_FLUSH_MS or, for uncorrected and
+ * fatal errors, right away. Like the database commits, the flushes are
+ * done by the event decoder thread, between the events.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-output.h"
+#include "ras-sink.h"
+#include "ras-tables.h"
+#include "types.h"
+
+#define EVENT_OUTPUT_FORMAT	"EVENT_OUTPUT_FORMAT"
+#define EVENT_OUTPUT_BUFFER_KB	"EVENT_OUTPUT_BUFFER_KB"
+#define EVENT_OUTPUT_FLUSH_MS	"EVENT_OUTPUT_FLUSH_MS"
+
+#define DEFAULT_BUFFER_KB	64
+#define DEFAULT_FLUSH_MS	1000
+
+static struct {
+	bool		enabled;
+	bool		failed;
+
+	char		*buf;
+	size_t		size;
+	size_t		len;
+
+	int		flush_ms;
+	struct timespec	first_pending;
+
+	uint64_t	lines;
+	uint64_t	writes;
+} out;
+
+static void output_write(void)
+{
+	const char *p = out.buf;
+	size_t len = out.len;
+	ssize_t n;
+
+	/* Keep the order with anything printed with stdio */
+	fflush(stdout);
+
+	while (len) {
+		n = write(STDOUT_FILENO, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (!out.failed)
+				log(SYSLOG, LOG_ERR,
+				    "Can't write the event output: %s\n",
+				    strerror(errno));
+			out.failed = true;
+			break;
+		}
+		out.writes++;
+		p += n;
+		len -= n;
+	}
+
+	out.len = 0;
+}
+
+/* Time, in ms, until the output should be flushed, or -1 */
+int ras_output_flush_timeout(void)
+{
+	struct timespec now;
+	long ms;
+
+	if (!out.len)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (now.tv_sec - out.first_pending.tv_sec) * 1000 +
+	     (now.tv_nsec - out.first_pending.tv_nsec) / 1000000;
+
+	if (ms >= out.flush_ms)
+		return 0;
+
+	return out.flush_ms - ms;
+}
+
+void ras_output_flush(void)
+{
+	if (out.len)
+		output_write();
+}
+
+static int output_sink_emit(struct ras_events *ras,
+			    const struct ras_sink_event *event)
+{
+	const struct db_table_descriptor *tab = ras_event_table(event->type);
+	size_t need = ras_event_json_object_len(tab, event) + 1;
+	char *p;
+
+	if (!out.enabled)
+		return 0;
+
+	if (need > out.size - out.len)
+		ras_output_flush();
+
+	/* Larger than the buffer: grow it */
+	if (need > out.size) {
+		p = realloc(out.buf, need);
+		if (!p)
+			return -ENOMEM;
+		out.buf = p;
+		out.size = need;
+	}
+
+	if (!out.len)
+		clock_gettime(CLOCK_MONOTONIC, &out.first_pending);
+
+	p = ras_event_json_object(tab, event, out.buf + out.len);
+	*p++ = '\n';
+	out.len = p - out.buf;
+	out.lines++;
+
+	if (event->severity >= RAS_SEV_UNCORRECTED || !out.flush_ms)
+		ras_output_flush();
+
+	return 0;
+}
+
+static struct ras_sink output_sink = {
+	.name = "output",
+	.emit = output_sink_emit,
+	.types = RAS_SINK_ALL_EVENTS,
+	.min_severity = RAS_SEV_INFO,
+};
+
+static long env_long(const char *name, long def)
+{
+	char *env = getenv(name);
+	char *end;
+	long val;
+
+	if (!env || !*env)
+		return def;
+
+	val = strtol(env, &end, 0);
+	if (*end || val < 0 || val > INT_MAX / 1024) {
+		log(ALL, LOG_WARNING, "Invalid %s=%s, using %ld\n", name, env,
+		    def);
+		return def;
+	}
+
+	return val;
+}
+
+/*
+ * Should be called after the text output is selected: the NDJSON output
+ * replaces it.
+ */
+void ras_output_setup(struct ras_events *ras)
+{
+	char *env = getenv(EVENT_OUTPUT_FORMAT);
+	long kb;
+
+	if (out.enabled || !env || !*env || !strcasecmp(env, "text"))
+		return;
+
+	if (strcasecmp(env, "ndjson")) {
+		log(ALL, LOG_WARNING, "Unknown %s=%s, printing text\n",
+		    EVENT_OUTPUT_FORMAT, env);
+		return;
+	}
+
+	if (!ras->text_output) {
+		log(ALL, LOG_WARNING,
+		    "%s=ndjson ignored, as events aren't printed\n",
+		    EVENT_OUTPUT_FORMAT);
+		return;
+	}
+
+	kb = env_long(EVENT_OUTPUT_BUFFER_KB, DEFAULT_BUFFER_KB);
+	out.flush_ms = env_long(EVENT_OUTPUT_FLUSH_MS, DEFAULT_FLUSH_MS);
+
+	out.size = (kb ? kb : 1) * 1024;
+	out.buf = malloc(out.size);
+	if (!out.buf) {
+		log(ALL, LOG_ERR, "Can't allocate the event output buffer\n");
+		return;
+	}
+
+	ras->text_output = 0;
+	out.enabled = true;
+	ras_sink_register(&output_sink);
+
+	log(TERM, LOG_INFO,
+	    "Events will be printed as NDJSON, flushed every %d ms\n",
+	    out.flush_ms);
+}
+
+void ras_output_close(void)
+{
+	if (!out.enabled)
+		return;
+
+	ras_output_flush();
+
+	log(TERM, LOG_INFO, "Printed %llu events in %llu writes\n",
+	    (unsigned long long)out.lines, (unsigned long long)out.writes);
+
+	free(out.buf);
+	out.buf = NULL;
+	out.size = 0;
+	out.enabled = false;
+}
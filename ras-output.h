@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Structured event output
+ */
+
+#ifndef __RAS_OUTPUT_H
+#define __RAS_OUTPUT_H
+
+struct ras_events;
+
+void ras_output_setup(struct ras_events *ras);
+void ras_output_close(void);
+
+int ras_output_flush_timeout(void);
+void ras_output_flush(void);
+
+#endif
@@ -13,10 +13,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "ras-capture.h"
 #include "ras-logger.h"
 #include "ras-page-isolation.h"
 #include "ras-poison-page-stat.h"
 #include "ras-record.h"
+#include "ras-stats.h"
 #include "types.h"
 
 #define PARSED_ENV_LEN 50
@@ -112,6 +114,9 @@ static void page_offline_init(void)
 	if (!matched)
 		log(TERM, LOG_INFO, "Improper %s, set to default soft\n", env);
 
+	if (ras_replaying())
+		offline = OFFLINE_OFF;
+
 	if (offline > OFFLINE_ACCOUNT && access(kernel_offline[offline], W_OK)) {
 		log(TERM, LOG_INFO, "Kernel does not support page offline interface\n");
 		offline = OFFLINE_ACCOUNT;
@@ -258,6 +263,9 @@ static void row_offline_init(void)
 	if (!matched)
 		log(TERM, LOG_INFO, "Improper %s, set to default off\n", env);
 
+	if (ras_replaying())
+		row_offline_action = OFFLINE_OFF;
+
 	if (row_offline_action > OFFLINE_ACCOUNT && access(kernel_offline[row_offline_action], W_OK)) {
 		log(TERM, LOG_INFO, "Kernel does not support row offline interface\n");
 		row_offline_action = OFFLINE_ACCOUNT;
@@ -360,6 +368,7 @@ static void page_offline(struct page_record *pr)
 
 static void page_record(struct page_record *pr, unsigned int count, time_t time)
 {
+	static unsigned long lost_seen;
 	unsigned long period = time - pr->start;
 	unsigned long tolerate;
 
@@ -376,6 +385,8 @@ static void page_record(struct page_record *pr, unsigned int count, time_t time)
 		pr->excess = 0;
 	}
 
+	ras_stats_ce_lost(&lost_seen, "page");
+
 	pr->count += count;
 	if (pr->count >= threshold.val) {
 		log(TERM, LOG_INFO, "Corrected Errors at %#llx exceeded threshold\n", pr->addr);
@@ -724,9 +735,13 @@ static void row_offline(struct row_record *rr, time_t time)
 
 static void row_record(struct row_record *rr, time_t time)
 {
+	static unsigned long lost_seen;
+
 	if (!rr)
 		return;
 
+	ras_stats_ce_lost(&lost_seen, "row");
+
 	if (time - rr->start > row_cycle.val) {
 		struct page_addr *page_info = NULL, *tmp_page_info = NULL;
 
@@ -0,0 +1,841 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Staged event pipeline
+ *
+ * Reader threads copy the raw trace records into preallocated,
+ * lock-free single-producer/single-consumer rings (one ring per reader).
+ * A decoder thread consumes the rings, running the tep event handlers,
+ * which also store the events. It is the only database writer, committing
+ * the events in groups. Slow sinks, like the event triggers, are handed
+ * over to sink workers, each with a bounded queue of its own, so a slow
+ * sink doesn't delay the others.
+ *
+ * When a ring is full, the reader waits for the decoder (backpressure), up
+ * to one second, holding the record it already consumed from the kernel
+ * buffer. Its other CPU buffers aren't read while it waits, so new events
+ * pile up there, and the kernel drops them if a buffer fills. If the decoder
+ * doesn't make room in time, the held record is dropped. Drops are counted
+ * per stage.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <traceevent/event-parse.h>
+#include <traceevent/kbuffer.h>
+#include <unistd.h>
+
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-output.h"
+#include "ras-pipeline.h"
+#include "ras-record.h"
+#include "ras-stats.h"
+#include "types.h"
+
+#define PIPELINE_RING_KB	"PIPELINE_RING_KB"
+#define DEFAULT_RING_KB		256
+
+/* Maximum time a reader waits for room at a full ring */
+#define RING_MAX_WAIT_MS	1000
+#define RING_WAIT_STEP_MS	10
+
+/* Records decoded from a ring before moving to the next one */
+#define DECODE_BATCH		64
+
+#define SINK_QUEUE_LEN		64
+
+#define CACHELINE		64
+
+#define RING_REC_PAD		BIT(0)
+
+struct ras_ring_rec {
+	uint32_t	len;		/* Including this header */
+	uint32_t	flags;
+	uint64_t	ts;
+	int32_t		cpu;
+	int32_t		size;
+	int32_t		offset;
+	int32_t		record_size;
+	int64_t		missed_events;
+	char		data[];
+};
+
+struct ras_ring {
+	/* Producer side */
+	_Atomic uint64_t	head;
+	uint64_t		reserved;
+	char			pad0[CACHELINE - 2 * sizeof(uint64_t)];
+
+	/* Consumer side */
+	_Atomic uint64_t	tail;
+	char			pad1[CACHELINE - sizeof(uint64_t)];
+
+	char			*buf;
+	uint64_t		size;
+
+	/* Used by a reader waiting for room */
+	atomic_int		waiting;
+	int			spacefd;
+
+	/* Counters */
+	_Atomic uint64_t	records;
+	_Atomic uint64_t	stalls;
+	_Atomic uint64_t	drops;
+};
+
+struct ras_pipeline {
+	struct ras_events	*ras;
+	ras_decode_func		decode;
+
+	unsigned int		n_rings;
+	struct ras_ring		*rings;
+
+	pthread_t		decoder;
+	int			wakefd;
+	atomic_int		sleeping;
+	atomic_int		stop;
+	unsigned		running: 1;
+	unsigned		lossless: 1;
+
+	_Atomic uint64_t	decoded;
+};
+
+struct sink_job {
+	ras_sink_func	func;
+	ras_sink_func	release;
+	void		*arg;
+};
+
+struct ras_sink_queue {
+	const char	*name;
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	pthread_t	thread;
+	struct sink_job	jobs[SINK_QUEUE_LEN];
+	unsigned int	first, count;
+	int		running, stop;
+	bool		full;
+
+	uint64_t	submitted;
+	uint64_t	drops;
+
+	struct ras_sink_queue *next;
+};
+
+/* Sink queues are never removed. Their workers run with the pipeline */
+static pthread_mutex_t queues_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ras_sink_queue *queues;
+static bool queues_started;
+
+/* The running pipeline, for ras_pipeline_get_stats() */
+static pthread_mutex_t active_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ras_pipeline *active;
+
+/*
+ * SPSC ring
+ */
+
+static struct ras_ring_rec *ring_reserve(struct ras_ring *ring, uint32_t len)
+{
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	uint64_t idx = head & (ring->size - 1);
+	uint64_t pad = 0;
+	struct ras_ring_rec *rec;
+
+	/* Records are contiguous: skip the end of the buffer if needed */
+	if (idx + len > ring->size)
+		pad = ring->size - idx;
+
+	if (ring->size - (head - tail) < pad + len)
+		return NULL;
+
+	if (pad) {
+		rec = (void *)(ring->buf + idx);
+		rec->len = pad;
+		rec->flags = RING_REC_PAD;
+		idx = 0;
+	}
+
+	ring->reserved = pad + len;
+
+	return (void *)(ring->buf + idx);
+}
+
+static void ring_commit(struct ras_ring *ring)
+{
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+	atomic_store(&ring->head, head + ring->reserved);
+	ring->reserved = 0;
+}
+
+static struct ras_ring_rec *ring_peek(struct ras_ring *ring)
+{
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	struct ras_ring_rec *rec;
+
+	while (tail != head) {
+		rec = (void *)(ring->buf + (tail & (ring->size - 1)));
+		if (!(rec->flags & RING_REC_PAD))
+			return rec;
+
+		tail += rec->len;
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+	}
+
+	return NULL;
+}
+
+static void ring_release(struct ras_ring *ring, struct ras_ring_rec *rec)
+{
+	uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	uint64_t val = 1;
+
+	atomic_store(&ring->tail, tail + rec->len);
+
+	if (atomic_load(&ring->waiting)) {
+		if (write(ring->spacefd, &val, sizeof(val)) < 0)
+			log(TERM, LOG_WARNING, "Can't wake up reader\n");
+	}
+}
+
+static bool ring_empty(struct ras_ring *ring)
+{
+	return atomic_load(&ring->head) == atomic_load(&ring->tail);
+}
+
+static long ms_since(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000 +
+	       (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/*
+ * Backpressure: wait for the decoder to free some room, for up to
+ * RING_MAX_WAIT_MS. The decoder is kicked again every RING_WAIT_STEP_MS.
+ */
+static struct ras_ring_rec *ring_wait(struct ras_pipeline *pl,
+				      struct ras_ring *ring, uint32_t len)
+{
+	struct pollfd pfd = { .fd = ring->spacefd, .events = POLLIN };
+	struct ras_ring_rec *rec = NULL;
+	struct timespec start;
+	long left = RING_WAIT_STEP_MS;
+	uint64_t val;
+
+	atomic_fetch_add(&ring->stalls, 1);
+	atomic_store(&ring->waiting, 1);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (1) {
+		rec = ring_reserve(ring, len);
+		if (rec)
+			break;
+
+		if (!pl->lossless) {
+			left = RING_MAX_WAIT_MS - ms_since(&start);
+			if (left <= 0)
+				break;
+		}
+
+		ras_pipeline_kick(pl);
+		if (left > RING_WAIT_STEP_MS)
+			left = RING_WAIT_STEP_MS;
+		if (poll(&pfd, 1, left) > 0) {
+			if (read(ring->spacefd, &val, sizeof(val)) < 0)
+				log(TERM, LOG_WARNING, "Can't read ring eventfd\n");
+		}
+	}
+
+	atomic_store(&ring->waiting, 0);
+
+	return rec;
+}
+
+int ras_pipeline_push(struct ras_pipeline *pl, unsigned int ring_idx,
+		      struct kbuffer *kbuf, void *data,
+		      unsigned long long time_stamp, int cpu)
+{
+	struct ras_ring *ring = &pl->rings[ring_idx];
+	struct ras_ring_rec *rec;
+	int size = kbuffer_event_size(kbuf);
+	uint32_t len;
+
+	len = (sizeof(*rec) + size + 7) & ~7;
+	if (len > ring->size / 2) {
+		atomic_fetch_add(&ring->drops, 1);
+		ras_stats_drop(RAS_DROP_QUEUE, cpu, -1, 1);
+		return -E2BIG;
+	}
+
+	rec = ring_reserve(ring, len);
+	if (!rec)
+		rec = ring_wait(pl, ring, len);
+	if (!rec) {
+		atomic_fetch_add(&ring->drops, 1);
+		ras_stats_drop(RAS_DROP_QUEUE, cpu, -1, 1);
+		return -ENOBUFS;
+	}
+
+	rec->len = len;
+	rec->flags = 0;
+	rec->ts = time_stamp;
+	rec->cpu = cpu;
+	rec->size = size;
+	rec->offset = kbuffer_curr_offset(kbuf);
+	rec->record_size = kbuffer_curr_size(kbuf);
+	rec->missed_events = kbuffer_missed_events(kbuf);
+	memcpy(rec->data, data, size);
+
+	ring_commit(ring);
+	atomic_fetch_add_explicit(&ring->records, 1, memory_order_relaxed);
+
+	return 0;
+}
+
+/*
+ * Make the readers wait for the decoder for as long as needed, instead of
+ * dropping records. Only used when replaying a capture, as it would
+ * stall the live trace buffers.
+ */
+void ras_pipeline_set_lossless(struct ras_pipeline *pl)
+{
+	pl->lossless = 1;
+}
+
+/* Wake up the decoder, if it is sleeping */
+void ras_pipeline_kick(struct ras_pipeline *pl)
+{
+	uint64_t val = 1;
+
+	if (atomic_load(&pl->sleeping)) {
+		if (write(pl->wakefd, &val, sizeof(val)) < 0)
+			log(TERM, LOG_WARNING, "Can't wake up decoder\n");
+	}
+}
+
+/*
+ * Decoder
+ */
+
+static bool rings_empty(struct ras_pipeline *pl)
+{
+	unsigned int i;
+
+	for (i = 0; i < pl->n_rings; i++) {
+		if (!ring_empty(&pl->rings[i]))
+			return false;
+	}
+
+	return true;
+}
+
+static int min_timeout(int a, int b)
+{
+	if (a < 0)
+		return b;
+	if (b < 0)
+		return a;
+
+	return a < b ? a : b;
+}
+
+/*
+ * Time, in ms, until the next database commit or maintenance, or until
+ * the event output is flushed
+ */
+static int decoder_timeout(struct ras_events *ras)
+{
+	int commit = ras_db_commit_timeout(ras);
+	int maint = ras_db_maintain(ras);
+
+	return min_timeout(min_timeout(commit, maint),
+			   ras_output_flush_timeout());
+}
+
+/* Commits the events, and flushes their output, when due */
+static void decoder_flush(struct ras_events *ras)
+{
+	if (!ras_db_commit_timeout(ras))
+		ras_db_commit(ras);
+	if (!ras_output_flush_timeout())
+		ras_output_flush();
+}
+
+static void *decoder_thread(void *priv)
+{
+	struct ras_pipeline *pl = priv;
+	struct pollfd pfd = { .fd = pl->wakefd, .events = POLLIN };
+	struct ras_ring_rec *rec;
+	struct tep_record record;
+	unsigned int i, n;
+	bool busy;
+	uint64_t val;
+	int rc;
+
+	do {
+		busy = false;
+		for (i = 0; i < pl->n_rings; i++) {
+			struct ras_ring *ring = &pl->rings[i];
+
+			for (n = 0; n < DECODE_BATCH; n++) {
+				rec = ring_peek(ring);
+				if (!rec)
+					break;
+
+				memset(&record, 0, sizeof(record));
+				record.ts = rec->ts;
+				record.size = rec->size;
+				record.data = rec->data;
+				record.cpu = rec->cpu;
+				/* note offset is just offset in subbuffer */
+				record.offset = rec->offset;
+				record.missed_events = rec->missed_events;
+				record.record_size = rec->record_size;
+
+				pl->decode(pl->ras, &record);
+
+				ring_release(ring, rec);
+				atomic_fetch_add_explicit(&pl->decoded, 1,
+							  memory_order_relaxed);
+				busy = true;
+			}
+		}
+		if (busy) {
+			/* Don't let a storm delay the commit of the events */
+			decoder_flush(pl->ras);
+			ras_db_maintain(pl->ras);
+			continue;
+		}
+
+		/* Only stop after draining all rings */
+		if (atomic_load(&pl->stop))
+			break;
+
+		atomic_store(&pl->sleeping, 1);
+		if (rings_empty(pl) && !atomic_load(&pl->stop)) {
+			rc = poll(&pfd, 1, decoder_timeout(pl->ras));
+			if (rc > 0) {
+				if (read(pl->wakefd, &val, sizeof(val)) < 0)
+					log(TERM, LOG_WARNING, "Can't read decoder eventfd\n");
+			} else if (!rc) {
+				decoder_flush(pl->ras);
+			}
+		}
+		atomic_store(&pl->sleeping, 0);
+	} while (1);
+
+	return NULL;
+}
+
+/*
+ * Sink worker
+ */
+
+static void *sink_thread(void *priv)
+{
+	struct ras_sink_queue *q = priv;
+	struct sink_job job;
+
+	pthread_mutex_lock(&q->lock);
+	do {
+		while (!q->count && !q->stop)
+			pthread_cond_wait(&q->cond, &q->lock);
+
+		if (!q->count)
+			break;
+
+		job = q->jobs[q->first];
+		q->first = (q->first + 1) % SINK_QUEUE_LEN;
+		q->count--;
+
+		pthread_mutex_unlock(&q->lock);
+		job.func(job.arg);
+		if (job.release)
+			job.release(job.arg);
+		pthread_mutex_lock(&q->lock);
+	} while (1);
+	pthread_mutex_unlock(&q->lock);
+
+	return NULL;
+}
+
+/*
+ * Run a job at the worker of @q. If the pipeline isn't running, or @q
+ * couldn't be created, the job is executed synchronously. Jobs are
+ * dropped when the queue is full: that is only logged when the queue
+ * gets full, and when it has room again.
+ */
+int ras_sink_submit(struct ras_sink_queue *q, ras_sink_func func,
+		    ras_sink_func release, void *arg)
+{
+	struct sink_job *job;
+	uint64_t drops = 0;
+	bool was_full;
+
+	if (q)
+		pthread_mutex_lock(&q->lock);
+	if (!q || !q->running) {
+		if (q)
+			pthread_mutex_unlock(&q->lock);
+		func(arg);
+		if (release)
+			release(arg);
+		return 0;
+	}
+
+	if (q->count == SINK_QUEUE_LEN) {
+		was_full = q->full;
+		q->full = true;
+		q->drops++;
+		pthread_mutex_unlock(&q->lock);
+		if (!was_full)
+			log(ALL, LOG_WARNING,
+			    "The %s sink queue is full, dropping its jobs\n",
+			    q->name);
+		if (release)
+			release(arg);
+		return -ENOBUFS;
+	}
+
+	was_full = q->full;
+	if (was_full)
+		drops = q->drops;
+	q->full = false;
+
+	job = &q->jobs[(q->first + q->count) % SINK_QUEUE_LEN];
+	job->func = func;
+	job->release = release;
+	job->arg = arg;
+	q->count++;
+	q->submitted++;
+	pthread_cond_signal(&q->cond);
+	pthread_mutex_unlock(&q->lock);
+
+	if (was_full)
+		log(ALL, LOG_WARNING, "%llu %s sink jobs were dropped\n",
+		    (unsigned long long)drops, q->name);
+
+	return 0;
+}
+
+static void sink_start(struct ras_sink_queue *q)
+{
+	int rc;
+
+	pthread_mutex_lock(&q->lock);
+	q->stop = 0;
+	rc = pthread_create(&q->thread, NULL, sink_thread, q);
+	if (!rc)
+		q->running = 1;
+	pthread_mutex_unlock(&q->lock);
+
+	if (rc)
+		log(TERM, LOG_WARNING,
+		    "Can't create the %s sink worker. Running it synchronously\n",
+		    q->name);
+}
+
+static void sink_stop(struct ras_sink_queue *q)
+{
+	pthread_mutex_lock(&q->lock);
+	if (!q->running) {
+		pthread_mutex_unlock(&q->lock);
+		return;
+	}
+	q->stop = 1;
+	pthread_cond_signal(&q->cond);
+	pthread_mutex_unlock(&q->lock);
+
+	pthread_join(q->thread, NULL);
+
+	pthread_mutex_lock(&q->lock);
+	q->running = 0;
+	pthread_mutex_unlock(&q->lock);
+
+	if (q->drops)
+		log(TERM, LOG_INFO, "Sink queue %s: %llu jobs, %llu dropped\n",
+		    q->name, (unsigned long long)q->submitted,
+		    (unsigned long long)q->drops);
+}
+
+/*
+ * A queue, with its own worker, for the jobs of a sink. Returns NULL if
+ * it can't be allocated, so the jobs run synchronously.
+ */
+struct ras_sink_queue *ras_sink_queue_create(const char *name)
+{
+	struct ras_sink_queue *q;
+
+	q = calloc(1, sizeof(*q));
+	if (!q) {
+		log(TERM, LOG_ERR, "Can't allocate the %s sink queue\n", name);
+		return NULL;
+	}
+
+	q->name = name;
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->cond, NULL);
+
+	pthread_mutex_lock(&queues_lock);
+	q->next = queues;
+	queues = q;
+	if (queues_started)
+		sink_start(q);
+	pthread_mutex_unlock(&queues_lock);
+
+	return q;
+}
+
+/*
+ * Pipeline setup
+ */
+
+static uint64_t get_ring_size(struct ras_events *ras)
+{
+	char *env = getenv(PIPELINE_RING_KB);
+	uint64_t size = DEFAULT_RING_KB * 1024, min, ring_size;
+
+	if (env && strlen(env) && atoi(env) > 0)
+		size = (uint64_t)atoi(env) * 1024;
+
+	/* A ring should hold at least a few sub-buffers */
+	min = 4 * ras->page_size;
+	if (size < min)
+		size = min;
+
+	/* Round up to a power of two */
+	for (ring_size = 1; ring_size < size; ring_size <<= 1)
+		;
+
+	return ring_size;
+}
+
+/*
+ * Allocates the buffer of a ring. Should be called before its reader
+ * starts pushing records.
+ */
+int ras_pipeline_ring_alloc(struct ras_pipeline *pl, unsigned int i)
+{
+	struct ras_ring *ring = &pl->rings[i];
+
+	if (ring->buf)
+		return 0;
+
+	ring->spacefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (ring->spacefd < 0)
+		return -errno;
+
+	ring->buf = malloc(ring->size);
+	if (!ring->buf) {
+		close(ring->spacefd);
+		ring->spacefd = -1;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/*
+ * With lazy set, the buffers of the rings aren't allocated here, but by
+ * ras_pipeline_ring_alloc(), as their readers are started.
+ */
+struct ras_pipeline *ras_pipeline_alloc(struct ras_events *ras,
+					unsigned int n_rings, bool lazy,
+					ras_decode_func decode)
+{
+	struct ras_pipeline *pl;
+	uint64_t ring_size = get_ring_size(ras);
+	unsigned int i;
+
+	pl = calloc(1, sizeof(*pl));
+	if (!pl)
+		return NULL;
+
+	pl->ras = ras;
+	pl->decode = decode;
+	pl->n_rings = n_rings;
+	pl->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+	if (posix_memalign((void **)&pl->rings, CACHELINE,
+			   n_rings * sizeof(*pl->rings))) {
+		pl->rings = NULL;
+		goto error;
+	}
+	memset(pl->rings, 0, n_rings * sizeof(*pl->rings));
+	for (i = 0; i < n_rings; i++) {
+		pl->rings[i].spacefd = -1;
+		pl->rings[i].size = ring_size;
+	}
+
+	if (pl->wakefd < 0)
+		goto error;
+
+	for (i = 0; i < n_rings && !lazy; i++) {
+		if (ras_pipeline_ring_alloc(pl, i))
+			goto error;
+	}
+
+	log(TERM, LOG_INFO, "Event pipeline: %s%u rings of %llu kB\n",
+	    lazy ? "up to " : "", n_rings,
+	    (unsigned long long)ring_size / 1024);
+
+	return pl;
+
+error:
+	log(TERM, LOG_ERR, "Can't allocate event pipeline\n");
+	ras_pipeline_free(pl);
+	return NULL;
+}
+
+int ras_pipeline_start(struct ras_pipeline *pl)
+{
+	struct ras_sink_queue *q;
+	int rc;
+
+	atomic_store(&pl->stop, 0);
+
+	rc = pthread_create(&pl->decoder, NULL, decoder_thread, pl);
+	if (rc) {
+		log(TERM, LOG_ERR, "Can't create decoder thread\n");
+		return -rc;
+	}
+	pl->running = 1;
+
+	pthread_mutex_lock(&queues_lock);
+	queues_started = true;
+	for (q = queues; q; q = q->next)
+		sink_start(q);
+	pthread_mutex_unlock(&queues_lock);
+
+	pthread_mutex_lock(&active_lock);
+	active = pl;
+	pthread_mutex_unlock(&active_lock);
+
+	return 0;
+}
+
+static void pipeline_read_stats(struct ras_pipeline *pl,
+				struct ras_pipeline_stats *st)
+{
+	struct ras_sink_queue *q;
+	struct ras_ring *ring;
+	unsigned int i;
+
+	memset(st, 0, sizeof(*st));
+
+	for (i = 0; i < pl->n_rings; i++) {
+		ring = &pl->rings[i];
+		st->records += atomic_load(&ring->records);
+		st->stalls += atomic_load(&ring->stalls);
+		st->drops += atomic_load(&ring->drops);
+		st->ring_used += atomic_load(&ring->head) -
+				 atomic_load(&ring->tail);
+		if (ring->buf)
+			st->ring_size += ring->size;
+	}
+	st->decoded = atomic_load(&pl->decoded);
+
+	pthread_mutex_lock(&queues_lock);
+	for (q = queues; q; q = q->next) {
+		pthread_mutex_lock(&q->lock);
+		st->sink_jobs += q->submitted;
+		st->sink_drops += q->drops;
+		st->sink_queued += q->count;
+		pthread_mutex_unlock(&q->lock);
+	}
+	pthread_mutex_unlock(&queues_lock);
+}
+
+/* Counters of the running pipeline. Returns -ENOENT if there's none */
+int ras_pipeline_get_stats(struct ras_pipeline_stats *st)
+{
+	int rc = -ENOENT;
+
+	pthread_mutex_lock(&active_lock);
+	if (active) {
+		pipeline_read_stats(active, st);
+		rc = 0;
+	}
+	pthread_mutex_unlock(&active_lock);
+
+	return rc;
+}
+
+/* Stop the pipeline, after decoding all the pending records */
+void ras_pipeline_stop(struct ras_pipeline *pl)
+{
+	struct ras_pipeline_stats st;
+	struct ras_sink_queue *q;
+	uint64_t val = 1;
+
+	if (!pl->running)
+		return;
+
+	pthread_mutex_lock(&active_lock);
+	if (active == pl)
+		active = NULL;
+	pthread_mutex_unlock(&active_lock);
+
+	atomic_store(&pl->stop, 1);
+	if (write(pl->wakefd, &val, sizeof(val)) < 0)
+		log(TERM, LOG_WARNING, "Can't wake up decoder\n");
+	pthread_join(pl->decoder, NULL);
+	pl->running = 0;
+
+	pthread_mutex_lock(&queues_lock);
+	queues_started = false;
+	for (q = queues; q; q = q->next)
+		sink_stop(q);
+	pthread_mutex_unlock(&queues_lock);
+
+	pipeline_read_stats(pl, &st);
+
+	log(ALL, LOG_INFO,
+	    "Event pipeline: read %llu records (%llu stalls, %llu drops), decoded %llu\n",
+	    (unsigned long long)st.records, (unsigned long long)st.stalls,
+	    (unsigned long long)st.drops, (unsigned long long)st.decoded);
+
+	pthread_mutex_lock(&queues_lock);
+	for (q = queues; q; q = q->next)
+		log(ALL, LOG_INFO, "Event pipeline: %llu %s jobs (%llu drops)\n",
+		    (unsigned long long)q->submitted, q->name,
+		    (unsigned long long)q->drops);
+	pthread_mutex_unlock(&queues_lock);
+}
+
+void ras_pipeline_free(struct ras_pipeline *pl)
+{
+	unsigned int i;
+
+	if (!pl)
+		return;
+
+	ras_pipeline_stop(pl);
+
+	if (pl->rings) {
+		for (i = 0; i < pl->n_rings; i++) {
+			free(pl->rings[i].buf);
+			if (pl->rings[i].spacefd >= 0)
+				close(pl->rings[i].spacefd);
+		}
+		free(pl->rings);
+	}
+	if (pl->wakefd >= 0)
+		close(pl->wakefd);
+	free(pl);
+}
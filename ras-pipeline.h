@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Staged event pipeline: readers -> decoder -> sinks
+ */
+
+#ifndef __RAS_PIPELINE_H
+#define __RAS_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct kbuffer;
+struct ras_events;
+struct ras_pipeline;
+struct ras_sink_queue;
+struct tep_record;
+
+typedef void (*ras_decode_func)(struct ras_events *ras,
+				struct tep_record *record);
+typedef void (*ras_sink_func)(void *arg);
+
+struct ras_pipeline_stats {
+	uint64_t	records;	/* Read by the readers */
+	uint64_t	stalls;
+	uint64_t	drops;
+	uint64_t	decoded;
+	uint64_t	ring_used;	/* Bytes waiting at the rings */
+	uint64_t	ring_size;
+	uint64_t	sink_jobs;
+	uint64_t	sink_drops;
+	unsigned int	sink_queued;
+};
+
+struct ras_pipeline *ras_pipeline_alloc(struct ras_events *ras,
+					unsigned int n_rings, bool lazy,
+					ras_decode_func decode);
+int ras_pipeline_ring_alloc(struct ras_pipeline *pl, unsigned int i);
+int ras_pipeline_start(struct ras_pipeline *pl);
+void ras_pipeline_stop(struct ras_pipeline *pl);
+void ras_pipeline_free(struct ras_pipeline *pl);
+
+int ras_pipeline_push(struct ras_pipeline *pl, unsigned int ring,
+		      struct kbuffer *kbuf, void *data,
+		      unsigned long long time_stamp, int cpu);
+void ras_pipeline_kick(struct ras_pipeline *pl);
+void ras_pipeline_set_lossless(struct ras_pipeline *pl);
+int ras_pipeline_get_stats(struct ras_pipeline_stats *st);
+
+struct ras_sink_queue *ras_sink_queue_create(const char *name);
+int ras_sink_submit(struct ras_sink_queue *q, ras_sink_func func,
+		    ras_sink_func release, void *arg);
+
+#endif
@@ -5,20 +5,27 @@
  * Copyright (c) 2016, The Linux Foundation. All rights reserved.
  */
 
+#include <ctype.h>
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "ras-aer-handler.h"
+#include "ras-binlog.h"
 #include "ras-events.h"
 #include "ras-logger.h"
 #include "ras-mce-handler.h"
 #include "ras-mc-handler.h"
 #include "ras-record.h"
 #include "ras-reri-handler.h"
+#include "ras-sink.h"
+#include "ras-staging.h"
+#include "ras-stats.h"
+#include "ras-tables.h"
 
 /*
  * BuildRequires: sqlite-devel
@@ -29,1386 +36,1653 @@
 #define SQLITE_RAS_DB RASSTATEDIR "/" RAS_DB_FNAME
 
 /*
- * Table and functions to handle ras:mc_event
+ * Group commit
+ *
+ * Events are inserted inside a transaction, which is committed after
+ * DB_COMMIT_COUNT events, or DB_COMMIT_INTERVAL_MS after its first event,
+ * so an error storm doesn't cost a journal sync per event. Uncorrected
+ * and fatal errors are committed at once.
+ *
+ * The database is only written by the event decoder thread, which also
+ * commits the pending events when the interval expires while idle.
  */
 
-static const struct db_fields mc_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "err_count",		.type = "INTEGER" },
-		{ .name = "err_type",		.type = "TEXT" },
-		{ .name = "err_msg",		.type = "TEXT" },
-		{ .name = "label",		.type = "TEXT" },
-		{ .name = "mc",			.type = "INTEGER" },
-		{ .name = "top_layer",		.type = "INTEGER" },
-		{ .name = "middle_layer",		.type = "INTEGER" },
-		{ .name = "lower_layer",		.type = "INTEGER" },
-		{ .name = "address",		.type = "INTEGER" },
-		{ .name = "grain",		.type = "INTEGER" },
-		{ .name = "syndrome",		.type = "INTEGER" },
-		{ .name = "driver_detail",	.type = "TEXT" },
-};
+#define DB_COMMIT_COUNT			"DB_COMMIT_COUNT"
+#define DB_COMMIT_INTERVAL_MS		"DB_COMMIT_INTERVAL_MS"
+#define DEFAULT_COMMIT_COUNT		256
+#define DEFAULT_COMMIT_INTERVAL_MS	1000
 
-static const struct db_table_descriptor mc_event_tab = {
-	.name = "mc_event",
-	.fields = mc_event_fields,
-	.num_fields = ARRAY_SIZE(mc_event_fields),
-};
+/* Time to wait for ras-mc-ctl, or another reader, to release the database */
+#define DB_BUSY_TIMEOUT_MS		5000
 
-int ras_store_mc_event(struct ras_events *ras, struct ras_mc_event *ev)
+static void db_coalesce_flush_all(struct sqlite3_priv *priv);
+static uint64_t db_staging_mark(struct sqlite3_priv *priv);
+
+static void db_begin(struct sqlite3_priv *priv)
 {
 	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_mc_event)
-		return 0;
-	log(TERM, LOG_INFO, "mc_event store: %p\n", priv->stmt_mc_event);
-
-	sqlite3_bind_text(priv->stmt_mc_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_int (priv->stmt_mc_event,  2, ev->error_count);
-	sqlite3_bind_text(priv->stmt_mc_event,  3, ev->error_type, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mc_event,  4, ev->msg, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mc_event,  5, ev->label, -1, NULL);
-	sqlite3_bind_int (priv->stmt_mc_event,  6, ev->mc_index);
-	sqlite3_bind_int (priv->stmt_mc_event,  7, ev->top_layer);
-	sqlite3_bind_int (priv->stmt_mc_event,  8, ev->middle_layer);
-	sqlite3_bind_int (priv->stmt_mc_event,  9, ev->lower_layer);
-	sqlite3_bind_int64(priv->stmt_mc_event, 10, ev->address);
-	sqlite3_bind_int64(priv->stmt_mc_event, 11, ev->grain);
-	sqlite3_bind_int64(priv->stmt_mc_event, 12, ev->syndrome);
-	sqlite3_bind_text(priv->stmt_mc_event, 13, ev->driver_detail, -1, NULL);
-	rc = sqlite3_step(priv->stmt_mc_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do mc_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_mc_event);
-	if (rc != SQLITE_OK)
+	if (priv->in_transaction)
+		return;
+
+	/* Without a transaction, each event is committed on its own */
+	rc = sqlite3_exec(priv->db, "BEGIN", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
 		log(TERM, LOG_ERR,
-		    "Failed reset mc_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		    "Failed to begin transaction on sqlite: error = %d\n", rc);
+		return;
+	}
 
-	return rc;
+	priv->in_transaction = true;
+	clock_gettime(CLOCK_MONOTONIC, &priv->first_pending);
 }
 
-/*
- * Table and functions to handle ras:aer
- */
-
-#ifdef HAVE_AER
-static const struct db_fields aer_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "dev_name",		.type = "TEXT" },
-		{ .name = "err_type",		.type = "TEXT" },
-		{ .name = "err_msg",		.type = "TEXT" },
-};
-
-static const struct db_table_descriptor aer_event_tab = {
-	.name = "aer_event",
-	.fields = aer_event_fields,
-	.num_fields = ARRAY_SIZE(aer_event_fields),
-};
-
-int ras_store_aer_event(struct ras_events *ras, struct ras_aer_event *ev)
+static void db_commit(struct sqlite3_priv *priv)
 {
+	uint64_t staged;
 	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_aer_event)
-		return 0;
-	log(TERM, LOG_INFO, "aer_event store: %p\n", priv->stmt_aer_event);
+	if (!priv->in_transaction)
+		return;
 
-	sqlite3_bind_text(priv->stmt_aer_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_aer_event,  2, ev->dev_name, -1, NULL);
-	sqlite3_bind_text(priv->stmt_aer_event,  3, ev->error_type, -1, NULL);
-	sqlite3_bind_text(priv->stmt_aer_event,  4, ev->msg, -1, NULL);
+	db_coalesce_flush_all(priv);
+	staged = db_staging_mark(priv);
 
-	rc = sqlite3_step(priv->stmt_aer_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do aer_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_aer_event);
-	if (rc != SQLITE_OK)
+	rc = sqlite3_exec(priv->db, "COMMIT", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
 		log(TERM, LOG_ERR,
-		    "Failed reset aer_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		    "Failed to commit %u events on sqlite: error = %d\n",
+		    priv->pending, rc);
+		ras_stats_drop(RAS_DROP_DB, -1, -1, priv->pending);
+		sqlite3_exec(priv->db, "ROLLBACK", NULL, NULL, NULL);
 
-	return rc;
-}
-#endif
+		/* The rows cached for coalescing may have been rolled back */
+		memset(priv->coalesce, 0, sizeof(priv->coalesce));
+	} else {
+		ras_staging_ack(staged);
+	}
 
-/*
- * Table and functions to handle ras:non standard
- */
+	priv->in_transaction = false;
+	priv->pending = 0;
+}
 
-#ifdef HAVE_NON_STANDARD
-static const struct db_fields non_standard_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "sec_type",		.type = "BLOB" },
-		{ .name = "fru_id",		.type = "BLOB" },
-		{ .name = "fru_text",		.type = "TEXT" },
-		{ .name = "severity",		.type = "TEXT" },
-		{ .name = "error",		.type = "BLOB" },
-};
+/* Called after storing an event. Urgent events are committed at once */
+static void db_stored(struct sqlite3_priv *priv, bool urgent)
+{
+	if (!priv->in_transaction)
+		return;
 
-static const struct db_table_descriptor non_standard_event_tab = {
-	.name = "non_standard_event",
-	.fields = non_standard_event_fields,
-	.num_fields = ARRAY_SIZE(non_standard_event_fields),
-};
+	priv->pending++;
+	if (urgent || priv->pending >= priv->commit_count)
+		db_commit(priv);
+}
 
-int ras_store_non_standard_record(struct ras_events *ras, struct ras_non_standard_event *ev)
+/*
+ * Returns the time, in ms, until the pending events should be committed,
+ * or -1 if there's nothing to commit.
+ */
+int ras_db_commit_timeout(struct ras_events *ras)
 {
-	int rc;
 	struct sqlite3_priv *priv = ras->db_priv;
+	struct timespec now;
+	long ms;
 
-	if (!priv || !priv->stmt_non_standard_record)
+	if (!priv || !priv->in_transaction)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (now.tv_sec - priv->first_pending.tv_sec) * 1000 +
+	     (now.tv_nsec - priv->first_pending.tv_nsec) / 1000000;
+
+	if (ms >= priv->commit_interval)
 		return 0;
-	log(TERM, LOG_INFO, "non_standard_event store: %p\n", priv->stmt_non_standard_record);
 
-	sqlite3_bind_text(priv->stmt_non_standard_record,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_blob(priv->stmt_non_standard_record,  2, ev->sec_type, -1, NULL);
-	sqlite3_bind_blob(priv->stmt_non_standard_record,  3, ev->fru_id, 16, NULL);
-	sqlite3_bind_text(priv->stmt_non_standard_record,  4, ev->fru_text, -1, NULL);
-	sqlite3_bind_text(priv->stmt_non_standard_record,  5, ev->severity, -1, NULL);
-	sqlite3_bind_blob(priv->stmt_non_standard_record,  6, ev->error, ev->length, NULL);
+	return priv->commit_interval - ms;
+}
 
-	rc = sqlite3_step(priv->stmt_non_standard_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do non_standard_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_non_standard_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset non_standard_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+void ras_db_commit(struct ras_events *ras)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
 
-	return rc;
+	if (priv)
+		db_commit(priv);
 }
-#endif
 
 /*
- * Table and functions to handle ras:arm
+ * Event time
+ *
+ * Besides the text timestamp filled by the handlers, every table has the
+ * time of the event as integers, in ns: time_ns, at the wall clock, and
+ * boot_ns, since boot. Both are indexed, and so are the columns used to
+ * look for the events of a device, so time ranges are index scans.
+ *
+ * The decoder sets the time of each trace record before calling its
+ * handler. Events stored out of the trace records use the current time.
  */
 
-#ifdef HAVE_ARM
-static const struct db_fields arm_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "error_count",		.type = "INTEGER" },
-		{ .name = "affinity",		.type = "INTEGER" },
-		{ .name = "mpidr",		.type = "INTEGER" },
-		{ .name = "running_state",	.type = "INTEGER" },
-		{ .name = "psci_state",		.type = "INTEGER" },
-		{ .name = "err_info",		.type = "BLOB"	},
-		{ .name = "context_info",		.type = "BLOB"	},
-		{ .name = "vendor_info",		.type = "BLOB"	},
-		{ .name = "error_type",		.type = "TEXT" },
-		{ .name = "error_flags",	.type = "TEXT" },
-		{ .name = "error_info",		.type = "INTEGER" },
-		{ .name = "virt_fault_addr",	.type = "INTEGER" },
-		{ .name = "phy_fault_addr",	.type = "INTEGER" },
+static const struct db_fields time_fields[] = {
+	{ .name = "time_ns",		.type = "INTEGER" },
+	{ .name = "boot_ns",		.type = "INTEGER" },
 };
 
-static const struct db_table_descriptor arm_event_tab = {
-	.name = "arm_event",
-	.fields = arm_event_fields,
-	.num_fields = ARRAY_SIZE(arm_event_fields),
+static const char * const locator_fields[] = {
+	"address", "addr", "cpu", "dev", "dev_name", "memdev",
 };
 
-int ras_store_arm_record(struct ras_events *ras, struct ras_arm_event *ev)
+static uint64_t timespec_ns(const struct timespec *ts)
 {
-	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
-
-	if (!priv || !priv->stmt_arm_record)
-		return 0;
-	log(TERM, LOG_INFO, "arm_event store: %p\n", priv->stmt_arm_record);
-
-	sqlite3_bind_text(priv->stmt_arm_record,  1,  ev->timestamp, -1, NULL);
-	sqlite3_bind_int  (priv->stmt_arm_record,  2,  ev->error_count);
-	sqlite3_bind_int  (priv->stmt_arm_record,  3,  ev->affinity);
-	sqlite3_bind_int64(priv->stmt_arm_record,  4,  ev->mpidr);
-	sqlite3_bind_int  (priv->stmt_arm_record,  5,  ev->running_state);
-	sqlite3_bind_int  (priv->stmt_arm_record,  6,  ev->psci_state);
-	sqlite3_bind_blob(priv->stmt_arm_record,  7,
-			  ev->pei_error, ev->pei_len, NULL);
-	sqlite3_bind_blob(priv->stmt_arm_record,  8,
-			  ev->ctx_error, ev->ctx_len, NULL);
-	sqlite3_bind_blob(priv->stmt_arm_record,  9,
-			  ev->vsei_error, ev->oem_len, NULL);
-	sqlite3_bind_text(priv->stmt_arm_record,  10, ev->error_types, -1, NULL);
-	sqlite3_bind_text(priv->stmt_arm_record, 11, ev->error_flags, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_arm_record,  12,  ev->error_info);
-	sqlite3_bind_int64(priv->stmt_arm_record,  13,  ev->virt_fault_addr);
-	sqlite3_bind_int64(priv->stmt_arm_record,  14,  ev->phy_fault_addr);
-
-	rc = sqlite3_step(priv->stmt_arm_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do arm_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_arm_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset arm_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
-
-	return rc;
+	return (uint64_t)ts->tv_sec * 1000000000ULL + ts->tv_nsec;
 }
-#endif
 
-#ifdef HAVE_EXTLOG
-static const struct db_fields extlog_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "etype",		.type = "INTEGER" },
-		{ .name = "error_count",		.type = "INTEGER" },
-		{ .name = "severity",		.type = "INTEGER" },
-		{ .name = "address",		.type = "INTEGER" },
-		{ .name = "fru_id",		.type = "BLOB" },
-		{ .name = "fru_text",		.type = "TEXT" },
-		{ .name = "cper_data",		.type = "BLOB" },
-};
+static void db_bind_time(sqlite3_stmt *stmt, int idx)
+{
+	uint64_t boot_ns, wall_ns;
 
-static const struct db_table_descriptor extlog_event_tab = {
-	.name = "extlog_event",
-	.fields = extlog_event_fields,
-	.num_fields = ARRAY_SIZE(extlog_event_fields),
-};
+	ras_db_event_time(&boot_ns, &wall_ns);
+
+	sqlite3_bind_int64(stmt, idx, wall_ns);
+	sqlite3_bind_int64(stmt, idx + 1, boot_ns);
+}
 
-int ras_store_extlog_mem_record(struct ras_events *ras, struct ras_extlog_event *ev)
+/* Binds the time columns of a new row, and its coalescing ones */
+static void db_bind_row_time(sqlite3_stmt *stmt,
+			     const struct db_table_descriptor *tab,
+			     uint64_t wall_ns, uint64_t boot_ns)
 {
-	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
+	int idx = tab->num_fields;
 
-	if (!priv || !priv->stmt_extlog_record)
-		return 0;
-	log(TERM, LOG_INFO, "extlog_record store: %p\n", priv->stmt_extlog_record);
-
-	sqlite3_bind_text(priv->stmt_extlog_record,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_int   (priv->stmt_extlog_record,  2, ev->etype);
-	sqlite3_bind_int   (priv->stmt_extlog_record,  3, ev->error_seq);
-	sqlite3_bind_int   (priv->stmt_extlog_record,  4, ev->severity);
-	sqlite3_bind_int64(priv->stmt_extlog_record,  5, ev->address);
-	sqlite3_bind_blob(priv->stmt_extlog_record,  6, ev->fru_id, 16, NULL);
-	sqlite3_bind_text(priv->stmt_extlog_record,  7, ev->fru_text, -1, NULL);
-	sqlite3_bind_blob(priv->stmt_extlog_record,  8, ev->cper_data, ev->cper_data_length, NULL);
-
-	rc = sqlite3_step(priv->stmt_extlog_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do extlog_mem_record step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_extlog_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset extlog_mem_record on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+	sqlite3_bind_int64(stmt, idx, wall_ns);
+	sqlite3_bind_int64(stmt, idx + 1, boot_ns);
 
-	return rc;
+	if (tab->coalesce) {
+		idx += ARRAY_SIZE(time_fields);
+		sqlite3_bind_int64(stmt, idx, wall_ns);
+		sqlite3_bind_int64(stmt, idx + 1, 1);
+	}
 }
-#endif
 
 /*
- * Table and functions to handle mce:mce_record
+ * Coalescing
+ *
+ * On tables with .coalesce, corrected errors identical to one stored less
+ * than DB_COALESCE_MS before, but for their time, don't get a row of their
+ * own: the last_ns and occurrences columns of the first row are updated
+ * instead. The updates are kept at a small cache, indexed by a hash of the
+ * event, and written when the transaction is committed. Uncorrected errors
+ * are always stored on their own rows. At the staging ring, the repeats
+ * are also kept as updates of the first row, not as events.
  */
 
-#ifdef HAVE_MCE
-static const struct db_fields mce_record_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-
-		/* MCE registers */
-		{ .name = "mcgcap",		.type = "INTEGER" },
-		{ .name = "mcgstatus",		.type = "INTEGER" },
-		{ .name = "status",		.type = "INTEGER" },
-		{ .name = "addr",			.type = "INTEGER" }, // 5
-		{ .name = "misc",			.type = "INTEGER" },
-		{ .name = "ip",			.type = "INTEGER" },
-		{ .name = "tsc",			.type = "INTEGER" },
-		{ .name = "walltime",		.type = "INTEGER" },
-		{ .name = "ppin",			.type = "INTEGER" }, // 10
-		{ .name = "cpu",			.type = "INTEGER" },
-		{ .name = "cpuid",		.type = "INTEGER" },
-		{ .name = "apicid",		.type = "INTEGER" },
-		{ .name = "socketid",		.type = "INTEGER" },
-		{ .name = "cs",			.type = "INTEGER" }, // 15
-		{ .name = "bank",			.type = "INTEGER" },
-		{ .name = "cpuvendor",		.type = "INTEGER" },
-		{ .name = "microcode",      .type = "INTEGER" },
-
-		/* Parsed data - will likely change */
-		{ .name = "bank_name",		.type = "TEXT" },
-		{ .name = "error_msg",		.type = "TEXT" }, // 20
-		{ .name = "mcgstatus_msg",	.type = "TEXT" },
-		{ .name = "mcistatus_msg",	.type = "TEXT" },
-		{ .name = "mcastatus_msg",	.type = "TEXT" },
-		{ .name = "user_action",		.type = "TEXT" },
-		{ .name = "mc_location",		.type = "TEXT" },
-};
+#define DB_COALESCE_MS		"DB_COALESCE_MS"
 
-static const struct db_table_descriptor mce_record_tab = {
-	.name = "mce_record",
-	.fields = mce_record_fields,
-	.num_fields = ARRAY_SIZE(mce_record_fields),
+static const struct db_fields coalesce_fields[] = {
+	{ .name = "last_ns",		.type = "INTEGER" },
+	{ .name = "occurrences",	.type = "INTEGER" },
 };
 
-int ras_store_mce_record(struct ras_events *ras, struct mce_event *ev)
+static uint64_t db_event_hash(const struct db_table_descriptor *tab,
+			      const void *ev)
 {
-	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
+	uint64_t hash = 0xcbf29ce484222325ULL;	/* FNV-1a */
+	const struct db_fields *field;
+	const unsigned char *data;
+	int64_t val;
+	size_t len, j;
+	int i;
+
+	for (i = 0; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+
+		switch (field->bind) {
+		case DB_BIND_NONE:
+			continue;
+		case DB_BIND_INT:
+			val = db_field_int(field, ev);
+			data = (const unsigned char *)&val;
+			len = sizeof(val);
+			break;
+		case DB_BIND_TEXT:
+		case DB_BIND_STR:
+			if (!strcmp(field->name, "timestamp"))
+				continue;
+			data = (const unsigned char *)db_field_text(field, ev, &len);
+			break;
+		default:
+			data = db_field_blob(field, ev, &len);
+			break;
+		}
 
-	if (!priv || !priv->stmt_mce_record)
-		return 0;
-	log(TERM, LOG_INFO, "mce_record store: %p\n", priv->stmt_mce_record);
-
-	sqlite3_bind_text(priv->stmt_mce_record,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_int   (priv->stmt_mce_record,  2, ev->mcgcap);
-	sqlite3_bind_int   (priv->stmt_mce_record,  3, ev->mcgstatus);
-	sqlite3_bind_int64(priv->stmt_mce_record,  4, ev->status);
-	sqlite3_bind_int64(priv->stmt_mce_record,  5, ev->addr);
-	sqlite3_bind_int64(priv->stmt_mce_record,  6, ev->misc);
-	sqlite3_bind_int64(priv->stmt_mce_record,  7, ev->ip);
-	sqlite3_bind_int64(priv->stmt_mce_record,  8, ev->tsc);
-	sqlite3_bind_int64(priv->stmt_mce_record,  9, ev->walltime);
-	sqlite3_bind_int64(priv->stmt_mce_record,  10, ev->ppin);
-	sqlite3_bind_int   (priv->stmt_mce_record, 11, ev->cpu);
-	sqlite3_bind_int   (priv->stmt_mce_record, 12, ev->cpuid);
-	sqlite3_bind_int   (priv->stmt_mce_record, 13, ev->apicid);
-	sqlite3_bind_int   (priv->stmt_mce_record, 14, ev->socketid);
-	sqlite3_bind_int   (priv->stmt_mce_record, 15, ev->cs);
-	sqlite3_bind_int   (priv->stmt_mce_record, 16, ev->bank);
-	sqlite3_bind_int   (priv->stmt_mce_record, 17, ev->cpuvendor);
-	sqlite3_bind_int   (priv->stmt_mce_record, 18, ev->microcode);
-
-	sqlite3_bind_text(priv->stmt_mce_record, 19, ev->bank_name, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mce_record, 20, ev->error_msg, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mce_record, 21, ev->mcgstatus_msg, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mce_record, 22, ev->mcistatus_msg, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mce_record, 23, ev->mcastatus_msg, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mce_record, 24, ev->user_action, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mce_record, 25, ev->mc_location, -1, NULL);
-
-	rc = sqlite3_step(priv->stmt_mce_record);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do mce_record step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_mce_record);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset mce_record on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		/* The length separates the fields */
+		hash ^= len;
+		hash *= 0x100000001b3ULL;
+		for (j = 0; data && j < len; j++) {
+			hash ^= data[j];
+			hash *= 0x100000001b3ULL;
+		}
+	}
 
-	return rc;
+	return hash;
 }
-#endif
 
-/*
- * Table and functions to handle devlink:devlink_health_report
- */
+/* Prepared when the table is opened, as its INSERT statement */
+static int db_coalesce_prepare(struct sqlite3_priv *priv,
+			       const struct db_table_descriptor *db_tab)
+{
+	struct db_coalesce_stmt *cs;
+	char sql[256];
+	int rc;
 
-#ifdef HAVE_DEVLINK
-static const struct db_fields devlink_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "bus_name",		.type = "TEXT" },
-		{ .name = "dev_name",		.type = "TEXT" },
-		{ .name = "driver_name",		.type = "TEXT" },
-		{ .name = "reporter_name",	.type = "TEXT" },
-		{ .name = "msg",			.type = "TEXT" },
-};
+	if (priv->n_coalesce_stmt == DB_COALESCE_TABLES) {
+		log(TERM, LOG_ERR, "Too many tables with coalescing\n");
+		return SQLITE_ERROR;
+	}
+	cs = &priv->coalesce_stmt[priv->n_coalesce_stmt];
 
-static const struct db_table_descriptor devlink_event_tab = {
-	.name = "devlink_event",
-	.fields = devlink_event_fields,
-	.num_fields = ARRAY_SIZE(devlink_event_fields),
-};
+	snprintf(sql, sizeof(sql),
+		 "UPDATE %s SET last_ns = ?, occurrences = ? WHERE rowid = ?",
+		 db_tab->name);
+	rc = sqlite3_prepare_v2(priv->db, sql, -1, &cs->stmt, NULL);
+	if (rc != SQLITE_OK) {
+		log(TERM, LOG_ERR,
+		    "Failed to prepare the update of %s: error = %s\n",
+		    db_tab->name, sqlite3_errmsg(priv->db));
+		return rc;
+	}
+	cs->db_tab = db_tab;
+	priv->n_coalesce_stmt++;
 
-int ras_store_devlink_event(struct ras_events *ras, struct devlink_event *ev)
+	return SQLITE_OK;
+}
+
+static sqlite3_stmt *db_coalesce_stmt(struct sqlite3_priv *priv,
+				      const struct db_table_descriptor *db_tab)
 {
-	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
+	unsigned int i;
 
-	if (!priv || !priv->stmt_devlink_event)
-		return 0;
-	log(TERM, LOG_INFO, "devlink_event store: %p\n", priv->stmt_devlink_event);
+	for (i = 0; i < priv->n_coalesce_stmt; i++)
+		if (priv->coalesce_stmt[i].db_tab == db_tab)
+			return priv->coalesce_stmt[i].stmt;
 
-	sqlite3_bind_text(priv->stmt_devlink_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_devlink_event,  2, ev->bus_name, -1, NULL);
-	sqlite3_bind_text(priv->stmt_devlink_event,  3, ev->dev_name, -1, NULL);
-	sqlite3_bind_text(priv->stmt_devlink_event,  4, ev->driver_name, -1, NULL);
-	sqlite3_bind_text(priv->stmt_devlink_event,  5, ev->reporter_name, -1, NULL);
-	sqlite3_bind_text(priv->stmt_devlink_event,  6, ev->msg, -1, NULL);
+	return NULL;
+}
 
-	rc = sqlite3_step(priv->stmt_devlink_event);
+static void db_coalesce_flush(struct sqlite3_priv *priv,
+			      struct db_coalesce *c)
+{
+	sqlite3_stmt *stmt;
+	int rc = SQLITE_ERROR;
+
+	if (!c->dirty)
+		return;
+	c->dirty = false;
+
+	stmt = db_coalesce_stmt(priv, c->db_tab);
+	if (stmt) {
+		sqlite3_bind_int64(stmt, 1, c->last_ns);
+		sqlite3_bind_int64(stmt, 2, c->count);
+		sqlite3_bind_int64(stmt, 3, c->rowid);
+		rc = sqlite3_step(stmt);
+		sqlite3_reset(stmt);
+	}
 	if (rc != SQLITE_DONE)
 		log(TERM, LOG_ERR,
-		    "Failed to do devlink_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_devlink_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset devlink_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		    "Failed to update repeated %s events: error = %s\n",
+		    c->db_tab->name, sqlite3_errmsg(priv->db));
+}
 
-	return rc;
+static void db_coalesce_flush_all(struct sqlite3_priv *priv)
+{
+	int i;
+
+	for (i = 0; i < DB_COALESCE_SLOTS; i++)
+		db_coalesce_flush(priv, &priv->coalesce[i]);
 }
-#endif
 
 /*
- * Table and functions to handle block:block_rq_{complete|error}
+ * Returns at *slot the cache entry of the row of the event, and true if
+ * the event was merged into a previous row, instead of a row about to be
+ * stored.
  */
+static bool db_coalesce(struct sqlite3_priv *priv,
+			const struct db_table_descriptor *tab, const void *ev,
+			struct db_coalesce **slot)
+{
+	uint64_t hash = db_event_hash(tab, ev);
+	struct db_coalesce *c = &priv->coalesce[hash % DB_COALESCE_SLOTS];
+	uint64_t boot_ns, wall_ns;
+
+	ras_db_event_time(&boot_ns, &wall_ns);
+
+	if (c->db_tab == tab && c->hash == hash && c->rowid &&
+	    wall_ns >= c->first_ns && wall_ns - c->first_ns < priv->coalesce_ns) {
+		c->last_ns = wall_ns;
+		c->count++;
+		c->dirty = true;
+		*slot = c;
+		return true;
+	}
 
-#ifdef HAVE_DISKERROR
-static const struct db_fields diskerror_event_fields[] = {
-		{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-		{ .name = "timestamp",		.type = "TEXT" },
-		{ .name = "dev",			.type = "TEXT" },
-		{ .name = "sector",		.type = "INTEGER" },
-		{ .name = "nr_sector",		.type = "INTEGER" },
-		{ .name = "error",		.type = "TEXT" },
-		{ .name = "rwbs",			.type = "TEXT" },
-		{ .name = "cmd",			.type = "TEXT" },
-};
-
-static const struct db_table_descriptor diskerror_event_tab = {
-	.name = "disk_errors",
-	.fields = diskerror_event_fields,
-	.num_fields = ARRAY_SIZE(diskerror_event_fields),
-};
+	db_coalesce_flush(priv, c);
+	c->db_tab = tab;
+	c->hash = hash;
+	c->rowid = 0;
+	c->first_ns = wall_ns;
+	c->last_ns = wall_ns;
+	c->count = 1;
+	c->staged = -1;
+	*slot = c;
+
+	return false;
+}
 
-int ras_store_diskerror_event(struct ras_events *ras, struct diskerror_event *ev)
+/* Descriptor columns, followed by the time and the coalescing columns */
+static int db_num_fields(const struct db_table_descriptor *db_tab)
 {
-	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
-
-	if (!priv || !priv->stmt_diskerror_event)
-		return 0;
-	log(TERM, LOG_INFO, "diskerror_event store: %p\n", priv->stmt_diskerror_event);
+	return db_tab->num_fields + ARRAY_SIZE(time_fields) +
+	       (db_tab->coalesce ? ARRAY_SIZE(coalesce_fields) : 0);
+}
 
-	sqlite3_bind_text(priv->stmt_diskerror_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_diskerror_event,  2, ev->dev, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_diskerror_event,  3, ev->sector);
-	sqlite3_bind_int(priv->stmt_diskerror_event,  4, ev->nr_sector);
-	sqlite3_bind_text(priv->stmt_diskerror_event,  5, ev->error, -1, NULL);
-	sqlite3_bind_text(priv->stmt_diskerror_event,  6, ev->rwbs, -1, NULL);
-	sqlite3_bind_text(priv->stmt_diskerror_event,  7, ev->cmd, -1, NULL);
+static const struct db_fields *db_field(const struct db_table_descriptor *db_tab,
+					int i)
+{
+	if (i < db_tab->num_fields)
+		return &db_tab->fields[i];
+	i -= db_tab->num_fields;
 
-	rc = sqlite3_step(priv->stmt_diskerror_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do diskerror_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_diskerror_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset diskerror_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+	if (i < ARRAY_SIZE(time_fields))
+		return &time_fields[i];
 
-	return rc;
+	return &coalesce_fields[i - ARRAY_SIZE(time_fields)];
 }
-#endif
 
 /*
- * Table and functions to handle ras:memory_failure
+ * Staging ring
+ *
+ * Events are also written to the staging ring until their transaction is
+ * committed, so the ones lost by a crash are stored at the next start.
+ * The ring position of the last event committed is stored together with
+ * the events, at the staging_ack table.
  */
 
-#ifdef HAVE_MEMORY_FAILURE
-static const struct db_fields mf_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "pfn",		.type = "TEXT" },
-	{ .name = "page_type",		.type = "TEXT" },
-	{ .name = "action_result",	.type = "TEXT" },
-};
+/* Stages an event, returning its ring position at *pos, if not NULL */
+static void db_stage(struct sqlite3_priv *priv,
+		     const struct db_table_descriptor *tab, const void *ev,
+		     uint64_t wall_ns, uint64_t boot_ns, bool urgent,
+		     int64_t *pos)
+{
+	uint64_t staged;
+	int rc;
 
-static const struct db_table_descriptor mf_event_tab = {
-	.name = "memory_failure_event",
-	.fields = mf_event_fields,
-	.num_fields = ARRAY_SIZE(mf_event_fields),
-};
+	rc = ras_staging_put(tab, ev, wall_ns, boot_ns, urgent, &staged);
+	if (rc == -ENOSPC) {
+		/* Committing the pending events frees the ring */
+		db_commit(priv);
+		db_begin(priv);
+		rc = ras_staging_put(tab, ev, wall_ns, boot_ns, urgent,
+				     &staged);
+	}
+	if (rc) {
+		log(TERM, LOG_WARNING, "Can't stage %s event: %s\n",
+		    tab->name, strerror(-rc));
+		return;
+	}
+	if (pos)
+		*pos = staged;
+}
 
-int ras_store_mf_event(struct ras_events *ras, struct ras_mf_event *ev)
+/* Stages a repeat merged at the cache entry @c */
+static void db_stage_repeat(struct sqlite3_priv *priv, struct db_coalesce *c,
+			    uint64_t wall_ns, uint64_t boot_ns)
 {
+	struct staging_repeat rep = {
+		.first = c->staged,
+		.rowid = c->rowid,
+		.count = c->count,
+	};
 	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_mf_event)
-		return 0;
-	log(TERM, LOG_INFO, "memory_failure_event store: %p\n", priv->stmt_mf_event);
+	/* Without its first one, the replay couldn't find the row */
+	if (c->staged < 0)
+		return;
 
-	sqlite3_bind_text(priv->stmt_mf_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mf_event,  2, ev->pfn, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mf_event,  3, ev->page_type, -1, NULL);
-	sqlite3_bind_text(priv->stmt_mf_event,  4, ev->action_result, -1, NULL);
+	rc = ras_staging_put_repeat(c->db_tab, &rep, wall_ns, boot_ns);
+	if (rc == -ENOSPC) {
+		db_commit(priv);
+		db_begin(priv);
+		rc = ras_staging_put_repeat(c->db_tab, &rep, wall_ns, boot_ns);
+	}
+	if (rc)
+		log(TERM, LOG_WARNING, "Can't stage %s event: %s\n",
+		    c->db_tab->name, strerror(-rc));
+}
 
-	rc = sqlite3_step(priv->stmt_mf_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do memory_failure_event step on sqlite: error = %d\n", rc);
+/* Stores the ring position at the transaction, and returns it */
+static uint64_t db_staging_mark(struct sqlite3_priv *priv)
+{
+	sqlite3_stmt *stmt = priv->stmt_staging;
+	uint64_t head;
 
-	rc = sqlite3_reset(priv->stmt_mf_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset memory_failure_event on sqlite: error = %d\n",
-		    rc);
+	if (!stmt)
+		return 0;
 
-	log(TERM, LOG_INFO, "register inserted at db\n");
+	head = ras_staging_head();
+	sqlite3_bind_int64(stmt, 1, ras_staging_id());
+	sqlite3_bind_int64(stmt, 2, head);
+	if (sqlite3_step(stmt) != SQLITE_DONE)
+		head = 0;
+	sqlite3_reset(stmt);
 
-	return rc;
+	return head;
 }
-#endif
 
-#ifdef HAVE_CXL
 /*
- * Table and functions to handle cxl:cxl_poison
+ * Generic binder
+ *
+ * ras_store_event() binds the columns of @tab from the event struct @ev,
+ * as described by the table, and inserts the row. @event is the event
+ * type, used to count the events that couldn't be stored, or -1.
+ * Uncorrected and fatal events, by the @severity the handler gave to the
+ * sinks, are urgent: committed, and synced at the staging ring, at once.
+ *
+ * With EVENT_STORAGE=binlog, the events go to the binary event log
+ * instead, and the database isn't opened.
  */
-static const struct db_fields cxl_poison_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "trace_type",		.type = "TEXT" },
-	{ .name = "region",		.type = "TEXT" },
-	{ .name = "region_uuid",	.type = "TEXT" },
-	{ .name = "hpa",		.type = "INTEGER" },
-	{ .name = "dpa",		.type = "INTEGER" },
-	{ .name = "dpa_length",		.type = "INTEGER" },
-	{ .name = "source",		.type = "TEXT" },
-	{ .name = "flags",		.type = "INTEGER" },
-	{ .name = "overflow_ts",	.type = "TEXT" },
-	{ .name = "hpa_alias0",		.type = "INTEGER" },
-};
 
-static const struct db_table_descriptor cxl_poison_event_tab = {
-	.name = "cxl_poison_event",
-	.fields = cxl_poison_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_poison_event_fields),
-};
+/* Prepared insert of a table, or NULL if the database isn't open */
+#define DB_STMT(priv, stmt)	((priv) ? (priv)->stmt : NULL)
 
-int ras_store_cxl_poison_event(struct ras_events *ras, struct ras_cxl_poison_event *ev)
+static void db_bind_fields(sqlite3_stmt *stmt,
+			   const struct db_table_descriptor *tab,
+			   const void *ev)
 {
+	const struct db_fields *field;
+	const void *data;
+	size_t len;
+	int i;
+
+	/* Column 0 is the row id */
+	for (i = 1; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+
+		switch (field->bind) {
+		case DB_BIND_INT:
+			sqlite3_bind_int64(stmt, i, db_field_int(field, ev));
+			break;
+		case DB_BIND_TEXT:
+		case DB_BIND_STR:
+			data = db_field_text(field, ev, &len);
+			sqlite3_bind_text(stmt, i, data, len, NULL);
+			break;
+		case DB_BIND_BLOB:
+		case DB_BIND_BLOB_PTR:
+		case DB_BIND_BLOB_LEN:
+			data = db_field_blob(field, ev, &len);
+			sqlite3_bind_blob(stmt, i, data, len, NULL);
+			break;
+		default:
+			sqlite3_bind_null(stmt, i);
+			break;
+		}
+	}
+}
+
+static int __ras_store_event(struct sqlite3_priv *priv, sqlite3_stmt *stmt,
+			     const struct db_table_descriptor *tab,
+			     const void *ev, int event,
+			     enum ras_severity severity, bool coalesce)
+{
+	bool urgent = severity >= RAS_SEV_UNCORRECTED;
+	struct db_coalesce *slot = NULL;
+	uint64_t boot_ns, wall_ns;
 	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_cxl_poison_event)
+	if (ras_binlog_active()) {
+		ras_db_event_time(&boot_ns, &wall_ns);
+		rc = ras_binlog_store(tab, ev, wall_ns, boot_ns, urgent);
+		if (rc && event >= 0)
+			ras_stats_drop(RAS_DROP_DB, -1, event, 1);
+		return rc;
+	}
+
+	if (!priv || !stmt)
 		return 0;
-	log(TERM, LOG_INFO, "cxl_poison_event store: %p\n", priv->stmt_cxl_poison_event);
-
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 2, ev->memdev, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 3, ev->host, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_poison_event, 4, ev->serial);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 5, ev->trace_type, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 6, ev->region, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 7, ev->uuid, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_poison_event, 8, ev->hpa);
-	sqlite3_bind_int64(priv->stmt_cxl_poison_event, 9, ev->dpa);
-	sqlite3_bind_int(priv->stmt_cxl_poison_event, 10, ev->dpa_length);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 11, ev->source, -1, NULL);
-	sqlite3_bind_int(priv->stmt_cxl_poison_event, 12, ev->flags);
-	sqlite3_bind_text(priv->stmt_cxl_poison_event, 13, ev->overflow_ts, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_poison_event, 14, ev->hpa_alias0);
-
-	rc = sqlite3_step(priv->stmt_cxl_poison_event);
-	if (rc != SQLITE_DONE)
+
+	log(TERM, LOG_INFO, "%s store: %p\n", tab->name, stmt);
+
+	ras_db_event_time(&boot_ns, &wall_ns);
+	db_begin(priv);
+
+	if (coalesce && tab->coalesce && priv->coalesce_ns &&
+	    db_coalesce(priv, tab, ev, &slot)) {
+		if (ras_staging_active())
+			db_stage_repeat(priv, slot, wall_ns, boot_ns);
+		log(TERM, LOG_INFO, "register coalesced at db\n");
+		db_stored(priv, false);
+		return 0;
+	}
+
+	if (ras_staging_active())
+		db_stage(priv, tab, ev, wall_ns, boot_ns, urgent,
+			 slot ? &slot->staged : NULL);
+
+	db_bind_fields(stmt, tab, ev);
+	db_bind_row_time(stmt, tab, wall_ns, boot_ns);
+
+	rc = sqlite3_step(stmt);
+	if (rc != SQLITE_DONE) {
 		log(TERM, LOG_ERR,
-		    "Failed to do cxl_poison_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_poison_event);
+		    "Failed to do %s step on sqlite: error = %d\n",
+		    tab->name, rc);
+		if (event >= 0)
+			ras_stats_drop(RAS_DROP_DB, -1, event, 1);
+	} else if (slot) {
+		slot->rowid = sqlite3_last_insert_rowid(priv->db);
+	}
+	rc = sqlite3_reset(stmt);
 	if (rc != SQLITE_OK)
 		log(TERM, LOG_ERR,
-		    "Failed reset cxl_poison_event on sqlite: error = %d\n",
-		    rc);
+		    "Failed reset %s on sqlite: error = %d\n", tab->name, rc);
 	log(TERM, LOG_INFO, "register inserted at db\n");
+	db_stored(priv, urgent);
 
 	return rc;
 }
 
+static int ras_store_event(struct sqlite3_priv *priv, sqlite3_stmt *stmt,
+			   const struct db_table_descriptor *tab,
+			   const void *ev, int event,
+			   enum ras_severity severity)
+{
+	return __ras_store_event(priv, stmt, tab, ev, event, severity, false);
+}
+
 /*
- * Table and functions to handle cxl:cxl_aer_uncorrectable_error
+ * Functions to handle the events lost by rasdaemon
  */
-static const struct db_fields cxl_aer_ue_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "error_status",	.type = "INTEGER" },
-	{ .name = "first_error",	.type = "INTEGER" },
-	{ .name = "header_log",		.type = "BLOB" },
-};
 
-static const struct db_table_descriptor cxl_aer_ue_event_tab = {
-	.name = "cxl_aer_ue_event",
-	.fields = cxl_aer_ue_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_aer_ue_event_fields),
-};
-
-int ras_store_cxl_aer_ue_event(struct ras_events *ras, struct ras_cxl_aer_ue_event *ev)
+int ras_store_lost_event(struct ras_events *ras, struct ras_lost_event *ev)
 {
-	int rc;
 	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_cxl_aer_ue_event)
-		return 0;
-	log(TERM, LOG_INFO, "cxl_aer_ue_event store: %p\n", priv->stmt_cxl_aer_ue_event);
+	/* Failing to store the losses isn't counted as a loss */
+	return ras_store_event(priv, DB_STMT(priv, stmt_lost_event),
+			       &lost_event_tab, ev, -1, RAS_SEV_INFO);
+}
 
-	sqlite3_bind_text(priv->stmt_cxl_aer_ue_event, 1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_aer_ue_event, 2, ev->memdev, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_aer_ue_event, 3, ev->host, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_aer_ue_event, 4, ev->serial);
-	sqlite3_bind_int(priv->stmt_cxl_aer_ue_event, 5, ev->error_status);
-	sqlite3_bind_int(priv->stmt_cxl_aer_ue_event, 6, ev->first_error);
-	sqlite3_bind_blob(priv->stmt_cxl_aer_ue_event, 7, ev->header_log, CXL_HEADERLOG_SIZE, NULL);
+/*
+ * Functions to handle ras:mc_event
+ */
 
-	rc = sqlite3_step(priv->stmt_cxl_aer_ue_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do cxl_aer_ue_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_aer_ue_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset cxl_aer_ue_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+int ras_store_mc_event(struct ras_events *ras, struct ras_mc_event *ev,
+		       enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
 
-	return rc;
+	return __ras_store_event(priv, DB_STMT(priv, stmt_mc_event),
+				 &mc_event_tab, ev, MC_EVENT, severity,
+				 severity == RAS_SEV_CORRECTED);
 }
 
 /*
- * Table and functions to handle cxl:cxl_aer_correctable_error
+ * Functions to handle ras:aer
  */
-static const struct db_fields cxl_aer_ce_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "error_status",	.type = "INTEGER" },
-};
 
-static const struct db_table_descriptor cxl_aer_ce_event_tab = {
-	.name = "cxl_aer_ce_event",
-	.fields = cxl_aer_ce_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_aer_ce_event_fields),
-};
-
-int ras_store_cxl_aer_ce_event(struct ras_events *ras, struct ras_cxl_aer_ce_event *ev)
+#ifdef HAVE_AER
+int ras_store_aer_event(struct ras_events *ras, struct ras_aer_event *ev,
+			enum ras_severity severity)
 {
-	int rc;
 	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_cxl_aer_ce_event)
-		return 0;
-	log(TERM, LOG_INFO, "cxl_aer_ce_event store: %p\n", priv->stmt_cxl_aer_ce_event);
+	return __ras_store_event(priv, DB_STMT(priv, stmt_aer_event),
+				 &aer_event_tab, ev, AER_EVENT, severity,
+				 severity == RAS_SEV_CORRECTED);
+}
+#endif
 
-	sqlite3_bind_text(priv->stmt_cxl_aer_ce_event, 1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_aer_ce_event, 2, ev->memdev, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_aer_ce_event, 3, ev->host, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_aer_ce_event, 4, ev->serial);
-	sqlite3_bind_int(priv->stmt_cxl_aer_ce_event, 5, ev->error_status);
+/*
+ * Functions to handle ras:non standard
+ */
 
-	rc = sqlite3_step(priv->stmt_cxl_aer_ce_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do cxl_aer_ce_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_aer_ce_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset cxl_aer_ce_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+#ifdef HAVE_NON_STANDARD
+int ras_store_non_standard_record(struct ras_events *ras,
+				  struct ras_non_standard_event *ev,
+				  enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
 
-	return rc;
+	return ras_store_event(priv, DB_STMT(priv, stmt_non_standard_record),
+			       &non_standard_event_tab, ev, NON_STANDARD_EVENT,
+			       severity);
 }
+#endif
 
 /*
- * Table and functions to handle cxl:cxl_overflow
+ * Functions to handle ras:arm
  */
-static const struct db_fields cxl_overflow_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "log_type",		.type = "TEXT" },
-	{ .name = "count",		.type = "INTEGER" },
-	{ .name = "first_ts",		.type = "TEXT" },
-	{ .name = "last_ts",		.type = "TEXT" },
-};
 
-static const struct db_table_descriptor cxl_overflow_event_tab = {
-	.name = "cxl_overflow_event",
-	.fields = cxl_overflow_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_overflow_event_fields),
-};
-
-int ras_store_cxl_overflow_event(struct ras_events *ras, struct ras_cxl_overflow_event *ev)
+#ifdef HAVE_ARM
+int ras_store_arm_record(struct ras_events *ras, struct ras_arm_event *ev,
+			 enum ras_severity severity)
 {
-	int rc;
 	struct sqlite3_priv *priv = ras->db_priv;
 
-	if (!priv || !priv->stmt_cxl_overflow_event)
-		return 0;
-	log(TERM, LOG_INFO, "cxl_overflow_event store: %p\n", priv->stmt_cxl_overflow_event);
-
-	sqlite3_bind_text(priv->stmt_cxl_overflow_event, 1, ev->timestamp, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_overflow_event, 2, ev->memdev, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_overflow_event, 3, ev->host, -1, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_overflow_event, 4, ev->serial);
-	sqlite3_bind_text(priv->stmt_cxl_overflow_event, 5, ev->log_type, -1, NULL);
-	sqlite3_bind_int(priv->stmt_cxl_overflow_event, 6, ev->count);
-	sqlite3_bind_text(priv->stmt_cxl_overflow_event, 7, ev->first_ts, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_overflow_event, 8, ev->last_ts, -1, NULL);
-
-	rc = sqlite3_step(priv->stmt_cxl_overflow_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do cxl_overflow_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_overflow_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset cxl_overflow_event on sqlite: error = %d\n",
-		    rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
-
-	return rc;
+	return ras_store_event(priv, DB_STMT(priv, stmt_arm_record),
+			       &arm_event_tab, ev, ARM_EVENT, severity);
 }
+#endif
 
-static int ras_store_cxl_common_hdr(sqlite3_stmt *stmt, struct ras_cxl_event_common_hdr *hdr)
+#ifdef HAVE_EXTLOG
+int ras_store_extlog_mem_record(struct ras_events *ras,
+				struct ras_extlog_event *ev,
+				enum ras_severity severity)
 {
-	int idx = 1;
-
-	if (!stmt || !hdr)
-		return -1;
+	struct sqlite3_priv *priv = ras->db_priv;
 
-	sqlite3_bind_text(stmt, idx++, hdr->timestamp, -1, NULL);
-	sqlite3_bind_text(stmt, idx++, hdr->memdev, -1, NULL);
-	sqlite3_bind_text(stmt, idx++, hdr->host, -1, NULL);
-	sqlite3_bind_int64(stmt, idx++, hdr->serial);
-	sqlite3_bind_text(stmt, idx++, hdr->log_type, -1, NULL);
-	sqlite3_bind_text(stmt, idx++, hdr->hdr_uuid, -1, NULL);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_flags);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_handle);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_related_handle);
-	sqlite3_bind_text(stmt, idx++, hdr->hdr_timestamp, -1, NULL);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_length);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_maint_op_class);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_maint_op_sub_class);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_ld_id);
-	sqlite3_bind_int(stmt, idx++, hdr->hdr_head_id);
-
-	return idx;
+	return ras_store_event(priv, DB_STMT(priv, stmt_extlog_record),
+			       &extlog_event_tab, ev, EXTLOG_EVENT, severity);
 }
+#endif
 
 /*
- * Table and functions to handle cxl:cxl_generic_event
+ * Functions to handle mce:mce_record
  */
-static const struct db_fields cxl_generic_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "log_type",		.type = "TEXT" },
-	{ .name = "hdr_uuid",		.type = "TEXT" },
-	{ .name = "hdr_flags",		.type = "INTEGER" },
-	{ .name = "hdr_handle",		.type = "INTEGER" },
-	{ .name = "hdr_related_handle",	.type = "INTEGER" },
-	{ .name = "hdr_ts",		.type = "TEXT" },
-	{ .name = "hdr_length",		.type = "INTEGER" },
-	{ .name = "hdr_maint_op_class",	.type = "INTEGER" },
-	{ .name = "hdr_maint_op_sub_class",	.type = "INTEGER" },
-	{ .name = "hdr_ld_id",		.type = "INTEGER" },
-	{ .name = "hdr_head_id",	.type = "INTEGER" },
-	{ .name = "data",		.type = "BLOB" },
-};
 
-static const struct db_table_descriptor cxl_generic_event_tab = {
-	.name = "cxl_generic_event",
-	.fields = cxl_generic_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_generic_event_fields),
-};
+#ifdef HAVE_MCE
+int ras_store_mce_record(struct ras_events *ras, struct mce_event *ev,
+			 enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_mce_record),
+			       &mce_record_tab, ev, MCE_EVENT, severity);
+}
+#endif
 
-int ras_store_cxl_generic_event(struct ras_events *ras, struct ras_cxl_generic_event *ev)
+/*
+ * Functions to handle devlink:devlink_health_report
+ */
+
+#ifdef HAVE_DEVLINK
+int ras_store_devlink_event(struct ras_events *ras, struct devlink_event *ev,
+			    enum ras_severity severity)
 {
 	struct sqlite3_priv *priv = ras->db_priv;
-	int idx;
-	int rc;
 
-	if (!priv || !priv->stmt_cxl_generic_event)
-		return -1;
-	log(TERM, LOG_INFO, "cxl_generic_event store: %p\n", priv->stmt_cxl_generic_event);
+	return ras_store_event(priv, DB_STMT(priv, stmt_devlink_event),
+			       &devlink_event_tab, ev, DEVLINK_EVENT, severity);
+}
+#endif
 
-	idx = ras_store_cxl_common_hdr(priv->stmt_cxl_generic_event, &ev->hdr);
-	if (idx <= 0)
-		return -1;
+/*
+ * Functions to handle block:block_rq_{complete|error}
+ */
 
-	sqlite3_bind_blob(priv->stmt_cxl_generic_event, idx++, ev->data,
-			  CXL_EVENT_RECORD_DATA_LENGTH, NULL);
+#ifdef HAVE_DISKERROR
+int ras_store_diskerror_event(struct ras_events *ras,
+			      struct diskerror_event *ev,
+			      enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
 
-	rc = sqlite3_step(priv->stmt_cxl_generic_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do stmt_cxl_generic_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_generic_event);
-	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset stmt_cxl_generic_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+	return ras_store_event(priv, DB_STMT(priv, stmt_diskerror_event),
+			       &diskerror_event_tab, ev, DISKERROR_EVENT,
+			       severity);
+}
+#endif
 
-	return rc;
+/*
+ * Functions to handle ras:memory_failure
+ */
+
+#ifdef HAVE_MEMORY_FAILURE
+int ras_store_mf_event(struct ras_events *ras, struct ras_mf_event *ev,
+		       enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_mf_event),
+			       &mf_event_tab, ev, MF_EVENT, severity);
+}
+#endif
+
+#ifdef HAVE_CXL
+/*
+ * Functions to handle cxl:cxl_poison
+ */
+int ras_store_cxl_poison_event(struct ras_events *ras,
+			       struct ras_cxl_poison_event *ev,
+			       enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_poison_event),
+			       &cxl_poison_event_tab, ev, CXL_POISON_EVENT,
+			       severity);
 }
 
 /*
- * Table and functions to handle cxl:cxl_general_media_event
+ * Functions to handle cxl:cxl_aer_uncorrectable_error
  */
-static const struct db_fields cxl_general_media_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "log_type",		.type = "TEXT" },
-	{ .name = "hdr_uuid",		.type = "TEXT" },
-	{ .name = "hdr_flags",		.type = "INTEGER" },
-	{ .name = "hdr_handle",		.type = "INTEGER" },
-	{ .name = "hdr_related_handle",	.type = "INTEGER" },
-	{ .name = "hdr_ts",		.type = "TEXT" },
-	{ .name = "hdr_length",		.type = "INTEGER" },
-	{ .name = "hdr_maint_op_class",	.type = "INTEGER" },
-	{ .name = "hdr_maint_op_sub_class",	.type = "INTEGER" },
-	{ .name = "hdr_ld_id",		.type = "INTEGER" },
-	{ .name = "hdr_head_id",	.type = "INTEGER" },
-	{ .name = "dpa",		.type = "INTEGER" },
-	{ .name = "dpa_flags",		.type = "INTEGER" },
-	{ .name = "descriptor",		.type = "INTEGER" },
-	{ .name = "type",		.type = "INTEGER" },
-	{ .name = "transaction_type",	.type = "INTEGER" },
-	{ .name = "channel",		.type = "INTEGER" },
-	{ .name = "rank",		.type = "INTEGER" },
-	{ .name = "device",		.type = "INTEGER" },
-	{ .name = "comp_id",		.type = "BLOB" },
-	{ .name = "hpa",		.type = "INTEGER" },
-	{ .name = "region",		.type = "TEXT" },
-	{ .name = "region_uuid",	.type = "TEXT" },
-	{ .name = "pldm_entity_id",	.type = "BLOB" },
-	{ .name = "pldm_resource_id",	.type = "BLOB" },
-	{ .name = "sub_type",		.type = "INTEGER" },
-	{ .name = "cme_threshold_ev_flags",	.type = "INTEGER" },
-	{ .name = "cme_count",		.type = "INTEGER" },
-	{ .name = "hpa_alias0",		.type = "INTEGER" },
-};
+int ras_store_cxl_aer_ue_event(struct ras_events *ras,
+			       struct ras_cxl_aer_ue_event *ev,
+			       enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
 
-static const struct db_table_descriptor cxl_general_media_event_tab = {
-	.name = "cxl_general_media_event",
-	.fields = cxl_general_media_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_general_media_event_fields),
-};
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_aer_ue_event),
+			       &cxl_aer_ue_event_tab, ev, CXL_AER_UE_EVENT,
+			       severity);
+}
+
+/*
+ * Functions to handle cxl:cxl_aer_correctable_error
+ */
+int ras_store_cxl_aer_ce_event(struct ras_events *ras,
+			       struct ras_cxl_aer_ce_event *ev,
+			       enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_aer_ce_event),
+			       &cxl_aer_ce_event_tab, ev, CXL_AER_CE_EVENT,
+			       severity);
+}
+
+/*
+ * Functions to handle cxl:cxl_overflow
+ */
+int ras_store_cxl_overflow_event(struct ras_events *ras,
+				 struct ras_cxl_overflow_event *ev,
+				 enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_overflow_event),
+			       &cxl_overflow_event_tab, ev, CXL_OVERFLOW_EVENT,
+			       severity);
+}
+
+/*
+ * Functions to handle cxl:cxl_generic_event
+ */
+int ras_store_cxl_generic_event(struct ras_events *ras,
+				struct ras_cxl_generic_event *ev,
+				enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_generic_event),
+			       &cxl_generic_event_tab, ev, CXL_GENERIC_EVENT,
+			       severity);
+}
 
+/*
+ * Functions to handle cxl:cxl_general_media_event
+ */
 int ras_store_cxl_general_media_event(struct ras_events *ras,
-				      struct ras_cxl_general_media_event *ev)
+				      struct ras_cxl_general_media_event *ev,
+				      enum ras_severity severity)
 {
 	struct sqlite3_priv *priv = ras->db_priv;
-	int idx;
-	int rc;
 
-	if (!priv || !priv->stmt_cxl_general_media_event)
-		return -1;
-	log(TERM, LOG_INFO, "cxl_general_media_event store: %p\n",
-	    priv->stmt_cxl_general_media_event);
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_general_media_event),
+			       &cxl_general_media_event_tab, ev,
+			       CXL_GENERAL_MEDIA_EVENT, severity);
+}
 
-	idx = ras_store_cxl_common_hdr(priv->stmt_cxl_general_media_event, &ev->hdr);
-	if (idx <= 0)
-		return -1;
-	sqlite3_bind_int64(priv->stmt_cxl_general_media_event, idx++, ev->dpa);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->dpa_flags);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->descriptor);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->type);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->transaction_type);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->channel);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->rank);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->device);
-	sqlite3_bind_blob(priv->stmt_cxl_general_media_event, idx++, ev->comp_id,
-			  CXL_EVENT_GEN_MED_COMP_ID_SIZE, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_general_media_event, idx++, ev->hpa);
-	sqlite3_bind_text(priv->stmt_cxl_general_media_event, idx++, ev->region, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_general_media_event, idx++, ev->region_uuid, -1, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_general_media_event, idx++, ev->entity_id,
-			  CXL_PLDM_ENTITY_ID_LEN, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_general_media_event, idx++, ev->res_id,
-			  CXL_PLDM_RES_ID_LEN, NULL);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->sub_type);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++,
-			 ev->cme_threshold_ev_flags);
-	sqlite3_bind_int(priv->stmt_cxl_general_media_event, idx++, ev->cme_count);
-	sqlite3_bind_int64(priv->stmt_cxl_general_media_event, idx++, ev->hpa_alias0);
-
-	rc = sqlite3_step(priv->stmt_cxl_general_media_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do stmt_cxl_general_media_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_general_media_event);
-	if (rc != SQLITE_OK)
+/*
+ * Functions to handle cxl:cxl_dram_event
+ */
+int ras_store_cxl_dram_event(struct ras_events *ras,
+			     struct ras_cxl_dram_event *ev,
+			     enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_dram_event),
+			       &cxl_dram_event_tab, ev, CXL_DRAM_EVENT,
+			       severity);
+}
+
+/*
+ * Functions to handle cxl:cxl_memory_module_event
+ */
+int ras_store_cxl_memory_module_event(struct ras_events *ras,
+				      struct ras_cxl_memory_module_event *ev,
+				      enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_cxl_memory_module_event),
+			       &cxl_memory_module_event_tab, ev,
+			       CXL_MEMORY_MODULE_EVENT, severity);
+}
+#endif
+
+#ifdef HAVE_SIGNAL
+int ras_store_signal_event(struct ras_events *ras, struct ras_signal_event *ev,
+			   enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_signal_event),
+			       &signal_event_tab, ev, SIGNAL_EVENT, severity);
+}
+#endif
+
+/*
+ * Functions to handle ras:reri_event
+ */
+
+#ifdef HAVE_RERI
+int ras_store_reri_event(struct ras_events *ras, struct ras_reri_event *ev,
+			 enum ras_severity severity)
+{
+	struct sqlite3_priv *priv = ras->db_priv;
+
+	return ras_store_event(priv, DB_STMT(priv, stmt_reri_event),
+			       &reri_event_tab, ev, RERI_EVENT, severity);
+}
+#endif
+
+/*
+ * Storage sink
+ */
+static int db_sink_emit(struct ras_events *ras, const struct ras_sink_event *ev)
+{
+	switch (ev->type) {
+	case MC_EVENT:
+		return ras_store_mc_event(ras, ev->ev, ev->severity);
+#ifdef HAVE_AER
+	case AER_EVENT:
+		return ras_store_aer_event(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_NON_STANDARD
+	case NON_STANDARD_EVENT:
+		return ras_store_non_standard_record(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_ARM
+	case ARM_EVENT:
+		return ras_store_arm_record(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_EXTLOG
+	case EXTLOG_EVENT:
+		return ras_store_extlog_mem_record(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_MCE
+	case MCE_EVENT:
+		return ras_store_mce_record(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_DEVLINK
+	case DEVLINK_EVENT:
+		return ras_store_devlink_event(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_DISKERROR
+	case DISKERROR_EVENT:
+		return ras_store_diskerror_event(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_MEMORY_FAILURE
+	case MF_EVENT:
+		return ras_store_mf_event(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_CXL
+	case CXL_POISON_EVENT:
+		return ras_store_cxl_poison_event(ras, ev->ev, ev->severity);
+	case CXL_AER_UE_EVENT:
+		return ras_store_cxl_aer_ue_event(ras, ev->ev, ev->severity);
+	case CXL_AER_CE_EVENT:
+		return ras_store_cxl_aer_ce_event(ras, ev->ev, ev->severity);
+	case CXL_OVERFLOW_EVENT:
+		return ras_store_cxl_overflow_event(ras, ev->ev, ev->severity);
+	case CXL_GENERIC_EVENT:
+		return ras_store_cxl_generic_event(ras, ev->ev, ev->severity);
+	case CXL_GENERAL_MEDIA_EVENT:
+		return ras_store_cxl_general_media_event(ras, ev->ev, ev->severity);
+	case CXL_DRAM_EVENT:
+		return ras_store_cxl_dram_event(ras, ev->ev, ev->severity);
+	case CXL_MEMORY_MODULE_EVENT:
+		return ras_store_cxl_memory_module_event(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_SIGNAL
+	case SIGNAL_EVENT:
+		return ras_store_signal_event(ras, ev->ev, ev->severity);
+#endif
+#ifdef HAVE_RERI
+	case RERI_EVENT:
+		return ras_store_reri_event(ras, ev->ev, ev->severity);
+#endif
+	default:
+		return 0;
+	}
+}
+
+static struct ras_sink db_sink = {
+	.name = "storage",
+	.emit = db_sink_emit,
+	.types = RAS_SINK_ALL_EVENTS,
+};
+
+/*
+ * Generic code
+ */
+static int __ras_mc_prepare_stmt(struct sqlite3_priv *priv,
+				 sqlite3_stmt **stmt,
+				 const struct db_table_descriptor *db_tab)
+
+{
+	int i, rc, num_fields = db_num_fields(db_tab);
+	char sql[4096], *p = sql, *end = sql + sizeof(sql);
+	const struct db_fields *field;
+
+	p += snprintf(p, end - p, "INSERT INTO %s (",
+		      db_tab->name);
+
+	for (i = 0; i < num_fields; i++) {
+		field = db_field(db_tab, i);
+		p += snprintf(p, end - p, "%s", field->name);
+
+		if (i < num_fields - 1)
+			p += snprintf(p, end - p, ", ");
+	}
+
+	p += snprintf(p, end - p, ") VALUES ( NULL, ");
+
+	for (i = 1; i < num_fields; i++) {
+		if (i < num_fields - 1)
+			strscat(sql, "?, ", sizeof(sql));
+		else
+			strscat(sql, "?)", sizeof(sql));
+	}
+
+#ifdef DEBUG_SQL
+	log(TERM, LOG_INFO, "SQL: %s\n", sql);
+#endif
+
+	rc = sqlite3_prepare_v2(priv->db, sql, -1, stmt, NULL);
+	if (rc != SQLITE_OK) {
 		log(TERM, LOG_ERR,
-		    "Failed reset stmt_cxl_general_media_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		    "Failed to prepare insert db at table %s (db %s): error = %s\n",
+		    db_tab->name, SQLITE_RAS_DB, sqlite3_errmsg(priv->db));
+		stmt = NULL;
+	} else {
+		log(TERM, LOG_INFO, "Recording %s events\n", db_tab->name);
+	}
+
+	return rc;
+}
+
+static int __ras_mc_create_table(struct sqlite3_priv *priv,
+				 const struct db_table_descriptor *db_tab)
+{
+	const struct db_fields *field;
+	char sql[4096], *p = sql, *end = sql + sizeof(sql);
+	int i, rc, num_fields = db_num_fields(db_tab);
+
+	p += snprintf(p, end - p, "CREATE TABLE IF NOT EXISTS %s (",
+		      db_tab->name);
+
+	for (i = 0; i < num_fields; i++) {
+		field = db_field(db_tab, i);
+		p += snprintf(p, end - p, "%s %s", field->name, field->type);
+
+		if (i < num_fields - 1)
+			p += snprintf(p, end - p, ", ");
+	}
+	p += snprintf(p, end - p, ")");
+
+#ifdef DEBUG_SQL
+	log(TERM, LOG_INFO, "SQL: %s\n", sql);
+#endif
 
+	rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		log(TERM, LOG_ERR,
+		    "Failed to create table %s on %s: error = %d\n",
+		    db_tab->name, SQLITE_RAS_DB, rc);
+	}
 	return rc;
 }
 
 /*
- * Table and functions to handle cxl:cxl_dram_event
+ * Fill time_ns of the events stored before it was added, from their
+ * "%Y-%m-%d %H:%M:%S %z" timestamps. There's no boot_ns for them.
  */
-static const struct db_fields cxl_dram_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "log_type",		.type = "TEXT" },
-	{ .name = "hdr_uuid",		.type = "TEXT" },
-	{ .name = "hdr_flags",		.type = "INTEGER" },
-	{ .name = "hdr_handle",		.type = "INTEGER" },
-	{ .name = "hdr_related_handle",	.type = "INTEGER" },
-	{ .name = "hdr_ts",		.type = "TEXT" },
-	{ .name = "hdr_length",		.type = "INTEGER" },
-	{ .name = "hdr_maint_op_class",	.type = "INTEGER" },
-	{ .name = "hdr_maint_op_sub_class",	.type = "INTEGER" },
-	{ .name = "hdr_ld_id",		.type = "INTEGER" },
-	{ .name = "hdr_head_id",	.type = "INTEGER" },
-	{ .name = "dpa",		.type = "INTEGER" },
-	{ .name = "dpa_flags",		.type = "INTEGER" },
-	{ .name = "descriptor",		.type = "INTEGER" },
-	{ .name = "type",		.type = "INTEGER" },
-	{ .name = "transaction_type",	.type = "INTEGER" },
-	{ .name = "channel",		.type = "INTEGER" },
-	{ .name = "rank",		.type = "INTEGER" },
-	{ .name = "nibble_mask",	.type = "INTEGER" },
-	{ .name = "bank_group",		.type = "INTEGER" },
-	{ .name = "bank",		.type = "INTEGER" },
-	{ .name = "row",		.type = "INTEGER" },
-	{ .name = "column",		.type = "INTEGER" },
-	{ .name = "cor_mask",		.type = "BLOB" },
-	{ .name = "hpa",		.type = "INTEGER" },
-	{ .name = "region",		.type = "TEXT" },
-	{ .name = "region_uuid",	.type = "TEXT" },
-	{ .name = "comp_id",		.type = "BLOB" },
-	{ .name = "pldm_entity_id",	.type = "BLOB" },
-	{ .name = "pldm_resource_id",	.type = "BLOB" },
-	{ .name = "sub_type",		.type = "INTEGER" },
-	{ .name = "sub_channel",	.type = "INTEGER" },
-	{ .name = "cme_threshold_ev_flags",	.type = "INTEGER" },
-	{ .name = "cvme_count",		.type = "INTEGER" },
-	{ .name = "hpa_alias0",		.type = "INTEGER" },
-};
+static void ras_mc_fill_time(struct sqlite3_priv *priv,
+			     const struct db_table_descriptor *db_tab)
+{
+	char sql[1024];
+	int rc;
 
-static const struct db_table_descriptor cxl_dram_event_tab = {
-	.name = "cxl_dram_event",
-	.fields = cxl_dram_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_dram_event_fields),
-};
+	snprintf(sql, sizeof(sql),
+		 "UPDATE %s SET time_ns = (strftime('%%s', substr(timestamp, 1, 19)) - "
+		 "(CASE substr(timestamp, 21, 1) WHEN '-' THEN -1 ELSE 1 END) * "
+		 "(substr(timestamp, 22, 2) * 3600 + substr(timestamp, 24, 2) * 60)) * 1000000000 "
+		 "WHERE time_ns IS NULL AND timestamp IS NOT NULL",
+		 db_tab->name);
+
+	rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
+	if (rc != SQLITE_OK)
+		log(TERM, LOG_WARNING,
+		    "Failed to fill the time of the %s events: error = %s\n",
+		    db_tab->name, sqlite3_errmsg(priv->db));
+}
 
-int ras_store_cxl_dram_event(struct ras_events *ras, struct ras_cxl_dram_event *ev)
+static int ras_mc_create_index(struct sqlite3_priv *priv,
+			       const struct db_table_descriptor *db_tab,
+			       const char *name, const char *columns)
 {
-	struct sqlite3_priv *priv = ras->db_priv;
-	int idx;
+	char sql[512];
 	int rc;
 
-	if (!priv || !priv->stmt_cxl_dram_event)
-		return -1;
-	log(TERM, LOG_INFO, "cxl_dram_event store: %p\n",
-	    priv->stmt_cxl_dram_event);
+	snprintf(sql, sizeof(sql),
+		 "CREATE INDEX IF NOT EXISTS %s_%s ON %s (%s)",
+		 db_tab->name, name, db_tab->name, columns);
 
-	idx = ras_store_cxl_common_hdr(priv->stmt_cxl_dram_event, &ev->hdr);
-	if (idx <= 0)
-		return -1;
-	sqlite3_bind_int64(priv->stmt_cxl_dram_event, idx++, ev->dpa);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->dpa_flags);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->descriptor);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->type);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->transaction_type);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->channel);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->rank);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->nibble_mask);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->bank_group);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->bank);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->row);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->column);
-	sqlite3_bind_blob(priv->stmt_cxl_dram_event, idx++, ev->cor_mask,
-			  CXL_EVENT_DER_CORRECTION_MASK_SIZE, NULL);
-	sqlite3_bind_int64(priv->stmt_cxl_dram_event, idx++, ev->hpa);
-	sqlite3_bind_text(priv->stmt_cxl_dram_event, idx++, ev->region, -1, NULL);
-	sqlite3_bind_text(priv->stmt_cxl_dram_event, idx++, ev->region_uuid, -1, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_dram_event, idx++, ev->comp_id,
-			  CXL_EVENT_GEN_MED_COMP_ID_SIZE, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_dram_event, idx++, ev->entity_id,
-			  CXL_PLDM_ENTITY_ID_LEN, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_dram_event, idx++, ev->res_id,
-			  CXL_PLDM_RES_ID_LEN, NULL);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->sub_type);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->sub_channel);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++,
-			 ev->cme_threshold_ev_flags);
-	sqlite3_bind_int(priv->stmt_cxl_dram_event, idx++, ev->cvme_count);
-	sqlite3_bind_int64(priv->stmt_cxl_dram_event, idx++, ev->hpa_alias0);
-
-	rc = sqlite3_step(priv->stmt_cxl_dram_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do stmt_cxl_dram_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_dram_event);
+#ifdef DEBUG_SQL
+	log(TERM, LOG_INFO, "SQL: %s\n", sql);
+#endif
+
+	rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
 	if (rc != SQLITE_OK)
-		log(TERM, LOG_ERR,
-		    "Failed reset stmt_cxl_dram_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		log(TERM, LOG_WARNING,
+		    "Failed to create index %s_%s on %s: error = %s\n",
+		    db_tab->name, name, SQLITE_RAS_DB,
+		    sqlite3_errmsg(priv->db));
+
+	return rc;
+}
+
+/* Index the time, and the device columns together with the time */
+static int ras_mc_create_indexes(struct sqlite3_priv *priv,
+				 const struct db_table_descriptor *db_tab)
+{
+	char columns[128];
+	int i, j, rc;
+
+	rc = ras_mc_create_index(priv, db_tab, "time_ns", "time_ns");
+
+	for (i = 0; i < db_tab->num_fields; i++) {
+		for (j = 0; j < ARRAY_SIZE(locator_fields); j++) {
+			if (strcmp(db_tab->fields[i].name, locator_fields[j]))
+				continue;
+
+			snprintf(columns, sizeof(columns), "%s, time_ns",
+				 locator_fields[j]);
+			if (ras_mc_create_index(priv, db_tab, locator_fields[j],
+						columns) != SQLITE_OK)
+				rc = SQLITE_ERROR;
+		}
+	}
 
 	return rc;
 }
 
 /*
- * Table and functions to handle cxl:cxl_memory_module_event
+ * Rollups
+ *
+ * Tables with a .rollup have a <table>_hourly companion, with the number of
+ * events per hour of time_ns and per value of the rollup columns. It is
+ * kept up to date by a trigger, in the same transaction as the event, so
+ * summaries read one row per bucket instead of scanning the events. When
+ * the rollup table is created, it is filled from the events already stored.
  */
-static const struct db_fields cxl_memory_module_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "memdev",		.type = "TEXT" },
-	{ .name = "host",		.type = "TEXT" },
-	{ .name = "serial",		.type = "INTEGER" },
-	{ .name = "log_type",		.type = "TEXT" },
-	{ .name = "hdr_uuid",		.type = "TEXT" },
-	{ .name = "hdr_flags",		.type = "INTEGER" },
-	{ .name = "hdr_handle",		.type = "INTEGER" },
-	{ .name = "hdr_related_handle",	.type = "INTEGER" },
-	{ .name = "hdr_ts",		.type = "TEXT" },
-	{ .name = "hdr_length",		.type = "INTEGER" },
-	{ .name = "hdr_maint_op_class",	.type = "INTEGER" },
-	{ .name = "hdr_maint_op_sub_class",	.type = "INTEGER" },
-	{ .name = "hdr_ld_id",		.type = "INTEGER" },
-	{ .name = "hdr_head_id",	.type = "INTEGER" },
-	{ .name = "event_type",		.type = "INTEGER" },
-	{ .name = "health_status",	.type = "INTEGER" },
-	{ .name = "media_status",	.type = "INTEGER" },
-	{ .name = "life_used",		.type = "INTEGER" },
-	{ .name = "dirty_shutdown_cnt",	.type = "INTEGER" },
-	{ .name = "cor_vol_err_cnt",	.type = "INTEGER" },
-	{ .name = "cor_per_err_cnt",	.type = "INTEGER" },
-	{ .name = "device_temp",	.type = "INTEGER" },
-	{ .name = "add_status",		.type = "INTEGER" },
-	{ .name = "event_sub_type",	.type = "INTEGER" },
-	{ .name = "comp_id",		.type = "BLOB" },
-	{ .name = "pldm_entity_id",	.type = "BLOB" },
-	{ .name = "pldm_resource_id",	.type = "BLOB" },
-};
 
-static const struct db_table_descriptor cxl_memory_module_event_tab = {
-	.name = "cxl_memory_module_event",
-	.fields = cxl_memory_module_event_fields,
-	.num_fields = ARRAY_SIZE(cxl_memory_module_event_fields),
-};
+#define ROLLUP_HOUR_NS	"3600000000000"
 
-int ras_store_cxl_memory_module_event(struct ras_events *ras,
-				      struct ras_cxl_memory_module_event *ev)
+static bool ras_mc_table_exists(struct sqlite3_priv *priv, const char *name)
 {
-	struct sqlite3_priv *priv = ras->db_priv;
-	int idx;
+	sqlite3_stmt *stmt;
+	bool exists = false;
+
+	if (sqlite3_prepare_v2(priv->db,
+			       "SELECT 1 FROM sqlite_master WHERE type='table' AND name=?",
+			       -1, &stmt, NULL) != SQLITE_OK)
+		return false;
+
+	sqlite3_bind_text(stmt, 1, name, -1, NULL);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		exists = true;
+	sqlite3_finalize(stmt);
+
+	return exists;
+}
+
+static int ras_mc_create_rollup(struct sqlite3_priv *priv,
+				const struct db_table_descriptor *db_tab)
+{
+	char keys[256], match[1024], values[512], rollup[128], sql[4096];
+	char *m = match, *v = values, *p = sql, *end = sql + sizeof(sql);
+	const char *tab = db_tab->name;
+	char *col, *saveptr;
 	int rc;
 
-	if (!priv || !priv->stmt_cxl_memory_module_event)
-		return -1;
-	log(TERM, LOG_INFO, "cxl_memory_module_event store: %p\n",
-	    priv->stmt_cxl_memory_module_event);
+	if (!db_tab->rollup)
+		return SQLITE_OK;
+
+	/* "a, b" gives "AND a IS NEW.a AND b IS NEW.b" and "NEW.a, NEW.b" */
+	strscpy(keys, db_tab->rollup, sizeof(keys));
+	*match = '\0';
+	*values = '\0';
+	for (col = strtok_r(keys, ", ", &saveptr); col;
+	     col = strtok_r(NULL, ", ", &saveptr)) {
+		m += snprintf(m, match + sizeof(match) - m,
+			      " AND %s IS NEW.%s", col, col);
+		v += snprintf(v, values + sizeof(values) - v,
+			      ", NEW.%s", col);
+	}
 
-	idx = ras_store_cxl_common_hdr(priv->stmt_cxl_memory_module_event, &ev->hdr);
-	if (idx <= 0)
-		return -1;
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->event_type);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->health_status);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->media_status);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->life_used);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->dirty_shutdown_cnt);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->cor_vol_err_cnt);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->cor_per_err_cnt);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->device_temp);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->add_status);
-	sqlite3_bind_int(priv->stmt_cxl_memory_module_event, idx++, ev->event_sub_type);
-	sqlite3_bind_blob(priv->stmt_cxl_memory_module_event, idx++, ev->comp_id,
-			  CXL_EVENT_GEN_MED_COMP_ID_SIZE, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_memory_module_event, idx++, ev->entity_id,
-			  CXL_PLDM_ENTITY_ID_LEN, NULL);
-	sqlite3_bind_blob(priv->stmt_cxl_memory_module_event, idx++, ev->res_id,
-			  CXL_PLDM_RES_ID_LEN, NULL);
-
-	rc = sqlite3_step(priv->stmt_cxl_memory_module_event);
-	if (rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do stmt_cxl_memory_module_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_cxl_memory_module_event);
-	if (rc != SQLITE_OK)
+	snprintf(rollup, sizeof(rollup), "%s_hourly", tab);
+	p += snprintf(p, end - p, "SAVEPOINT rollup; ");
+
+	if (!ras_mc_table_exists(priv, rollup))
+		p += snprintf(p, end - p,
+			      "CREATE TABLE %1$s (hour INTEGER, %2$s, events INTEGER); "
+			      "CREATE INDEX %1$s_key ON %1$s (hour, %2$s); "
+			      "INSERT INTO %1$s SELECT time_ns / " ROLLUP_HOUR_NS ", %2$s, %4$s "
+			      "FROM %3$s GROUP BY time_ns / " ROLLUP_HOUR_NS ", %2$s; ",
+			      rollup, db_tab->rollup, tab,
+			      db_tab->coalesce ? "sum(ifnull(occurrences, 1))" : "count(*)");
+
+	p += snprintf(p, end - p,
+		      "CREATE TRIGGER IF NOT EXISTS %3$s_rollup AFTER INSERT ON %3$s BEGIN "
+		      "UPDATE %1$s SET events = events + 1 "
+		      "WHERE hour IS NEW.time_ns / " ROLLUP_HOUR_NS "%2$s; "
+		      "INSERT INTO %1$s SELECT NEW.time_ns / " ROLLUP_HOUR_NS "%4$s, 1 "
+		      "WHERE changes() = 0; "
+		      "END; ",
+		      rollup, match, tab, values);
+
+	/* Coalesced events are counted at the hour of their first occurrence */
+	if (db_tab->coalesce)
+		p += snprintf(p, end - p,
+			      "CREATE TRIGGER IF NOT EXISTS %3$s_rollup_repeat "
+			      "AFTER UPDATE OF occurrences ON %3$s BEGIN "
+			      "UPDATE %1$s SET events = events + NEW.occurrences - ifnull(OLD.occurrences, 1) "
+			      "WHERE hour IS NEW.time_ns / " ROLLUP_HOUR_NS "%2$s; "
+			      "END; ",
+			      rollup, match, tab);
+
+	snprintf(p, end - p, "RELEASE rollup");
+
+#ifdef DEBUG_SQL
+	log(TERM, LOG_INFO, "SQL: %s\n", sql);
+#endif
+
+	rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		log(TERM, LOG_WARNING,
+		    "Failed to create rollup table %s on %s: error = %s\n",
+		    rollup, SQLITE_RAS_DB, sqlite3_errmsg(priv->db));
+		sqlite3_exec(priv->db, "ROLLBACK TO rollup; RELEASE rollup",
+			     NULL, NULL, NULL);
+	}
+
+	return rc;
+}
+
+static int ras_mc_alter_table(struct sqlite3_priv *priv,
+			      const struct db_table_descriptor *db_tab)
+{
+	char sql[1024], *p = sql, *end = sql + sizeof(sql);
+	const struct db_fields *field;
+	sqlite3_stmt *stmt;
+	int col_count, num_fields = db_num_fields(db_tab);
+	int i, j, rc, found;
+
+	snprintf(p, end - p, "SELECT * FROM %s", db_tab->name);
+	rc = sqlite3_prepare_v2(priv->db, sql, -1, &stmt, NULL);
+	if (rc != SQLITE_OK) {
 		log(TERM, LOG_ERR,
-		    "Failed reset stmt_cxl_memory_module_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		    "Failed to query fields from the table %s on %s: error = %d\n",
+		    db_tab->name, SQLITE_RAS_DB, rc);
+		return rc;
+	}
+
+	col_count = sqlite3_column_count(stmt);
+	for (i = 0; i < num_fields; i++) {
+		field = db_field(db_tab, i);
+		found = 0;
+		for (j = 0; j < col_count; j++) {
+			if (!strcmp(field->name,
+				    sqlite3_column_name(stmt, j))) {
+				found = 1;
+				break;
+			}
+		}
+
+		if (!found) {
+			/* add new field */
+			p += snprintf(p, end - p, "ALTER TABLE %s ADD ",
+				      db_tab->name);
+			p += snprintf(p, end - p,
+				      "%s %s", field->name, field->type);
+#ifdef DEBUG_SQL
+			log(TERM, LOG_INFO, "SQL: %s\n", sql);
+#endif
+			rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
+			if (rc != SQLITE_OK) {
+				log(TERM, LOG_ERR,
+				    "Failed to add new field %s to the table %s on %s: error = %d\n",
+				    field->name, db_tab->name,
+				    SQLITE_RAS_DB, rc);
+				break;
+			}
+			p = sql;
+			memset(sql, 0, sizeof(sql));
+
+			if (field == &time_fields[0])
+				ras_mc_fill_time(priv, db_tab);
+		}
+	}
+	sqlite3_finalize(stmt);
 
 	return rc;
 }
+
+/*
+ * Retention
+ *
+ * Events older than DB_RETENTION_DAYS, or DB_RETENTION_DAYS_<TABLE> for a
+ * given table, are deleted; their counts are kept by the hourly rollups.
+ * Tables without a rollup only expire with their own DB_RETENTION_DAYS_<TABLE>,
+ * as their counts would be lost.
+ * When the database gets bigger than DB_MAX_SIZE_MB, the oldest events are
+ * deleted, whatever table they are at.
+ *
+ * The decoder thread does it every DB_MAINT_INTERVAL_MS, deleting at most
+ * DB_DELETE_BATCH events and freeing at most DB_VACUUM_PAGES pages each
+ * time, so it never holds the event processing for long. While there's
+ * more to do, it runs again after DB_MAINT_BUSY_MS.
+ */
+
+#define DB_RETENTION_DAYS		"DB_RETENTION_DAYS"
+#define DB_MAX_SIZE_MB			"DB_MAX_SIZE_MB"
+#define DB_MAINT_INTERVAL_MS		60000
+#define DB_MAINT_BUSY_MS		100
+#define DB_DELETE_BATCH			1000
+#define DB_VACUUM_PAGES			"256"
+#define NS_PER_DAY			(86400ULL * 1000000000ULL)
+
+static void ras_mc_add_retention(struct sqlite3_priv *priv,
+				 const struct db_table_descriptor *db_tab)
+{
+	struct db_retention *t;
+	char name[128], *p;
+
+	t = realloc(priv->tables, (priv->n_tables + 1) * sizeof(*t));
+	if (!t)
+		return;
+	priv->tables = t;
+
+	/* e. g. DB_RETENTION_DAYS_MC_EVENT */
+	snprintf(name, sizeof(name), DB_RETENTION_DAYS "_%s", db_tab->name);
+	for (p = name + sizeof(DB_RETENTION_DAYS); *p; p++)
+		*p = toupper(*p);
+
+	t = &priv->tables[priv->n_tables++];
+	t->db_tab = db_tab;
+	t->keep_ns = get_env_uint(name, db_tab->rollup ? priv->retention_days : 0) *
+		     NS_PER_DAY;
+	if (t->keep_ns)
+		priv->maintain = true;
+}
+
+static int64_t db_pragma(struct sqlite3_priv *priv, const char *pragma)
+{
+	sqlite3_stmt *stmt;
+	int64_t val = -1;
+	char sql[64];
+
+	snprintf(sql, sizeof(sql), "PRAGMA %s", pragma);
+	if (sqlite3_prepare_v2(priv->db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		return -1;
+
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		val = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	return val;
+}
+
+/* Deletes a batch of the oldest events matching cond */
+static int db_delete_oldest(struct sqlite3_priv *priv,
+			    const struct db_table_descriptor *db_tab,
+			    const char *cond)
+{
+	char sql[512];
+	int rc;
+
+	snprintf(sql, sizeof(sql),
+		 "DELETE FROM %s WHERE rowid IN "
+		 "(SELECT rowid FROM %s %s ORDER BY time_ns LIMIT %d)",
+		 db_tab->name, db_tab->name, cond, DB_DELETE_BATCH);
+
+#ifdef DEBUG_SQL
+	log(TERM, LOG_INFO, "SQL: %s\n", sql);
 #endif
 
-#ifdef HAVE_SIGNAL
-static const struct db_fields signal_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",	.type = "TEXT" },
-	{ .name = "sig",		.type = "INTEGER" },
-	{ .name = "errorno",	.type = "INTEGER" },
-	{ .name = "code",		.type = "INTEGER" },
-	{ .name = "comm",		.type = "TEXT" },
-	{ .name = "pid",		.type = "INTEGER" },
-	{ .name = "grp",		.type = "INTEGER" },
-	{ .name = "res",		.type = "INTEGER" },
+	rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		log(TERM, LOG_WARNING,
+		    "Failed to delete old events from %s: error = %s\n",
+		    db_tab->name, sqlite3_errmsg(priv->db));
+		return 0;
+	}
 
-};
+	return sqlite3_changes(priv->db);
+}
 
-static const struct db_table_descriptor signal_event_tab = {
-	.name = "signal_event",
-	.fields = signal_event_fields,
-	.num_fields = ARRAY_SIZE(signal_event_fields),
-};
+/* Returns true if there are more expired events to delete */
+static bool db_expire(struct sqlite3_priv *priv)
+{
+	struct db_retention *t;
+	struct timespec ts;
+	char cond[64];
+	uint64_t now;
+	int i;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	now = timespec_ns(&ts);
+
+	for (i = 0; i < priv->n_tables; i++) {
+		t = &priv->tables[i];
+		if (!t->keep_ns || t->keep_ns > now)
+			continue;
+
+		snprintf(cond, sizeof(cond), "WHERE time_ns < %llu",
+			 (unsigned long long)(now - t->keep_ns));
+		if (db_delete_oldest(priv, t->db_tab, cond) == DB_DELETE_BATCH)
+			return true;
+	}
+
+	return false;
+}
+
+/* The table with the oldest event. Events without time_ns come first */
+static const struct db_table_descriptor *db_oldest_table(struct sqlite3_priv *priv)
+{
+	const struct db_table_descriptor *oldest = NULL;
+	sqlite3_stmt *stmt;
+	int64_t time, oldest_time = INT64_MAX;
+	char sql[256];
+	int i;
+
+	for (i = 0; i < priv->n_tables; i++) {
+		snprintf(sql, sizeof(sql),
+			 "SELECT time_ns FROM %s ORDER BY time_ns LIMIT 1",
+			 priv->tables[i].db_tab->name);
+		if (sqlite3_prepare_v2(priv->db, sql, -1, &stmt, NULL) != SQLITE_OK)
+			continue;
+
+		if (sqlite3_step(stmt) == SQLITE_ROW) {
+			if (sqlite3_column_type(stmt, 0) == SQLITE_NULL)
+				time = INT64_MIN;
+			else
+				time = sqlite3_column_int64(stmt, 0);
+
+			if (!oldest || time < oldest_time) {
+				oldest = priv->tables[i].db_tab;
+				oldest_time = time;
+			}
+		}
+		sqlite3_finalize(stmt);
+	}
+
+	return oldest;
+}
+
+/* Returns true if the database is still over its size limit */
+static bool db_shrink(struct sqlite3_priv *priv)
+{
+	const struct db_table_descriptor *db_tab;
+	int64_t used;
+
+	if (!priv->max_size)
+		return false;
+
+	used = (db_pragma(priv, "page_count") - db_pragma(priv, "freelist_count")) *
+	       db_pragma(priv, "page_size");
+	if (used <= priv->max_size) {
+		priv->shrinking = false;
+		return false;
+	}
+
+	db_tab = db_oldest_table(priv);
+	if (!db_tab)
+		return false;
+
+	if (!priv->shrinking)
+		log(ALL, LOG_WARNING,
+		    "Database is over %llu MB. Deleting the oldest events\n",
+		    (unsigned long long)priv->max_size >> 20);
+	priv->shrinking = true;
+
+	return db_delete_oldest(priv, db_tab, "") > 0;
+}
+
+/*
+ * Deleted pages are only given back to the filesystem with incremental
+ * auto vacuum. New databases get it when created. Switching an existing
+ * one needs a VACUUM, which rewrites the whole database and needs about
+ * its size in free disk space, so it is only done with DB_VACUUM=yes,
+ * when the database is opened, before any event is read.
+ */
+#define DB_VACUUM			"DB_VACUUM"
 
-int ras_store_signal_event(struct ras_events *ras, struct ras_signal_event *ev)
+static void db_setup_vacuum(struct sqlite3_priv *priv)
 {
+	char *env = getenv(DB_VACUUM);
 	int rc;
+
+	if (db_pragma(priv, "auto_vacuum") == 2) {
+		priv->incremental = true;
+		return;
+	}
+
+	if (!env || strcasecmp(env, "yes")) {
+		log(ALL, LOG_INFO,
+		    "The space of the deleted events is reused, but not given back. Set %s=yes to convert %s to incremental vacuum\n",
+		    DB_VACUUM, SQLITE_RAS_DB);
+		return;
+	}
+
+	log(ALL, LOG_INFO, "Converting %s to incremental vacuum\n",
+	    SQLITE_RAS_DB);
+	rc = sqlite3_exec(priv->db, "PRAGMA auto_vacuum=INCREMENTAL", NULL, NULL, NULL);
+	if (rc == SQLITE_OK)
+		rc = sqlite3_exec(priv->db, "VACUUM", NULL, NULL, NULL);
+	if (rc != SQLITE_OK) {
+		log(ALL, LOG_WARNING,
+		    "Failed to enable incremental vacuum on %s: error = %s\n",
+		    SQLITE_RAS_DB, sqlite3_errmsg(priv->db));
+		return;
+	}
+
+	priv->incremental = db_pragma(priv, "auto_vacuum") == 2;
+}
+
+/*
+ * Called by the decoder thread. Returns the time, in ms, until it should
+ * be called again, or -1 if there's no retention.
+ */
+int ras_db_maintain(struct ras_events *ras)
+{
 	struct sqlite3_priv *priv = ras->db_priv;
+	struct timespec now;
+	long ms;
+	bool more;
 
-	if (!priv || !priv->stmt_signal_event)
+	if (!priv || !priv->maintain)
 		return -1;
-	log(TERM, LOG_INFO, "signal_event store: %p\n", priv->stmt_signal_event);
-
-	sqlite3_bind_text(priv->stmt_signal_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_int(priv->stmt_signal_event,  2, ev->sig);
-	sqlite3_bind_int(priv->stmt_signal_event,  3, ev->error_no);
-	sqlite3_bind_int(priv->stmt_signal_event,  4, ev->code);
-	sqlite3_bind_text(priv->stmt_signal_event, 5, ev->comm, -1, NULL);
-	sqlite3_bind_int(priv->stmt_signal_event,  6, ev->pid);
-	sqlite3_bind_int(priv->stmt_signal_event,  7, ev->group);
-	sqlite3_bind_int(priv->stmt_signal_event,  8, ev->result);
-
-	rc = sqlite3_step(priv->stmt_signal_event);
-	if (rc != SQLITE_OK && rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do signal_event step on sqlite: error = %d\n", rc);
 
-	rc = sqlite3_reset(priv->stmt_signal_event);
-	if (rc != SQLITE_OK && rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed reset signal_event on sqlite: error = %d\n",
-		    rc);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (priv->next_maint.tv_sec - now.tv_sec) * 1000 +
+	     (priv->next_maint.tv_nsec - now.tv_nsec) / 1000000;
+	if (ms > 0)
+		return ms;
+
+	/* Deletions are committed on their own */
+	db_commit(priv);
+
+	more = db_expire(priv);
+	more |= db_shrink(priv);
+
+	/* Without incremental vacuum, the free pages are only reused */
+	if (priv->incremental && db_pragma(priv, "freelist_count") > 0) {
+		sqlite3_exec(priv->db,
+			     "PRAGMA incremental_vacuum(" DB_VACUUM_PAGES ")",
+			     NULL, NULL, NULL);
+		more |= db_pragma(priv, "freelist_count") > 0;
+	}
 
-	log(TERM, LOG_INFO, "register inserted at db\n");
+	ms = more ? DB_MAINT_BUSY_MS : DB_MAINT_INTERVAL_MS;
+	priv->next_maint.tv_sec = now.tv_sec + ms / 1000;
+	priv->next_maint.tv_nsec = now.tv_nsec + (ms % 1000) * 1000000;
+	if (priv->next_maint.tv_nsec >= 1000000000L) {
+		priv->next_maint.tv_sec++;
+		priv->next_maint.tv_nsec -= 1000000000L;
+	}
 
-	return rc;
+	return ms;
 }
-#endif
 
 /*
- * Table and functions to handle ras:reri_event
+ * Schema versions
+ *
+ * PRAGMA user_version has DB_SCHEMA_VERSION, the version of what is added
+ * to every table: the time columns, the indexes and the rollups. The
+ * schema_version table has a hash of the columns of each event table.
+ * Tables are only created or migrated when those don't match, in a
+ * transaction that adds the missing columns, fills them and creates the
+ * indexes and the rollup. Otherwise, opening the database just prepares
+ * the insert statements.
  */
 
-#ifdef HAVE_RERI
-static const struct db_fields reri_event_fields[] = {
-	{ .name = "id",			.type = "INTEGER PRIMARY KEY" },
-	{ .name = "timestamp",		.type = "TEXT" },
-	{ .name = "err_src_id",		.type = "INTEGER" },
-	{ .name = "source_type",	.type = "INTEGER" },
-	{ .name = "severity",		.type = "INTEGER" },
-	{ .name = "hart_id",		.type = "INTEGER" },
-	{ .name = "cluster_id",		.type = "INTEGER" },
-	{ .name = "status",		.type = "INTEGER" },
-	{ .name = "addr_info",		.type = "INTEGER" },
-	{ .name = "info",		.type = "INTEGER" },
-	{ .name = "suppl_info",		.type = "INTEGER" },
-	{ .name = "timestamp_val",	.type = "INTEGER" },
-};
-
-static const struct db_table_descriptor reri_event_tab = {
-	.name = "reri_event",
-	.fields = reri_event_fields,
-	.num_fields = ARRAY_SIZE(reri_event_fields),
-};
+#define DB_SCHEMA_VERSION	1
 
-int ras_store_reri_event(struct ras_events *ras, struct ras_reri_event *ev)
+static uint64_t db_table_hash(const struct db_table_descriptor *db_tab)
 {
-	int rc;
-	struct sqlite3_priv *priv = ras->db_priv;
+	uint64_t hash = 0xcbf29ce484222325ULL;	/* FNV-1a */
+	const struct db_fields *field;
+	const char *s[3];
+	int i, j, n;
+
+	for (i = 0; i <= db_num_fields(db_tab); i++) {
+		if (i < db_num_fields(db_tab)) {
+			field = db_field(db_tab, i);
+			s[0] = field->name;
+			s[1] = field->type;
+			n = 2;
+		} else {
+			s[0] = db_tab->rollup ? db_tab->rollup : "";
+			n = 1;
+		}
 
-	if (!priv || !priv->stmt_reri_event)
-		return 0;
-	log(TERM, LOG_INFO, "reri_event store: %p\n", priv->stmt_reri_event);
-
-	sqlite3_bind_text(priv->stmt_reri_event,  1, ev->timestamp, -1, NULL);
-	sqlite3_bind_int(priv->stmt_reri_event,  2, ev->err_src_id);
-	sqlite3_bind_int(priv->stmt_reri_event,  3, ev->source_type);
-	sqlite3_bind_int(priv->stmt_reri_event,  4, ev->severity);
-	sqlite3_bind_int(priv->stmt_reri_event,  5, ev->hart_id);
-	sqlite3_bind_int(priv->stmt_reri_event,  6, ev->cluster_id);
-	sqlite3_bind_int64(priv->stmt_reri_event,  7, ev->status);
-	sqlite3_bind_int64(priv->stmt_reri_event,  8, ev->addr_info);
-	sqlite3_bind_int64(priv->stmt_reri_event,  9, ev->info);
-	sqlite3_bind_int64(priv->stmt_reri_event, 10, ev->suppl_info);
-	sqlite3_bind_int64(priv->stmt_reri_event, 11, ev->timestamp_val);
-
-	rc = sqlite3_step(priv->stmt_reri_event);
-	if (rc != SQLITE_OK && rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed to do reri_event step on sqlite: error = %d\n", rc);
-	rc = sqlite3_reset(priv->stmt_reri_event);
-	if (rc != SQLITE_OK && rc != SQLITE_DONE)
-		log(TERM, LOG_ERR,
-		    "Failed reset reri_event on sqlite: error = %d\n", rc);
-	log(TERM, LOG_INFO, "register inserted at db\n");
+		/* Including the terminating NUL, as a separator */
+		for (j = 0; j < n; j++) {
+			do {
+				hash ^= (unsigned char)*s[j];
+				hash *= 0x100000001b3ULL;
+			} while (*s[j]++);
+		}
+	}
 
-	return rc;
+	return hash;
 }
-#endif
-
-/*
- * Generic code
- */
-static int __ras_mc_prepare_stmt(struct sqlite3_priv *priv,
-				 sqlite3_stmt **stmt,
-				 const struct db_table_descriptor *db_tab)
 
+static bool ras_mc_schema_current(struct sqlite3_priv *priv,
+				  const struct db_table_descriptor *db_tab)
 {
-	int i, rc;
-	char sql[1024], *p = sql, *end = sql + sizeof(sql);
-	const struct db_fields *field;
+	sqlite3_stmt *stmt;
+	bool current = false;
 
-	p += snprintf(p, end - p, "INSERT INTO %s (",
-		      db_tab->name);
+	if (!priv->schema_current)
+		return false;
 
-	for (i = 0; i < db_tab->num_fields; i++) {
-		field = &db_tab->fields[i];
-		p += snprintf(p, end - p, "%s", field->name);
+	if (sqlite3_prepare_v2(priv->db,
+			       "SELECT hash FROM schema_version WHERE name=?",
+			       -1, &stmt, NULL) != SQLITE_OK)
+		return false;
 
-		if (i < db_tab->num_fields - 1)
-			p += snprintf(p, end - p, ", ");
-	}
+	sqlite3_bind_text(stmt, 1, db_tab->name, -1, NULL);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		current = (uint64_t)sqlite3_column_int64(stmt, 0) ==
+			  db_table_hash(db_tab);
+	sqlite3_finalize(stmt);
 
-	p += snprintf(p, end - p, ") VALUES ( NULL, ");
+	return current;
+}
 
-	for (i = 1; i < db_tab->num_fields; i++) {
-		if (i <  db_tab->num_fields - 1)
-			strscat(sql, "?, ", sizeof(sql));
-		else
-			strscat(sql, "?)", sizeof(sql));
-	}
+static int ras_mc_set_schema(struct sqlite3_priv *priv,
+			     const struct db_table_descriptor *db_tab)
+{
+	sqlite3_stmt *stmt;
+	struct timespec ts;
+	int rc;
 
-#ifdef DEBUG_SQL
-	log(TERM, LOG_INFO, "SQL: %s\n", sql);
-#endif
+	rc = sqlite3_prepare_v2(priv->db,
+				"INSERT OR REPLACE INTO schema_version (name, hash, time_ns) VALUES (?, ?, ?)",
+				-1, &stmt, NULL);
+	if (rc != SQLITE_OK)
+		return rc;
 
-	rc = sqlite3_prepare_v2(priv->db, sql, -1, stmt, NULL);
-	if (rc != SQLITE_OK) {
-		log(TERM, LOG_ERR,
-		    "Failed to prepare insert db at table %s (db %s): error = %s\n",
-		    db_tab->name, SQLITE_RAS_DB, sqlite3_errmsg(priv->db));
-		stmt = NULL;
-	} else {
-		log(TERM, LOG_INFO, "Recording %s events\n", db_tab->name);
-	}
+	clock_gettime(CLOCK_REALTIME, &ts);
+	sqlite3_bind_text(stmt, 1, db_tab->name, -1, NULL);
+	sqlite3_bind_int64(stmt, 2, db_table_hash(db_tab));
+	sqlite3_bind_int64(stmt, 3, timespec_ns(&ts));
+	rc = sqlite3_step(stmt);
+	sqlite3_finalize(stmt);
 
-	return rc;
+	return rc == SQLITE_DONE ? SQLITE_OK : rc;
 }
 
-static int ras_mc_create_table(struct sqlite3_priv *priv,
-			       const struct db_table_descriptor *db_tab)
+static int ras_mc_migrate_table(struct sqlite3_priv *priv,
+				const struct db_table_descriptor *db_tab)
 {
-	const struct db_fields *field;
-	char sql[1024], *p = sql, *end = sql + sizeof(sql);
-	int i, rc;
-
-	p += snprintf(p, end - p, "CREATE TABLE IF NOT EXISTS %s (",
-		      db_tab->name);
+	bool complete;
+	int rc;
 
-	for (i = 0; i < db_tab->num_fields; i++) {
-		field = &db_tab->fields[i];
-		p += snprintf(p, end - p, "%s %s", field->name, field->type);
+	rc = sqlite3_exec(priv->db, "SAVEPOINT migrate", NULL, NULL, NULL);
+	if (rc != SQLITE_OK)
+		return rc;
 
-		if (i < db_tab->num_fields - 1)
-			p += snprintf(p, end - p, ", ");
+	rc = __ras_mc_create_table(priv, db_tab);
+	if (rc == SQLITE_OK)
+		rc = ras_mc_alter_table(priv, db_tab);
+	if (rc == SQLITE_OK) {
+		/*
+		 * The table can be used without its indexes and rollup, but
+		 * its schema is only recorded with them, so that they're
+		 * tried again at the next start.
+		 */
+		complete = ras_mc_create_indexes(priv, db_tab) == SQLITE_OK;
+		if (ras_mc_create_rollup(priv, db_tab) != SQLITE_OK)
+			complete = false;
+		if (complete)
+			rc = ras_mc_set_schema(priv, db_tab);
 	}
-	p += snprintf(p, end - p, ")");
-
-#ifdef DEBUG_SQL
-	log(TERM, LOG_INFO, "SQL: %s\n", sql);
-#endif
 
-	rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
 	if (rc != SQLITE_OK) {
 		log(TERM, LOG_ERR,
-		    "Failed to create table %s on %s: error = %d\n",
-		    db_tab->name, SQLITE_RAS_DB, rc);
+		    "Failed to migrate table %s on %s: error = %s\n",
+		    db_tab->name, SQLITE_RAS_DB, sqlite3_errmsg(priv->db));
+		sqlite3_exec(priv->db, "ROLLBACK TO migrate", NULL, NULL, NULL);
+	} else if (complete) {
+		log(TERM, LOG_INFO, "Updated the schema of table %s\n",
+		    db_tab->name);
 	}
+	sqlite3_exec(priv->db, "RELEASE migrate", NULL, NULL, NULL);
+
 	return rc;
 }
 
-static int ras_mc_alter_table(struct sqlite3_priv *priv,
-			      sqlite3_stmt **stmt,
-			      const struct db_table_descriptor *db_tab)
+static int ras_mc_create_table(struct sqlite3_priv *priv,
+			       const struct db_table_descriptor *db_tab)
 {
-	char sql[1024], *p = sql, *end = sql + sizeof(sql);
-	const struct db_fields *field;
-	int col_count;
-	int i, j, rc, found;
-
-	snprintf(p, end - p, "SELECT * FROM %s", db_tab->name);
-	rc = sqlite3_prepare_v2(priv->db, sql, -1, stmt, NULL);
-	if (rc != SQLITE_OK) {
-		log(TERM, LOG_ERR,
-		    "Failed to query fields from the table %s on %s: error = %d\n",
-		    db_tab->name, SQLITE_RAS_DB, rc);
-		return rc;
-	}
-
-	col_count = sqlite3_column_count(*stmt);
-	for (i = 0; i < db_tab->num_fields; i++) {
-		field = &db_tab->fields[i];
-		found = 0;
-		for (j = 0; j < col_count; j++) {
-			if (!strcmp(field->name,
-				    sqlite3_column_name(*stmt, j))) {
-				found = 1;
-				break;
-			}
-		}
-
-		if (!found) {
-			/* add new field */
-			p += snprintf(p, end - p, "ALTER TABLE %s ADD ",
-				      db_tab->name);
-			p += snprintf(p, end - p,
-				      "%s %s", field->name, field->type);
-#ifdef DEBUG_SQL
-			log(TERM, LOG_INFO, "SQL: %s\n", sql);
-#endif
-			rc = sqlite3_exec(priv->db, sql, NULL, NULL, NULL);
-			if (rc != SQLITE_OK) {
-				log(TERM, LOG_ERR,
-				    "Failed to add new field %s to the table %s on %s: error = %d\n",
-				    field->name, db_tab->name,
-				    SQLITE_RAS_DB, rc);
-				return rc;
-			}
-			p = sql;
-			memset(sql, 0, sizeof(sql));
-		}
-	}
+	if (ras_mc_schema_current(priv, db_tab))
+		return SQLITE_OK;
 
-	return rc;
+	return ras_mc_migrate_table(priv, db_tab);
 }
 
 static int ras_mc_prepare_stmt(struct sqlite3_priv *priv,
@@ -1419,26 +1693,21 @@ static int ras_mc_prepare_stmt(struct sqlite3_priv *priv,
 
 	rc = __ras_mc_prepare_stmt(priv, stmt, db_tab);
 	if (rc != SQLITE_OK) {
-		log(TERM, LOG_ERR,
-		    "Failed to prepare insert db at table %s (db %s): error = %s\n",
-		    db_tab->name, SQLITE_RAS_DB, sqlite3_errmsg(priv->db));
-
-		log(TERM, LOG_INFO, "Trying to alter db at table %s (db %s)\n",
+		/* The table was changed behind our back */
+		log(TERM, LOG_INFO, "Trying to migrate db at table %s (db %s)\n",
 		    db_tab->name, SQLITE_RAS_DB);
 
-		rc = ras_mc_alter_table(priv, stmt, db_tab);
-		if (rc != SQLITE_OK && rc != SQLITE_DONE) {
-			log(TERM, LOG_ERR,
-			    "Failed to alter db at table %s (db %s): error = %s\n",
-			    db_tab->name, SQLITE_RAS_DB,
-			    sqlite3_errmsg(priv->db));
-			stmt = NULL;
-			return rc;
-		}
-
-		rc = __ras_mc_prepare_stmt(priv, stmt, db_tab);
+		rc = ras_mc_migrate_table(priv, db_tab);
+		if (rc == SQLITE_OK)
+			rc = __ras_mc_prepare_stmt(priv, stmt, db_tab);
 	}
 
+	if (rc == SQLITE_OK && db_tab->coalesce)
+		rc = db_coalesce_prepare(priv, db_tab);
+
+	if (rc == SQLITE_OK)
+		ras_mc_add_retention(priv, db_tab);
+
 	return rc;
 }
 
@@ -1449,6 +1718,10 @@ int ras_mc_add_vendor_table(struct ras_events *ras,
 	int rc;
 	struct sqlite3_priv *priv = ras->db_priv;
 
+	/* Only vendor events with a table descriptor go to the event log */
+	if (ras_binlog_active())
+		return 0;
+
 	if (!priv)
 		return -1;
 
@@ -1471,10 +1744,289 @@ int ras_mc_finalize_vendor_table(sqlite3_stmt *stmt)
 	return rc;
 }
 
+/* Inserts the row bound by a vendor decoder, and clears its bindings */
+int ras_mc_store_vendor_record(sqlite3_stmt *stmt, const char *name)
+{
+	int rc, ret = SQLITE_OK;
+
+	if (!stmt)
+		return 0;
+
+	/* The time columns are the last ones */
+	db_bind_time(stmt, sqlite3_bind_parameter_count(stmt) -
+		     ARRAY_SIZE(time_fields) + 1);
+
+	rc = sqlite3_step(stmt);
+	if (rc != SQLITE_DONE) {
+		log(TERM, LOG_ERR,
+		    "Failed to do %s step on sqlite: error = %d\n", name, rc);
+		ras_stats_drop(RAS_DROP_DB, -1, NON_STANDARD_EVENT, 1);
+		ret = rc;
+	}
+
+	rc = sqlite3_reset(stmt);
+	if (rc != SQLITE_OK)
+		log(TERM, LOG_ERR,
+		    "Failed to reset %s on sqlite: error = %d\n", name, rc);
+
+	rc = sqlite3_clear_bindings(stmt);
+	if (rc != SQLITE_OK)
+		log(TERM, LOG_ERR,
+		    "Failed to clear bindings %s on sqlite: error = %d\n",
+		    name, rc);
+
+	return ret;
+}
+
+/* Stores a vendor event struct, whose table describes its columns */
+int ras_mc_store_vendor_event(sqlite3_stmt *stmt,
+			      const struct db_table_descriptor *db_tab,
+			      const void *ev)
+{
+	uint64_t boot_ns, wall_ns;
+	int rc;
+
+	if (ras_binlog_active()) {
+		ras_db_event_time(&boot_ns, &wall_ns);
+		rc = ras_binlog_store(db_tab, ev, wall_ns, boot_ns, false);
+		if (rc)
+			ras_stats_drop(RAS_DROP_DB, -1, NON_STANDARD_EVENT, 1);
+		return rc;
+	}
+
+	if (!stmt)
+		return 0;
+
+	db_bind_fields(stmt, db_tab, ev);
+
+	return ras_mc_store_vendor_record(stmt, db_tab->name);
+}
+
+/* Binds the columns of @tab from the values packed at the staging ring */
+static int db_bind_packed(sqlite3_stmt *stmt,
+			  const struct db_table_descriptor *tab,
+			  const char *p, const char *end)
+{
+	const struct db_fields *field;
+	const void *data;
+	int64_t val;
+	size_t len;
+	int i;
+
+	/* Column 0 is the row id */
+	for (i = 1; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+
+		p = ras_event_unpack(field, p, end, &val, &data, &len);
+		if (!p)
+			return -EINVAL;
+
+		switch (field->bind) {
+		case DB_BIND_INT:
+			sqlite3_bind_int64(stmt, i, val);
+			break;
+		case DB_BIND_TEXT:
+		case DB_BIND_STR:
+			sqlite3_bind_text(stmt, i, data, len, NULL);
+			break;
+		case DB_BIND_BLOB:
+		case DB_BIND_BLOB_PTR:
+		case DB_BIND_BLOB_LEN:
+			sqlite3_bind_blob(stmt, i, data, len, NULL);
+			break;
+		default:
+			sqlite3_bind_null(stmt, i);
+			break;
+		}
+	}
+
+	return 0;
+}
+
+struct db_replay_row {
+	uint64_t	pos;
+	int64_t		rowid;
+};
+
+struct db_replay {
+	struct sqlite3_priv	*priv;
+	sqlite3_stmt		**stmts;	/* One per registered table */
+	uint64_t		from;
+
+	/* Rows stored for the events of tables with .coalesce, by position */
+	struct db_replay_row	*rows;
+	unsigned int		n_rows, max_rows;
+};
+
+static void db_replay_add_row(struct db_replay *replay, uint64_t pos,
+			      int64_t rowid)
+{
+	struct db_replay_row *rows;
+	unsigned int max;
+
+	if (replay->n_rows == replay->max_rows) {
+		max = replay->max_rows ? replay->max_rows * 2 : 64;
+		rows = realloc(replay->rows, max * sizeof(*rows));
+		if (!rows)
+			return;
+		replay->rows = rows;
+		replay->max_rows = max;
+	}
+
+	replay->rows[replay->n_rows].pos = pos;
+	replay->rows[replay->n_rows].rowid = rowid;
+	replay->n_rows++;
+}
+
+static int64_t db_replay_rowid(struct db_replay *replay, uint64_t pos)
+{
+	unsigned int lo = 0, hi = replay->n_rows, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (replay->rows[mid].pos == pos)
+			return replay->rows[mid].rowid;
+		if (replay->rows[mid].pos < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return 0;
+}
+
+/* Updates the row of the first one, as db_coalesce_flush() would */
+static int db_replay_repeat(struct db_replay *replay,
+			    const struct db_table_descriptor *tab,
+			    const struct staging_record *rec)
+{
+	struct sqlite3_priv *priv = replay->priv;
+	struct staging_repeat rep;
+	sqlite3_stmt *stmt;
+	int rc = 0;
+
+	if (rec->len != sizeof(rep))
+		return -EINVAL;
+	memcpy(&rep, rec->data, sizeof(rep));
+
+	/* Stored again by this replay, maybe at another row */
+	if (rep.first >= replay->from)
+		rep.rowid = db_replay_rowid(replay, rep.first);
+
+	stmt = db_coalesce_stmt(priv, tab);
+	if (!stmt || !rep.rowid)
+		return -ENOENT;
+
+	sqlite3_bind_int64(stmt, 1, rec->time_ns);
+	sqlite3_bind_int64(stmt, 2, rep.count);
+	sqlite3_bind_int64(stmt, 3, rep.rowid);
+	if (sqlite3_step(stmt) != SQLITE_DONE)
+		rc = -EIO;
+	sqlite3_reset(stmt);
+
+	return rc;
+}
+
+static int db_replay_event(void *arg, const struct staging_record *rec)
+{
+	struct db_replay *replay = arg;
+	struct sqlite3_priv *priv = replay->priv;
+	const struct db_table_descriptor *tab;
+	sqlite3_stmt **stmt;
+	unsigned int i;
+	int rc;
+
+	for (i = 0; i < priv->n_tables; i++)
+		if (!strcmp(priv->tables[i].db_tab->name, rec->table))
+			break;
+	if (i == priv->n_tables)
+		return -ENOENT;
+
+	tab = priv->tables[i].db_tab;
+	if (rec->repeat)
+		return db_replay_repeat(replay, tab, rec);
+
+	stmt = &replay->stmts[i];
+	if (!*stmt && __ras_mc_prepare_stmt(priv, stmt, tab) != SQLITE_OK)
+		return -EIO;
+
+	rc = db_bind_packed(*stmt, tab, rec->data, rec->data + rec->len);
+	if (!rc) {
+		db_bind_row_time(*stmt, tab, rec->time_ns, rec->boot_ns);
+		if (sqlite3_step(*stmt) != SQLITE_DONE)
+			rc = -EIO;
+		else if (tab->coalesce)
+			db_replay_add_row(replay, rec->pos,
+					  sqlite3_last_insert_rowid(priv->db));
+	}
+	sqlite3_reset(*stmt);
+	sqlite3_clear_bindings(*stmt);
+
+	return rc;
+}
+
+/* Opens the staging ring, and stores the events a crash left there */
+static void ras_mc_open_staging(struct sqlite3_priv *priv)
+{
+	struct db_replay replay = { .priv = priv };
+	sqlite3_stmt *stmt;
+	uint64_t from = 0;
+	unsigned int i;
+	int rc, n;
+
+	if (ras_staging_open())
+		return;
+
+	rc = sqlite3_exec(priv->db,
+			  "CREATE TABLE IF NOT EXISTS staging_ack "
+			  "(id INTEGER PRIMARY KEY, ring INTEGER, pos INTEGER)",
+			  NULL, NULL, NULL);
+	if (rc == SQLITE_OK)
+		rc = sqlite3_prepare_v2(priv->db,
+					"INSERT OR REPLACE INTO staging_ack VALUES (0, ?, ?)",
+					-1, &priv->stmt_staging, NULL);
+	if (rc != SQLITE_OK) {
+		log(TERM, LOG_ERR,
+		    "Failed to create staging_ack on sqlite: error = %d\n", rc);
+		ras_staging_close();
+		return;
+	}
+
+	/* Events before the position of the last commit are stored already */
+	rc = sqlite3_prepare_v2(priv->db,
+				"SELECT ring, pos FROM staging_ack WHERE id = 0",
+				-1, &stmt, NULL);
+	if (rc == SQLITE_OK) {
+		if (sqlite3_step(stmt) == SQLITE_ROW &&
+		    sqlite3_column_int64(stmt, 0) == ras_staging_id())
+			from = sqlite3_column_int64(stmt, 1);
+		sqlite3_finalize(stmt);
+	}
+
+	replay.stmts = calloc(priv->n_tables, sizeof(*replay.stmts));
+	if (!replay.stmts)
+		return;
+
+	replay.from = from;
+	db_begin(priv);
+	n = ras_staging_replay(from, db_replay_event, &replay);
+	db_commit(priv);
+
+	for (i = 0; i < priv->n_tables; i++)
+		sqlite3_finalize(replay.stmts[i]);
+	free(replay.stmts);
+	free(replay.rows);
+
+	if (n > 0)
+		log(ALL, LOG_INFO,
+		    "Stored %d events left at the staging ring\n", n);
+}
+
 int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras)
 {
 	int rc;
-	sqlite3 *db;
+	sqlite3 *db = NULL;
+	sqlite3_stmt *stmt;
 	struct sqlite3_priv *priv;
 
 	printf("Calling %s()\n", __func__);
@@ -1485,6 +2037,12 @@ int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras)
 
 	ras->db_priv = NULL;
 
+	/* Either to the database or to the binary event log */
+	ras_sink_register(&db_sink);
+
+	if (ras_binlog_configured())
+		return ras_binlog_open() ? -1 : 0;
+
 	priv = calloc(1, sizeof(*priv));
 	if (!priv)
 		return -1;
@@ -1514,21 +2072,76 @@ int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras)
 	}
 
 	do {
+		/* Only used by the event decoder thread */
 		rc = sqlite3_open_v2(SQLITE_RAS_DB, &db,
-				     SQLITE_OPEN_FULLMUTEX |
+				     SQLITE_OPEN_NOMUTEX |
 				     SQLITE_OPEN_READWRITE |
 				     SQLITE_OPEN_CREATE, NULL);
 		if (rc == SQLITE_BUSY)
 			usleep(10000);
 	} while (rc == SQLITE_BUSY);
 
+	/* Even on failure, there may be a handle to be closed */
+	priv->db = db;
 	if (rc != SQLITE_OK) {
 		log(TERM, LOG_ERR,
 		    "cpu %u: Failed to connect to %s: error = %d\n",
 		    cpu, SQLITE_RAS_DB, rc);
 		goto error;
 	}
-	priv->db = db;
+
+	/*
+	 * A new database gets incremental vacuum, so the space of the
+	 * deleted events can be given back. It should be set before the
+	 * database file is written, even by enabling WAL.
+	 */
+	if (db_pragma(priv, "page_count") == 0)
+		sqlite3_exec(db, "PRAGMA auto_vacuum=INCREMENTAL", NULL, NULL, NULL);
+
+	/*
+	 * With WAL, commits only append to the log, and ras-mc-ctl can read
+	 * the database while events are being stored.
+	 */
+	rc = sqlite3_exec(db, "PRAGMA journal_mode=WAL", NULL, NULL, NULL);
+	if (rc != SQLITE_OK)
+		log(TERM, LOG_WARNING,
+		    "cpu %u: Failed to enable WAL on %s: error = %d\n",
+		    cpu, SQLITE_RAS_DB, rc);
+	sqlite3_busy_timeout(db, DB_BUSY_TIMEOUT_MS);
+
+	priv->commit_count = get_env_uint(DB_COMMIT_COUNT,
+					  DEFAULT_COMMIT_COUNT);
+	if (!priv->commit_count)
+		priv->commit_count = 1;
+	priv->commit_interval = get_env_uint(DB_COMMIT_INTERVAL_MS,
+					     DEFAULT_COMMIT_INTERVAL_MS);
+	priv->schema_current = db_pragma(priv, "user_version") == DB_SCHEMA_VERSION;
+	if (!priv->schema_current) {
+		rc = sqlite3_exec(db,
+				  "CREATE TABLE IF NOT EXISTS schema_version "
+				  "(name TEXT PRIMARY KEY, hash INTEGER, time_ns INTEGER)",
+				  NULL, NULL, NULL);
+		if (rc != SQLITE_OK) {
+			log(TERM, LOG_ERR,
+			    "cpu %u: Failed to create schema_version on %s: error = %d\n",
+			    cpu, SQLITE_RAS_DB, rc);
+			goto error;
+		}
+	}
+
+	priv->coalesce_ns = get_env_uint(DB_COALESCE_MS, 0) * 1000000ULL;
+	priv->retention_days = get_env_uint(DB_RETENTION_DAYS, 0);
+	priv->max_size = (uint64_t)get_env_uint(DB_MAX_SIZE_MB, 0) << 20;
+	if (priv->max_size)
+		priv->maintain = true;
+
+	rc = ras_mc_create_table(priv, &lost_event_tab);
+	if (rc == SQLITE_OK) {
+		rc = ras_mc_prepare_stmt(priv, &priv->stmt_lost_event,
+					 &lost_event_tab);
+		if (rc != SQLITE_OK)
+			goto error;
+	}
 
 	rc = ras_mc_create_table(priv, &mc_event_tab);
 	if (rc == SQLITE_OK) {
@@ -1703,16 +2316,38 @@ int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras)
 	}
 #endif
 
+	if (priv->maintain)
+		db_setup_vacuum(priv);
+
+	ras_mc_open_staging(priv);
+
+	if (!priv->schema_current) {
+		char sql[64];
+
+		snprintf(sql, sizeof(sql), "PRAGMA user_version = %d",
+			 DB_SCHEMA_VERSION);
+		sqlite3_exec(db, sql, NULL, NULL, NULL);
+	}
+
 	ras->db_priv = priv;
 	return 0;
 
 error:
+	if (priv->db) {
+		/* The statements prepared before the failure */
+		while ((stmt = sqlite3_next_stmt(priv->db, NULL)))
+			sqlite3_finalize(stmt);
+		sqlite3_close(priv->db);
+	}
+	free(priv->tables);
 	free(priv);
+	ras->db_ref_count--;
 	return -1;
 }
 
 int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras)
 {
+	unsigned int i;
 	int rc;
 	sqlite3 *db;
 	struct sqlite3_priv *priv = ras->db_priv;
@@ -1726,6 +2361,11 @@ int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras)
 	if (ras->db_ref_count > 0)
 		return 0;
 
+	if (ras_binlog_active()) {
+		ras_binlog_close();
+		return 0;
+	}
+
 	if (!priv)
 		return -1;
 
@@ -1733,6 +2373,16 @@ int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras)
 	if (!db)
 		return -1;
 
+	db_commit(priv);
+
+	if (priv->stmt_lost_event) {
+		rc = sqlite3_finalize(priv->stmt_lost_event);
+		if (rc != SQLITE_OK)
+			log(TERM, LOG_ERR,
+			    "cpu %u: Failed to finalize lost_event sqlite: error = %d\n",
+			    cpu, rc);
+	}
+
 	if (priv->stmt_mc_event) {
 		rc = sqlite3_finalize(priv->stmt_mc_event);
 		if (rc != SQLITE_OK)
@@ -1907,6 +2557,12 @@ int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras)
 	}
 #endif
 
+	for (i = 0; i < priv->n_coalesce_stmt; i++)
+		sqlite3_finalize(priv->coalesce_stmt[i].stmt);
+
+	sqlite3_finalize(priv->stmt_staging);
+	ras_staging_close();
+
 	rc = sqlite3_close_v2(db);
 	if (rc != SQLITE_OK)
 		log(TERM, LOG_ERR,
@@ -1916,6 +2572,7 @@ int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras)
 	if (rc != SQLITE_OK)
 		log(TERM, LOG_ERR,
 		    "cpu %u: Failed to shutdown sqlite: error = %d\n", cpu, rc);
+	free(priv->tables);
 	free(priv);
 	ras->db_priv = NULL;
 
@@ -9,10 +9,16 @@
 #define __RAS_RECORD_H
 
 #include <fcntl.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "config.h"
+#include "ras-sink.h"
 #include "types.h"
 
 extern long user_hz;
@@ -297,6 +303,14 @@ struct ras_cxl_memory_sparing_event {
 	uint8_t res_id[CXL_PLDM_RES_ID_LEN];
 };
 
+struct ras_lost_event {
+	char timestamp[64];
+	const char *source;
+	int cpu;
+	const char *event;
+	unsigned long long count;
+};
+
 struct ras_mc_event;
 struct ras_aer_event;
 struct ras_extlog_event;
@@ -318,12 +332,231 @@ struct ras_signal_event;
 struct ras_cxl_memory_sparing_event;
 struct ras_reri_event;
 
+/*
+ * Event tables
+ *
+ * Besides its name and SQL type, each column tells where its value is
+ * at the event struct, so a single function can store any event, and
+ * other outputs can walk the same tables.
+ */
+enum db_bind {
+	DB_BIND_NONE,		/* Not taken from the event, e.g. the row id */
+	DB_BIND_INT,		/* Integer of .size bytes */
+	DB_BIND_TEXT,		/* char array of .size bytes */
+	DB_BIND_STR,		/* Pointer to a string */
+	DB_BIND_BLOB,		/* Array of .size bytes */
+	DB_BIND_BLOB_PTR,	/* Pointer to .size bytes */
+	DB_BIND_BLOB_LEN,	/* Pointer to bytes, with the length at .len_offset */
+};
+
+struct db_fields {
+	const char	*name;
+	const char	*type;
+
+	enum db_bind	bind;
+	bool		is_signed;
+	size_t		offset;
+	size_t		size;
+	size_t		len_offset;
+	size_t		len_size;
+};
+
+struct db_table_descriptor {
+	const char              *name;
+	const struct db_fields  *fields;
+	size_t                  num_fields;
+	const char              *rollup;	/* Columns counted per hour */
+	bool                    coalesce;	/* Repeated errors share a row */
+};
+
+#define DB_MEMBER(_st, _m)						\
+	.offset = offsetof(_st, _m), .size = sizeof(((_st *)0)->_m)
+
+#define DB_FIELD_ID							\
+	{ .name = "id", .type = "INTEGER PRIMARY KEY" }
+
+/* Types not listed, like enums and bool, are taken as unsigned */
+#define DB_IS_SIGNED(_x)						\
+	_Generic((_x),							\
+		 char: CHAR_MIN < 0,					\
+		 signed char: true,					\
+		 short: true,						\
+		 int: true,						\
+		 long: true,						\
+		 long long: true,					\
+		 default: false)
+
+#define DB_FIELD_INT(_name, _st, _m)					\
+	{ .name = _name, .type = "INTEGER", .bind = DB_BIND_INT,	\
+	  .is_signed = DB_IS_SIGNED(((_st *)0)->_m),			\
+	  DB_MEMBER(_st, _m) }
+
+#define DB_FIELD_TEXT(_name, _st, _m)					\
+	{ .name = _name, .type = "TEXT", .bind = DB_BIND_TEXT,		\
+	  DB_MEMBER(_st, _m) }
+
+#define DB_FIELD_STR(_name, _st, _m)					\
+	{ .name = _name, .type = "TEXT", .bind = DB_BIND_STR,		\
+	  DB_MEMBER(_st, _m) }
+
+#define DB_FIELD_BLOB(_name, _st, _m)					\
+	{ .name = _name, .type = "BLOB", .bind = DB_BIND_BLOB,		\
+	  DB_MEMBER(_st, _m) }
+
+#define DB_FIELD_BLOB_PTR(_name, _st, _m, _size)			\
+	{ .name = _name, .type = "BLOB", .bind = DB_BIND_BLOB_PTR,	\
+	  .offset = offsetof(_st, _m), .size = _size }
+
+#define DB_FIELD_BLOB_LEN(_name, _st, _m, _len)				\
+	{ .name = _name, .type = "BLOB", .bind = DB_BIND_BLOB_LEN,	\
+	  DB_MEMBER(_st, _m), .len_offset = offsetof(_st, _len),	\
+	  .len_size = sizeof(((_st *)0)->_len) }
+
+static inline int64_t db_get_int(const void *p, size_t size, bool is_signed)
+{
+	switch (size) {
+	case 1:
+		return is_signed ? *(const int8_t *)p : *(const uint8_t *)p;
+	case 2:
+		return is_signed ? *(const int16_t *)p : *(const uint16_t *)p;
+	case 4:
+		/* Both as int64_t, or the ?: makes them both unsigned */
+		return is_signed ? (int64_t)*(const int32_t *)p :
+				   (int64_t)*(const uint32_t *)p;
+	case 8:
+		return *(const int64_t *)p;
+	}
+
+	return 0;
+}
+
+static inline int64_t db_field_int(const struct db_fields *field,
+				   const void *ev)
+{
+	return db_get_int((const char *)ev + field->offset, field->size,
+			  field->is_signed);
+}
+
+/* Returns the string, or NULL, and its length at @len */
+static inline const char *db_field_text(const struct db_fields *field,
+					const void *ev, size_t *len)
+{
+	const char *p = (const char *)ev + field->offset;
+
+	if (field->bind == DB_BIND_TEXT) {
+		*len = strnlen(p, field->size);
+		return p;
+	}
+
+	p = *(const char * const *)p;
+	*len = p ? strlen(p) : 0;
+
+	return p;
+}
+
+/* Returns the data, or NULL, and its length at @len */
+static inline const void *db_field_blob(const struct db_fields *field,
+					const void *ev, size_t *len)
+{
+	const char *p = (const char *)ev + field->offset;
+
+	switch (field->bind) {
+	case DB_BIND_BLOB:
+		*len = field->size;
+		return p;
+	case DB_BIND_BLOB_PTR:
+		*len = field->size;
+		break;
+	case DB_BIND_BLOB_LEN:
+		*len = db_get_int((const char *)ev + field->len_offset,
+				  field->len_size, false);
+		break;
+	default:
+		*len = 0;
+		return NULL;
+	}
+
+	return *(const void * const *)p;
+}
+
+/* Settings of the event storage, from the environment */
+static inline unsigned int get_env_uint(const char *name, unsigned int def)
+{
+	char *env = getenv(name);
+
+	if (!env || !*env)
+		return def;
+
+	return strtoul(env, NULL, 0);
+}
+
+/* Time of the event being stored, at ras-tables.c */
+void ras_db_set_event_time(uint64_t boot_ns, uint64_t wall_ns);
+void ras_db_event_time(uint64_t *boot_ns, uint64_t *wall_ns);
+
 #ifdef HAVE_SQLITE3
 
 #include <sqlite3.h>
 
+struct db_retention {
+	const struct db_table_descriptor	*db_tab;
+	uint64_t				keep_ns;	/* 0: forever */
+};
+
+#define DB_COALESCE_SLOTS	64
+
+struct db_coalesce {
+	const struct db_table_descriptor	*db_tab;
+	uint64_t				hash;
+	int64_t					rowid;
+	uint64_t				first_ns;
+	uint64_t				last_ns;
+	unsigned int				count;
+	bool					dirty;
+	int64_t					staged;	/* Ring position, or -1 */
+};
+
+/* Prepared UPDATE of the repeated events, per table with .coalesce */
+#define DB_COALESCE_TABLES	4
+
+struct db_coalesce_stmt {
+	const struct db_table_descriptor	*db_tab;
+	sqlite3_stmt				*stmt;
+};
+
 struct sqlite3_priv {
 	sqlite3		*db;
+
+	/* Group commit */
+	bool		in_transaction;
+	unsigned int	pending;
+	unsigned int	commit_count;
+	unsigned int	commit_interval;
+	struct timespec	first_pending;
+
+	/* Coalescing */
+	uint64_t		coalesce_ns;
+	struct db_coalesce	coalesce[DB_COALESCE_SLOTS];
+	struct db_coalesce_stmt	coalesce_stmt[DB_COALESCE_TABLES];
+	unsigned int		n_coalesce_stmt;
+
+	/* Set if user_version is current: only tables with a new hash migrate */
+	bool		schema_current;
+
+	/* Retention */
+	bool			maintain;
+	bool			incremental;	/* auto_vacuum=INCREMENTAL */
+	bool			shrinking;
+	struct db_retention	*tables;
+	unsigned int		n_tables;
+	unsigned int		retention_days;
+	uint64_t		max_size;
+	struct timespec		next_maint;
+
+	/* Staging ring */
+	sqlite3_stmt	*stmt_staging;
+
+	sqlite3_stmt	*stmt_lost_event;
 	sqlite3_stmt	*stmt_mc_event;
 #ifdef HAVE_AER
 	sqlite3_stmt	*stmt_aer_event;
@@ -367,97 +600,135 @@ struct sqlite3_priv {
 #endif
 };
 
-struct db_fields {
-	const char *name;
-	const char *type;
-};
-
-struct db_table_descriptor {
-	const char              *name;
-	const struct db_fields  *fields;
-	size_t                  num_fields;
-};
-
 int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras);
 int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras);
 int ras_mc_add_vendor_table(struct ras_events *ras, sqlite3_stmt **stmt,
 			    const struct db_table_descriptor *db_tab);
 int ras_mc_finalize_vendor_table(sqlite3_stmt *stmt);
-int ras_store_mc_event(struct ras_events *ras, struct ras_mc_event *ev);
-int ras_store_aer_event(struct ras_events *ras, struct ras_aer_event *ev);
-int ras_store_mce_record(struct ras_events *ras, struct mce_event *ev);
+int ras_mc_store_vendor_record(sqlite3_stmt *stmt, const char *name);
+int ras_mc_store_vendor_event(sqlite3_stmt *stmt,
+			      const struct db_table_descriptor *db_tab,
+			      const void *ev);
+int ras_db_commit_timeout(struct ras_events *ras);
+void ras_db_commit(struct ras_events *ras);
+int ras_db_maintain(struct ras_events *ras);
+int ras_store_lost_event(struct ras_events *ras, struct ras_lost_event *ev);
+int ras_store_mc_event(struct ras_events *ras, struct ras_mc_event *ev,
+		       enum ras_severity severity);
+int ras_store_aer_event(struct ras_events *ras, struct ras_aer_event *ev,
+			enum ras_severity severity);
+int ras_store_mce_record(struct ras_events *ras, struct mce_event *ev,
+			 enum ras_severity severity);
 int ras_store_extlog_mem_record(struct ras_events *ras,
-				struct ras_extlog_event *ev);
+				struct ras_extlog_event *ev,
+				enum ras_severity severity);
 int ras_store_non_standard_record(struct ras_events *ras,
-				  struct ras_non_standard_event *ev);
-int ras_store_arm_record(struct ras_events *ras, struct ras_arm_event *ev);
-int ras_store_devlink_event(struct ras_events *ras, struct devlink_event *ev);
+				  struct ras_non_standard_event *ev,
+				  enum ras_severity severity);
+int ras_store_arm_record(struct ras_events *ras, struct ras_arm_event *ev,
+			 enum ras_severity severity);
+int ras_store_devlink_event(struct ras_events *ras, struct devlink_event *ev,
+			    enum ras_severity severity);
 int ras_store_diskerror_event(struct ras_events *ras,
-			      struct diskerror_event *ev);
-int ras_store_mf_event(struct ras_events *ras, struct ras_mf_event *ev);
+			      struct diskerror_event *ev,
+			      enum ras_severity severity);
+int ras_store_mf_event(struct ras_events *ras, struct ras_mf_event *ev,
+		       enum ras_severity severity);
 int ras_store_cxl_poison_event(struct ras_events *ras,
-			       struct ras_cxl_poison_event *ev);
+			       struct ras_cxl_poison_event *ev,
+			       enum ras_severity severity);
 int ras_store_cxl_aer_ue_event(struct ras_events *ras,
-			       struct ras_cxl_aer_ue_event *ev);
+			       struct ras_cxl_aer_ue_event *ev,
+			       enum ras_severity severity);
 int ras_store_cxl_aer_ce_event(struct ras_events *ras,
-			       struct ras_cxl_aer_ce_event *ev);
+			       struct ras_cxl_aer_ce_event *ev,
+			       enum ras_severity severity);
 int ras_store_cxl_overflow_event(struct ras_events *ras,
-				 struct ras_cxl_overflow_event *ev);
+				 struct ras_cxl_overflow_event *ev,
+				 enum ras_severity severity);
 int ras_store_cxl_generic_event(struct ras_events *ras,
-				struct ras_cxl_generic_event *ev);
+				struct ras_cxl_generic_event *ev,
+				enum ras_severity severity);
 int ras_store_cxl_general_media_event(struct ras_events *ras,
-				      struct ras_cxl_general_media_event *ev);
+				      struct ras_cxl_general_media_event *ev,
+				      enum ras_severity severity);
 int ras_store_cxl_dram_event(struct ras_events *ras,
-			     struct ras_cxl_dram_event *ev);
+			     struct ras_cxl_dram_event *ev,
+			     enum ras_severity severity);
 int ras_store_cxl_memory_module_event(struct ras_events *ras,
-				      struct ras_cxl_memory_module_event *ev);
-int ras_store_signal_event(struct ras_events *ras,
-			   struct ras_signal_event *ev);
-int ras_store_reri_event(struct ras_events *ras, struct ras_reri_event *ev);
+				      struct ras_cxl_memory_module_event *ev,
+				      enum ras_severity severity);
+int ras_store_signal_event(struct ras_events *ras, struct ras_signal_event *ev,
+			   enum ras_severity severity);
+int ras_store_reri_event(struct ras_events *ras, struct ras_reri_event *ev,
+			 enum ras_severity severity);
 
 #else
-static inline int ras_mc_event_opendb(unsigned int cpu,
-				      struct ras_events *ras) { return 0; };
-static inline int ras_mc_event_closedb(unsigned int cpu,
-				       struct ras_events *ras) { return 0; };
+/* At ras-binlog.c, the only event storage without SQLite */
+int ras_mc_event_opendb(unsigned int cpu, struct ras_events *ras);
+int ras_mc_event_closedb(unsigned int cpu, struct ras_events *ras);
+int ras_store_lost_event(struct ras_events *ras, struct ras_lost_event *ev);
+
+static inline int ras_db_commit_timeout(struct ras_events *ras) { return -1; };
+static inline void ras_db_commit(struct ras_events *ras) { };
+static inline int ras_db_maintain(struct ras_events *ras) { return -1; };
 static inline int ras_store_mc_event(struct ras_events *ras,
-				     struct ras_mc_event *ev) { return 0; };
+				     struct ras_mc_event *ev,
+				     enum ras_severity severity) { return 0; };
 static inline int ras_store_aer_event(struct ras_events *ras,
-				      struct ras_aer_event *ev) { return 0; };
+				      struct ras_aer_event *ev,
+				      enum ras_severity severity) { return 0; };
 static inline int ras_store_mce_record(struct ras_events *ras,
-				       struct mce_event *ev) { return 0; };
+				       struct mce_event *ev,
+				       enum ras_severity severity) { return 0; };
 static inline int ras_store_extlog_mem_record(struct ras_events *ras,
-					      struct ras_extlog_event *ev) { return 0; };
+					      struct ras_extlog_event *ev,
+					      enum ras_severity severity) { return 0; };
 static inline int ras_store_non_standard_record(struct ras_events *ras,
-						struct ras_non_standard_event *ev) { return 0; };
+						struct ras_non_standard_event *ev,
+						enum ras_severity severity) { return 0; };
 static inline int ras_store_arm_record(struct ras_events *ras,
-				       struct ras_arm_event *ev) { return 0; };
+				       struct ras_arm_event *ev,
+				       enum ras_severity severity) { return 0; };
 static inline int ras_store_devlink_event(struct ras_events *ras,
-					  struct devlink_event *ev) { return 0; };
+					  struct devlink_event *ev,
+					  enum ras_severity severity) { return 0; };
 static inline int ras_store_diskerror_event(struct ras_events *ras,
-					    struct diskerror_event *ev) { return 0; };
+					    struct diskerror_event *ev,
+					    enum ras_severity severity) { return 0; };
 static inline int ras_store_mf_event(struct ras_events *ras,
-				     struct ras_mf_event *ev) { return 0; };
+				     struct ras_mf_event *ev,
+				     enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_poison_event(struct ras_events *ras,
-					     struct ras_cxl_poison_event *ev) { return 0; };
+					     struct ras_cxl_poison_event *ev,
+					     enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_aer_ue_event(struct ras_events *ras,
-					     struct ras_cxl_aer_ue_event *ev) { return 0; };
+					     struct ras_cxl_aer_ue_event *ev,
+					     enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_aer_ce_event(struct ras_events *ras,
-					     struct ras_cxl_aer_ce_event *ev) { return 0; };
+					     struct ras_cxl_aer_ce_event *ev,
+					     enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_overflow_event(struct ras_events *ras,
-					       struct ras_cxl_overflow_event *ev) { return 0; };
+					       struct ras_cxl_overflow_event *ev,
+					       enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_generic_event(struct ras_events *ras,
-					      struct ras_cxl_generic_event *ev) { return 0; };
+					      struct ras_cxl_generic_event *ev,
+					      enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_general_media_event(struct ras_events *ras,
-						    struct ras_cxl_general_media_event *ev) { return 0; };
+						    struct ras_cxl_general_media_event *ev,
+						    enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_dram_event(struct ras_events *ras,
-					   struct ras_cxl_dram_event *ev) { return 0; };
+					   struct ras_cxl_dram_event *ev,
+					   enum ras_severity severity) { return 0; };
 static inline int ras_store_cxl_memory_module_event(struct ras_events *ras,
-						    struct ras_cxl_memory_module_event *ev) { return 0; };
+						    struct ras_cxl_memory_module_event *ev,
+						    enum ras_severity severity) { return 0; };
 static inline int ras_store_signal_event(struct ras_events *ras,
-					 struct ras_signal_event *ev) { return 0; };
+					 struct ras_signal_event *ev,
+					 enum ras_severity severity) { return 0; };
 static inline int ras_store_reri_event(struct ras_events *ras,
-				       struct ras_reri_event *ev) { return 0; };
+				       struct ras_reri_event *ev,
+				       enum ras_severity severity) { return 0; };
 
 #endif
 
@@ -4,27 +4,160 @@
  * Copyright (c) 2016, The Linux Foundation. All rights reserved.
  */
 
+/*
+ * Reports are sent to ABRT by a thread of their own, so a slow or hung
+ * ABRT never delays the events. The event handlers only write the report
+ * backtrace to a bounded queue. If the queue is full, the report is
+ * dropped, and counted as the rate limited ones below.
+ *
+ * ABRT takes a single report per connection, so each report still has
+ * its own connect(), but the whole report is sent with a single writev(),
+ * starting with a basic header prepared only once.
+ *
+ * Reports are also rate limited per analyzer. The ones over the limit, or
+ * repeating the last report of the analyzer, are only counted, and their
+ * count is added to the next report of that analyzer.
+ */
+
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <sys/utsname.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "ras-logger.h"
 #include "ras-report.h"
 #include "ras-record.h"
+#include "ras-sink.h"
+
+#define ABRT_REPORT_INTERVAL	"ABRT_REPORT_INTERVAL"
+#define ABRT_REPORT_BURST	"ABRT_REPORT_BURST"
+#define DEFAULT_REPORT_INTERVAL	60	/* seconds */
+#define DEFAULT_REPORT_BURST	5
+#define REPORT_QUEUE_SIZE	32
+#define REPORT_BACKTRACE_SIZE	(16 * 1024)
+#define REPORT_SEND_TIMEOUT	5	/* seconds */
+
+struct report_analyzer {
+	const char	*analyzer;	/* ABRT items, sent with their NUL */
+	const char	*reason;
+
+	/* Rate limit, protected by the queue lock */
+	time_t		window;
+	unsigned int	sent;
+	unsigned int	suppressed;
+	uint32_t	last_hash;
+};
+
+static struct report_analyzer analyzers[NR_EVENTS] = {
+	[MC_EVENT] = {
+		"ANALYZER=rasdaemon-mc",
+		"REASON=EDAC driver report problem" },
+	[MCE_EVENT] = {
+		"ANALYZER=rasdaemon-mce",
+		"REASON=Machine Check driver report problem" },
+	[AER_EVENT] = {
+		"ANALYZER=rasdaemon-aer",
+		"REASON=PCIe AER driver report problem" },
+	[NON_STANDARD_EVENT] = {
+		"ANALYZER=rasdaemon-non-standard",
+		"REASON=Unknown CPER section problem" },
+	[ARM_EVENT] = {
+		"ANALYZER=rasdaemon-arm",
+		"REASON=ARM CPU report problem" },
+	[DEVLINK_EVENT] = {
+		"ANALYZER=rasdaemon-devlink",
+		"REASON=devlink health report problem" },
+	[DISKERROR_EVENT] = {
+		"ANALYZER=rasdaemon-diskerror",
+		"REASON=disk I/O error" },
+	[MF_EVENT] = {
+		"ANALYZER=rasdaemon-memory_failure",
+		"REASON=memory failure problem" },
+	[SIGNAL_EVENT] = {
+		"ANALYZER=rasdaemon-signal_event",
+		"REASON=SIGBUS for Hardware error" },
+	[CXL_POISON_EVENT] = {
+		"ANALYZER=rasdaemon-cxl-poison",
+		"REASON=CXL poison" },
+	[CXL_AER_UE_EVENT] = {
+		"ANALYZER=rasdaemon-cxl-aer-uncorrectable-error",
+		"REASON=CXL AER uncorrectable error" },
+	[CXL_AER_CE_EVENT] = {
+		"ANALYZER=rasdaemon-cxl-aer-correctable-error",
+		"REASON=CXL AER correctable error" },
+	[CXL_OVERFLOW_EVENT] = {
+		"ANALYZER=rasdaemon-cxl-overflow",
+		"REASON=CXL overflow" },
+	[CXL_GENERIC_EVENT] = {
+		"ANALYZER=rasdaemon-cxl_generic_event",
+		"REASON=CXL Generic Event " },
+	[CXL_GENERAL_MEDIA_EVENT] = {
+		"ANALYZER=rasdaemon-cxl_general_media_event",
+		"REASON=CXL General Media Event" },
+	[CXL_DRAM_EVENT] = {
+		"ANALYZER=rasdaemon-cxl_dram_event",
+		"REASON=CXL DRAM Event" },
+	[CXL_MEMORY_MODULE_EVENT] = {
+		"ANALYZER=rasdaemon-cxl_memory_module_event",
+		"REASON=CXL Memory Module Event" },
+	[RERI_EVENT] = {
+		"ANALYZER=rasdaemon-reri",
+		"REASON=RISC-V RERI error report" },
+};
+
+struct report {
+	struct report_analyzer	*an;
+	size_t			len;	/* Of the backtrace, with its NUL */
+	char			backtrace[REPORT_BACKTRACE_SIZE];
+};
+
+static struct {
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	pthread_t	thread;
+	bool		started;
+
+	struct report	slots[REPORT_QUEUE_SIZE];
+	unsigned int	head;		/* Next slot to queue */
+	unsigned int	tail;		/* Next slot to send */
+	unsigned long	dropped;
+	bool		full;
+
+	time_t		interval;
+	unsigned int	burst;
+
+	char		basic[256];
+	size_t		basic_len;
+} rq = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t report_once = PTHREAD_ONCE_INIT;
 
 static int setup_report_socket(void)
 {
+	struct timeval tv = { .tv_sec = REPORT_SEND_TIMEOUT };
 	int sockfd = -1;
 	int rc = -1;
 	struct sockaddr_un addr;
 
-	sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
 	if (sockfd < 0)
 		return -1;
 
+	/* Also bounds connect(), if ABRT stopped accepting */
+	setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
 	memset(&addr, 0, sizeof(struct sockaddr_un));
 	addr.sun_family = AF_UNIX;
 	strscpy(addr.sun_path, ABRT_SOCKET, sizeof(addr.sun_path));
@@ -39,71 +172,48 @@ static int setup_report_socket(void)
 	return sockfd;
 }
 
-static int commit_report_basic(int sockfd)
+/*
+ * ABRT server protocol: the request line, then NUL terminated items.
+ * The basic ones are the same for every report.
+ */
+static int prepare_report_basic(void)
 {
-	char buf[INPUT_BUFFER_SIZE];
+	size_t size = sizeof(rq.basic);
 	struct utsname un;
-	int rc = -1;
+	int n;
 
-	if (sockfd < 0)
-		return rc;
-
-	memset(buf, 0, INPUT_BUFFER_SIZE);
 	memset(&un, 0, sizeof(struct utsname));
-
-	rc = uname(&un);
-	if (rc < 0)
-		return rc;
-
-	/*
-	 * ABRT server protocol
-	 */
-	snprintf(buf, INPUT_BUFFER_SIZE, "PUT / HTTP/1.1\r\n\r\n");
-	rc = write(sockfd, buf, strlen(buf));
-	if (rc < strlen(buf))
+	if (uname(&un) < 0)
 		return -1;
 
-	snprintf(buf, INPUT_BUFFER_SIZE, "PID=%d", (int)getpid());
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
+	n = snprintf(rq.basic, size, "PUT / HTTP/1.1\r\n\r\n");
+	n += snprintf(rq.basic + n, size - n, "PID=%d", (int)getpid()) + 1;
+	n += snprintf(rq.basic + n, size - n, "EXECUTABLE=/boot/vmlinuz-%s",
+		      un.release) + 1;
+	n += snprintf(rq.basic + n, size - n, "TYPE=%s", "ras") + 1;
+	if (n > size)
 		return -1;
 
-	snprintf(buf, INPUT_BUFFER_SIZE, "EXECUTABLE=/boot/vmlinuz-%s",
-		 un.release);
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		return -1;
-
-	snprintf(buf, INPUT_BUFFER_SIZE, "TYPE=%s", "ras");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		return -1;
+	rq.basic_len = n;
 
 	return 0;
 }
 
-static int set_mc_event_backtrace(char *buf, struct ras_mc_event *ev)
+static int set_mc_event_backtrace(char *buf, size_t size, struct ras_mc_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"error_count=%d\n"
 		"error_type=%s\n"
 		"msg=%s\n"
 		"label=%s\n"
-		"mc_index=%c\n"
-		"top_layer=%c\n"
-		"middle_layer=%c\n"
-		"lower_layer=%c\n"
+		"mc_index=%d\n"
+		"top_layer=%d\n"
+		"middle_layer=%d\n"
+		"lower_layer=%d\n"
 		"address=%llu\n"
 		"grain=%llu\n"
 		"syndrome=%llu\n"
@@ -125,18 +235,11 @@ static int set_mc_event_backtrace(char *buf, struct ras_mc_event *ev)
 	return 0;
 }
 
-static int set_mce_event_backtrace(char *buf, struct mce_event *ev)
+static int set_mce_event_backtrace(char *buf, size_t size, struct mce_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"bank_name=%s\n"
@@ -188,18 +291,11 @@ static int set_mce_event_backtrace(char *buf, struct mce_event *ev)
 	return 0;
 }
 
-static int set_aer_event_backtrace(char *buf, struct ras_aer_event *ev)
+static int set_aer_event_backtrace(char *buf, size_t size, struct ras_aer_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"error_type=%s\n"
@@ -213,18 +309,11 @@ static int set_aer_event_backtrace(char *buf, struct ras_aer_event *ev)
 	return 0;
 }
 
-static int set_non_standard_event_backtrace(char *buf, struct ras_non_standard_event *ev)
+static int set_non_standard_event_backtrace(char *buf, size_t size, struct ras_non_standard_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"severity=%s\n"
@@ -236,18 +325,11 @@ static int set_non_standard_event_backtrace(char *buf, struct ras_non_standard_e
 	return 0;
 }
 
-static int set_arm_event_backtrace(char *buf, struct ras_arm_event *ev)
+static int set_arm_event_backtrace(char *buf, size_t size, struct ras_arm_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"error_count=%d\n"
@@ -267,18 +349,11 @@ static int set_arm_event_backtrace(char *buf, struct ras_arm_event *ev)
 	return 0;
 }
 
-static int set_devlink_event_backtrace(char *buf, struct devlink_event *ev)
+static int set_devlink_event_backtrace(char *buf, size_t size, struct devlink_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"bus_name=%s\n"
@@ -296,18 +371,11 @@ static int set_devlink_event_backtrace(char *buf, struct devlink_event *ev)
 	return 0;
 }
 
-static int set_diskerror_event_backtrace(char *buf, struct diskerror_event *ev)
+static int set_diskerror_event_backtrace(char *buf, size_t size, struct diskerror_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"dev=%s\n"
@@ -327,18 +395,11 @@ static int set_diskerror_event_backtrace(char *buf, struct diskerror_event *ev)
 	return 0;
 }
 
-static int set_mf_event_backtrace(char *buf, struct ras_mf_event *ev)
+static int set_mf_event_backtrace(char *buf, size_t size, struct ras_mf_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"pfn=%s\n"
@@ -352,18 +413,11 @@ static int set_mf_event_backtrace(char *buf, struct ras_mf_event *ev)
 	return 0;
 }
 
-static int set_cxl_poison_event_backtrace(char *buf, struct ras_cxl_poison_event *ev)
+static int set_cxl_poison_event_backtrace(char *buf, size_t size, struct ras_cxl_poison_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -397,18 +451,11 @@ static int set_cxl_poison_event_backtrace(char *buf, struct ras_cxl_poison_event
 	return 0;
 }
 
-static int set_cxl_aer_ue_event_backtrace(char *buf, struct ras_cxl_aer_ue_event *ev)
+static int set_cxl_aer_ue_event_backtrace(char *buf, size_t size, struct ras_cxl_aer_ue_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -426,18 +473,11 @@ static int set_cxl_aer_ue_event_backtrace(char *buf, struct ras_cxl_aer_ue_event
 	return 0;
 }
 
-static int set_cxl_aer_ce_event_backtrace(char *buf, struct ras_cxl_aer_ce_event *ev)
+static int set_cxl_aer_ce_event_backtrace(char *buf, size_t size, struct ras_cxl_aer_ce_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -453,18 +493,11 @@ static int set_cxl_aer_ce_event_backtrace(char *buf, struct ras_cxl_aer_ce_event
 	return 0;
 }
 
-static int set_cxl_overflow_event_backtrace(char *buf, struct ras_cxl_overflow_event *ev)
+static int set_cxl_overflow_event_backtrace(char *buf, size_t size, struct ras_cxl_overflow_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -486,18 +519,11 @@ static int set_cxl_overflow_event_backtrace(char *buf, struct ras_cxl_overflow_e
 	return 0;
 }
 
-static int set_cxl_generic_event_backtrace(char *buf, struct ras_cxl_generic_event *ev)
+static int set_cxl_generic_event_backtrace(char *buf, size_t size, struct ras_cxl_generic_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -533,18 +559,11 @@ static int set_cxl_generic_event_backtrace(char *buf, struct ras_cxl_generic_eve
 	return 0;
 }
 
-static int set_cxl_general_media_event_backtrace(char *buf, struct ras_cxl_general_media_event *ev)
+static int set_cxl_general_media_event_backtrace(char *buf, size_t size, struct ras_cxl_general_media_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -610,18 +629,11 @@ static int set_cxl_general_media_event_backtrace(char *buf, struct ras_cxl_gener
 	return 0;
 }
 
-static int set_cxl_dram_event_backtrace(char *buf, struct ras_cxl_dram_event *ev)
+static int set_cxl_dram_event_backtrace(char *buf, size_t size, struct ras_cxl_dram_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -697,18 +709,11 @@ static int set_cxl_dram_event_backtrace(char *buf, struct ras_cxl_dram_event *ev
 	return 0;
 }
 
-static int set_cxl_memory_module_event_backtrace(char *buf, struct ras_cxl_memory_module_event *ev)
+static int set_cxl_memory_module_event_backtrace(char *buf, size_t size, struct ras_cxl_memory_module_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"memdev=%s\n"
@@ -764,18 +769,11 @@ static int set_cxl_memory_module_event_backtrace(char *buf, struct ras_cxl_memor
 	return 0;
 }
 
-static int set_signal_event_backtrace(char *buf, struct ras_signal_event *ev)
+static int set_signal_event_backtrace(char *buf, size_t size, struct ras_signal_event *ev)
 {
-	unsigned int size = MAX_BACKTRACE_SIZE;
-
 	if (!buf || !ev)
 		return -1;
 
-	while (*buf && size > 0) {
-		buf++;
-		size--;
-	}
-
 	snprintf(buf, size, "BACKTRACE="
 		"timestamp=%s\n"
 		"signal=%d\n"
@@ -795,910 +793,286 @@ static int set_signal_event_backtrace(char *buf, struct ras_signal_event *ev)
 	return 0;
 }
 
-static int commit_report_backtrace(int sockfd, int type, void *ev)
+static int set_report_backtrace(char *buf, size_t size, int type, void *ev)
 {
-	char buf[MAX_BACKTRACE_SIZE];
-	char *pbuf = buf;
-	int rc = -1;
-	int buf_len = 0;
-
-	if (sockfd < 0 || !ev)
-		return -1;
-
-	memset(buf, 0, MAX_BACKTRACE_SIZE);
-
 	switch (type) {
 	case MC_EVENT:
-		rc = set_mc_event_backtrace(buf,
-					    (struct ras_mc_event *)ev);
-		break;
+		return set_mc_event_backtrace(buf, size,
+					      (struct ras_mc_event *)ev);
 	case AER_EVENT:
-		rc = set_aer_event_backtrace(buf,
-					     (struct ras_aer_event *)ev);
-		break;
+		return set_aer_event_backtrace(buf, size,
+					       (struct ras_aer_event *)ev);
 	case MCE_EVENT:
-		rc = set_mce_event_backtrace(buf,
-					     (struct mce_event *)ev);
-		break;
+		return set_mce_event_backtrace(buf, size,
+					       (struct mce_event *)ev);
 	case NON_STANDARD_EVENT:
-		rc = set_non_standard_event_backtrace(buf,
-						      (struct ras_non_standard_event *)ev);
-		break;
+		return set_non_standard_event_backtrace(buf, size,
+							(struct ras_non_standard_event *)ev);
 	case ARM_EVENT:
-		rc = set_arm_event_backtrace(buf,
-					     (struct ras_arm_event *)ev);
-		break;
+		return set_arm_event_backtrace(buf, size,
+					       (struct ras_arm_event *)ev);
 	case DEVLINK_EVENT:
-		rc = set_devlink_event_backtrace(buf,
-						 (struct devlink_event *)ev);
-		break;
+		return set_devlink_event_backtrace(buf, size,
+						   (struct devlink_event *)ev);
 	case DISKERROR_EVENT:
-		rc = set_diskerror_event_backtrace(buf,
-						   (struct diskerror_event *)ev);
-		break;
+		return set_diskerror_event_backtrace(buf, size,
+						     (struct diskerror_event *)ev);
 	case MF_EVENT:
-		rc = set_mf_event_backtrace(buf,
-					    (struct ras_mf_event *)ev);
-		break;
+		return set_mf_event_backtrace(buf, size,
+					      (struct ras_mf_event *)ev);
 	case CXL_POISON_EVENT:
-		rc = set_cxl_poison_event_backtrace(buf,
-						    (struct ras_cxl_poison_event *)ev);
-		break;
+		return set_cxl_poison_event_backtrace(buf, size,
+						      (struct ras_cxl_poison_event *)ev);
 	case CXL_AER_UE_EVENT:
-		rc = set_cxl_aer_ue_event_backtrace(buf,
-						    (struct ras_cxl_aer_ue_event *)ev);
-		break;
+		return set_cxl_aer_ue_event_backtrace(buf, size,
+						      (struct ras_cxl_aer_ue_event *)ev);
 	case CXL_AER_CE_EVENT:
-		rc = set_cxl_aer_ce_event_backtrace(buf,
-						    (struct ras_cxl_aer_ce_event *)ev);
-		break;
+		return set_cxl_aer_ce_event_backtrace(buf, size,
+						      (struct ras_cxl_aer_ce_event *)ev);
 	case CXL_OVERFLOW_EVENT:
-		rc = set_cxl_overflow_event_backtrace(buf,
-						      (struct ras_cxl_overflow_event *)ev);
-		break;
+		return set_cxl_overflow_event_backtrace(buf, size,
+							(struct ras_cxl_overflow_event *)ev);
 	case CXL_GENERIC_EVENT:
-		rc = set_cxl_generic_event_backtrace(buf,
-						     (struct ras_cxl_generic_event *)ev);
-		break;
+		return set_cxl_generic_event_backtrace(buf, size,
+						       (struct ras_cxl_generic_event *)ev);
 	case CXL_GENERAL_MEDIA_EVENT:
-		rc = set_cxl_general_media_event_backtrace(buf,
-							   (struct ras_cxl_general_media_event *)ev);
-		break;
+		return set_cxl_general_media_event_backtrace(buf, size,
+							     (struct ras_cxl_general_media_event *)ev);
 	case CXL_DRAM_EVENT:
-		rc = set_cxl_dram_event_backtrace(buf,
-						  (struct ras_cxl_dram_event *)ev);
-		break;
+		return set_cxl_dram_event_backtrace(buf, size,
+						    (struct ras_cxl_dram_event *)ev);
 	case CXL_MEMORY_MODULE_EVENT:
-		rc = set_cxl_memory_module_event_backtrace(buf,
-							   (struct ras_cxl_memory_module_event *)ev);
-		break;
+		return set_cxl_memory_module_event_backtrace(buf, size,
+							     (struct ras_cxl_memory_module_event *)ev);
 	case SIGNAL_EVENT:
-		rc = set_signal_event_backtrace(buf,
-						(struct ras_signal_event *)ev);
-		break;
+		return set_signal_event_backtrace(buf, size,
+						  (struct ras_signal_event *)ev);
 	default:
 		return -1;
 	}
-
-	if (rc < 0)
-		return -1;
-
-	buf_len = strlen(buf);
-
-	for (; buf_len > INPUT_BUFFER_SIZE - 1; buf_len -= (INPUT_BUFFER_SIZE - 1)) {
-		rc = write(sockfd, pbuf, INPUT_BUFFER_SIZE - 1);
-		if (rc < INPUT_BUFFER_SIZE - 1)
-			return -1;
-
-		pbuf = pbuf + INPUT_BUFFER_SIZE - 1;
-	}
-
-	rc = write(sockfd, pbuf, buf_len + 1);
-	if (rc < buf_len)
-		return -1;
-
-	return 0;
-}
-
-int ras_report_mc_event(struct ras_events *ras, struct ras_mc_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = -1;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto mc_fail;
-
-	rc = commit_report_backtrace(sockfd, MC_EVENT, ev);
-	if (rc < 0)
-		goto mc_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-mc");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto mc_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "EDAC driver report problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto mc_fail;
-
-	done = 1;
-
-mc_fail:
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_aer_event(struct ras_events *ras, struct ras_aer_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto aer_fail;
-
-	rc = commit_report_backtrace(sockfd, AER_EVENT, ev);
-	if (rc < 0)
-		goto aer_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-aer");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto aer_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s",
-		 "PCIe AER driver report problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto aer_fail;
-
-	done = 1;
-
-aer_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_non_standard_event(struct ras_events *ras,
-				  struct ras_non_standard_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return rc;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto non_standard_fail;
-
-	rc = commit_report_backtrace(sockfd, NON_STANDARD_EVENT, ev);
-	if (rc < 0)
-		goto non_standard_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-non-standard");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto non_standard_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s",
-		 "Unknown CPER section problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto non_standard_fail;
-
-	rc = 0;
-
-non_standard_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	return rc;
-}
-
-int ras_report_arm_event(struct ras_events *ras, struct ras_arm_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return rc;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto arm_fail;
-
-	rc = commit_report_backtrace(sockfd, ARM_EVENT, ev);
-	if (rc < 0)
-		goto arm_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-arm");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto arm_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "ARM CPU report problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto arm_fail;
-
-	rc = 0;
-
-arm_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	return rc;
 }
 
-int ras_report_mce_event(struct ras_events *ras, struct mce_event *ev)
+static int send_report(struct report *r)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
+	struct iovec iov[4];
+	ssize_t len = 0, rc;
+	int sockfd, i;
+
+	iov[0].iov_base = rq.basic;
+	iov[0].iov_len = rq.basic_len;
+	iov[1].iov_base = r->backtrace;
+	iov[1].iov_len = r->len;
+	iov[2].iov_base = (void *)r->an->analyzer;
+	iov[2].iov_len = strlen(r->an->analyzer) + 1;
+	iov[3].iov_base = (void *)r->an->reason;
+	iov[3].iov_len = strlen(r->an->reason) + 1;
+
+	for (i = 0; i < 4; i++)
+		len += iov[i].iov_len;
 
 	sockfd = setup_report_socket();
 	if (sockfd < 0)
 		return -1;
 
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto mce_fail;
-
-	rc = commit_report_backtrace(sockfd, MCE_EVENT, ev);
-	if (rc < 0)
-		goto mce_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-mce");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto mce_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s",
-		 "Machine Check driver report problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto mce_fail;
-
-	done = 1;
+	rc = writev(sockfd, iov, 4);
+	close(sockfd);
 
-mce_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_devlink_event(struct ras_events *ras, struct devlink_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
+	if (rc < len)
 		return -1;
 
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto devlink_fail;
-
-	rc = commit_report_backtrace(sockfd, DEVLINK_EVENT, ev);
-	if (rc < 0)
-		goto devlink_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-devlink");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto devlink_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s",
-		 "devlink health report problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto devlink_fail;
-
-	done = 1;
-
-devlink_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_diskerror_event(struct ras_events *ras, struct diskerror_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto diskerror_fail;
-
-	rc = commit_report_backtrace(sockfd, DISKERROR_EVENT, ev);
-	if (rc < 0)
-		goto diskerror_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-diskerror");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto diskerror_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "disk I/O error");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto diskerror_fail;
-
-	done = 1;
-
-diskerror_fail:
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
+	return 0;
 }
 
-int ras_report_mf_event(struct ras_events *ras, struct ras_mf_event *ev)
+static void *report_thread(void *arg)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto mf_fail;
-
-	rc = commit_report_backtrace(sockfd, MF_EVENT, ev);
-	if (rc < 0)
-		goto mf_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-memory_failure");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto mf_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "memory failure problem");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto mf_fail;
-
-	done = 1;
-
-mf_fail:
-	if (sockfd >= 0)
-		close(sockfd);
+	struct report *r;
+
+	for (;;) {
+		pthread_mutex_lock(&rq.lock);
+		while (rq.tail == rq.head)
+			pthread_cond_wait(&rq.cond, &rq.lock);
+		r = &rq.slots[rq.tail % REPORT_QUEUE_SIZE];
+		pthread_mutex_unlock(&rq.lock);
+
+		/* The slot is only reused once the tail moves past it */
+		if (send_report(r) < 0)
+			log(TERM, LOG_WARNING, "Can't send the report to ABRT\n");
+
+		pthread_mutex_lock(&rq.lock);
+		rq.tail++;
+		pthread_mutex_unlock(&rq.lock);
+	}
 
-	if (done)
-		return 0;
-	else
-		return -1;
+	return NULL;
 }
 
-int ras_report_cxl_poison_event(struct ras_events *ras,
-				struct ras_cxl_poison_event *ev)
+static void report_init(void)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_poison_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_POISON_EVENT, ev);
-	if (rc < 0)
-		goto cxl_poison_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-cxl-poison");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_poison_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "CXL poison");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_poison_fail;
-
-	done = 1;
-
-cxl_poison_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
+	char *env;
+
+	rq.interval = DEFAULT_REPORT_INTERVAL;
+	env = getenv(ABRT_REPORT_INTERVAL);
+	if (env && *env)
+		rq.interval = strtoul(env, NULL, 0);
+
+	rq.burst = DEFAULT_REPORT_BURST;
+	env = getenv(ABRT_REPORT_BURST);
+	if (env && *env)
+		rq.burst = strtoul(env, NULL, 0);
+	if (!rq.burst)
+		rq.burst = 1;
+
+	/* Done at the first report, as the PID changes when daemonizing */
+	if (prepare_report_basic() < 0) {
+		log(ALL, LOG_ERR, "Can't prepare the ABRT reports\n");
+		return;
+	}
 
-	if (done)
-		return 0;
+	if (pthread_create(&rq.thread, NULL, report_thread, NULL)) {
+		log(ALL, LOG_ERR, "Can't create the ABRT report thread\n");
+		return;
+	}
+	pthread_detach(rq.thread);
 
-	return -1;
+	rq.started = true;
 }
 
-int ras_report_cxl_aer_ue_event(struct ras_events *ras,
-				struct ras_cxl_aer_ue_event *ev)
+/* FNV-1a, to tell repeated reports apart */
+static uint32_t report_hash(const char *s)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_aer_ue_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_AER_UE_EVENT, ev);
-	if (rc < 0)
-		goto cxl_aer_ue_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl-aer-uncorrectable-error");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_aer_ue_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s",
-		 "CXL AER uncorrectable error");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_aer_ue_fail;
+	uint32_t hash = 2166136261U;
 
-	done = 1;
+	for (; *s; s++)
+		hash = (hash ^ (unsigned char)*s) * 16777619U;
 
-cxl_aer_ue_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
+	return hash;
 }
 
-int ras_report_cxl_aer_ce_event(struct ras_events *ras,
-				struct ras_cxl_aer_ce_event *ev)
+/*
+ * Tells if a report should only be counted. Repeats are compared without
+ * their first line, the event timestamp.
+ */
+static bool report_throttled(struct report_analyzer *an, const char *bt)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_aer_ce_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_AER_CE_EVENT, ev);
-	if (rc < 0)
-		goto cxl_aer_ce_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl-aer-correctable-error");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_aer_ce_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s",
-		 "CXL AER correctable error");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_aer_ce_fail;
-
-	done = 1;
+	struct timespec now;
+	const char *body;
+	uint32_t hash;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec - an->window >= rq.interval) {
+		an->window = now.tv_sec;
+		an->sent = 0;
+	}
 
-cxl_aer_ce_fail:
+	body = strchr(bt, '\n');
+	hash = report_hash(body ? body : bt);
 
-	if (sockfd >= 0)
-		close(sockfd);
+	if (an->sent >= rq.burst || (an->sent && hash == an->last_hash)) {
+		an->suppressed++;
+		return true;
+	}
 
-	if (done)
-		return 0;
+	an->sent++;
+	an->last_hash = hash;
 
-	return -1;
+	return false;
 }
 
-int ras_report_cxl_overflow_event(struct ras_events *ras,
-				  struct ras_cxl_overflow_event *ev)
+static int report_event(int type, void *ev)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
+	struct report_analyzer *an;
+	char buf[REPORT_BACKTRACE_SIZE];
+	struct report *r;
+	size_t len;
 	int rc = -1;
 
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
+	if (type < 0 || type >= NR_EVENTS || !ev)
 		return -1;
 
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_overflow_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_OVERFLOW_EVENT, ev);
-	if (rc < 0)
-		goto cxl_overflow_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl-overflow");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_overflow_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "CXL overflow");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_overflow_fail;
-
-	done = 1;
-
-cxl_overflow_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
+	an = &analyzers[type];
+	if (!an->analyzer)
 		return 0;
 
-	return -1;
-}
-
-int ras_report_cxl_generic_event(struct ras_events *ras,
-				 struct ras_cxl_generic_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
+	pthread_once(&report_once, report_init);
+	if (!rq.started)
 		return -1;
 
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_generic_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_GENERIC_EVENT, ev);
-	if (rc < 0)
-		goto cxl_generic_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl_generic_event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_generic_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "CXL Generic Event ");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_generic_fail;
-
-	done = 1;
-
-cxl_generic_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_cxl_general_media_event(struct ras_events *ras,
-				       struct ras_cxl_general_media_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
+	buf[0] = '\0';
+	if (set_report_backtrace(buf, sizeof(buf), type, ev) < 0)
 		return -1;
 
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_general_media_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_GENERAL_MEDIA_EVENT, ev);
-	if (rc < 0)
-		goto cxl_general_media_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl_general_media_event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_general_media_fail;
+	pthread_mutex_lock(&rq.lock);
 
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "CXL General Media Event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_general_media_fail;
+	/*
+	 * Checked before throttling, so a dropped report doesn't take the
+	 * burst, nor suppress its repeats. It is counted as suppressed.
+	 */
+	if (rq.head - rq.tail >= REPORT_QUEUE_SIZE) {
+		if (!rq.full)
+			log(ALL, LOG_WARNING,
+			    "ABRT is not taking reports, dropping them\n");
+		rq.full = true;
+		rq.dropped++;
+		an->suppressed++;
+		rc = -ENOBUFS;
+		goto out;
+	}
+	if (rq.full)
+		log(ALL, LOG_WARNING, "%lu ABRT reports were dropped\n",
+		    rq.dropped);
+	rq.full = false;
+
+	if (report_throttled(an, buf)) {
+		rc = 0;
+		goto out;
+	}
 
-	done = 1;
+	len = strlen(buf);
+	if (an->suppressed) {
+		snprintf(buf + len, sizeof(buf) - len, "suppressed=%u\n",
+			 an->suppressed);
+		len = strlen(buf);
+		an->suppressed = 0;
+	}
 
-cxl_general_media_fail:
+	r = &rq.slots[rq.head % REPORT_QUEUE_SIZE];
+	r->an = an;
+	r->len = len + 1;
+	memcpy(r->backtrace, buf, r->len);
 
-	if (sockfd >= 0)
-		close(sockfd);
+	rq.head++;
+	pthread_cond_signal(&rq.cond);
+	rc = 0;
 
-	if (done)
-		return 0;
+out:
+	pthread_mutex_unlock(&rq.lock);
 
-	return -1;
+	return rc;
 }
 
-int ras_report_cxl_dram_event(struct ras_events *ras,
-			      struct ras_cxl_dram_event *ev)
+static int abrt_sink_emit(struct ras_events *ras,
+			  const struct ras_sink_event *ev)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_dram_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_DRAM_EVENT, ev);
-	if (rc < 0)
-		goto cxl_dram_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl_dram_event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_dram_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "CXL DRAM Event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_dram_fail;
-
-	done = 1;
-
-cxl_dram_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
+	/* Only the RERI errors the hart couldn't correct were reported */
+	if (ev->type == RERI_EVENT && ev->severity < RAS_SEV_UNCORRECTED)
 		return 0;
 
-	return -1;
+	return report_event(ev->type, ev->ev);
 }
 
-int ras_report_cxl_memory_module_event(struct ras_events *ras,
-				       struct ras_cxl_memory_module_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
+static struct ras_sink abrt_sink = {
+	.name = "abrt",
+	.emit = abrt_sink_emit,
+};
 
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto cxl_memory_module_fail;
-
-	rc = commit_report_backtrace(sockfd, CXL_MEMORY_MODULE_EVENT, ev);
-	if (rc < 0)
-		goto cxl_memory_module_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-cxl_memory_module_event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_memory_module_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "CXL Memory Module Event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto cxl_memory_module_fail;
-
-	done = 1;
-
-cxl_memory_module_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_signal_event(struct ras_events *ras,
-			    struct ras_signal_event *ev)
-{
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int done = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return -1;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto signal_fail;
-
-	rc = commit_report_backtrace(sockfd, SIGNAL_EVENT, ev);
-	if (rc < 0)
-		goto signal_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s",
-		 "rasdaemon-signal_event");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto signal_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "SIGBUS for Hardware error");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto signal_fail;
-
-	done = 1;
-
-signal_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
-
-	if (done)
-		return 0;
-
-	return -1;
-}
-
-int ras_report_reri_event(struct ras_events *ras, struct ras_reri_event *ev)
+void ras_report_setup(void)
 {
-	char buf[MAX_MESSAGE_SIZE];
-	int sockfd = 0;
-	int rc = -1;
-
-	memset(buf, 0, sizeof(buf));
-
-	sockfd = setup_report_socket();
-	if (sockfd < 0)
-		return rc;
-
-	rc = commit_report_basic(sockfd);
-	if (rc < 0)
-		goto reri_fail;
-
-	rc = commit_report_backtrace(sockfd, RERI_EVENT, ev);
-	if (rc < 0)
-		goto reri_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "ANALYZER=%s", "rasdaemon-reri");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto reri_fail;
-
-	snprintf(buf, MAX_MESSAGE_SIZE, "REASON=%s", "RISC-V RERI error report");
-	rc = write(sockfd, buf, strlen(buf) + 1);
-	if (rc < strlen(buf) + 1)
-		goto reri_fail;
+	int i;
 
-	rc = 0;
-
-reri_fail:
-
-	if (sockfd >= 0)
-		close(sockfd);
+	for (i = 0; i < NR_EVENTS; i++) {
+		if (analyzers[i].analyzer)
+			abrt_sink.types |= BIT_ULL(i);
+	}
 
-	return rc;
+	ras_sink_register(&abrt_sink);
 }
@@ -18,7 +18,7 @@
 #include "ras-cpu-isolation.h"
 #include "ras-logger.h"
 #include "ras-record.h"
-#include "ras-report.h"
+#include "ras-sink.h"
 #include "types.h"
 
 #define RERI_GET_FIELD(val, offset, mask)	(((val) >> (offset)) & (mask))
@@ -325,9 +325,8 @@ int ras_reri_event_handler(struct trace_seq *s,
 
 	trace_seq_puts(s, "\n");
 
-#ifdef HAVE_SQLITE3
-	ras_store_reri_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, RERI_EVENT,
+		      ras_severity_from_str(get_severity_str(ev.severity)), &ev);
 
 #ifdef HAVE_CPU_FAULT_ISOLATION
 	if (ev.source_type == RERI_SOURCE_TYPE_CPU &&
@@ -336,10 +335,5 @@ int ras_reri_event_handler(struct trace_seq *s,
 		ras_record_cpu_error(NULL, ev.hart_id);
 #endif
 
-#ifdef HAVE_ABRT_REPORT
-	if (ras->record_events && ev.severity >= RERI_SEV_RECOVERABLE)
-		ras_report_reri_event(ras, &ev);
-#endif
-
 	return 0;
 }
@@ -23,7 +23,8 @@
 #include <signal.h>
 
 #include "ras-signal-handler.h"
-#include "ras-report.h"
+#include "ras-record.h"
+#include "ras-sink.h"
 #include "types.h"
 
 enum {
@@ -129,15 +130,7 @@ int ras_signal_event_handler(struct trace_seq *s, struct tep_record *record,
 
 	report_ras_signal_event(s, &ev);
 
-	/* Store data into the SQLite DB */
-#ifdef HAVE_SQLITE3
-	ras_store_signal_event(ras, &ev);
-#endif
-
-#ifdef HAVE_ABRT_REPORT
-	/* Report event to ABRT */
-	ras_report_signal_event(ras, &ev);
-#endif
+	ras_sink_emit(ras, SIGNAL_EVENT, RAS_SEV_UNCORRECTED, &ev);
 
 	return 0;
 }
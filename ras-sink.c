@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Event sinks
+ *
+ * The event handlers decode each event into its typed struct and emit
+ * it once. The event is then handed to each registered sink accepting
+ * its type and severity: the event storage, the ABRT reports, the event
+ * triggers, ...
+ *
+ * Sinks are registered before the events are enabled and are called by
+ * the event decoder thread, in their registration order. Sinks doing slow
+ * work, like the ABRT reports and the triggers, queue it, so a slow sink
+ * doesn't delay the others. Events each sink got, filtered out, dropped
+ * at a full queue or failed are counted, as well as the time each sink
+ * took, dumped at the log with the other event counters.
+ *
+ * The filters may be changed by the environment, per sink, e.g.:
+ *	ABRT_SINK_EVENTS=mc_event,aer_event
+ *	ABRT_SINK_SEVERITY=uncorrected
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-sink.h"
+#include "ras-stats.h"
+#include "types.h"
+
+static const char * const severity_names[NR_RAS_SEVERITIES] = {
+	[RAS_SEV_INFO] = "info",
+	[RAS_SEV_CORRECTED] = "corrected",
+	[RAS_SEV_DEFERRED] = "deferred",
+	[RAS_SEV_UNCORRECTED] = "uncorrected",
+	[RAS_SEV_FATAL] = "fatal",
+};
+
+static struct ras_sink *sinks;
+
+const char *ras_severity_name(enum ras_severity severity)
+{
+	if (severity >= NR_RAS_SEVERITIES)
+		return "unknown";
+
+	return severity_names[severity];
+}
+
+/*
+ * Severity of the error types printed by the Kernel and by the handlers,
+ * like "Corrected", "Uncorrected (Fatal)" or "Recoverable"
+ */
+enum ras_severity ras_severity_from_str(const char *str)
+{
+	if (!str)
+		return RAS_SEV_INFO;
+
+	if (!strncasecmp(str, "Fatal", 5) || strstr(str, "(Fatal)"))
+		return RAS_SEV_FATAL;
+	if (!strncasecmp(str, "Uncorrected", 11) ||
+	    !strncasecmp(str, "Recoverable", 11) ||
+	    !strncasecmp(str, "Failure", 7))
+		return RAS_SEV_UNCORRECTED;
+	if (!strncasecmp(str, "Deferred", 8))
+		return RAS_SEV_DEFERRED;
+	if (!strncasecmp(str, "Corrected", 9) ||
+	    !strncasecmp(str, "Warning", 7))
+		return RAS_SEV_CORRECTED;
+
+	return RAS_SEV_INFO;
+}
+
+static void sink_env_name(char *buf, size_t size, const char *name,
+			  const char *suffix)
+{
+	size_t i;
+
+	snprintf(buf, size, "%s_SINK_%s", name, suffix);
+	for (i = 0; buf[i]; i++)
+		buf[i] = toupper(buf[i]);
+}
+
+/*
+ * Parses a comma separated list of events, "all" or "none". Returns
+ * -EINVAL if an event is unknown, after adding the known ones.
+ */
+int ras_sink_parse_events(const char *list, uint64_t *types)
+{
+	char *s, *p, *tok, *saveptr;
+	int i, rc = 0;
+
+	if (!strcmp(list, "all")) {
+		*types = RAS_SINK_ALL_EVENTS;
+		return 0;
+	}
+
+	s = strdup(list);
+	if (!s)
+		return -ENOMEM;
+
+	*types = 0;
+	for (p = s; (tok = strtok_r(p, ", ", &saveptr)); p = NULL) {
+		if (!strcmp(tok, "none"))
+			continue;
+
+		for (i = 0; i < NR_EVENTS; i++) {
+			if (!strcmp(tok, ras_stats_event_name(i)))
+				break;
+		}
+		if (i == NR_EVENTS) {
+			rc = -EINVAL;
+			continue;
+		}
+		*types |= BIT_ULL(i);
+	}
+	free(s);
+
+	return rc;
+}
+
+/* Returns the severity named @name, or -EINVAL */
+int ras_severity_by_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < NR_RAS_SEVERITIES; i++) {
+		if (!strcasecmp(name, severity_names[i]))
+			return i;
+	}
+
+	return -EINVAL;
+}
+
+static void sink_setup_filter(struct ras_sink *sink)
+{
+	char name[64];
+	char *env;
+	int sev;
+
+	sink_env_name(name, sizeof(name), sink->name, "EVENTS");
+	env = getenv(name);
+	if (env && *env && ras_sink_parse_events(env, &sink->types) == -EINVAL)
+		log(ALL, LOG_WARNING, "Unknown events at %s\n", name);
+
+	sink_env_name(name, sizeof(name), sink->name, "SEVERITY");
+	env = getenv(name);
+	if (!env || !*env)
+		return;
+
+	sev = ras_severity_by_name(env);
+	if (sev < 0) {
+		log(ALL, LOG_WARNING, "Unknown severity `%s' at %s\n", env, name);
+		return;
+	}
+	sink->min_severity = sev;
+}
+
+/* Should be called before the events are enabled */
+void ras_sink_register(struct ras_sink *sink)
+{
+	struct ras_sink **p;
+
+	if (sink->registered)
+		return;
+
+	sink_setup_filter(sink);
+
+	for (p = &sinks; *p; p = &(*p)->next)
+		;
+	sink->next = NULL;
+	*p = sink;
+	sink->registered = true;
+
+	log(TERM, LOG_INFO, "Registered event sink %s\n", sink->name);
+}
+
+/* Walks the sinks, starting with ras_sink_next(NULL) */
+struct ras_sink *ras_sink_next(struct ras_sink *sink)
+{
+	return sink ? sink->next : sinks;
+}
+
+static uint64_t sink_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void ras_sink_emit(struct ras_events *ras, int type,
+		   enum ras_severity severity, void *ev)
+{
+	struct ras_sink_event event = {
+		.type = type,
+		.severity = severity,
+		.ev = ev,
+	};
+	uint64_t start, end, elapsed;
+	struct ras_sink *sink;
+	int rc;
+
+	for (sink = sinks; sink; sink = sink->next) {
+		if (!(sink->types & BIT_ULL(type)) ||
+		    severity < sink->min_severity) {
+			atomic_fetch_add_explicit(&sink->filtered, 1,
+						  memory_order_relaxed);
+			continue;
+		}
+
+		start = sink_clock_ns();
+		rc = sink->emit(ras, &event);
+		end = sink_clock_ns();
+
+		atomic_fetch_add_explicit(&sink->emitted, 1,
+					  memory_order_relaxed);
+		if (rc == -ENOBUFS)
+			atomic_fetch_add(&sink->dropped, 1);
+		else if (rc < 0)
+			atomic_fetch_add(&sink->failed, 1);
+
+		/* Only the decoder updates the times */
+		elapsed = end - start;
+		atomic_fetch_add_explicit(&sink->time_ns, elapsed,
+					  memory_order_relaxed);
+		if (elapsed > atomic_load_explicit(&sink->max_ns,
+						   memory_order_relaxed))
+			atomic_store_explicit(&sink->max_ns, elapsed,
+					      memory_order_relaxed);
+	}
+}
+
+void ras_sink_log(void)
+{
+	uint64_t emitted, time_ns;
+	struct ras_sink *sink;
+
+	for (sink = sinks; sink; sink = sink->next) {
+		emitted = atomic_load(&sink->emitted);
+		time_ns = atomic_load(&sink->time_ns);
+
+		log(ALL, LOG_INFO,
+		    "Sink %s: %llu events, %llu filtered, %llu dropped, %llu failed, %llu us average, %llu us max\n",
+		    sink->name, (unsigned long long)emitted,
+		    (unsigned long long)atomic_load(&sink->filtered),
+		    (unsigned long long)atomic_load(&sink->dropped),
+		    (unsigned long long)atomic_load(&sink->failed),
+		    (unsigned long long)(emitted ? time_ns / emitted / 1000 : 0),
+		    (unsigned long long)atomic_load(&sink->max_ns) / 1000);
+	}
+}
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Event sinks: where the decoded events go
+ */
+
+#ifndef __RAS_SINK_H
+#define __RAS_SINK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct ras_events;
+
+enum ras_severity {
+	RAS_SEV_INFO,
+	RAS_SEV_CORRECTED,
+	RAS_SEV_DEFERRED,
+	RAS_SEV_UNCORRECTED,
+	RAS_SEV_FATAL,
+	NR_RAS_SEVERITIES
+};
+
+struct ras_sink_event {
+	int			type;		/* MC_EVENT, AER_EVENT, ... */
+	enum ras_severity	severity;
+	void			*ev;		/* Only valid during emit() */
+};
+
+/*
+ * Sinks are called by the event decoder thread, so emit() must not block:
+ * slow sinks hand the event over to a queue of their own, returning
+ * -ENOBUFS if it is full.
+ */
+struct ras_sink {
+	const char		*name;
+	int			(*emit)(struct ras_events *ras,
+					const struct ras_sink_event *ev);
+
+	/* Default filter: event types, as BIT_ULL(type), and severity */
+	uint64_t		types;
+	enum ras_severity	min_severity;
+
+	/* Accounting */
+	_Atomic uint64_t	emitted;
+	_Atomic uint64_t	filtered;
+	_Atomic uint64_t	dropped;
+	_Atomic uint64_t	failed;
+	_Atomic uint64_t	time_ns;
+	_Atomic uint64_t	max_ns;
+
+	struct ras_sink		*next;
+	bool			registered;
+};
+
+#define RAS_SINK_ALL_EVENTS	(~0ULL)
+
+void ras_sink_register(struct ras_sink *sink);
+void ras_sink_emit(struct ras_events *ras, int type,
+		   enum ras_severity severity, void *ev);
+struct ras_sink *ras_sink_next(struct ras_sink *sink);
+void ras_sink_log(void);
+int ras_sink_parse_events(const char *list, uint64_t *types);
+
+enum ras_severity ras_severity_from_str(const char *str);
+const char *ras_severity_name(enum ras_severity severity);
+int ras_severity_by_name(const char *name);
+
+#endif
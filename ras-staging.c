@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Staging ring
+ *
+ * Events inserted at the database are only safe once their transaction
+ * is committed. Until then, they are also kept at a small ring file at
+ * the state directory, mapped into memory. If rasdaemon, or the host,
+ * dies before the commit, the events left at the ring are stored when
+ * rasdaemon starts again.
+ *
+ * Uncorrected and fatal errors are synced to the disk as soon as they
+ * are staged, together with the entries staged before them, as replaying
+ * stops at the first torn entry. The others only reach the disk with the
+ * page cache writeback: they survive a crash of rasdaemon, but maybe not
+ * of the host, as without the ring.
+ *
+ * Repeats of a corrected error merged into the row of the first one, at
+ * tables with .coalesce, are staged as the update of that row, so the
+ * replay stores them the same way.
+ *
+ * Entries are acknowledged when their transaction is committed. The
+ * position of the last entry committed is also stored at the database,
+ * at the same transaction, so an entry is never stored twice, even if
+ * the acknowledgement didn't reach the ring.
+ *
+ * Positions only grow, and are taken modulo the ring size. An entry that
+ * doesn't fit before the end of the ring is preceded by padding.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ras-logger.h"
+#include "ras-record.h"
+#include "ras-staging.h"
+#include "ras-tables.h"
+
+#define STAGING_RING_KB		"STAGING_RING_KB"
+#define DEFAULT_RING_KB		256
+#define STAGING_FILE		RASSTATEDIR "/staging.ring"
+
+#define STAGING_MAGIC		"RASSTG01"
+#define STAGING_VERSION		1
+#define STAGING_ALIGN		8
+
+enum staging_type {
+	STAGING_EVENT = 1,
+	STAGING_PAD,		/* Up to the end of the ring */
+	STAGING_REPEAT,		/* A struct staging_repeat */
+};
+
+struct staging_hdr {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	big_endian;
+	uint64_t	size;		/* Of the ring, after this header */
+	uint64_t	id;		/* Creation time, tells rings apart */
+	uint64_t	head;		/* Position of the next entry */
+	uint64_t	tail;		/* Position of the first entry not acked */
+	uint64_t	reserved[2];
+};
+
+struct staging_entry {
+	uint32_t	len;		/* Of the header, name and values */
+	uint32_t	crc;		/* From .pos to the end of the entry */
+	uint64_t	pos;
+	uint64_t	time_ns;
+	uint64_t	boot_ns;
+	uint16_t	type;
+	uint16_t	name_len;	/* Table name, with its NUL */
+	uint32_t	reserved;
+};
+
+/* Only used by the event decoder thread */
+static struct {
+	int			fd;
+	struct staging_hdr	*hdr;
+	char			*ring;
+	uint64_t		size;
+	size_t			map_size;
+	long			page_size;
+	uint64_t		synced;		/* Entries before it are on disk */
+} stg = {
+	.fd = -1,
+};
+
+static uint64_t align_up(uint64_t val)
+{
+	return (val + STAGING_ALIGN - 1) & ~(uint64_t)(STAGING_ALIGN - 1);
+}
+
+static bool host_is_big_endian(void)
+{
+	uint16_t val = 1;
+
+	return *(uint8_t *)&val == 0;
+}
+
+static uint32_t entry_crc(const struct staging_entry *entry, size_t len)
+{
+	size_t skip = offsetof(struct staging_entry, pos);
+
+	return ras_crc32(0, (const char *)entry + skip, len - skip);
+}
+
+static void sync_range(const void *start, size_t len)
+{
+	uintptr_t addr = (uintptr_t)start & ~(uintptr_t)(stg.page_size - 1);
+
+	if (msync((void *)addr, (uintptr_t)start + len - addr, MS_SYNC))
+		log(ALL, LOG_ERR, "Can't sync the staging ring: %s\n",
+		    strerror(errno));
+}
+
+/* Syncs the entries between the positions @from and @to */
+static void sync_entries(uint64_t from, uint64_t to)
+{
+	uint64_t off = from % stg.size, len = to - from;
+
+	if (!len)
+		return;
+
+	if (off + len > stg.size) {
+		sync_range(stg.ring + off, stg.size - off);
+		len -= stg.size - off;
+		off = 0;
+	}
+	sync_range(stg.ring + off, len);
+}
+
+static void ring_init(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	memset(stg.hdr, 0, sizeof(*stg.hdr));
+	memcpy(stg.hdr->magic, STAGING_MAGIC, sizeof(stg.hdr->magic));
+	stg.hdr->version = STAGING_VERSION;
+	stg.hdr->big_endian = host_is_big_endian();
+	stg.hdr->size = stg.size;
+	stg.hdr->id = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	sync_range(stg.hdr, sizeof(*stg.hdr));
+}
+
+static bool ring_valid(void)
+{
+	struct staging_hdr *hdr = stg.hdr;
+
+	return !memcmp(hdr->magic, STAGING_MAGIC, sizeof(hdr->magic)) &&
+	       hdr->version == STAGING_VERSION &&
+	       hdr->big_endian == host_is_big_endian() &&
+	       hdr->size == stg.size && hdr->tail <= hdr->head &&
+	       hdr->head - hdr->tail <= stg.size;
+}
+
+int ras_staging_open(void)
+{
+	unsigned int kb = DEFAULT_RING_KB;
+	char *env = getenv(STAGING_RING_KB);
+	struct stat st;
+
+	if (env && *env)
+		kb = strtoul(env, NULL, 0);
+	if (!kb)
+		return -ENOENT;
+
+	stg.size = align_up((uint64_t)kb << 10);
+	stg.map_size = sizeof(*stg.hdr) + stg.size;
+	stg.page_size = sysconf(_SC_PAGESIZE);
+
+	stg.fd = open(STAGING_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (stg.fd < 0)
+		goto error;
+
+	/* Allocated now, so a full disk can't fault the mapping later */
+	if (fstat(stg.fd, &st))
+		goto error;
+	if (st.st_size != stg.map_size) {
+		if (ftruncate(stg.fd, 0))
+			goto error;
+		errno = posix_fallocate(stg.fd, 0, stg.map_size);
+		if (errno)
+			goto error;
+	}
+
+	stg.hdr = mmap(NULL, stg.map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		       stg.fd, 0);
+	if (stg.hdr == MAP_FAILED) {
+		stg.hdr = NULL;
+		goto error;
+	}
+	stg.ring = (char *)(stg.hdr + 1);
+
+	if (!ring_valid())
+		ring_init();
+	stg.synced = stg.hdr->head;
+
+	return 0;
+
+error:
+	log(ALL, LOG_ERR, "Can't open the staging ring %s: %s\n",
+	    STAGING_FILE, strerror(errno));
+	if (stg.fd >= 0)
+		close(stg.fd);
+	stg.fd = -1;
+
+	return -errno;
+}
+
+bool ras_staging_active(void)
+{
+	return stg.hdr;
+}
+
+uint64_t ras_staging_id(void)
+{
+	return stg.hdr->id;
+}
+
+uint64_t ras_staging_head(void)
+{
+	return stg.hdr->head;
+}
+
+/*
+ * Reserves an entry at the head of the ring, with the table name and
+ * room for @data_len bytes after it, or returns NULL and the error at
+ * *rc.
+ */
+static struct staging_entry *entry_start(const char *name, size_t data_len,
+					 unsigned int type, uint64_t time_ns,
+					 uint64_t boot_ns, int *rc)
+{
+	struct staging_hdr *hdr = stg.hdr;
+	struct staging_entry *entry;
+	uint64_t off, pad = 0;
+	size_t name_len, len;
+
+	name_len = strlen(name) + 1;
+	len = sizeof(*entry) + name_len + data_len;
+
+	if (len > stg.size / 2) {
+		*rc = -E2BIG;
+		return NULL;
+	}
+
+	off = hdr->head % stg.size;
+	if (off + len > stg.size)
+		pad = stg.size - off;
+	if (hdr->head - hdr->tail + pad + align_up(len) > stg.size) {
+		*rc = -ENOSPC;
+		return NULL;
+	}
+
+	if (pad) {
+		/* Too short tails are skipped without a padding entry */
+		if (pad >= sizeof(*entry)) {
+			entry = (struct staging_entry *)(stg.ring + off);
+			entry->len = pad;
+			entry->pos = hdr->head;
+			entry->type = STAGING_PAD;
+		}
+		hdr->head += pad;
+		off = 0;
+	}
+
+	entry = (struct staging_entry *)(stg.ring + off);
+	entry->len = len;
+	entry->pos = hdr->head;
+	entry->time_ns = time_ns;
+	entry->boot_ns = boot_ns;
+	entry->type = type;
+	entry->name_len = name_len;
+	entry->reserved = 0;
+	memcpy(entry + 1, name, name_len);
+
+	return entry;
+}
+
+/* Adds the entry filled after entry_start() to the ring */
+static void entry_finish(struct staging_entry *entry, bool sync)
+{
+	struct staging_hdr *hdr = stg.hdr;
+
+	entry->crc = entry_crc(entry, entry->len);
+
+	/* The header is written after the entry, so it never points past it */
+	__atomic_store_n(&hdr->head, hdr->head + align_up(entry->len),
+			 __ATOMIC_RELEASE);
+
+	if (sync) {
+		sync_entries(stg.synced > hdr->tail ? stg.synced : hdr->tail,
+			     hdr->head);
+		sync_range(hdr, sizeof(*hdr));
+		stg.synced = hdr->head;
+	}
+}
+
+/*
+ * Stages an event, returning its ring position at *pos. Returns -ENOSPC
+ * if the ring is full, so the pending transaction should be committed
+ * first, or -E2BIG if the event is too big to be staged.
+ */
+int ras_staging_put(const struct db_table_descriptor *tab, const void *ev,
+		    uint64_t time_ns, uint64_t boot_ns, bool sync,
+		    uint64_t *pos)
+{
+	struct staging_entry *entry;
+	int rc;
+
+	entry = entry_start(tab->name, ras_event_packed_len(tab, ev),
+			    STAGING_EVENT, time_ns, boot_ns, &rc);
+	if (!entry)
+		return rc;
+
+	ras_event_pack(tab, ev, (char *)(entry + 1) + entry->name_len);
+	entry_finish(entry, sync);
+	*pos = entry->pos;
+
+	return 0;
+}
+
+/* Stages a repeat of an event at @tab, seen at @time_ns. Errors as above */
+int ras_staging_put_repeat(const struct db_table_descriptor *tab,
+			   const struct staging_repeat *rep,
+			   uint64_t time_ns, uint64_t boot_ns)
+{
+	struct staging_entry *entry;
+	int rc;
+
+	entry = entry_start(tab->name, sizeof(*rep), STAGING_REPEAT,
+			    time_ns, boot_ns, &rc);
+	if (!entry)
+		return rc;
+
+	memcpy((char *)(entry + 1) + entry->name_len, rep, sizeof(*rep));
+	entry_finish(entry, false);
+
+	return 0;
+}
+
+/* Called once the entries before @pos are committed */
+void ras_staging_ack(uint64_t pos)
+{
+	if (stg.hdr && pos > stg.hdr->tail && pos <= stg.hdr->head)
+		stg.hdr->tail = pos;
+}
+
+/*
+ * Calls @fn for each entry not acknowledged, starting at @from if it is
+ * still at the ring. Stops at the first entry torn by a crash.
+ */
+int ras_staging_replay(uint64_t from, staging_replay_fn fn, void *arg)
+{
+	struct staging_hdr *hdr = stg.hdr;
+	struct staging_entry *entry;
+	struct staging_record rec;
+	uint64_t pos = hdr->tail, off;
+	const char *name;
+	int n = 0;
+
+	while (pos < hdr->head) {
+		off = pos % stg.size;
+		entry = (struct staging_entry *)(stg.ring + off);
+
+		if (stg.size - off < sizeof(*entry) ||
+		    (entry->type == STAGING_PAD && entry->pos == pos)) {
+			pos += stg.size - off;
+			continue;
+		}
+
+		if (entry->len < sizeof(*entry) + entry->name_len ||
+		    entry->len > stg.size - off || entry->pos != pos ||
+		    entry->crc != entry_crc(entry, entry->len)) {
+			log(ALL, LOG_WARNING,
+			    "Staging ring entry at %llu is damaged\n",
+			    (unsigned long long)pos);
+			break;
+		}
+		pos += align_up(entry->len);
+
+		name = (const char *)(entry + 1);
+		if (entry->pos < from || !entry->name_len ||
+		    name[entry->name_len - 1])
+			continue;
+
+		rec.pos = entry->pos;
+		rec.repeat = entry->type == STAGING_REPEAT;
+		rec.table = name;
+		rec.time_ns = entry->time_ns;
+		rec.boot_ns = entry->boot_ns;
+		rec.data = name + entry->name_len;
+		rec.len = entry->len - sizeof(*entry) - entry->name_len;
+		if (!fn(arg, &rec))
+			n++;
+	}
+
+	return n;
+}
+
+void ras_staging_close(void)
+{
+	if (!stg.hdr)
+		return;
+
+	munmap(stg.hdr, stg.map_size);
+	close(stg.fd);
+	stg.hdr = NULL;
+	stg.fd = -1;
+}
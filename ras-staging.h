@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Staging ring of the events not committed to the database yet
+ */
+
+#ifndef __RAS_STAGING_H
+#define __RAS_STAGING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct db_table_descriptor;
+
+/* A repeat of a corrected error, merged into the row of the first one */
+struct staging_repeat {
+	uint64_t	first;		/* Ring position of the first one */
+	int64_t		rowid;		/* Of its row, if committed before */
+	uint32_t	count;		/* Occurrences, the first one included */
+	uint32_t	reserved;
+};
+
+struct staging_record {
+	uint64_t	pos;
+	bool		repeat;
+	const char	*table;
+	uint64_t	time_ns;
+	uint64_t	boot_ns;
+	const char	*data;	/* Packed column values, or a staging_repeat */
+	size_t		len;
+};
+
+/* Called for each staged event */
+typedef int (*staging_replay_fn)(void *arg, const struct staging_record *rec);
+
+int ras_staging_open(void);
+bool ras_staging_active(void);
+uint64_t ras_staging_id(void);
+uint64_t ras_staging_head(void);
+int ras_staging_put(const struct db_table_descriptor *tab, const void *ev,
+		    uint64_t time_ns, uint64_t boot_ns, bool sync,
+		    uint64_t *pos);
+int ras_staging_put_repeat(const struct db_table_descriptor *tab,
+			   const struct staging_repeat *rep,
+			   uint64_t time_ns, uint64_t boot_ns);
+void ras_staging_ack(uint64_t pos);
+int ras_staging_replay(uint64_t from, staging_replay_fn fn, void *arg);
+void ras_staging_close(void);
+
+#endif
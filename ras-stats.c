@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Event and lost event counters
+ *
+ * Events may be lost at the Kernel ring buffers, when rasdaemon can't
+ * keep up with them, at the event pipeline, or when storing them at the
+ * database. Losses are counted per CPU, when known, and per event type,
+ * when known. The Kernel only reports how many events were overwritten,
+ * not which ones, so those losses are only counted per CPU.
+ *
+ * Counters are updated by the reader and decoder threads, dumped at the
+ * log on SIGUSR1 and stored at the lost_event table by the decoder.
+ */
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-record.h"
+#include "ras-sink.h"
+#include "ras-stats.h"
+
+static const char * const drop_sources[NR_RAS_DROPS] = {
+	[RAS_DROP_KERNEL] = "kernel",
+	[RAS_DROP_QUEUE] = "queue",
+	[RAS_DROP_DB] = "database",
+};
+
+static const char * const event_names[NR_EVENTS] = {
+	[MC_EVENT] = "mc_event",
+	[MCE_EVENT] = "mce_record",
+	[AER_EVENT] = "aer_event",
+	[NON_STANDARD_EVENT] = "non_standard_event",
+	[ARM_EVENT] = "arm_event",
+	[EXTLOG_EVENT] = "extlog_mem_event",
+	[DEVLINK_EVENT] = "devlink_event",
+	[DISKERROR_EVENT] = "diskerror_event",
+	[MF_EVENT] = "memory_failure_event",
+	[SIGNAL_EVENT] = "signal_event",
+	[CXL_POISON_EVENT] = "cxl_poison",
+	[CXL_AER_UE_EVENT] = "cxl_aer_uncorrectable_error",
+	[CXL_AER_CE_EVENT] = "cxl_aer_correctable_error",
+	[CXL_OVERFLOW_EVENT] = "cxl_overflow",
+	[CXL_GENERIC_EVENT] = "cxl_generic_event",
+	[CXL_GENERAL_MEDIA_EVENT] = "cxl_general_media",
+	[CXL_DRAM_EVENT] = "cxl_dram",
+	[CXL_MEMORY_MODULE_EVENT] = "cxl_memory_module",
+	[CXL_MEMORY_SPARING_EVENT] = "cxl_memory_sparing",
+	[RERI_EVENT] = "reri_event",
+};
+
+static struct {
+	unsigned int		n_cpus;
+	_Atomic uint64_t	(*cpu_drops)[NR_RAS_DROPS];
+	_Atomic uint64_t	event_drops[NR_EVENTS][NR_RAS_DROPS];
+	_Atomic uint64_t	events[NR_EVENTS];
+	_Atomic uint64_t	drops[NR_RAS_DROPS];
+
+	/* Incremented when events are lost before reaching the handlers */
+	atomic_ulong		input_lost;
+	atomic_ulong		changed;
+
+	/* Already stored at the database. Only used by the decoder */
+	uint64_t		(*cpu_stored)[NR_RAS_DROPS];
+	uint64_t		event_stored[NR_EVENTS][NR_RAS_DROPS];
+	unsigned long		stored;
+} stats;
+
+int ras_stats_init(unsigned int n_cpus)
+{
+	stats.cpu_drops = calloc(n_cpus, sizeof(*stats.cpu_drops));
+	stats.cpu_stored = calloc(n_cpus, sizeof(*stats.cpu_stored));
+	if (!stats.cpu_drops || !stats.cpu_stored) {
+		ras_stats_free();
+		return -ENOMEM;
+	}
+	stats.n_cpus = n_cpus;
+
+	return 0;
+}
+
+void ras_stats_free(void)
+{
+	free(stats.cpu_drops);
+	free(stats.cpu_stored);
+	stats.cpu_drops = NULL;
+	stats.cpu_stored = NULL;
+	stats.n_cpus = 0;
+}
+
+const char *ras_stats_event_name(int event)
+{
+	if (event < 0 || event >= NR_EVENTS || !event_names[event])
+		return "unknown";
+
+	return event_names[event];
+}
+
+const char *ras_stats_drop_name(enum ras_drop_source source)
+{
+	if (source >= NR_RAS_DROPS)
+		return "unknown";
+
+	return drop_sources[source];
+}
+
+void ras_stats_event(int event)
+{
+	if (event >= 0 && event < NR_EVENTS)
+		atomic_fetch_add_explicit(&stats.events[event], 1,
+					  memory_order_relaxed);
+}
+
+/* @cpu and @event are -1 when unknown */
+void ras_stats_drop(enum ras_drop_source source, int cpu, int event,
+		    uint64_t count)
+{
+	if (cpu >= 0 && cpu < stats.n_cpus)
+		atomic_fetch_add(&stats.cpu_drops[cpu][source], count);
+	if (event >= 0 && event < NR_EVENTS)
+		atomic_fetch_add(&stats.event_drops[event][source], count);
+	atomic_fetch_add(&stats.drops[source], count);
+
+	if (source != RAS_DROP_DB)
+		atomic_fetch_add(&stats.input_lost, 1);
+	atomic_fetch_add(&stats.changed, 1);
+}
+
+uint64_t ras_stats_drops(enum ras_drop_source source)
+{
+	return atomic_load(&stats.drops[source]);
+}
+
+/*
+ * Used by the threshold policies counting the Corrected Errors of @what:
+ * if events were lost before reaching the handlers since the last call
+ * with the same @seen, warns that the count may be too low, and returns
+ * true. The policies only warn: a loss can't be told to a page or CPU.
+ */
+bool ras_stats_ce_lost(unsigned long *seen, const char *what)
+{
+	unsigned long val = atomic_load(&stats.input_lost);
+
+	if (val == *seen)
+		return false;
+
+	*seen = val;
+	log(TERM, LOG_WARNING,
+	    "Events were lost: %s Corrected Errors may be under-counted\n",
+	    what);
+
+	return true;
+}
+
+void ras_stats_log(void)
+{
+	uint64_t val, drops[NR_RAS_DROPS];
+	unsigned int i, j;
+
+	for (j = 0; j < NR_RAS_DROPS; j++)
+		drops[j] = atomic_load(&stats.drops[j]);
+
+	log(ALL, LOG_INFO, "Lost events: %llu at kernel, %llu at queue, %llu at database\n",
+	    (unsigned long long)drops[RAS_DROP_KERNEL],
+	    (unsigned long long)drops[RAS_DROP_QUEUE],
+	    (unsigned long long)drops[RAS_DROP_DB]);
+
+	for (i = 0; i < stats.n_cpus; i++) {
+		for (j = 0; j < NR_RAS_DROPS; j++)
+			drops[j] = atomic_load(&stats.cpu_drops[i][j]);
+		if (!drops[RAS_DROP_KERNEL] && !drops[RAS_DROP_QUEUE])
+			continue;
+
+		log(ALL, LOG_INFO, "  cpu %u: %llu lost at kernel, %llu at queue\n",
+		    i, (unsigned long long)drops[RAS_DROP_KERNEL],
+		    (unsigned long long)drops[RAS_DROP_QUEUE]);
+	}
+
+	for (i = 0; i < NR_EVENTS; i++) {
+		val = atomic_load(&stats.events[i]);
+		drops[RAS_DROP_DB] = atomic_load(&stats.event_drops[i][RAS_DROP_DB]);
+		if (!val && !drops[RAS_DROP_DB])
+			continue;
+
+		log(ALL, LOG_INFO, "  %s: %llu events, %llu not stored\n",
+		    event_names[i], (unsigned long long)val,
+		    (unsigned long long)drops[RAS_DROP_DB]);
+	}
+
+	ras_sink_log();
+}
+
+static void store_drops(struct ras_events *ras, const char *timestamp,
+			int source, int cpu, int event, uint64_t count)
+{
+	struct ras_lost_event ev = {
+		.source = drop_sources[source],
+		.cpu = cpu,
+		.event = event >= 0 ? event_names[event] : "",
+		.count = count,
+	};
+
+	strscpy(ev.timestamp, timestamp, sizeof(ev.timestamp));
+	ras_store_lost_event(ras, &ev);
+}
+
+/* Store the losses since the last call. Called by the decoder thread */
+void ras_stats_store(struct ras_events *ras)
+{
+	unsigned long changed = atomic_load(&stats.changed);
+	char timestamp[64];
+	unsigned int i, j;
+	uint64_t val;
+	time_t now;
+	struct tm tm;
+
+	if (changed == stats.stored || !ras->db_priv)
+		return;
+	stats.stored = changed;
+
+	now = time(NULL);
+	localtime_r(&now, &tm);
+	strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S %z", &tm);
+
+	for (i = 0; i < stats.n_cpus; i++) {
+		for (j = 0; j < NR_RAS_DROPS; j++) {
+			val = atomic_load(&stats.cpu_drops[i][j]);
+			if (val == stats.cpu_stored[i][j])
+				continue;
+
+			store_drops(ras, timestamp, j, i, -1,
+				    val - stats.cpu_stored[i][j]);
+			stats.cpu_stored[i][j] = val;
+		}
+	}
+
+	/* Kernel and queue losses were already stored per CPU */
+	for (i = 0; i < NR_EVENTS; i++) {
+		val = atomic_load(&stats.event_drops[i][RAS_DROP_DB]);
+		if (val == stats.event_stored[i][RAS_DROP_DB])
+			continue;
+
+		store_drops(ras, timestamp, RAS_DROP_DB, -1, i,
+			    val - stats.event_stored[i][RAS_DROP_DB]);
+		stats.event_stored[i][RAS_DROP_DB] = val;
+	}
+}
@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Event and lost event counters
+ */
+
+#ifndef __RAS_STATS_H
+#define __RAS_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct ras_events;
+
+enum ras_drop_source {
+	RAS_DROP_KERNEL,	/* Overwritten at the Kernel ring buffer */
+	RAS_DROP_QUEUE,		/* Dropped at the event pipeline */
+	RAS_DROP_DB,		/* Failed to be stored at the database */
+	NR_RAS_DROPS
+};
+
+int ras_stats_init(unsigned int n_cpus);
+void ras_stats_free(void);
+
+const char *ras_stats_event_name(int event);
+const char *ras_stats_drop_name(enum ras_drop_source source);
+void ras_stats_event(int event);
+void ras_stats_drop(enum ras_drop_source source, int cpu, int event,
+		    uint64_t count);
+uint64_t ras_stats_drops(enum ras_drop_source source);
+bool ras_stats_ce_lost(unsigned long *seen, const char *what);
+
+void ras_stats_log(void);
+void ras_stats_store(struct ras_events *ras);
+
+#endif
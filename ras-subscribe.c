@@ -0,0 +1,953 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Live event subscriptions
+ *
+ * Clients connect to the Unix socket set by SUBSCRIBE_SOCKET, that only
+ * root and SUBSCRIBE_SOCKET_GROUP can connect, and send a line with their
+ * filter, as space separated options:
+ *	format=ndjson|json|binary	defaults to ndjson
+ *	events=mc_event,aer_event	defaults to all
+ *	severity=corrected		the minimum severity
+ *	<column>=<value>		only events with this value
+ * e.g.:
+ *	format=json events=mc_event severity=corrected mc=0
+ * The daemon answers with "OK", or with "ERR <reason>" and hangs up, also
+ * if the line didn't come within REQUEST_TIMEOUT_MS. The matching events
+ * are then streamed:
+ *	ndjson	a JSON object per line
+ *	json	JSON objects, each prefixed by its uint32_t length
+ *	binary	struct ras_sub_msg, followed by the packed event. The table
+ *		of each event type is sent once, before its first event.
+ *
+ * Each client has a ring of its own, filled by the event decoder thread
+ * and drained by a single I/O thread, so a slow client never blocks the
+ * decoder or the other clients. When its ring is full, the events are
+ * dropped and counted; the count is sent before the next event fitting
+ * the ring, as {"dropped":N} or as a RAS_SUB_MSG_DROPPED message.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <grp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ras-events.h"
+#include "ras-logger.h"
+#include "ras-record.h"
+#include "ras-sink.h"
+#include "ras-subscribe.h"
+#include "ras-tables.h"
+#include "types.h"
+
+#define SUBSCRIBE_SOCKET	"SUBSCRIBE_SOCKET"
+#define SUBSCRIBE_SOCKET_GROUP	"SUBSCRIBE_SOCKET_GROUP"
+#define SUBSCRIBE_RING_KB	"SUBSCRIBE_RING_KB"
+#define SUBSCRIBE_MAX_CLIENTS	"SUBSCRIBE_MAX_CLIENTS"
+
+#define DEFAULT_RING_KB		64
+#define DEFAULT_MAX_CLIENTS	16
+#define MAX_CLIENTS		256
+
+#define MAX_FILTERS		8
+#define FILTER_VALUE_SIZE	64
+#define REQUEST_SIZE		512
+#define REQUEST_TIMEOUT_MS	5000
+
+enum sub_format {
+	SUB_NDJSON,
+	SUB_JSON,
+	SUB_BINARY,
+	NR_SUB_FORMATS
+};
+
+static const char * const format_names[NR_SUB_FORMATS] = {
+	[SUB_NDJSON] = "ndjson",
+	[SUB_JSON] = "json",
+	[SUB_BINARY] = "binary",
+};
+
+/* Matches a column of the event table */
+struct sub_filter {
+	char		name[FILTER_VALUE_SIZE];
+	char		value[FILTER_VALUE_SIZE];
+	long long	ival;
+	bool		is_int;
+};
+
+struct sub_client {
+	int			fd;
+	bool			subscribed;
+	bool			eof;		/* Shut down its writes */
+
+	/* Subscription request */
+	char			req[REQUEST_SIZE];
+	size_t			req_len;
+	int64_t			deadline_ms;
+
+	/* Filter */
+	enum sub_format		format;
+	uint64_t		types;
+	enum ras_severity	min_severity;
+	struct sub_filter	filters[MAX_FILTERS];
+	unsigned int		nr_filters;
+
+	/* Tables sent, as BIT_ULL(type) */
+	uint64_t		tables;
+
+	/*
+	 * Ring, filled by the decoder at head and drained by the I/O thread
+	 * at tail. Both are protected by sub.lock, but the bytes between
+	 * them are only sent by the I/O thread, out of the lock.
+	 */
+	char			*ring;
+	uint64_t		head;
+	uint64_t		tail;
+
+	uint64_t		events;
+	uint64_t		dropped;
+	uint64_t		dropped_sent;
+};
+
+/* Encoding buffers, only used by the decoder */
+struct sub_buf {
+	char			*data;
+	size_t			size;
+	size_t			len;
+};
+
+static struct {
+	pthread_mutex_t		lock;
+	struct sub_client	**clients;
+	unsigned int		max_clients;
+	size_t			ring_size;
+
+	int			fd;
+	int			wake_fd;
+	atomic_bool		wake_pending;
+	atomic_bool		stop;
+	pthread_t		thread;
+	bool			running;
+	bool			enabled;
+	char			path[108];
+
+	struct sub_buf		json;
+	struct sub_buf		packed;
+	struct sub_buf		table;
+} sub = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.fd = -1,
+	.wake_fd = -1,
+};
+
+/*
+ * Ring
+ */
+
+static size_t ring_room(struct sub_client *c)
+{
+	return sub.ring_size - (c->head - c->tail);
+}
+
+static void ring_put(struct sub_client *c, const void *data, size_t len)
+{
+	size_t off = c->head & (sub.ring_size - 1);
+	size_t n = len < sub.ring_size - off ? len : sub.ring_size - off;
+
+	memcpy(c->ring + off, data, n);
+	memcpy(c->ring, (const char *)data + n, len - n);
+	c->head += len;
+}
+
+/* Queues a message, prefixed by @hdr, if it fits the ring */
+static bool ring_put_msg(struct sub_client *c, const void *hdr,
+			 size_t hdr_len, const void *data, size_t len)
+{
+	if (hdr_len + len > ring_room(c))
+		return false;
+
+	if (hdr_len)
+		ring_put(c, hdr, hdr_len);
+	ring_put(c, data, len);
+
+	return true;
+}
+
+static bool queue_text(struct sub_client *c, const char *text, size_t len)
+{
+	uint32_t prefix = len;
+
+	switch (c->format) {
+	case SUB_NDJSON:
+		/* The text is followed by its newline */
+		return ring_put_msg(c, NULL, 0, text, len + 1);
+	case SUB_JSON:
+		return ring_put_msg(c, &prefix, sizeof(prefix), text, len);
+	default:
+		return false;
+	}
+}
+
+static bool queue_binary(struct sub_client *c, int type, int event,
+			 int severity, const void *data, size_t len)
+{
+	struct ras_sub_msg hdr = {
+		.len = sizeof(hdr) + len,
+		.type = type,
+		.event = event,
+		.severity = severity,
+	};
+
+	return ring_put_msg(c, &hdr, sizeof(hdr), data, len);
+}
+
+/* Tells the client about the events dropped since the last notice */
+static bool queue_dropped(struct sub_client *c)
+{
+	uint64_t dropped = c->dropped;
+	char text[48];
+	int len;
+
+	if (c->dropped == c->dropped_sent)
+		return true;
+
+	if (c->format == SUB_BINARY) {
+		if (!queue_binary(c, RAS_SUB_MSG_DROPPED, 0, 0, &dropped,
+				  sizeof(dropped)))
+			return false;
+	} else {
+		len = snprintf(text, sizeof(text), "{\"dropped\":%llu}\n",
+			       (unsigned long long)dropped);
+		if (!queue_text(c, text, len - 1))
+			return false;
+	}
+	c->dropped_sent = dropped;
+
+	return true;
+}
+
+static void subscribe_wake(void)
+{
+	uint64_t one = 1;
+
+	if (atomic_exchange(&sub.wake_pending, true))
+		return;
+
+	if (write(sub.wake_fd, &one, sizeof(one)) < 0)
+		atomic_store(&sub.wake_pending, false);
+}
+
+/*
+ * Event sink
+ */
+
+static char *buf_reserve(struct sub_buf *b, size_t size)
+{
+	char *data;
+
+	if (size > b->size) {
+		data = realloc(b->data, size);
+		if (!data)
+			return NULL;
+		b->data = data;
+		b->size = size;
+	}
+
+	return b->data;
+}
+
+static bool client_match(struct sub_client *c,
+			 const struct ras_sink_event *event,
+			 const struct db_table_descriptor *tab)
+{
+	const struct db_fields *field;
+	struct sub_filter *f;
+	const char *str;
+	unsigned int i;
+	size_t len;
+
+	if (!c->subscribed || !(c->types & BIT_ULL(event->type)) ||
+	    event->severity < c->min_severity)
+		return false;
+
+	for (i = 0; i < c->nr_filters; i++) {
+		f = &c->filters[i];
+		field = ras_table_field(tab, f->name);
+		if (!field)
+			return false;
+
+		switch (ras_field_kind(field)) {
+		case RAS_VALUE_INT:
+			if (!f->is_int || db_field_int(field, event->ev) != f->ival)
+				return false;
+			break;
+		case RAS_VALUE_TEXT:
+			str = db_field_text(field, event->ev, &len);
+			if (!str || len != strlen(f->value) ||
+			    memcmp(str, f->value, len))
+				return false;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* The event, as a JSON object followed by a newline */
+static int encode_json(const struct ras_sink_event *event,
+		       const struct db_table_descriptor *tab)
+{
+	char *p;
+
+	p = buf_reserve(&sub.json, ras_event_json_object_len(tab, event));
+	if (!p)
+		return -ENOMEM;
+
+	p = ras_event_json_object(tab, event, p);
+	*p = '\n';
+	sub.json.len = p - sub.json.data;
+
+	return 0;
+}
+
+static int encode_packed(const struct ras_sink_event *event,
+			 const struct db_table_descriptor *tab)
+{
+	char *p;
+
+	p = buf_reserve(&sub.packed, ras_event_packed_len(tab, event->ev));
+	if (!p)
+		return -ENOMEM;
+
+	sub.packed.len = ras_event_pack(tab, event->ev, p) - p;
+
+	return 0;
+}
+
+static bool queue_event(struct sub_client *c,
+			const struct ras_sink_event *event,
+			const struct db_table_descriptor *tab)
+{
+	char *p;
+
+	if (c->format != SUB_BINARY)
+		return queue_text(c, sub.json.data, sub.json.len);
+
+	if (!(c->tables & BIT_ULL(event->type))) {
+		p = buf_reserve(&sub.table, ras_table_desc_len(tab));
+		if (!p)
+			return false;
+		sub.table.len = ras_table_desc(tab, p) - p;
+
+		/* The table and its first event go together */
+		if (sizeof(struct ras_sub_msg) * 2 + sub.table.len +
+		    sub.packed.len > ring_room(c))
+			return false;
+
+		queue_binary(c, RAS_SUB_MSG_TABLE, event->type, 0,
+			     sub.table.data, sub.table.len);
+		c->tables |= BIT_ULL(event->type);
+	}
+
+	return queue_binary(c, RAS_SUB_MSG_EVENT, event->type, event->severity,
+			    sub.packed.data, sub.packed.len);
+}
+
+static int subscribe_sink_emit(struct ras_events *ras,
+			       const struct ras_sink_event *event)
+{
+	const struct db_table_descriptor *tab = ras_event_table(event->type);
+	bool encoded[NR_SUB_FORMATS] = { };
+	bool queued = false, dropped = false;
+	struct sub_client *c;
+	unsigned int i;
+	int rc = 0;
+
+	if (!tab)
+		return 0;
+
+	pthread_mutex_lock(&sub.lock);
+	for (i = 0; sub.clients && i < sub.max_clients; i++) {
+		c = sub.clients[i];
+		if (!c || !client_match(c, event, tab))
+			continue;
+
+		/* Encoded once per format, for all clients */
+		if (!encoded[c->format]) {
+			if (c->format == SUB_BINARY)
+				rc = encode_packed(event, tab);
+			else
+				rc = encode_json(event, tab);
+			if (rc < 0)
+				break;
+			encoded[SUB_BINARY] |= c->format == SUB_BINARY;
+			encoded[SUB_NDJSON] |= c->format != SUB_BINARY;
+			encoded[SUB_JSON] |= c->format != SUB_BINARY;
+		}
+
+		if (queue_dropped(c) && queue_event(c, event, tab)) {
+			c->events++;
+			queued = true;
+		} else {
+			c->dropped++;
+			dropped = true;
+		}
+	}
+	pthread_mutex_unlock(&sub.lock);
+
+	if (queued)
+		subscribe_wake();
+
+	if (rc < 0)
+		return rc;
+
+	return dropped ? -ENOBUFS : 0;
+}
+
+static struct ras_sink subscribe_sink = {
+	.name = "subscribe",
+	.emit = subscribe_sink_emit,
+	.types = RAS_SINK_ALL_EVENTS,
+	.min_severity = RAS_SEV_INFO,
+};
+
+/*
+ * Clients
+ */
+
+static int parse_filter(struct sub_client *c, const char *name,
+			const char *value)
+{
+	struct sub_filter *f;
+	char *end;
+
+	if (c->nr_filters == MAX_FILTERS)
+		return -E2BIG;
+	if (strlen(name) >= sizeof(f->name) ||
+	    strlen(value) >= sizeof(f->value))
+		return -ENAMETOOLONG;
+
+	f = &c->filters[c->nr_filters++];
+	strcpy(f->name, name);
+	strcpy(f->value, value);
+
+	errno = 0;
+	f->ival = strtoll(value, &end, 0);
+	f->is_int = *value && !*end && !errno;
+
+	return 0;
+}
+
+/* Parses the subscription request. Returns the reason of an error */
+static const char *parse_request(struct sub_client *c, char *req)
+{
+	char *p, *tok, *value, *saveptr;
+	int i;
+
+	c->format = SUB_NDJSON;
+	c->types = RAS_SINK_ALL_EVENTS;
+	c->min_severity = RAS_SEV_INFO;
+
+	for (p = req; (tok = strtok_r(p, " \t\r", &saveptr)); p = NULL) {
+		value = strchr(tok, '=');
+		if (!value)
+			return "invalid option";
+		*value++ = '\0';
+
+		if (!strcmp(tok, "format")) {
+			for (i = 0; i < NR_SUB_FORMATS; i++) {
+				if (!strcmp(value, format_names[i]))
+					break;
+			}
+			if (i == NR_SUB_FORMATS)
+				return "unknown format";
+			c->format = i;
+		} else if (!strcmp(tok, "events")) {
+			if (ras_sink_parse_events(value, &c->types))
+				return "unknown event";
+		} else if (!strcmp(tok, "severity")) {
+			i = ras_severity_by_name(value);
+			if (i < 0)
+				return "unknown severity";
+			c->min_severity = i;
+		} else if (parse_filter(c, tok, value)) {
+			return "invalid filter";
+		}
+	}
+
+	return NULL;
+}
+
+static void client_reply(int fd, const char *fmt, const char *arg)
+{
+	char reply[128];
+	int len;
+
+	len = snprintf(reply, sizeof(reply), fmt, arg);
+	if (send(fd, reply, len, MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+		log(TERM, LOG_DEBUG, "Can't answer a subscriber: %s\n",
+		    strerror(errno));
+}
+
+/* Reads the subscription request. Returns < 0 to close the client */
+static int client_read(struct sub_client *c)
+{
+	const char *reason;
+	char buf[256];
+	char *eol;
+	ssize_t n;
+
+	if (c->subscribed) {
+		/* Nothing more is expected, but it may still read */
+		n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+		if (n < 0)
+			return errno == EAGAIN || errno == EINTR ? 0 : -errno;
+		if (!n)
+			c->eof = true;
+
+		return 0;
+	}
+
+	n = recv(c->fd, c->req + c->req_len, sizeof(c->req) - c->req_len - 1,
+		 MSG_DONTWAIT);
+	if (n < 0)
+		return errno == EAGAIN || errno == EINTR ? 0 : -errno;
+	if (!n)
+		return -ECONNRESET;
+
+	c->req_len += n;
+	c->req[c->req_len] = '\0';
+
+	eol = strchr(c->req, '\n');
+	if (!eol) {
+		if (c->req_len < sizeof(c->req) - 1)
+			return 0;
+		client_reply(c->fd, "ERR %s\n", "request too long");
+		return -EINVAL;
+	}
+	*eol = '\0';
+
+	reason = parse_request(c, c->req);
+	if (reason) {
+		client_reply(c->fd, "ERR %s\n", reason);
+		return -EINVAL;
+	}
+
+	/* Queued, so it is followed by the events */
+	pthread_mutex_lock(&sub.lock);
+	ring_put(c, "OK\n", 3);
+	c->subscribed = true;
+	pthread_mutex_unlock(&sub.lock);
+
+	log(ALL, LOG_INFO, "New %s event subscriber\n",
+	    format_names[c->format]);
+
+	return 0;
+}
+
+/* Sends what the ring has. Returns < 0 to close the client */
+static int client_write(struct sub_client *c)
+{
+	size_t off, len;
+	ssize_t n;
+
+	pthread_mutex_lock(&sub.lock);
+	off = c->tail & (sub.ring_size - 1);
+	len = c->head - c->tail;
+	if (len > sub.ring_size - off)
+		len = sub.ring_size - off;
+	pthread_mutex_unlock(&sub.lock);
+
+	if (!len)
+		return 0;
+
+	n = send(c->fd, c->ring + off, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (n < 0)
+		return errno == EAGAIN || errno == EINTR ? 0 : -errno;
+
+	pthread_mutex_lock(&sub.lock);
+	c->tail += n;
+	pthread_mutex_unlock(&sub.lock);
+
+	return 0;
+}
+
+static void client_free(struct sub_client *c)
+{
+	close(c->fd);
+	free(c->ring);
+	free(c);
+}
+
+static void client_close(unsigned int slot)
+{
+	struct sub_client *c;
+
+	pthread_mutex_lock(&sub.lock);
+	c = sub.clients[slot];
+	sub.clients[slot] = NULL;
+	pthread_mutex_unlock(&sub.lock);
+
+	if (c->subscribed)
+		log(ALL, LOG_INFO,
+		    "Event subscriber gone: %llu events, %llu dropped\n",
+		    (unsigned long long)c->events,
+		    (unsigned long long)c->dropped);
+
+	client_free(c);
+}
+
+static int64_t now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void client_accept(void)
+{
+	struct sub_client *c;
+	unsigned int i;
+	int fd;
+
+	fd = accept4(sub.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0) {
+		if (errno != EAGAIN && errno != EINTR &&
+		    errno != ECONNABORTED)
+			log(ALL, LOG_ERR,
+			    "Can't accept event subscribers: %s\n",
+			    strerror(errno));
+		return;
+	}
+
+	/* Only the I/O thread adds clients, so a free slot stays free */
+	for (i = 0; i < sub.max_clients; i++) {
+		if (!sub.clients[i])
+			break;
+	}
+	if (i == sub.max_clients) {
+		client_reply(fd, "ERR %s\n", "too many subscribers");
+		close(fd);
+		return;
+	}
+
+	c = calloc(1, sizeof(*c));
+	if (c)
+		c->ring = malloc(sub.ring_size);
+	if (!c || !c->ring) {
+		client_reply(fd, "ERR %s\n", "out of memory");
+		free(c);
+		close(fd);
+		return;
+	}
+	c->fd = fd;
+	c->deadline_ms = now_ms() + REQUEST_TIMEOUT_MS;
+
+	pthread_mutex_lock(&sub.lock);
+	sub.clients[i] = c;
+	pthread_mutex_unlock(&sub.lock);
+}
+
+/*
+ * I/O thread
+ */
+
+/*
+ * Closes the clients that didn't send their request in time, so idle
+ * connections can't hold the slots. Returns the time until the next
+ * deadline, for poll().
+ */
+static int client_expire(void)
+{
+	int64_t now = now_ms(), wait = -1;
+	struct sub_client *c;
+	unsigned int i;
+
+	for (i = 0; i < sub.max_clients; i++) {
+		c = sub.clients[i];
+		if (!c || c->subscribed)
+			continue;
+
+		if (c->deadline_ms <= now) {
+			client_reply(c->fd, "ERR %s\n", "request timeout");
+			client_close(i);
+		} else if (wait < 0 || c->deadline_ms - now < wait) {
+			wait = c->deadline_ms - now;
+		}
+	}
+
+	return wait;
+}
+
+static void *subscribe_thread(void *arg)
+{
+	unsigned int slots[MAX_CLIENTS];
+	struct pollfd *pfd;
+	struct sub_client *c;
+	unsigned int i, n;
+	uint64_t count;
+	int rc = 0, wait;
+
+	pfd = calloc(sub.max_clients + 2, sizeof(*pfd));
+	if (!pfd) {
+		log(ALL, LOG_ERR, "Can't allocate the subscriber poll fds\n");
+		return NULL;
+	}
+
+	while (!atomic_load(&sub.stop)) {
+		wait = client_expire();
+
+		pfd[0].fd = sub.fd;
+		pfd[0].events = POLLIN;
+		pfd[1].fd = sub.wake_fd;
+		pfd[1].events = POLLIN;
+		n = 2;
+
+		pthread_mutex_lock(&sub.lock);
+		for (i = 0; i < sub.max_clients; i++) {
+			c = sub.clients[i];
+			if (!c)
+				continue;
+
+			slots[n - 2] = i;
+			pfd[n].fd = c->fd;
+			pfd[n].events = c->eof ? 0 : POLLIN;
+			if (c->head != c->tail)
+				pfd[n].events |= POLLOUT;
+			pfd[n].revents = 0;
+			n++;
+		}
+		pthread_mutex_unlock(&sub.lock);
+
+		if (poll(pfd, n, wait) < 0) {
+			if (errno == EINTR)
+				continue;
+			log(ALL, LOG_ERR, "Can't poll the event subscribers: %s\n",
+			    strerror(errno));
+			break;
+		}
+
+		if (pfd[1].revents & POLLIN) {
+			if (read(sub.wake_fd, &count, sizeof(count)) < 0)
+				log(TERM, LOG_DEBUG, "Can't read the wakeup: %s\n",
+				    strerror(errno));
+			atomic_store(&sub.wake_pending, false);
+		}
+
+		for (i = 2; i < n; i++) {
+			c = sub.clients[slots[i - 2]];
+
+			if (pfd[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+				rc = -EPIPE;
+			else if (pfd[i].revents & POLLIN)
+				rc = client_read(c);
+			if (!rc && pfd[i].revents & POLLOUT)
+				rc = client_write(c);
+
+			if (rc < 0) {
+				client_close(slots[i - 2]);
+				rc = 0;
+			}
+		}
+
+		if (pfd[0].revents & POLLIN)
+			client_accept();
+	}
+
+	free(pfd);
+
+	return NULL;
+}
+
+/*
+ * Setup
+ */
+
+/* Lets the group set by SUBSCRIBE_SOCKET_GROUP connect, besides root */
+static int socket_group(const char *path)
+{
+	char *env = getenv(SUBSCRIBE_SOCKET_GROUP);
+	struct group *gr;
+
+	if (!env || !*env)
+		return 0;
+
+	gr = getgrnam(env);
+	if (!gr) {
+		log(ALL, LOG_ERR, "Unknown %s=%s\n", SUBSCRIBE_SOCKET_GROUP, env);
+		errno = EINVAL;
+		return -1;
+	}
+
+	return chown(path, -1, gr->gr_gid);
+}
+
+static int subscribe_listen(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct stat st;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		log(ALL, LOG_ERR, "Subscription socket path %s is too long\n",
+		    path);
+		return -ENAMETOOLONG;
+	}
+	strcpy(addr.sun_path, path);
+
+	/* Left behind by a previous run */
+	if (!lstat(path, &st) && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto error;
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    socket_group(path) || chmod(path, 0660) || listen(fd, 8))
+		goto error;
+
+	return fd;
+
+error:
+	log(ALL, LOG_ERR, "Can't listen at the subscription socket %s: %s\n",
+	    path, strerror(errno));
+	if (fd >= 0)
+		close(fd);
+
+	return -errno;
+}
+
+static unsigned long env_ulong(const char *name, unsigned long def,
+			       unsigned long max)
+{
+	char *env = getenv(name);
+	unsigned long val;
+	char *end;
+
+	if (!env || !*env)
+		return def;
+
+	val = strtoul(env, &end, 0);
+	if (*end || !val || val > max) {
+		log(ALL, LOG_WARNING, "Invalid %s=%s, using %lu\n", name, env,
+		    def);
+		return def;
+	}
+
+	return val;
+}
+
+/* Should be called before the events are enabled */
+void ras_subscribe_setup(void)
+{
+	char *env = getenv(SUBSCRIBE_SOCKET);
+	size_t ring_kb;
+
+	if (sub.enabled || !env || !*env)
+		return;
+
+	ring_kb = env_ulong(SUBSCRIBE_RING_KB, DEFAULT_RING_KB, 1 << 20);
+	sub.ring_size = 1024;
+	while (sub.ring_size < ring_kb * 1024)
+		sub.ring_size <<= 1;
+
+	sub.max_clients = env_ulong(SUBSCRIBE_MAX_CLIENTS, DEFAULT_MAX_CLIENTS,
+				    MAX_CLIENTS);
+	sub.clients = calloc(sub.max_clients, sizeof(*sub.clients));
+	if (!sub.clients) {
+		log(ALL, LOG_ERR, "Can't allocate the event subscribers\n");
+		return;
+	}
+
+	sub.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (sub.wake_fd < 0) {
+		log(ALL, LOG_ERR, "Can't create the subscription eventfd: %s\n",
+		    strerror(errno));
+		ras_subscribe_close();
+		return;
+	}
+
+	sub.fd = subscribe_listen(env);
+	if (sub.fd < 0) {
+		ras_subscribe_close();
+		return;
+	}
+	strscpy(sub.path, env, sizeof(sub.path));
+
+	atomic_store(&sub.stop, false);
+	if (pthread_create(&sub.thread, NULL, subscribe_thread, NULL)) {
+		log(ALL, LOG_ERR, "Can't create the subscription thread\n");
+		ras_subscribe_close();
+		return;
+	}
+	sub.running = true;
+	sub.enabled = true;
+
+	ras_sink_register(&subscribe_sink);
+
+	log(ALL, LOG_INFO,
+	    "Serving event subscriptions at %s, %zu KiB per client\n",
+	    sub.path, sub.ring_size / 1024);
+}
+
+void ras_subscribe_close(void)
+{
+	struct sub_client **clients;
+	unsigned int i;
+
+	if (sub.running) {
+		atomic_store(&sub.stop, true);
+		atomic_store(&sub.wake_pending, false);
+		subscribe_wake();
+		pthread_join(sub.thread, NULL);
+		sub.running = false;
+	}
+
+	if (sub.fd >= 0) {
+		close(sub.fd);
+		unlink(sub.path);
+		sub.fd = -1;
+	}
+
+	if (sub.wake_fd >= 0) {
+		close(sub.wake_fd);
+		sub.wake_fd = -1;
+	}
+
+	/* The sink stays registered, but finds no clients */
+	pthread_mutex_lock(&sub.lock);
+	clients = sub.clients;
+	sub.clients = NULL;
+	pthread_mutex_unlock(&sub.lock);
+
+	if (clients) {
+		for (i = 0; i < sub.max_clients; i++) {
+			if (clients[i])
+				client_free(clients[i]);
+		}
+		free(clients);
+	}
+
+	free(sub.json.data);
+	free(sub.packed.data);
+	free(sub.table.data);
+	memset(&sub.json, 0, sizeof(sub.json));
+	memset(&sub.packed, 0, sizeof(sub.packed));
+	memset(&sub.table, 0, sizeof(sub.table));
+}
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Live event subscriptions
+ */
+
+#ifndef __RAS_SUBSCRIBE_H
+#define __RAS_SUBSCRIBE_H
+
+#include <stdint.h>
+
+/*
+ * Binary format: each message has this header, followed by its payload.
+ * Integers are in the host byte order.
+ */
+enum ras_sub_msg_type {
+	RAS_SUB_MSG_TABLE = 1,		/* Table description */
+	RAS_SUB_MSG_EVENT,		/* Packed event */
+	RAS_SUB_MSG_DROPPED,		/* uint64_t events dropped so far */
+};
+
+struct ras_sub_msg {
+	uint32_t	len;		/* Of the header and the payload */
+	uint16_t	type;		/* enum ras_sub_msg_type */
+	uint16_t	event;		/* MC_EVENT, AER_EVENT, ... */
+	uint8_t		severity;	/* enum ras_severity */
+	uint8_t		reserved[7];
+};
+
+void ras_subscribe_setup(void);
+void ras_subscribe_close(void);
+
+#endif
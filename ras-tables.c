@@ -0,0 +1,1044 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Event tables
+ *
+ * The columns of each event, and where their values are at the event
+ * struct. They are used to store the events at the database, but also by
+ * the outputs that don't need it, like the event subscriptions, so they
+ * are built even without SQLite.
+ *
+ * The values may be packed, as at the binary event log and the staging
+ * ring: the values of the columns taken from the event, in the table
+ * order, integers as int64_t, strings and blobs as their uint32_t length,
+ * RAS_VALUE_NULL_LEN for NULL, followed by their bytes. The columns are
+ * described by the table name, followed by the kind, name and SQL type
+ * of each column, with their NULs.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "ras-events.h"
+#include "ras-mce-handler.h"
+#include "ras-record.h"
+#include "ras-reri-handler.h"
+#include "ras-sink.h"
+#include "ras-stats.h"
+#include "ras-tables.h"
+#include "types.h"
+
+/*
+ * Table of the events lost by rasdaemon
+ */
+static const struct db_fields lost_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_lost_event, timestamp),
+	DB_FIELD_STR("source",		struct ras_lost_event, source),
+	DB_FIELD_INT("cpu",		struct ras_lost_event, cpu),
+	DB_FIELD_STR("event",		struct ras_lost_event, event),
+	DB_FIELD_INT("count",		struct ras_lost_event, count),
+};
+
+const struct db_table_descriptor lost_event_tab = {
+	.name = "lost_event",
+	.fields = lost_event_fields,
+	.num_fields = ARRAY_SIZE(lost_event_fields),
+};
+
+/*
+ * Table of ras:mc_event
+ */
+static const struct db_fields mc_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_mc_event, timestamp),
+	DB_FIELD_INT("err_count",	struct ras_mc_event, error_count),
+	DB_FIELD_STR("err_type",	struct ras_mc_event, error_type),
+	DB_FIELD_STR("err_msg",		struct ras_mc_event, msg),
+	DB_FIELD_STR("label",		struct ras_mc_event, label),
+	DB_FIELD_INT("mc",		struct ras_mc_event, mc_index),
+	DB_FIELD_INT("top_layer",	struct ras_mc_event, top_layer),
+	DB_FIELD_INT("middle_layer",	struct ras_mc_event, middle_layer),
+	DB_FIELD_INT("lower_layer",	struct ras_mc_event, lower_layer),
+	DB_FIELD_INT("address",		struct ras_mc_event, address),
+	DB_FIELD_INT("grain",		struct ras_mc_event, grain),
+	DB_FIELD_INT("syndrome",	struct ras_mc_event, syndrome),
+	DB_FIELD_STR("driver_detail",	struct ras_mc_event, driver_detail),
+};
+
+const struct db_table_descriptor mc_event_tab = {
+	.name = "mc_event",
+	.fields = mc_event_fields,
+	.num_fields = ARRAY_SIZE(mc_event_fields),
+	.rollup = "err_type, label, mc, top_layer, middle_layer, lower_layer",
+	.coalesce = true,
+};
+
+/*
+ * Table of ras:aer
+ */
+#ifdef HAVE_AER
+static const struct db_fields aer_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_aer_event, timestamp),
+	DB_FIELD_STR("dev_name",	struct ras_aer_event, dev_name),
+	DB_FIELD_STR("err_type",	struct ras_aer_event, error_type),
+	DB_FIELD_STR("err_msg",		struct ras_aer_event, msg),
+};
+
+const struct db_table_descriptor aer_event_tab = {
+	.name = "aer_event",
+	.fields = aer_event_fields,
+	.num_fields = ARRAY_SIZE(aer_event_fields),
+	.rollup = "dev_name, err_type, err_msg",
+	.coalesce = true,
+};
+#endif
+
+/*
+ * Table of ras:non standard
+ */
+#ifdef HAVE_NON_STANDARD
+static const struct db_fields non_standard_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_non_standard_event, timestamp),
+	DB_FIELD_BLOB_PTR("sec_type",	struct ras_non_standard_event, sec_type, 16),
+	DB_FIELD_BLOB_PTR("fru_id",	struct ras_non_standard_event, fru_id, 16),
+	DB_FIELD_STR("fru_text",	struct ras_non_standard_event, fru_text),
+	DB_FIELD_STR("severity",	struct ras_non_standard_event, severity),
+	DB_FIELD_BLOB_LEN("error",	struct ras_non_standard_event, error, length),
+};
+
+const struct db_table_descriptor non_standard_event_tab = {
+	.name = "non_standard_event",
+	.fields = non_standard_event_fields,
+	.num_fields = ARRAY_SIZE(non_standard_event_fields),
+};
+#endif
+
+/*
+ * Table of ras:arm
+ */
+#ifdef HAVE_ARM
+static const struct db_fields arm_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_arm_event, timestamp),
+	DB_FIELD_INT("error_count",	struct ras_arm_event, error_count),
+	DB_FIELD_INT("affinity",	struct ras_arm_event, affinity),
+	DB_FIELD_INT("mpidr",		struct ras_arm_event, mpidr),
+	DB_FIELD_INT("running_state",	struct ras_arm_event, running_state),
+	DB_FIELD_INT("psci_state",	struct ras_arm_event, psci_state),
+	DB_FIELD_BLOB_LEN("err_info",	struct ras_arm_event, pei_error, pei_len),
+	DB_FIELD_BLOB_LEN("context_info", struct ras_arm_event, ctx_error, ctx_len),
+	DB_FIELD_BLOB_LEN("vendor_info", struct ras_arm_event, vsei_error, oem_len),
+	DB_FIELD_TEXT("error_type",	struct ras_arm_event, error_types),
+	DB_FIELD_TEXT("error_flags",	struct ras_arm_event, error_flags),
+	DB_FIELD_INT("error_info",	struct ras_arm_event, error_info),
+	DB_FIELD_INT("virt_fault_addr",	struct ras_arm_event, virt_fault_addr),
+	DB_FIELD_INT("phy_fault_addr",	struct ras_arm_event, phy_fault_addr),
+};
+
+const struct db_table_descriptor arm_event_tab = {
+	.name = "arm_event",
+	.fields = arm_event_fields,
+	.num_fields = ARRAY_SIZE(arm_event_fields),
+	.rollup = "mpidr",
+};
+#endif
+
+#ifdef HAVE_EXTLOG
+static const struct db_fields extlog_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_extlog_event, timestamp),
+	DB_FIELD_INT("etype",		struct ras_extlog_event, etype),
+	DB_FIELD_INT("error_count",	struct ras_extlog_event, error_seq),
+	DB_FIELD_INT("severity",	struct ras_extlog_event, severity),
+	DB_FIELD_INT("address",		struct ras_extlog_event, address),
+	DB_FIELD_BLOB_PTR("fru_id",	struct ras_extlog_event, fru_id, 16),
+	DB_FIELD_STR("fru_text",	struct ras_extlog_event, fru_text),
+	DB_FIELD_BLOB_LEN("cper_data",	struct ras_extlog_event, cper_data,
+			  cper_data_length),
+};
+
+const struct db_table_descriptor extlog_event_tab = {
+	.name = "extlog_event",
+	.fields = extlog_event_fields,
+	.num_fields = ARRAY_SIZE(extlog_event_fields),
+	.rollup = "etype, severity",
+};
+#endif
+
+/*
+ * Table of mce:mce_record
+ */
+#ifdef HAVE_MCE
+static const struct db_fields mce_record_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct mce_event, timestamp),
+
+	/* MCE registers */
+	DB_FIELD_INT("mcgcap",		struct mce_event, mcgcap),
+	DB_FIELD_INT("mcgstatus",	struct mce_event, mcgstatus),
+	DB_FIELD_INT("status",		struct mce_event, status),
+	DB_FIELD_INT("addr",		struct mce_event, addr),	// 5
+	DB_FIELD_INT("misc",		struct mce_event, misc),
+	DB_FIELD_INT("ip",		struct mce_event, ip),
+	DB_FIELD_INT("tsc",		struct mce_event, tsc),
+	DB_FIELD_INT("walltime",	struct mce_event, walltime),
+	DB_FIELD_INT("ppin",		struct mce_event, ppin),	// 10
+	DB_FIELD_INT("cpu",		struct mce_event, cpu),
+	DB_FIELD_INT("cpuid",		struct mce_event, cpuid),
+	DB_FIELD_INT("apicid",		struct mce_event, apicid),
+	DB_FIELD_INT("socketid",	struct mce_event, socketid),
+	DB_FIELD_INT("cs",		struct mce_event, cs),		// 15
+	DB_FIELD_INT("bank",		struct mce_event, bank),
+	DB_FIELD_INT("cpuvendor",	struct mce_event, cpuvendor),
+	DB_FIELD_INT("microcode",	struct mce_event, microcode),
+
+	/* Parsed data - will likely change */
+	DB_FIELD_TEXT("bank_name",	struct mce_event, bank_name),
+	DB_FIELD_TEXT("error_msg",	struct mce_event, error_msg),	// 20
+	DB_FIELD_TEXT("mcgstatus_msg",	struct mce_event, mcgstatus_msg),
+	DB_FIELD_TEXT("mcistatus_msg",	struct mce_event, mcistatus_msg),
+	DB_FIELD_TEXT("mcastatus_msg",	struct mce_event, mcastatus_msg),
+	DB_FIELD_TEXT("user_action",	struct mce_event, user_action),
+	DB_FIELD_TEXT("mc_location",	struct mce_event, mc_location),
+};
+
+const struct db_table_descriptor mce_record_tab = {
+	.name = "mce_record",
+	.fields = mce_record_fields,
+	.num_fields = ARRAY_SIZE(mce_record_fields),
+	.rollup = "cpu, bank, error_msg",
+};
+#endif
+
+/*
+ * Table of devlink:devlink_health_report
+ */
+#ifdef HAVE_DEVLINK
+static const struct db_fields devlink_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct devlink_event, timestamp),
+	DB_FIELD_STR("bus_name",	struct devlink_event, bus_name),
+	DB_FIELD_STR("dev_name",	struct devlink_event, dev_name),
+	DB_FIELD_STR("driver_name",	struct devlink_event, driver_name),
+	DB_FIELD_STR("reporter_name",	struct devlink_event, reporter_name),
+	DB_FIELD_STR("msg",		struct devlink_event, msg),
+};
+
+const struct db_table_descriptor devlink_event_tab = {
+	.name = "devlink_event",
+	.fields = devlink_event_fields,
+	.num_fields = ARRAY_SIZE(devlink_event_fields),
+	.rollup = "dev_name",
+};
+#endif
+
+/*
+ * Table of block:block_rq_{complete|error}
+ */
+#ifdef HAVE_DISKERROR
+static const struct db_fields diskerror_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct diskerror_event, timestamp),
+	DB_FIELD_STR("dev",		struct diskerror_event, dev),
+	DB_FIELD_INT("sector",		struct diskerror_event, sector),
+	DB_FIELD_INT("nr_sector",	struct diskerror_event, nr_sector),
+	DB_FIELD_STR("error",		struct diskerror_event, error),
+	DB_FIELD_STR("rwbs",		struct diskerror_event, rwbs),
+	DB_FIELD_STR("cmd",		struct diskerror_event, cmd),
+};
+
+const struct db_table_descriptor diskerror_event_tab = {
+	.name = "disk_errors",
+	.fields = diskerror_event_fields,
+	.num_fields = ARRAY_SIZE(diskerror_event_fields),
+	.rollup = "dev",
+};
+#endif
+
+/*
+ * Table of ras:memory_failure
+ */
+#ifdef HAVE_MEMORY_FAILURE
+static const struct db_fields mf_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_mf_event, timestamp),
+	DB_FIELD_TEXT("pfn",		struct ras_mf_event, pfn),
+	DB_FIELD_STR("page_type",	struct ras_mf_event, page_type),
+	DB_FIELD_STR("action_result",	struct ras_mf_event, action_result),
+};
+
+const struct db_table_descriptor mf_event_tab = {
+	.name = "memory_failure_event",
+	.fields = mf_event_fields,
+	.num_fields = ARRAY_SIZE(mf_event_fields),
+	.rollup = "action_result",
+};
+#endif
+
+#ifdef HAVE_CXL
+/*
+ * Table of cxl:cxl_poison
+ */
+static const struct db_fields cxl_poison_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_cxl_poison_event, timestamp),
+	DB_FIELD_STR("memdev",		struct ras_cxl_poison_event, memdev),
+	DB_FIELD_STR("host",		struct ras_cxl_poison_event, host),
+	DB_FIELD_INT("serial",		struct ras_cxl_poison_event, serial),
+	DB_FIELD_STR("trace_type",	struct ras_cxl_poison_event, trace_type),
+	DB_FIELD_STR("region",		struct ras_cxl_poison_event, region),
+	DB_FIELD_STR("region_uuid",	struct ras_cxl_poison_event, uuid),
+	DB_FIELD_INT("hpa",		struct ras_cxl_poison_event, hpa),
+	DB_FIELD_INT("dpa",		struct ras_cxl_poison_event, dpa),
+	DB_FIELD_INT("dpa_length",	struct ras_cxl_poison_event, dpa_length),
+	DB_FIELD_STR("source",		struct ras_cxl_poison_event, source),
+	DB_FIELD_INT("flags",		struct ras_cxl_poison_event, flags),
+	DB_FIELD_TEXT("overflow_ts",	struct ras_cxl_poison_event, overflow_ts),
+	DB_FIELD_INT("hpa_alias0",	struct ras_cxl_poison_event, hpa_alias0),
+};
+
+const struct db_table_descriptor cxl_poison_event_tab = {
+	.name = "cxl_poison_event",
+	.fields = cxl_poison_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_poison_event_fields),
+	.rollup = "memdev",
+};
+
+/*
+ * Table of cxl:cxl_aer_uncorrectable_error
+ */
+static const struct db_fields cxl_aer_ue_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_cxl_aer_ue_event, timestamp),
+	DB_FIELD_STR("memdev",		struct ras_cxl_aer_ue_event, memdev),
+	DB_FIELD_STR("host",		struct ras_cxl_aer_ue_event, host),
+	DB_FIELD_INT("serial",		struct ras_cxl_aer_ue_event, serial),
+	DB_FIELD_INT("error_status",	struct ras_cxl_aer_ue_event, error_status),
+	DB_FIELD_INT("first_error",	struct ras_cxl_aer_ue_event, first_error),
+	DB_FIELD_BLOB_PTR("header_log",	struct ras_cxl_aer_ue_event, header_log,
+			  CXL_HEADERLOG_SIZE),
+};
+
+const struct db_table_descriptor cxl_aer_ue_event_tab = {
+	.name = "cxl_aer_ue_event",
+	.fields = cxl_aer_ue_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_aer_ue_event_fields),
+	.rollup = "memdev",
+};
+
+/*
+ * Table of cxl:cxl_aer_correctable_error
+ */
+static const struct db_fields cxl_aer_ce_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_cxl_aer_ce_event, timestamp),
+	DB_FIELD_STR("memdev",		struct ras_cxl_aer_ce_event, memdev),
+	DB_FIELD_STR("host",		struct ras_cxl_aer_ce_event, host),
+	DB_FIELD_INT("serial",		struct ras_cxl_aer_ce_event, serial),
+	DB_FIELD_INT("error_status",	struct ras_cxl_aer_ce_event, error_status),
+};
+
+const struct db_table_descriptor cxl_aer_ce_event_tab = {
+	.name = "cxl_aer_ce_event",
+	.fields = cxl_aer_ce_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_aer_ce_event_fields),
+	.rollup = "memdev",
+};
+
+/*
+ * Table of cxl:cxl_overflow
+ */
+static const struct db_fields cxl_overflow_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_cxl_overflow_event, timestamp),
+	DB_FIELD_STR("memdev",		struct ras_cxl_overflow_event, memdev),
+	DB_FIELD_STR("host",		struct ras_cxl_overflow_event, host),
+	DB_FIELD_INT("serial",		struct ras_cxl_overflow_event, serial),
+	DB_FIELD_STR("log_type",	struct ras_cxl_overflow_event, log_type),
+	DB_FIELD_INT("count",		struct ras_cxl_overflow_event, count),
+	DB_FIELD_TEXT("first_ts",	struct ras_cxl_overflow_event, first_ts),
+	DB_FIELD_TEXT("last_ts",	struct ras_cxl_overflow_event, last_ts),
+};
+
+const struct db_table_descriptor cxl_overflow_event_tab = {
+	.name = "cxl_overflow_event",
+	.fields = cxl_overflow_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_overflow_event_fields),
+	.rollup = "memdev",
+};
+
+/* Columns of the common header of the CXL event records */
+#define DB_FIELDS_CXL_COMMON_HDR(_st)					\
+	DB_FIELD_TEXT("timestamp",		_st, hdr.timestamp),	\
+	DB_FIELD_STR("memdev",			_st, hdr.memdev),	\
+	DB_FIELD_STR("host",			_st, hdr.host),		\
+	DB_FIELD_INT("serial",			_st, hdr.serial),	\
+	DB_FIELD_STR("log_type",		_st, hdr.log_type),	\
+	DB_FIELD_STR("hdr_uuid",		_st, hdr.hdr_uuid),	\
+	DB_FIELD_INT("hdr_flags",		_st, hdr.hdr_flags),	\
+	DB_FIELD_INT("hdr_handle",		_st, hdr.hdr_handle),	\
+	DB_FIELD_INT("hdr_related_handle",	_st, hdr.hdr_related_handle), \
+	DB_FIELD_TEXT("hdr_ts",			_st, hdr.hdr_timestamp), \
+	DB_FIELD_INT("hdr_length",		_st, hdr.hdr_length),	\
+	DB_FIELD_INT("hdr_maint_op_class",	_st, hdr.hdr_maint_op_class), \
+	DB_FIELD_INT("hdr_maint_op_sub_class",	_st, hdr.hdr_maint_op_sub_class), \
+	DB_FIELD_INT("hdr_ld_id",		_st, hdr.hdr_ld_id),	\
+	DB_FIELD_INT("hdr_head_id",		_st, hdr.hdr_head_id)
+
+/*
+ * Table of cxl:cxl_generic_event
+ */
+static const struct db_fields cxl_generic_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELDS_CXL_COMMON_HDR(struct ras_cxl_generic_event),
+	DB_FIELD_BLOB_PTR("data",	struct ras_cxl_generic_event, data,
+			  CXL_EVENT_RECORD_DATA_LENGTH),
+};
+
+const struct db_table_descriptor cxl_generic_event_tab = {
+	.name = "cxl_generic_event",
+	.fields = cxl_generic_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_generic_event_fields),
+	.rollup = "memdev",
+};
+
+/*
+ * Table of cxl:cxl_general_media_event
+ */
+static const struct db_fields cxl_general_media_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELDS_CXL_COMMON_HDR(struct ras_cxl_general_media_event),
+	DB_FIELD_INT("dpa",		struct ras_cxl_general_media_event, dpa),
+	DB_FIELD_INT("dpa_flags",	struct ras_cxl_general_media_event, dpa_flags),
+	DB_FIELD_INT("descriptor",	struct ras_cxl_general_media_event, descriptor),
+	DB_FIELD_INT("type",		struct ras_cxl_general_media_event, type),
+	DB_FIELD_INT("transaction_type", struct ras_cxl_general_media_event, transaction_type),
+	DB_FIELD_INT("channel",		struct ras_cxl_general_media_event, channel),
+	DB_FIELD_INT("rank",		struct ras_cxl_general_media_event, rank),
+	DB_FIELD_INT("device",		struct ras_cxl_general_media_event, device),
+	DB_FIELD_BLOB_PTR("comp_id",	struct ras_cxl_general_media_event, comp_id,
+			  CXL_EVENT_GEN_MED_COMP_ID_SIZE),
+	DB_FIELD_INT("hpa",		struct ras_cxl_general_media_event, hpa),
+	DB_FIELD_STR("region",		struct ras_cxl_general_media_event, region),
+	DB_FIELD_STR("region_uuid",	struct ras_cxl_general_media_event, region_uuid),
+	DB_FIELD_BLOB("pldm_entity_id",	struct ras_cxl_general_media_event, entity_id),
+	DB_FIELD_BLOB("pldm_resource_id", struct ras_cxl_general_media_event, res_id),
+	DB_FIELD_INT("sub_type",	struct ras_cxl_general_media_event, sub_type),
+	DB_FIELD_INT("cme_threshold_ev_flags",
+		     struct ras_cxl_general_media_event, cme_threshold_ev_flags),
+	DB_FIELD_INT("cme_count",	struct ras_cxl_general_media_event, cme_count),
+	DB_FIELD_INT("hpa_alias0",	struct ras_cxl_general_media_event, hpa_alias0),
+};
+
+const struct db_table_descriptor cxl_general_media_event_tab = {
+	.name = "cxl_general_media_event",
+	.fields = cxl_general_media_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_general_media_event_fields),
+	.rollup = "memdev",
+};
+
+/*
+ * Table of cxl:cxl_dram_event
+ */
+static const struct db_fields cxl_dram_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELDS_CXL_COMMON_HDR(struct ras_cxl_dram_event),
+	DB_FIELD_INT("dpa",		struct ras_cxl_dram_event, dpa),
+	DB_FIELD_INT("dpa_flags",	struct ras_cxl_dram_event, dpa_flags),
+	DB_FIELD_INT("descriptor",	struct ras_cxl_dram_event, descriptor),
+	DB_FIELD_INT("type",		struct ras_cxl_dram_event, type),
+	DB_FIELD_INT("transaction_type", struct ras_cxl_dram_event, transaction_type),
+	DB_FIELD_INT("channel",		struct ras_cxl_dram_event, channel),
+	DB_FIELD_INT("rank",		struct ras_cxl_dram_event, rank),
+	DB_FIELD_INT("nibble_mask",	struct ras_cxl_dram_event, nibble_mask),
+	DB_FIELD_INT("bank_group",	struct ras_cxl_dram_event, bank_group),
+	DB_FIELD_INT("bank",		struct ras_cxl_dram_event, bank),
+	DB_FIELD_INT("row",		struct ras_cxl_dram_event, row),
+	DB_FIELD_INT("column",		struct ras_cxl_dram_event, column),
+	DB_FIELD_BLOB_PTR("cor_mask",	struct ras_cxl_dram_event, cor_mask,
+			  CXL_EVENT_DER_CORRECTION_MASK_SIZE),
+	DB_FIELD_INT("hpa",		struct ras_cxl_dram_event, hpa),
+	DB_FIELD_STR("region",		struct ras_cxl_dram_event, region),
+	DB_FIELD_STR("region_uuid",	struct ras_cxl_dram_event, region_uuid),
+	DB_FIELD_BLOB_PTR("comp_id",	struct ras_cxl_dram_event, comp_id,
+			  CXL_EVENT_GEN_MED_COMP_ID_SIZE),
+	DB_FIELD_BLOB("pldm_entity_id",	struct ras_cxl_dram_event, entity_id),
+	DB_FIELD_BLOB("pldm_resource_id", struct ras_cxl_dram_event, res_id),
+	DB_FIELD_INT("sub_type",	struct ras_cxl_dram_event, sub_type),
+	DB_FIELD_INT("sub_channel",	struct ras_cxl_dram_event, sub_channel),
+	DB_FIELD_INT("cme_threshold_ev_flags",
+		     struct ras_cxl_dram_event, cme_threshold_ev_flags),
+	DB_FIELD_INT("cvme_count",	struct ras_cxl_dram_event, cvme_count),
+	DB_FIELD_INT("hpa_alias0",	struct ras_cxl_dram_event, hpa_alias0),
+};
+
+const struct db_table_descriptor cxl_dram_event_tab = {
+	.name = "cxl_dram_event",
+	.fields = cxl_dram_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_dram_event_fields),
+	.rollup = "memdev",
+};
+
+/*
+ * Table of cxl:cxl_memory_module_event
+ */
+static const struct db_fields cxl_memory_module_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELDS_CXL_COMMON_HDR(struct ras_cxl_memory_module_event),
+	DB_FIELD_INT("event_type",	struct ras_cxl_memory_module_event, event_type),
+	DB_FIELD_INT("health_status",	struct ras_cxl_memory_module_event, health_status),
+	DB_FIELD_INT("media_status",	struct ras_cxl_memory_module_event, media_status),
+	DB_FIELD_INT("life_used",	struct ras_cxl_memory_module_event, life_used),
+	DB_FIELD_INT("dirty_shutdown_cnt",
+		     struct ras_cxl_memory_module_event, dirty_shutdown_cnt),
+	DB_FIELD_INT("cor_vol_err_cnt",	struct ras_cxl_memory_module_event, cor_vol_err_cnt),
+	DB_FIELD_INT("cor_per_err_cnt",	struct ras_cxl_memory_module_event, cor_per_err_cnt),
+	DB_FIELD_INT("device_temp",	struct ras_cxl_memory_module_event, device_temp),
+	DB_FIELD_INT("add_status",	struct ras_cxl_memory_module_event, add_status),
+	DB_FIELD_INT("event_sub_type",	struct ras_cxl_memory_module_event, event_sub_type),
+	DB_FIELD_BLOB_PTR("comp_id",	struct ras_cxl_memory_module_event, comp_id,
+			  CXL_EVENT_GEN_MED_COMP_ID_SIZE),
+	DB_FIELD_BLOB("pldm_entity_id",	struct ras_cxl_memory_module_event, entity_id),
+	DB_FIELD_BLOB("pldm_resource_id", struct ras_cxl_memory_module_event, res_id),
+};
+
+const struct db_table_descriptor cxl_memory_module_event_tab = {
+	.name = "cxl_memory_module_event",
+	.fields = cxl_memory_module_event_fields,
+	.num_fields = ARRAY_SIZE(cxl_memory_module_event_fields),
+	.rollup = "memdev",
+};
+#endif
+
+#ifdef HAVE_SIGNAL
+static const struct db_fields signal_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_signal_event, timestamp),
+	DB_FIELD_INT("sig",		struct ras_signal_event, sig),
+	DB_FIELD_INT("errorno",		struct ras_signal_event, error_no),
+	DB_FIELD_INT("code",		struct ras_signal_event, code),
+	DB_FIELD_STR("comm",		struct ras_signal_event, comm),
+	DB_FIELD_INT("pid",		struct ras_signal_event, pid),
+	DB_FIELD_INT("grp",		struct ras_signal_event, group),
+	DB_FIELD_INT("res",		struct ras_signal_event, result),
+};
+
+const struct db_table_descriptor signal_event_tab = {
+	.name = "signal_event",
+	.fields = signal_event_fields,
+	.num_fields = ARRAY_SIZE(signal_event_fields),
+	.rollup = "code",
+};
+#endif
+
+/*
+ * Table of ras:reri_event
+ */
+#ifdef HAVE_RERI
+static const struct db_fields reri_event_fields[] = {
+	DB_FIELD_ID,
+	DB_FIELD_TEXT("timestamp",	struct ras_reri_event, timestamp),
+	DB_FIELD_INT("err_src_id",	struct ras_reri_event, err_src_id),
+	DB_FIELD_INT("source_type",	struct ras_reri_event, source_type),
+	DB_FIELD_INT("severity",	struct ras_reri_event, severity),
+	DB_FIELD_INT("hart_id",		struct ras_reri_event, hart_id),
+	DB_FIELD_INT("cluster_id",	struct ras_reri_event, cluster_id),
+	DB_FIELD_INT("status",		struct ras_reri_event, status),
+	DB_FIELD_INT("addr_info",	struct ras_reri_event, addr_info),
+	DB_FIELD_INT("info",		struct ras_reri_event, info),
+	DB_FIELD_INT("suppl_info",	struct ras_reri_event, suppl_info),
+	DB_FIELD_INT("timestamp_val",	struct ras_reri_event, timestamp_val),
+};
+
+const struct db_table_descriptor reri_event_tab = {
+	.name = "reri_event",
+	.fields = reri_event_fields,
+	.num_fields = ARRAY_SIZE(reri_event_fields),
+};
+#endif
+
+const struct db_table_descriptor *ras_event_table(int type)
+{
+	switch (type) {
+	case MC_EVENT:
+		return &mc_event_tab;
+#ifdef HAVE_AER
+	case AER_EVENT:
+		return &aer_event_tab;
+#endif
+#ifdef HAVE_NON_STANDARD
+	case NON_STANDARD_EVENT:
+		return &non_standard_event_tab;
+#endif
+#ifdef HAVE_ARM
+	case ARM_EVENT:
+		return &arm_event_tab;
+#endif
+#ifdef HAVE_EXTLOG
+	case EXTLOG_EVENT:
+		return &extlog_event_tab;
+#endif
+#ifdef HAVE_MCE
+	case MCE_EVENT:
+		return &mce_record_tab;
+#endif
+#ifdef HAVE_DEVLINK
+	case DEVLINK_EVENT:
+		return &devlink_event_tab;
+#endif
+#ifdef HAVE_DISKERROR
+	case DISKERROR_EVENT:
+		return &diskerror_event_tab;
+#endif
+#ifdef HAVE_MEMORY_FAILURE
+	case MF_EVENT:
+		return &mf_event_tab;
+#endif
+#ifdef HAVE_CXL
+	case CXL_POISON_EVENT:
+		return &cxl_poison_event_tab;
+	case CXL_AER_UE_EVENT:
+		return &cxl_aer_ue_event_tab;
+	case CXL_AER_CE_EVENT:
+		return &cxl_aer_ce_event_tab;
+	case CXL_OVERFLOW_EVENT:
+		return &cxl_overflow_event_tab;
+	case CXL_GENERIC_EVENT:
+		return &cxl_generic_event_tab;
+	case CXL_GENERAL_MEDIA_EVENT:
+		return &cxl_general_media_event_tab;
+	case CXL_DRAM_EVENT:
+		return &cxl_dram_event_tab;
+	case CXL_MEMORY_MODULE_EVENT:
+		return &cxl_memory_module_event_tab;
+#endif
+#ifdef HAVE_SIGNAL
+	case SIGNAL_EVENT:
+		return &signal_event_tab;
+#endif
+#ifdef HAVE_RERI
+	case RERI_EVENT:
+		return &reri_event_tab;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+const struct db_fields *ras_table_field(const struct db_table_descriptor *tab,
+					const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < tab->num_fields; i++) {
+		if (!strcmp(tab->fields[i].name, name))
+			return &tab->fields[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Event time, set by the decoder for each trace record, and stored at the
+ * time columns, both at the database and at the event log
+ */
+
+static struct {
+	uint64_t	boot_ns;
+	uint64_t	wall_ns;
+} event_time;
+
+void ras_db_set_event_time(uint64_t boot_ns, uint64_t wall_ns)
+{
+	event_time.boot_ns = boot_ns;
+	event_time.wall_ns = wall_ns;
+}
+
+/* Events stored out of the trace records use the current time */
+void ras_db_event_time(uint64_t *boot_ns, uint64_t *wall_ns)
+{
+	struct timespec ts;
+
+	*boot_ns = event_time.boot_ns;
+	*wall_ns = event_time.wall_ns;
+
+	if (!*wall_ns) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		*wall_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+		clock_gettime(CLOCK_BOOTTIME, &ts);
+		*boot_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+}
+
+/*
+ * Packed values
+ */
+
+static uint32_t crc_table[256];
+
+static void crc32_init(void)
+{
+	uint32_t c;
+	int i, j;
+
+	if (crc_table[1])
+		return;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++)
+			c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+		crc_table[i] = c;
+	}
+}
+
+/* The same CRC-32 as zlib */
+uint32_t ras_crc32(uint32_t crc, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+
+	crc32_init();
+
+	crc = ~crc;
+	while (len--)
+		crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+enum ras_value_kind ras_field_kind(const struct db_fields *field)
+{
+	switch (field->bind) {
+	case DB_BIND_INT:
+		return RAS_VALUE_INT;
+	case DB_BIND_TEXT:
+	case DB_BIND_STR:
+		return RAS_VALUE_TEXT;
+	case DB_BIND_BLOB:
+	case DB_BIND_BLOB_PTR:
+	case DB_BIND_BLOB_LEN:
+		return RAS_VALUE_BLOB;
+	default:
+		return RAS_VALUE_NONE;
+	}
+}
+
+size_t ras_table_desc_len(const struct db_table_descriptor *tab)
+{
+	size_t len = strlen(tab->name) + 1;
+	unsigned int i;
+
+	for (i = 0; i < tab->num_fields; i++)
+		len += 1 + strlen(tab->fields[i].name) + 1 +
+		       strlen(tab->fields[i].type) + 1;
+
+	return len;
+}
+
+static char *put_str(char *p, const char *str)
+{
+	size_t len = strlen(str) + 1;
+
+	memcpy(p, str, len);
+
+	return p + len;
+}
+
+/* Returns the end of the description */
+char *ras_table_desc(const struct db_table_descriptor *tab, char *p)
+{
+	unsigned int i;
+
+	p = put_str(p, tab->name);
+	for (i = 0; i < tab->num_fields; i++) {
+		*p++ = ras_field_kind(&tab->fields[i]);
+		p = put_str(p, tab->fields[i].name);
+		p = put_str(p, tab->fields[i].type);
+	}
+
+	return p;
+}
+
+static const void *field_data(const struct db_fields *field, const void *ev,
+			      enum ras_value_kind kind, size_t *len)
+{
+	if (kind == RAS_VALUE_TEXT)
+		return db_field_text(field, ev, len);
+
+	return db_field_blob(field, ev, len);
+}
+
+size_t ras_event_packed_len(const struct db_table_descriptor *tab,
+			    const void *ev)
+{
+	const struct db_fields *field;
+	enum ras_value_kind kind;
+	size_t len = 0, size;
+	unsigned int i;
+
+	for (i = 0; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+		kind = ras_field_kind(field);
+
+		if (kind == RAS_VALUE_INT) {
+			len += sizeof(int64_t);
+		} else if (kind != RAS_VALUE_NONE) {
+			field_data(field, ev, kind, &size);
+			len += sizeof(uint32_t) + size;
+		}
+	}
+
+	return len;
+}
+
+/* Returns the end of the packed values */
+char *ras_event_pack(const struct db_table_descriptor *tab, const void *ev,
+		     char *p)
+{
+	const struct db_fields *field;
+	enum ras_value_kind kind;
+	const void *data;
+	uint32_t len32;
+	unsigned int i;
+	int64_t val;
+	size_t size;
+
+	for (i = 0; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+		kind = ras_field_kind(field);
+
+		switch (kind) {
+		case RAS_VALUE_INT:
+			val = db_field_int(field, ev);
+			memcpy(p, &val, sizeof(val));
+			p += sizeof(val);
+			break;
+		case RAS_VALUE_TEXT:
+		case RAS_VALUE_BLOB:
+			data = field_data(field, ev, kind, &size);
+			len32 = data ? size : RAS_VALUE_NULL_LEN;
+			memcpy(p, &len32, sizeof(len32));
+			p += sizeof(len32);
+			if (data) {
+				memcpy(p, data, size);
+				p += size;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return p;
+}
+
+/*
+ * Reads the packed value of @field: integers at @val, strings and blobs
+ * at @data, which is NULL for NULL values, and @len. Returns the next
+ * value, or NULL if @p has no room for this one.
+ */
+const char *ras_event_unpack(const struct db_fields *field, const char *p,
+			     const char *end, int64_t *val,
+			     const void **data, size_t *len)
+{
+	uint32_t len32;
+
+	switch (ras_field_kind(field)) {
+	case RAS_VALUE_INT:
+		if (end - p < sizeof(*val))
+			return NULL;
+		memcpy(val, p, sizeof(*val));
+		return p + sizeof(*val);
+	case RAS_VALUE_TEXT:
+	case RAS_VALUE_BLOB:
+		if (end - p < sizeof(len32))
+			return NULL;
+		memcpy(&len32, p, sizeof(len32));
+		p += sizeof(len32);
+		*data = NULL;
+		*len = 0;
+		if (len32 == RAS_VALUE_NULL_LEN)
+			return p;
+		if (end - p < len32)
+			return NULL;
+		*data = p;
+		*len = len32;
+		return p + len32;
+	default:
+		return p;
+	}
+}
+
+/*
+ * JSON
+ *
+ * The columns taken from the event, as "name":value members: integers
+ * as numbers, strings as strings and blobs as hex strings.
+ */
+
+/* Worst case of an escaped char, as \u00XX */
+#define JSON_ESCAPE_LEN		6
+
+size_t ras_event_json_len(const struct db_table_descriptor *tab,
+			  const void *ev)
+{
+	const struct db_fields *field;
+	enum ras_value_kind kind;
+	size_t len = 0, size;
+	unsigned int i;
+
+	for (i = 0; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+		kind = ras_field_kind(field);
+		if (kind == RAS_VALUE_NONE)
+			continue;
+
+		/* ,"name": */
+		len += strlen(field->name) + 4;
+
+		if (kind == RAS_VALUE_INT) {
+			len += 20;
+		} else {
+			/* The quotes, or null */
+			field_data(field, ev, kind, &size);
+			len += 4 + size * (kind == RAS_VALUE_TEXT ?
+					   JSON_ESCAPE_LEN : 2);
+		}
+	}
+
+	return len;
+}
+
+/* Writes @len chars of @str as a JSON string. Returns its end */
+char *ras_json_str(char *p, const char *str, size_t len)
+{
+	unsigned char c;
+
+	*p++ = '"';
+	while (len--) {
+		c = *str++;
+		switch (c) {
+		case '"':
+		case '\\':
+			*p++ = '\\';
+			*p++ = c;
+			break;
+		case '\n':
+			*p++ = '\\';
+			*p++ = 'n';
+			break;
+		case '\t':
+			*p++ = '\\';
+			*p++ = 't';
+			break;
+		default:
+			if (c < 0x20) {
+				p += sprintf(p, "\\u%04x", c);
+				break;
+			}
+			*p++ = c;
+		}
+	}
+	*p++ = '"';
+
+	return p;
+}
+
+static char *json_hex(char *p, const uint8_t *data, size_t len)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	*p++ = '"';
+	while (len--) {
+		*p++ = hex[*data >> 4];
+		*p++ = hex[*data++ & 0xf];
+	}
+	*p++ = '"';
+
+	return p;
+}
+
+/*
+ * Writes the members, each one preceded by a comma. Needs the room given
+ * by ras_event_json_len(). Returns the end of the members.
+ */
+char *ras_event_json(const struct db_table_descriptor *tab, const void *ev,
+		     char *p)
+{
+	const struct db_fields *field;
+	enum ras_value_kind kind;
+	const void *data;
+	unsigned int i;
+	int64_t val;
+	size_t size;
+
+	for (i = 0; i < tab->num_fields; i++) {
+		field = &tab->fields[i];
+		kind = ras_field_kind(field);
+		if (kind == RAS_VALUE_NONE)
+			continue;
+
+		p += sprintf(p, ",\"%s\":", field->name);
+
+		switch (kind) {
+		case RAS_VALUE_INT:
+			val = db_field_int(field, ev);
+			if (field->is_signed)
+				p += sprintf(p, "%lld", (long long)val);
+			else
+				p += sprintf(p, "%llu",
+					     (unsigned long long)val);
+			break;
+		case RAS_VALUE_TEXT:
+			data = field_data(field, ev, kind, &size);
+			if (data)
+				p = ras_json_str(p, data, size);
+			else
+				p += sprintf(p, "null");
+			break;
+		default:
+			data = field_data(field, ev, kind, &size);
+			if (data)
+				p = json_hex(p, data, size);
+			else
+				p += sprintf(p, "null");
+			break;
+		}
+	}
+
+	return p;
+}
+
+/* Room needed by ras_event_json_object(), with its NUL */
+size_t ras_event_json_object_len(const struct db_table_descriptor *tab,
+				 const struct ras_sink_event *event)
+{
+	size_t len = strlen(ras_stats_event_name(event->type)) + 64;
+
+	if (tab)
+		len += ras_event_json_len(tab, event->ev);
+
+	return len;
+}
+
+/*
+ * Writes the event as a JSON object: its name and severity, followed by
+ * the columns of @tab, if any. Returns the end of the object.
+ */
+char *ras_event_json_object(const struct db_table_descriptor *tab,
+			    const struct ras_sink_event *event, char *p)
+{
+	p += sprintf(p, "{\"event\":\"%s\",\"severity\":\"%s\"",
+		     ras_stats_event_name(event->type),
+		     ras_severity_name(event->severity));
+	if (tab)
+		p = ras_event_json(tab, event->ev, p);
+	*p++ = '}';
+	*p = '\0';
+
+	return p;
+}
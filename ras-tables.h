@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/*
+ * Event tables: the columns of each event, and their encodings
+ */
+
+#ifndef __RAS_TABLES_H
+#define __RAS_TABLES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct db_fields;
+struct db_table_descriptor;
+struct ras_sink_event;
+
+/* Kinds of the packed values */
+enum ras_value_kind {
+	RAS_VALUE_NONE,		/* Not packed, e.g. the row id */
+	RAS_VALUE_INT,		/* int64_t */
+	RAS_VALUE_TEXT,		/* uint32_t length, and the chars */
+	RAS_VALUE_BLOB,		/* uint32_t length, and the bytes */
+};
+
+#define RAS_VALUE_NULL_LEN	UINT32_MAX
+
+extern const struct db_table_descriptor lost_event_tab;
+extern const struct db_table_descriptor mc_event_tab;
+extern const struct db_table_descriptor aer_event_tab;
+extern const struct db_table_descriptor non_standard_event_tab;
+extern const struct db_table_descriptor arm_event_tab;
+extern const struct db_table_descriptor extlog_event_tab;
+extern const struct db_table_descriptor mce_record_tab;
+extern const struct db_table_descriptor devlink_event_tab;
+extern const struct db_table_descriptor diskerror_event_tab;
+extern const struct db_table_descriptor mf_event_tab;
+extern const struct db_table_descriptor cxl_poison_event_tab;
+extern const struct db_table_descriptor cxl_aer_ue_event_tab;
+extern const struct db_table_descriptor cxl_aer_ce_event_tab;
+extern const struct db_table_descriptor cxl_overflow_event_tab;
+extern const struct db_table_descriptor cxl_generic_event_tab;
+extern const struct db_table_descriptor cxl_general_media_event_tab;
+extern const struct db_table_descriptor cxl_dram_event_tab;
+extern const struct db_table_descriptor cxl_memory_module_event_tab;
+extern const struct db_table_descriptor signal_event_tab;
+extern const struct db_table_descriptor reri_event_tab;
+
+const struct db_table_descriptor *ras_event_table(int type);
+const struct db_fields *ras_table_field(const struct db_table_descriptor *tab,
+					const char *name);
+
+/* Packed values, used by the binary event log and the staging ring */
+uint32_t ras_crc32(uint32_t crc, const void *buf, size_t len);
+enum ras_value_kind ras_field_kind(const struct db_fields *field);
+size_t ras_table_desc_len(const struct db_table_descriptor *tab);
+char *ras_table_desc(const struct db_table_descriptor *tab, char *p);
+size_t ras_event_packed_len(const struct db_table_descriptor *tab,
+			    const void *ev);
+char *ras_event_pack(const struct db_table_descriptor *tab, const void *ev,
+		     char *p);
+const char *ras_event_unpack(const struct db_fields *field, const char *p,
+			     const char *end, int64_t *val,
+			     const void **data, size_t *len);
+
+/* JSON members, without the braces */
+size_t ras_event_json_len(const struct db_table_descriptor *tab,
+			  const void *ev);
+char *ras_event_json(const struct db_table_descriptor *tab, const void *ev,
+		     char *p);
+char *ras_json_str(char *p, const char *str, size_t len);
+
+/* JSON objects, with the event name and severity */
+size_t ras_event_json_object_len(const struct db_table_descriptor *tab,
+				 const struct ras_sink_event *event);
+char *ras_event_json_object(const struct db_table_descriptor *tab,
+			    const struct ras_sink_event *event, char *p);
+
+#endif
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include "ras-capture.h"
 #include "ras-erst.h"
 #include "ras-events.h"
 #include "ras-logger.h"
@@ -38,6 +39,15 @@ struct arguments {
 	int enable_ipmitool;
 	int foreground;
 	int offline;
+	char *capture;
+	char *replay;
+	int replay_realtime;
+};
+
+enum CAPTURE_ARG_KEYS {
+	CAPTURE = 0x200,
+	REPLAY,
+	REPLAY_REALTIME
 };
 
 enum OFFLINE_ARG_KEYS {
@@ -63,11 +73,9 @@ static error_t parse_opt(int k, char *arg, struct argp_state *state)
 	case 'd':
 		args->enable_ras--;
 		break;
-#ifdef HAVE_SQLITE3
 	case 'r':
 		args->record_events++;
 		break;
-#endif
 #ifdef HAVE_OPENBMC_UNIFIED_SEL
 	case 'i':
 		args->enable_ipmitool++;
@@ -76,6 +84,15 @@ static error_t parse_opt(int k, char *arg, struct argp_state *state)
 	case 'f':
 		args->foreground++;
 		break;
+	case CAPTURE:
+		args->capture = arg;
+		break;
+	case REPLAY:
+		args->replay = arg;
+		break;
+	case REPLAY_REALTIME:
+		args->replay_realtime++;
+		break;
 #ifdef HAVE_MCE
 	case 'p':
 		if (state->argc < 4)
@@ -173,6 +190,8 @@ int main(int argc, char *argv[])
 		{"disable", 'd', 0, 0, "disable RAS events and exit", 0},
 #ifdef HAVE_SQLITE3
 		{"record",  'r', 0, 0, "record events via sqlite3", 0},
+#else
+		{"record",  'r', 0, 0, "record events at the binary event log", 0},
 #endif
 		{"foreground", 'f', 0, 0, "run foreground, not daemonize"},
 #ifdef HAVE_OPENBMC_UNIFIED_SEL
@@ -182,6 +201,12 @@ int main(int argc, char *argv[])
 		{"post-processing", 'p', 0, 0,
 		"Post-processing MCE's with raw register values"},
 #endif
+		{"capture", CAPTURE, "FILE", 0,
+		"store the raw trace buffers at FILE, for replaying them", 0},
+		{"replay", REPLAY, "FILE", 0,
+		"replay a capture, instead of reading the trace buffers, and exit", 0},
+		{"replay-realtime", REPLAY_REALTIME, 0, 0,
+		"replay with the captured timing, instead of as fast as possible", 0},
 
 		{ 0, 0, 0, 0, 0, 0 }
 	};
@@ -221,6 +246,17 @@ int main(int argc, char *argv[])
 	}
 #endif
 
+	if (args.replay) {
+		if (ras_replay_open(args.replay, args.replay_realtime))
+			return -1;
+		if (handle_ras_events(args.record_events, args.enable_ipmitool))
+			return -1;
+		return 0;
+	}
+
+	if (args.capture && ras_capture_open(args.capture))
+		return -1;
+
 	openlog(TOOL_NAME, 0, LOG_DAEMON);
 	if (!args.foreground)
 		if (daemon(0, 0))
@@ -1,20 +1,68 @@
 // SPDX-License-Identifier: GPL-2.0
 
 #define _GNU_SOURCE
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include "ras-logger.h"
+#include "ras-pipeline.h"
 #include "trigger.h"
 
-void run_trigger(const char *trigger, char *argv[], char **env, const char *reporter)
+struct trigger_job {
+	char *trigger;
+	char *reporter;
+	char **argv;
+	char **env;
+};
+
+static void free_strv(char **v)
+{
+	int i;
+
+	if (!v)
+		return;
+
+	for (i = 0; v[i]; i++)
+		free(v[i]);
+	free(v);
+}
+
+static int dup_strv(char **src, char ***dst)
+{
+	int i, n = 0;
+
+	*dst = NULL;
+	if (!src)
+		return 0;
+
+	while (src[n])
+		n++;
+
+	*dst = calloc(n + 1, sizeof(**dst));
+	if (!*dst)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		(*dst)[i] = strdup(src[i]);
+		if (!(*dst)[i])
+			return -1;
+	}
+
+	return 0;
+}
+
+static void exec_trigger(void *arg)
 {
+	struct trigger_job *job = arg;
 	pid_t child;
 	int status;
 
-	log(SYSLOG, LOG_INFO, "Running trigger `%s' (reporter: %s)\n", trigger, reporter);
+	log(SYSLOG, LOG_INFO, "Running trigger `%s' (reporter: %s)\n",
+	    job->trigger, job->reporter);
 
 	child = fork();
 	if (child < 0) {
@@ -23,20 +71,61 @@ void run_trigger(const char *trigger, char *argv[], char **env, const char *repo
 	}
 
 	if (child == 0) {
-		execve(trigger, argv, env);
+		execve(job->trigger, job->argv, job->env);
 		_exit(127);
 	} else {
 		waitpid(child, &status, 0);
 		if (WIFEXITED(status) && WEXITSTATUS(status)) {
 			log(SYSLOG, LOG_INFO, "Trigger %s exited with status %d",
-			    trigger, WEXITSTATUS(status));
+			    job->trigger, WEXITSTATUS(status));
 		} else if (WIFSIGNALED(status)) {
 			log(SYSLOG, LOG_INFO, "Trigger %s killed by signal %d",
-			    trigger, WTERMSIG(status));
+			    job->trigger, WTERMSIG(status));
 		}
 	}
 }
 
+static void free_trigger_job(void *arg)
+{
+	struct trigger_job *job = arg;
+
+	free(job->trigger);
+	free(job->reporter);
+	free_strv(job->argv);
+	free_strv(job->env);
+	free(job);
+}
+
+/*
+ * Triggers run at the worker of @queue, as waiting for the child would
+ * otherwise stall the event decoding. The caller keeps the ownership
+ * of argv and env, so they're copied here.
+ */
+int run_trigger(struct ras_sink_queue *queue, const char *trigger,
+		char *argv[], char **env, const char *reporter)
+{
+	struct trigger_job *job;
+
+	job = calloc(1, sizeof(*job));
+	if (!job)
+		goto error;
+
+	job->trigger = strdup(trigger);
+	job->reporter = strdup(reporter);
+	if (!job->trigger || !job->reporter ||
+	    dup_strv(argv, &job->argv) || dup_strv(env, &job->env)) {
+		free_trigger_job(job);
+		goto error;
+	}
+
+	/* Drops are logged and counted by the queue */
+	return ras_sink_submit(queue, exec_trigger, free_trigger_job, job);
+
+error:
+	log(SYSLOG, LOG_ERR, "Cannot allocate memory for trigger");
+	return -ENOMEM;
+}
+
 const char *trigger_check(const char *s)
 {
 	char *name;
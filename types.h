@@ -85,7 +85,9 @@
 
 /* BIT handling */
 
+#ifndef _AC	/* Also defined by <linux/const.h> */
 #define _AC(X, Y)	(X##Y)
+#endif
 
 #define _UL(x)          (_AC(x, UL))
 #define _ULL(x)         (_AC(x, ULL))